@@ -24,12 +24,29 @@
 
 /* Switch app headers */
 #include "mesh_proxy.h"
+#include "connections.h"
+#include "event_dispatch.h"
+#include "client_queue.h"
+#include "timer_wheel.h"
+#include "scheduler.h"
+#include "state_cache.h"
+#include "ps_cache.h"
+#include "request_tracker.h"
+#include "ll_priority.h"
+#include "ota.h"
+#include "host_protocol.h"
+#include "app.h"
+#include "app_console.h"
 
 /* Coex header */
 #include "coexistence-ble.h"
 
 #include <stdio.h>
 #include <darwin_log.h>
+#include <darwin_cycles.h>
+#include <darwin_console.h>
+#include <darwin_trace.h>
+#include <darwin_boot.h>
 
 /***************************************************************************//**
  * @addtogroup Application
@@ -47,18 +64,14 @@
 #define PB_ADV   0x1 ///< Advertising Provisioning Bearer
 #define PB_GATT  0x2 ///< GATT Provisioning Bearer
 
-/// Flag for indicating DFU Reset must be performed
-uint8_t boot_to_dfu = 0;
+/// ATT protocol error code of a stack error code
+#define ATT_ERROR(err)   ((uint8_t)((err) & 0xFF))
 
 /*******************************************************************************
  * Global variables
  ******************************************************************************/
 /// Address of the Primary Element of the Node
 static uint16_t _my_address = 0;
-/// number of active Bluetooth connections
-static uint8_t num_connections = 0;
-/// handle of the last opened LE connection
-static uint8_t conn_handle = 0xFF;
 /// Flag for indicating that provisioning procedure is finished
 static uint8_t provisioning_finished = 0;
 
@@ -66,7 +79,7 @@ static uint8_t provisioning_finished = 0;
  * Function prototypes.
  ******************************************************************************/
 bool mesh_bgapi_listener(struct gecko_cmd_packet *evt);
-static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *pEvt);
+static void register_event_handlers(void);
 
 /***************************************************************************//**
  * Initialise used bgapi classes.
@@ -77,6 +90,7 @@ static void gecko_bgapi_classes_init(void)
    gecko_bgapi_class_system_init();
    gecko_bgapi_class_le_gap_init();
    gecko_bgapi_class_le_connection_init();
+   gecko_bgapi_class_gatt_init();
    gecko_bgapi_class_gatt_server_init();
    gecko_bgapi_class_hardware_init();
    gecko_bgapi_class_flash_init();
@@ -95,6 +109,9 @@ static void gecko_bgapi_classes_init(void)
  ******************************************************************************/
 void appMain(const gecko_configuration_t *pConfig)
 {
+   // Start with the advertise profile, the stack takes the table at init
+   LlPrioInit(pConfig->bluetooth.linklayer_priorities);
+
    // Initialize stack
    gecko_stack_init(pConfig);
    gecko_bgapi_classes_init();
@@ -102,19 +119,50 @@ void appMain(const gecko_configuration_t *pConfig)
    // Initialize coexistence interface. Parameters are taken from HAL config.
    gecko_initCoexHAL();
 
+   // Build the event dispatch table
+   EventDispatchInit();
+   register_event_handlers();
+   TimerWheelInit();
+   SchedInit();
+   PsCacheInit();
+   OtaInit();
+   LlPrioAuto();
+
+#ifdef DARWIN_TRACE
+   TraceInit();
+#endif
+#ifdef DARWIN_CONSOLE
+   app_console_init();
+#endif
+#ifdef DARWIN_HOST_PROTOCOL
+   // takes over the console I/O when both are enabled
+   host_protocol_init();
+#endif
+
    while(1) {
       // Event pointer for handling events
       struct gecko_cmd_packet* evt;
-
-      // Check for stack event
-      evt = gecko_wait_event();
+      // Cycle count when the event was received
+      uint32_t received;
+
+      // Check for stack event, flush the deferred log and the event trace
+      // and run the background tasks before going to sleep. Events are
+      // checked again after every task slice.
+      evt = gecko_peek_event();
+      if(evt == NULL) {
+         LOG_DRAIN();
+         if(TRACE_IDLE() || SchedRun()) {
+            continue;
+         }
+         evt = gecko_wait_event();
+      }
+      received = CYCLE_COUNT();
+      TRACE_EVENT(evt);
 
       bool pass = mesh_bgapi_listener(evt);
+      LOG_GECKO_EVENT(evt);
       if(pass) {
-         handle_gecko_event(BGLIB_MSG_ID(evt->header), evt);
-      }
-      else {
-         LOG_GECKO_EVENT(evt);
+         EventDispatch(evt, received);
       }
    }
 }
@@ -126,7 +174,7 @@ void appMain(const gecko_configuration_t *pConfig)
  *
  * @param[in] pAddr  Pointer to Bluetooth address.
  ******************************************************************************/
-static void set_device_name(bd_addr *pAddr)
+void set_device_name(bd_addr *pAddr)
 {
    char name[20];
    uint16_t res;
@@ -153,14 +201,12 @@ static void initiate_factory_reset(void)
 {
    LOG("factory reset\n");
 
-   /* if connection is open then close it before rebooting */
-   if(conn_handle != 0xFF) {
-      gecko_cmd_le_connection_close(conn_handle);
-   }
+   /* close the open connections before rebooting */
+   ConnCloseAll();
 
    /* perform a factory reset by erasing PS storage. This removes all the keys and other settings
       that have been configured for this node */
-   gecko_cmd_flash_ps_erase_all();
+   PsCacheEraseAll();
    // reboot after a small delay
    gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(2000),
                                      FACTORY_RESET_TIMER,
@@ -168,210 +214,391 @@ static void initiate_factory_reset(void)
 }
 
 /***************************************************************************//**
- * Handling of stack events. Both Bluetooth LE and Bluetooth mesh events
- * are handled here.
- * @param[in] evt_id  Incoming event ID.
- * @param[in] pEvt    Pointer to incoming event.
+ * Handling of the system boot event. Sets the device name and initializes the
+ * mesh stack in node operation mode.
+ * @param[in] pEvt  Pointer to incoming event.
  ******************************************************************************/
-static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *pEvt)
+static void handle_system_boot(struct gecko_cmd_packet *pEvt)
 {
    uint16_t result;
    volatile bool FactoryReset = false;
 
-   if(NULL == pEvt) {
-      return;
+   BOOT_MARK(BOOT_PHASE_STACK);
+
+   if(FactoryReset) {
+      initiate_factory_reset();
    }
+   else {
+      struct gecko_msg_system_get_bt_address_rsp_t *pAddr = gecko_cmd_system_get_bt_address();
 
-   LOG_GECKO_EVENT(pEvt);
-   switch(evt_id) {
-      case gecko_evt_system_boot_id:
-         if(FactoryReset) {
-            initiate_factory_reset();
-         }
-         else {
-            struct gecko_msg_system_get_bt_address_rsp_t *pAddr = gecko_cmd_system_get_bt_address();
+      set_device_name(&pAddr->address);
 
-            set_device_name(&pAddr->address);
+      // proxy PDUs up to the MTU are not segmented
+      result = gecko_cmd_gatt_set_max_mtu(CONN_MAX_MTU)->result;
+      if(result) {
+         ELOG("gecko_cmd_gatt_set_max_mtu failed: 0x%x\n",result);
+      }
 
-            // Initialize Mesh stack in Node operation mode, it will generate initialized event
-            result = gecko_cmd_mesh_node_init()->result;
-            LOG("gecko_cmd_mesh_node_init returned: 0x%x\n",result);
-            if(result) {
-               ELOG("gecko_cmd_mesh_node_init failed: 0x%x\n",result);
-            }
-         }
+      // Initialize Mesh stack in Node operation mode, it will generate initialized event
+      result = gecko_cmd_mesh_node_init()->result;
+      LOG("gecko_cmd_mesh_node_init returned: 0x%x\n",result);
+      if(result) {
+         ELOG("gecko_cmd_mesh_node_init failed: 0x%x\n",result);
+      }
+   }
+}
+
+/***************************************************************************//**
+ * Handling of soft timer expiry.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_soft_timer(struct gecko_cmd_packet *pEvt)
+{
+   switch(pEvt->data.evt_hardware_soft_timer.handle) {
+      case FACTORY_RESET_TIMER:
+         // reset the device to finish factory reset
+         gecko_cmd_system_reset(0);
+         break;
+
+      case RESTART_TIMER:
+         // restart timer expires, reset the device
+         PsCacheFlush();
+         gecko_cmd_system_reset(0);
          break;
 
-      case gecko_evt_hardware_soft_timer_id:
-         switch(pEvt->data.evt_hardware_soft_timer.handle) {
-            case FACTORY_RESET_TIMER:
-               // reset the device to finish factory reset
-               gecko_cmd_system_reset(0);
-               break;
-
-            case RESTART_TIMER:
-               // restart timer expires, reset the device
-               gecko_cmd_system_reset(0);
-               break;
-
-            case PROVISIONING_TIMER:
-               // toggle LED to indicate the provisioning state
-               if(!provisioning_finished) {
-               }
-               break;
-
-            default:
-               break;
+      case PROVISIONING_TIMER:
+         // toggle LED to indicate the provisioning state
+         if(!provisioning_finished) {
          }
+         break;
 
+      case CLIENT_QUEUE_TIMER:
+         ClientQueueFlush();
+#ifdef DARWIN_HOST_PROTOCOL
+         host_protocol_grant();
+#endif
          break;
 
-      case gecko_evt_mesh_node_initialized_id:
-         LOG("node initialized\n");
+      case TIMER_WHEEL_TIMER:
+         TimerWheelTick();
+         break;
 
-         // Initialize generic client models
-         result = gecko_cmd_mesh_generic_client_init_on_off()->result;
-         if(result) {
-            LOG("mesh_generic_client_init_on_off failed, code 0x%x\n", result);
-         }
-         result = gecko_cmd_mesh_generic_client_init_lightness()->result;
-         if(result) {
-            LOG("mesh_generic_client_init_lightness failed, code 0x%x\n", result);
-         }
-         result = gecko_cmd_mesh_generic_client_init_ctl()->result;
-         if(result) {
-            LOG("mesh_generic_client_init_ctl failed, code 0x%x\n", result);
-         }
-         result = gecko_cmd_mesh_generic_client_init_common()->result;
-         if(result) {
-            LOG("mesh_generic_client_init_common failed, code 0x%x\n", result);
-         }
+      default:
+         break;
+   }
+}
 
-         // Initialize scene client model
-         result = gecko_cmd_mesh_scene_client_init(0)->result;
-         if(result) {
-            LOG("mesh_scene_client_init failed, code 0x%x\n", result);
-         }
+/***************************************************************************//**
+ * Handling of the mesh node initialized event. Initializes the client models
+ * and starts unprovisioned beaconing if needed.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_node_initialized(struct gecko_cmd_packet *pEvt)
+{
+   uint16_t result;
 
-         struct gecko_msg_mesh_node_initialized_evt_t *pData = (struct gecko_msg_mesh_node_initialized_evt_t *)&(pEvt->data);
+   BOOT_MARK(BOOT_PHASE_MESH);
+   LOG("node initialized\n");
 
-         if(pData->provisioned) {
-            LOG("node is provisioned. address:%x, ivi:%ld\n", pData->address, pData->ivi);
+   // Initialize generic client models
+   result = gecko_cmd_mesh_generic_client_init_on_off()->result;
+   if(result) {
+      LOG("mesh_generic_client_init_on_off failed, code 0x%x\n", result);
+   }
+   result = gecko_cmd_mesh_generic_client_init_lightness()->result;
+   if(result) {
+      LOG("mesh_generic_client_init_lightness failed, code 0x%x\n", result);
+   }
+   result = gecko_cmd_mesh_generic_client_init_ctl()->result;
+   if(result) {
+      LOG("mesh_generic_client_init_ctl failed, code 0x%x\n", result);
+   }
+   result = gecko_cmd_mesh_generic_client_init_common()->result;
+   if(result) {
+      LOG("mesh_generic_client_init_common failed, code 0x%x\n", result);
+   }
 
-            _my_address = pData->address;
+   // Initialize scene client model
+   result = gecko_cmd_mesh_scene_client_init(0)->result;
+   if(result) {
+      LOG("mesh_scene_client_init failed, code 0x%x\n", result);
+   }
 
-         }
-         else {
-            LOG("node is unprovisioned\n");
+   // Requests of the client models above go through the coalescing queue,
+   // their status replies are cached
+   ClientQueueInit();
+   StateCacheInit();
 
-            LOG("starting unprovisioned beaconing...\n");
-            // Enable ADV and GATT provisioning bearer
-            gecko_cmd_mesh_node_start_unprov_beaconing(PB_ADV | PB_GATT);
-         }
-         break;
+   struct gecko_msg_mesh_node_initialized_evt_t *pData = (struct gecko_msg_mesh_node_initialized_evt_t *)&(pEvt->data);
 
-      case gecko_evt_system_external_signal_id:
-         break;
+   if(pData->provisioned) {
+      LOG("node is provisioned. address:%x, ivi:%lu\n", pData->address, (unsigned long) pData->ivi);
 
-      case gecko_evt_mesh_node_provisioning_started_id:
-         LOG("Started provisioning\n");
-         // start timer for blinking LEDs to indicate which node is being provisioned
-         gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(250),
-                                           PROVISIONING_TIMER,
-                                           REPEATING);
-         break;
+      _my_address = pData->address;
 
-      case gecko_evt_mesh_node_provisioned_id:
-         provisioning_finished = 1;
-         LOG("node provisioned, got address=%x\n", pEvt->data.evt_mesh_node_provisioned.address);
-         // stop LED blinking when provisioning complete
-         gecko_cmd_hardware_set_soft_timer(TIMER_STOP,
-                                           PROVISIONING_TIMER,
-                                           REPEATING);
-         break;
+   }
+   else {
+      LOG("node is unprovisioned\n");
 
-      case gecko_evt_mesh_node_provisioning_failed_id:
-         LOG("provisioning failed, code 0x%x\n", pEvt->data.evt_mesh_node_provisioning_failed.result);
-         /* start a one-shot timer that will trigger soft reset after small delay */
-         gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(2000),
-                                           RESTART_TIMER,
-                                           SINGLE_SHOT);
-         break;
+      LOG("starting unprovisioned beaconing...\n");
+      // Enable ADV and GATT provisioning bearer
+      gecko_cmd_mesh_node_start_unprov_beaconing(PB_ADV | PB_GATT);
+   }
+}
 
-      case gecko_evt_mesh_node_key_added_id:
-         LOG("got new %s key with index 0x%x\n",
-             pEvt->data.evt_mesh_node_key_added.type == 0 ? "network" : "application",
-             pEvt->data.evt_mesh_node_key_added.index);
-         break;
+/***************************************************************************//**
+ * Handling of provisioning start.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_provisioning_started(struct gecko_cmd_packet *pEvt)
+{
+   LOG("Started provisioning\n");
+   // start timer for blinking LEDs to indicate which node is being provisioned
+   gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(250),
+                                     PROVISIONING_TIMER,
+                                     REPEATING);
+}
 
-      case gecko_evt_mesh_node_model_config_changed_id:
-         LOG("model config changed\n");
-         break;
+/***************************************************************************//**
+ * Handling of provisioning completion.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_provisioned(struct gecko_cmd_packet *pEvt)
+{
+   provisioning_finished = 1;
+   LOG("node provisioned, got address=%x\n", pEvt->data.evt_mesh_node_provisioned.address);
+   // stop LED blinking when provisioning complete
+   gecko_cmd_hardware_set_soft_timer(TIMER_STOP,
+                                     PROVISIONING_TIMER,
+                                     REPEATING);
+}
 
-      case gecko_evt_mesh_node_config_set_id:
-         LOG("model config set\n");
-         break;
+/***************************************************************************//**
+ * Handling of provisioning failure.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_provisioning_failed(struct gecko_cmd_packet *pEvt)
+{
+   LOG("provisioning failed, code 0x%x\n", pEvt->data.evt_mesh_node_provisioning_failed.result);
+   /* start a one-shot timer that will trigger soft reset after small delay */
+   gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(2000),
+                                     RESTART_TIMER,
+                                     SINGLE_SHOT);
+}
 
-      case gecko_evt_le_connection_opened_id:
-         LOG("evt:gecko_evt_le_connection_opened_id\n");
-         num_connections++;
-         conn_handle = pEvt->data.evt_le_connection_opened.connection;
-         break;
+/***************************************************************************//**
+ * Handling of new network or application keys.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_key_added(struct gecko_cmd_packet *pEvt)
+{
+   LOG("got new %s key with index 0x%x\n",
+       pEvt->data.evt_mesh_node_key_added.type == 0 ? "network" : "application",
+       pEvt->data.evt_mesh_node_key_added.index);
+   ConnProxyActivity();
+}
 
-      case gecko_evt_le_connection_closed_id:
-         /* Check if need to boot to dfu mode */
-         if(boot_to_dfu) {
-            /* Enter to DFU OTA mode */
-            gecko_cmd_system_reset(2);
-         }
+/***************************************************************************//**
+ * Handling of model configuration changes.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_model_config_changed(struct gecko_cmd_packet *pEvt)
+{
+   LOG("model config changed\n");
+   ConnProxyActivity();
+}
 
-         LOG("evt:conn closed, reason 0x%x\n", pEvt->data.evt_le_connection_closed.reason);
-         conn_handle = 0xFF;
-         if(num_connections > 0) {
-            if(--num_connections == 0) {
-            }
-         }
-         break;
+/***************************************************************************//**
+ * Handling of node configuration changes.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_config_set(struct gecko_cmd_packet *pEvt)
+{
+   LOG("model config set\n");
+   ConnProxyActivity();
+}
 
-      case gecko_evt_mesh_node_reset_id:
-         LOG("evt gecko_evt_mesh_node_reset_id\n");
-         initiate_factory_reset();
-         break;
+/***************************************************************************//**
+ * Handling of status messages received by the generic client models.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_server_status(struct gecko_cmd_packet *pEvt)
+{
+   StateCacheUpdate(&pEvt->data.evt_mesh_generic_client_server_status);
+   ReqGenericStatus(&pEvt->data.evt_mesh_generic_client_server_status);
+#ifdef DARWIN_HOST_PROTOCOL
+   host_protocol_status(pEvt);
+#endif
+}
 
-      case gecko_evt_le_connection_parameters_id:
-         LOG("connection params: interval %d, timeout %d\n",
-             pEvt->data.evt_le_connection_parameters.interval,
-             pEvt->data.evt_le_connection_parameters.timeout);
-         break;
+/***************************************************************************//**
+ * Handling of node reset requested by the provisioner.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_node_reset(struct gecko_cmd_packet *pEvt)
+{
+   LOG("evt gecko_evt_mesh_node_reset_id\n");
+   initiate_factory_reset();
+}
 
-      case gecko_evt_le_gap_adv_timeout_id:
-         // these events silently discarded
-         break;
+/***************************************************************************//**
+ * Handling of user characteristic reads. The event latency statistics are
+ * snapshotted on the first read (offset 0), long reads continue from the
+ * snapshot. The log levels are read as one byte per module.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_user_read_request(struct gecko_cmd_packet *pEvt)
+{
+   struct gecko_msg_gatt_server_user_read_request_evt_t *pReq = &pEvt->data.evt_gatt_server_user_read_request;
+
+#ifdef gattdb_event_latency
+   if(pReq->characteristic == gattdb_event_latency) {
+      static uint8_t snapshot[512];
+      static int snapshot_len;
+      Connection_t *conn = ConnFind(pReq->connection);
+      int mtu = conn != NULL ? conn->Mtu : CONN_DEFAULT_MTU;
+      int len;
+
+      if(pReq->offset == 0) {
+         snapshot_len = EventDispatchSerializeStats(snapshot, sizeof(snapshot));
+      }
+      if(pReq->offset > snapshot_len) {
+         gecko_cmd_gatt_server_send_user_read_response(pReq->connection, pReq->characteristic,
+                                                       ATT_ERROR(bg_err_att_invalid_offset), 0, NULL);
+         return;
+      }
+      len = snapshot_len - pReq->offset;
+      if(len > mtu - 1) {
+         len = mtu - 1;
+      }
+      gecko_cmd_gatt_server_send_user_read_response(pReq->connection, pReq->characteristic,
+                                                    bg_err_success, len, &snapshot[pReq->offset]);
+      ConnAddBytes(pReq->connection, 0, len);
+      return;
+   }
+#endif
+#ifdef gattdb_log_levels
+   if(pReq->characteristic == gattdb_log_levels) {
+      uint8_t levels[LOG_MODULES];
+      int i;
+
+      for(i = 0; i < LOG_MODULES; i++) {
+         levels[i] = LogGetLevel(i);
+      }
+      gecko_cmd_gatt_server_send_user_read_response(pReq->connection, pReq->characteristic,
+                                                    bg_err_success, LOG_MODULES, levels);
+      return;
+   }
+#endif
 
-      case gecko_evt_gatt_server_user_write_request_id:
-         if(pEvt->data.evt_gatt_server_user_write_request.characteristic == gattdb_ota_control) {
-            /* Set flag to enter to OTA mode */
-            boot_to_dfu = 1;
-            /* Send response to Write Request */
-            gecko_cmd_gatt_server_send_user_write_response(
-                                                          pEvt->data.evt_gatt_server_user_write_request.connection,
-                                                          gattdb_ota_control,
-                                                          bg_err_success);
-
-            /* Close connection to enter to DFU OTA mode */
-            gecko_cmd_le_connection_close(pEvt->data.evt_gatt_server_user_write_request.connection);
-         }
-         break;
+   gecko_cmd_gatt_server_send_user_read_response(pReq->connection, pReq->characteristic,
+                                                 ATT_ERROR(bg_err_att_read_not_permitted), 0, NULL);
+}
 
-      case gecko_evt_mesh_proxy_connected_id:
-      case gecko_evt_mesh_proxy_disconnected_id:
-         handle_mesh_proxy_events(pEvt);
-         break;
+/***************************************************************************//**
+ * Handling of external signals raised from interrupt handlers.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_external_signal(struct gecko_cmd_packet *pEvt)
+{
+#ifdef DARWIN_CONSOLE
+   if(pEvt->data.evt_system_external_signal.extsignals & EXT_SIGNAL_CONSOLE_RX) {
+      ConsolePoll();
+   }
+#endif
+#ifdef DARWIN_HOST_PROTOCOL
+   if(pEvt->data.evt_system_external_signal.extsignals & EXT_SIGNAL_HOST_RX) {
+      host_protocol_poll();
+   }
+#endif
+}
 
-      default:
-         //LOG("unhandled evt: %8.8x class %2.2x method %2.2x\n", evt_id, (evt_id >> 16) & 0xFF, (evt_id >> 24) & 0xFF);
-         break;
+/***************************************************************************//**
+ * Handling of user characteristic writes. With an OTA data characteristic in
+ * the GATT database the image is received by the application, see ota.h.
+ * Otherwise a write to the OTA control characteristic reboots into the
+ * bootloader once the writing connection is closed, the other connections
+ * are left alone until then. The log levels are written as pairs of module
+ * (0xff for all) and level, see darwin_log.h. A write with an unknown module
+ * is refused with an out of range error and sets nothing.
+ * @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_user_write_request(struct gecko_cmd_packet *pEvt)
+{
+   struct gecko_msg_gatt_server_user_write_request_evt_t *pReq = &pEvt->data.evt_gatt_server_user_write_request;
+
+   ConnAddBytes(pReq->connection, pReq->value.len, 0);
+#ifdef gattdb_log_levels
+   if(pReq->characteristic == gattdb_log_levels) {
+      uint8_t result = bg_err_success;
+      int i;
+
+      if(pReq->value.len == 0 || (pReq->value.len & 1) != 0) {
+         result = ATT_ERROR(bg_err_att_invalid_att_length);
+      }
+      /* Check every module before setting any of them */
+      for(i = 0; result == bg_err_success && i < pReq->value.len; i += 2) {
+         if(pReq->value.data[i] != 0xff && pReq->value.data[i] >= LOG_MODULES) {
+            result = ATT_ERROR(bg_err_att_out_of_range);
+         }
+      }
+      for(i = 0; result == bg_err_success && i < pReq->value.len; i += 2) {
+         LogSetLevel(pReq->value.data[i] == 0xff ? LOG_MODULES : pReq->value.data[i], pReq->value.data[i + 1]);
+      }
+      gecko_cmd_gatt_server_send_user_write_response(pReq->connection, pReq->characteristic, result);
+      return;
    }
+#endif
+#ifdef gattdb_ota_data
+   if(pReq->characteristic == gattdb_ota_data) {
+      OtaData(pReq->value.data, pReq->value.len);
+      /* Normally written without response, answer a Write Request */
+      if(pReq->att_opcode == gatt_write_request) {
+         gecko_cmd_gatt_server_send_user_write_response(pReq->connection, gattdb_ota_data, bg_err_success);
+      }
+   }
+   else if(pReq->characteristic == gattdb_ota_control) {
+      OtaControl(pReq->connection, pReq->characteristic, pReq->value.data, pReq->value.len);
+   }
+#else
+   if(pReq->characteristic == gattdb_ota_control) {
+      /* Enter OTA mode when this connection is closed */
+      ConnRequestDfu(pReq->connection);
+      /* Send response to Write Request */
+      gecko_cmd_gatt_server_send_user_write_response(pReq->connection, gattdb_ota_control,
+                                                     bg_err_success);
+
+      /* Close connection to enter to DFU OTA mode */
+      gecko_cmd_le_connection_close(pReq->connection);
+   }
+#endif
+}
+
+/***************************************************************************//**
+ * Register the handlers of the stack events used by the application. Both
+ * Bluetooth LE and Bluetooth mesh events are handled here, events without a
+ * handler (e.g. gecko_evt_le_gap_adv_timeout_id) are silently discarded.
+ ******************************************************************************/
+static void register_event_handlers(void)
+{
+   EventDispatchRegister(gecko_evt_system_boot_id, handle_system_boot);
+   EventDispatchRegister(gecko_evt_hardware_soft_timer_id, handle_soft_timer);
+   EventDispatchRegister(gecko_evt_mesh_node_initialized_id, handle_node_initialized);
+   EventDispatchRegister(gecko_evt_mesh_node_provisioning_started_id, handle_provisioning_started);
+   EventDispatchRegister(gecko_evt_mesh_node_provisioned_id, handle_provisioned);
+   EventDispatchRegister(gecko_evt_mesh_node_provisioning_failed_id, handle_provisioning_failed);
+   EventDispatchRegister(gecko_evt_mesh_node_key_added_id, handle_key_added);
+   EventDispatchRegister(gecko_evt_mesh_node_model_config_changed_id, handle_model_config_changed);
+   EventDispatchRegister(gecko_evt_mesh_node_config_set_id, handle_config_set);
+   EventDispatchRegister(gecko_evt_mesh_generic_client_server_status_id, handle_server_status);
+   EventDispatchRegister(gecko_evt_mesh_node_reset_id, handle_node_reset);
+   EventDispatchRegister(gecko_evt_gatt_server_user_write_request_id, handle_user_write_request);
+   EventDispatchRegister(gecko_evt_gatt_server_user_read_request_id, handle_user_read_request);
+   EventDispatchRegister(gecko_evt_system_external_signal_id, handle_external_signal);
+
+   ConnInit();
+   ReqInit();
+   mesh_proxy_init();
 }
 
 /** @} (end addtogroup app) */
@@ -19,10 +19,16 @@
 #define APP_H
 
 #include <gecko_configuration.h>
+#include <native_gecko.h>
 
 #define ERR_CHK(x) Err = x->result; \
    if(Err != 0) ELOG(" failed, %d (0x%x)\n",Err,Err)
 
+/// External signal raised when console input is waiting
+#define EXT_SIGNAL_CONSOLE_RX   0x01
+/// External signal raised when host link frames are waiting
+#define EXT_SIGNAL_HOST_RX      0x02
+
 /***************************************************************************//**
  * @defgroup app Application Code
  * @brief Sample Application Implementation
@@ -44,6 +50,13 @@
  ******************************************************************************/
 void appMain(const gecko_configuration_t *pConfig);
 
+/***************************************************************************//**
+ * Set the device name in the GATT database from the Bluetooth address, called
+ * on boot. Not static so the host benchmark can time it.
+ * @param[in] pAddr  Pointer to Bluetooth address.
+ ******************************************************************************/
+void set_device_name(bd_addr *pAddr);
+
 /** @} (end addtogroup app) */
 /** @} (end addtogroup Application) */
 
@@ -0,0 +1,482 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifdef DARWIN_CONSOLE
+#include <stdlib.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "em_device.h"
+#include "app.h"
+#include "app_console.h"
+#include "event_dispatch.h"
+#include "client_queue.h"
+#include "connections.h"
+#include "scheduler.h"
+#include "state_cache.h"
+#include "ps_cache.h"
+#include "request_tracker.h"
+#include "scene_bulk.h"
+#include "ll_priority.h"
+#include "ota.h"
+#include "darwin_console.h"
+#include "darwin_log.h"
+#include "darwin_trace.h"
+#include "darwin_mem.h"
+#include "darwin_boot.h"
+#include "darwin_cmd_prof.h"
+#include "host_link.h"
+
+/***************************************************************************//**
+ * @addtogroup AppConsole
+ * @{
+ ******************************************************************************/
+
+/// Called from the USART0 interrupt, wakes up the main loop
+static void console_rx_signal(void)
+{
+   gecko_external_signal(EXT_SIGNAL_CONSOLE_RX);
+}
+
+/// Convert CPU cycles to microseconds
+static uint32_t cycles_to_us(uint32_t Cycles)
+{
+   return (uint32_t) ((uint64_t) Cycles * 1000000 / SystemCoreClockGet());
+}
+
+static void print_latency(const char *Name,const EventHandlerStats_t *pStats)
+{
+   ConsolePrintf("%-34s %8lu %8lu %8lu\n",Name,(unsigned long) pStats->Count,
+                 (unsigned long) cycles_to_us(pStats->MaxLatency),
+                 (unsigned long) cycles_to_us(EventDispatchP99(pStats)));
+}
+
+/***************************************************************************//**
+ *  lat [reset]: event loop latency per event in microseconds.
+ ******************************************************************************/
+static void cmd_latency(int Argc,char **Argv)
+{
+   const EventHandlerStats_t *pStats;
+   int Count;
+   int i;
+
+   if(Argc > 1 && strcmp(Argv[1],"reset") == 0) {
+      EventDispatchResetStats();
+      return;
+   }
+
+   pStats = EventDispatchGetStats(&Count);
+   ConsolePrintf("%-34s %8s %8s %8s\n","event","count","max us","p99 us");
+   for(i = 0; i < Count; i++) {
+      const char *Name = GeckoEventName(pStats[i].ID);
+
+      print_latency(Name != NULL ? Name : "?",&pStats[i]);
+   }
+   print_latency("(unhandled)",EventDispatchGetUnhandled());
+   ConsolePrintf("stalls > %d ms: %lu\n",EVENT_STALL_MS,(unsigned long) EventDispatchStalls());
+}
+
+/***************************************************************************//**
+ *  cq [interval ms]: client queue statistics, optionally set the flush interval.
+ ******************************************************************************/
+static void cmd_client_queue(int Argc,char **Argv)
+{
+   const ClientQueueStats_t *pStats = ClientQueueGetStats();
+
+   if(Argc > 1) {
+      ClientQueueSetInterval(strtoul(Argv[1],NULL,0));
+   }
+
+   ConsolePrintf("submitted %lu, coalesced %lu, sent %lu\n",(unsigned long) pStats->Submitted,
+                 (unsigned long) pStats->Coalesced,(unsigned long) pStats->Sent);
+   ConsolePrintf("dropped %lu, failed %lu, pending %u (max %u)\n",(unsigned long) pStats->Dropped,
+                 (unsigned long) pStats->Failed,pStats->Pending,pStats->MaxPending);
+}
+
+/***************************************************************************//**
+ *  req [window]: acknowledged requests, optionally set the window per destination.
+ ******************************************************************************/
+static void cmd_requests(int Argc,char **Argv)
+{
+   const ReqStats_t *pStats = ReqGetStats();
+
+   if(Argc > 1) {
+      ReqSetWindow(strtoul(Argv[1],NULL,0));
+   }
+
+   ConsolePrintf("sent %lu, retries %lu, acked %lu, timed out %lu\n",(unsigned long) pStats->Sent,
+                 (unsigned long) pStats->Retries,(unsigned long) pStats->Acked,(unsigned long) pStats->TimedOut);
+   ConsolePrintf("busy %lu, failed %lu, unmatched %lu, in flight %u (max %u)\n",(unsigned long) pStats->Busy,
+                 (unsigned long) pStats->Failed,(unsigned long) pStats->Unmatched,pStats->InFlight,pStats->MaxInFlight);
+   ConsolePrintf("round trip avg %lu ms, max %lu ms\n",
+                 (unsigned long) (pStats->Acked ? pStats->TotalRttMs / pStats->Acked : 0),
+                 (unsigned long) pStats->MaxRttMs);
+}
+
+static void print_scene_result(const SceneBulkResult_t *pResult)
+{
+   int i;
+
+   ConsolePrintf("scene %u: %u targets, %u acked, %u groups, %u failed, %u retries, %lu ms\n",pResult->Scene,
+                 pResult->Targets,pResult->Acked,pResult->Groups,pResult->Failed,pResult->Retries,
+                 (unsigned long) pResult->ElapsedMs);
+   for(i = 0; i < pResult->Failed; i++) {
+      ConsolePrintf("no status from 0x%04x\n",pResult->pFailed[i]);
+   }
+}
+
+/***************************************************************************//**
+ *  scene <scene> <addr>...: recall a scene on many targets, prints the result
+ *  when all are done.
+ ******************************************************************************/
+static void cmd_scene(int Argc,char **Argv)
+{
+   uint16_t Targets[CONSOLE_MAX_ARGS];
+   int i;
+
+   if(Argc < 3) {
+      ConsolePrintf("usage: scene <scene> <addr>...\n");
+      return;
+   }
+   for(i = 2; i < Argc; i++) {
+      Targets[i - 2] = strtoul(Argv[i],NULL,0);
+   }
+   if(!SceneBulkRecall(strtoul(Argv[1],NULL,0),0,Targets,Argc - 2,print_scene_result)) {
+      ConsolePrintf("a scene recall is running\n");
+   }
+}
+
+/***************************************************************************//**
+ *  ll [auto|<profile>]: link layer priority profiles, optionally select one.
+ ******************************************************************************/
+static void cmd_link_layer(int Argc,char **Argv)
+{
+   int i;
+
+   if(Argc > 1) {
+      if(strcmp(Argv[1],"auto") == 0) {
+         LlPrioAuto();
+      }
+      for(i = 0; i < LL_PRIO_PROFILES; i++) {
+         if(strcmp(Argv[1],LlPrioName(i)) == 0) {
+            LlPrioSelect(i);
+         }
+      }
+   }
+
+   ConsolePrintf("profile %s%s\n",LlPrioName(LlPrioGetProfile()),LlPrioIsAuto() ? ", auto" : "");
+   ConsolePrintf("%-10s %8s %10s %8s %8s %8s %8s\n","profile","selected","time ms","sent","retries","timeouts",
+                 "rtt ms");
+   for(i = 0; i < LL_PRIO_PROFILES; i++) {
+      const LlPrioStats_t *p = LlPrioGetStats(i);
+
+      ConsolePrintf("%-10s %8lu %10lu %8lu %8lu %8lu %8lu\n",LlPrioName(i),(unsigned long) p->Selected,
+                    (unsigned long) p->TimeMs,(unsigned long) p->Sent,(unsigned long) p->Retries,
+                    (unsigned long) p->TimedOut,(unsigned long) (p->Acked ? p->TotalRttMs / p->Acked : 0));
+   }
+}
+
+/***************************************************************************//**
+ *  sched [slice us]: task latency per priority, optionally set the slice budget.
+ ******************************************************************************/
+static void cmd_sched(int Argc,char **Argv)
+{
+   static const char *Names[SCHED_PRIORITIES] = {"high","normal","low"};
+   const SchedStats_t *pStats = SchedGetStats();
+   int i;
+
+   if(Argc > 1) {
+      SchedSetSlice(strtoul(Argv[1],NULL,0));
+   }
+
+   ConsolePrintf("slice %lu us, overruns %lu\n",(unsigned long) cycles_to_us(pStats->SliceCycles),
+                 (unsigned long) pStats->Overruns);
+   ConsolePrintf("%-34s %8s %8s %8s\n","priority","slices","max us","p99 us");
+   for(i = 0; i < SCHED_PRIORITIES; i++) {
+      print_latency(Names[i],&pStats->Prio[i]);
+   }
+   for(i = 0; i < SCHED_PRIORITIES; i++) {
+      ConsolePrintf("longest %s slice %lu us\n",Names[i],(unsigned long) cycles_to_us(pStats->Prio[i].MaxCycles));
+   }
+}
+
+/***************************************************************************//**
+ *  state [addr model]: state cache counters, optionally look up a state.
+ ******************************************************************************/
+static void cmd_state(int Argc,char **Argv)
+{
+   const StateCacheStats_t *pStats = StateCacheGetStats();
+
+   if(Argc > 2) {
+      uint32_t AgeMs = 0;
+      const StateEntry_t *p = StateCacheGet(strtoul(Argv[1],NULL,0),0,strtoul(Argv[2],NULL,0),UINT32_MAX,&AgeMs);
+      int i;
+
+      if(p == NULL) {
+         ConsolePrintf("not cached\n");
+         return;
+      }
+      ConsolePrintf("type 0x%02x, age %lu ms, remaining %lu ms:",p->Type,(unsigned long) AgeMs,
+                    (unsigned long) p->Remaining);
+      for(i = 0; i < p->Len; i++) {
+         ConsolePrintf(" %02x",p->Params[i]);
+      }
+      ConsolePrintf("\n");
+      return;
+   }
+
+   ConsolePrintf("entries %u of %d, updates %lu, longest probe %u\n",pStats->Entries,STATE_CACHE_MAX_ENTRIES,
+                 (unsigned long) pStats->Updates,pStats->MaxProbe);
+   ConsolePrintf("hits %lu, misses %lu, stale %lu, evictions %lu\n",(unsigned long) pStats->Hits,
+                 (unsigned long) pStats->Misses,(unsigned long) pStats->Stale,(unsigned long) pStats->Evictions);
+}
+
+/***************************************************************************//**
+ *  ps [flush]: persistent store cache counters, optionally write all values.
+ ******************************************************************************/
+static void cmd_ps(int Argc,char **Argv)
+{
+   const PsCacheStats_t *pStats = PsCacheGetStats();
+
+   if(Argc > 1 && strcmp(Argv[1],"flush") == 0) {
+      PsCacheFlush();
+   }
+
+   ConsolePrintf("saves %lu, saved %lu, writes %lu, failed %lu, dirty %u\n",(unsigned long) pStats->Saves,
+                 (unsigned long) pStats->Saved,(unsigned long) pStats->Writes,(unsigned long) pStats->Failed,
+                 pStats->Dirty);
+   ConsolePrintf("loads %lu, hits %lu, longest write %lu us\n",(unsigned long) pStats->Loads,
+                 (unsigned long) pStats->LoadHits,(unsigned long) cycles_to_us(pStats->MaxFlushCycles));
+}
+
+/***************************************************************************//**
+ *  conn [on|off]: open connections and counters, optionally turn the tuning on or off.
+ ******************************************************************************/
+static void cmd_connections(int Argc,char **Argv)
+{
+   const Connection_t *pConn = ConnGetTable();
+   const ConnStats_t *pStats = ConnGetStats();
+   int i;
+
+   if(Argc > 1) {
+      ConnSetTuning(strcmp(Argv[1],"on") == 0);
+   }
+
+   ConsolePrintf("opened %lu, closed %lu, rejected %lu, open %u (max %u of %d)\n",(unsigned long) pStats->Opened,
+                 (unsigned long) pStats->Closed,(unsigned long) pStats->Rejected,pStats->Active,pStats->MaxActive,
+                 MAX_CONNECTIONS);
+   ConsolePrintf("tuning %s, %lu parameter and %lu phy requests\n",ConnGetTuning() ? "on" : "off",
+                 (unsigned long) pStats->ParamRequests,(unsigned long) pStats->PhyRequests);
+   for(i = 0; i < MAX_CONNECTIONS; i++, pConn++) {
+      if(pConn->Handle == CONN_INVALID) {
+         continue;
+      }
+      ConsolePrintf("%u: mtu %u, interval %u, phy %u%s%s, in %lu, out %lu\n",pConn->Handle,pConn->Mtu,pConn->Interval,
+                    pConn->Phy,pConn->Proxy ? ", proxy" : "",pConn->Dfu ? ", dfu" : "",(unsigned long) pConn->BytesIn,
+                    (unsigned long) pConn->BytesOut);
+      ConsolePrintf("   rssi %d, %lu bytes/s (max %lu)%s\n",pConn->Rssi,(unsigned long) pConn->BytesPerSec,
+                    (unsigned long) pConn->MaxBytesPerSec,pConn->Fast ? ", fast" : "");
+   }
+}
+
+/***************************************************************************//**
+ *  ota: state and counters of the last firmware update.
+ ******************************************************************************/
+static void cmd_ota(int Argc,char **Argv)
+{
+   static const char *States[] = {"idle","receiving","verifying","installing","failed"};
+   const OtaStats_t *pStats = OtaGetStats();
+
+   ConsolePrintf("%s, %lu bytes, crc 0x%08lx, %lu blocks, %lu stalls, %lu dropped\n",States[pStats->State],
+                 (unsigned long) pStats->Size,(unsigned long) pStats->Crc,(unsigned long) pStats->Blocks,
+                 (unsigned long) pStats->Stalls,(unsigned long) pStats->Dropped);
+   ConsolePrintf("received in %lu ms, verified in %lu ms, longest slice %lu us\n",(unsigned long) pStats->ReceiveMs,
+                 (unsigned long) pStats->VerifyMs,(unsigned long) cycles_to_us(pStats->MaxSliceCycles));
+}
+
+/***************************************************************************//**
+ *  log [module|all level]: compiled and runtime log levels, optionally set the
+ *  runtime level of a module.
+ ******************************************************************************/
+static void cmd_log(int Argc,char **Argv)
+{
+   int i;
+
+   if(Argc > 2) {
+      int Module = LogFindModule(Argv[1]);
+      int Level = LogFindLevel(Argv[2]);
+
+      if(Module < 0 || Level < 0) {
+         ConsolePrintf("unknown module or level\n");
+         return;
+      }
+      LogSetLevel(Module,Level);
+   }
+
+   for(i = 0; i < LOG_MODULES; i++) {
+      ConsolePrintf("%-8s %-5s (compiled %s)\n",LogModuleName(i),LogLevelName(LogGetLevel(i)),
+                    LogLevelName(LogGetCompiledLevel(i)));
+   }
+}
+
+#ifdef DARWIN_MEM
+/***************************************************************************//**
+ *  mem: RAM high-watermarks of the painted regions.
+ ******************************************************************************/
+static void cmd_mem(int Argc,char **Argv)
+{
+   MemUsage_t Usage[MEM_MAX_REGIONS];
+   int Count = MemGetUsage(Usage,MEM_MAX_REGIONS);
+   int i;
+
+   for(i = 0; i < Count; i++) {
+      ConsolePrintf("%-10s %6lu of %6lu bytes, %6lu free\n",Usage[i].Name,(unsigned long) Usage[i].Used,
+                    (unsigned long) Usage[i].Size,(unsigned long) (Usage[i].Size - Usage[i].Used));
+   }
+}
+#endif
+
+#ifdef DARWIN_BOOT
+/***************************************************************************//**
+ *  boot: boot phase times of this and the previous boot.
+ ******************************************************************************/
+static void cmd_boot(int Argc,char **Argv)
+{
+   int Last;
+
+   for(Last = 0; Last < 2; Last++) {
+      const BootRecord_t *p = BootGetRecord(Last);
+      uint32_t Start = 0;
+      int i;
+
+      if(p == NULL) {
+         ConsolePrintf("no record of the last boot\n");
+         continue;
+      }
+      ConsolePrintf("%s boot %lu, reset cause 0x%lx%s\n",Last ? "last" : "this",(unsigned long) p->Boots,
+                    (unsigned long) p->ResetCause,p->FastBoot ? ", fast boot" : "");
+      for(i = 0; i < BOOT_PHASES; i++) {
+         if(p->EndUs[i] == 0) {
+            // not reached
+            break;
+         }
+         ConsolePrintf("  %-5s %8lu us, done at %8lu us\n",BootPhaseName(i),(unsigned long) (p->EndUs[i] - Start),
+                       (unsigned long) p->EndUs[i]);
+         Start = p->EndUs[i];
+      }
+   }
+}
+#endif
+
+#ifdef DARWIN_CMD_PROF
+/***************************************************************************//**
+ *  cmd [reset]: time the stack took for each BGAPI command, * marks the
+ *  last of the commands without an entry.
+ ******************************************************************************/
+static void cmd_commands(int Argc,char **Argv)
+{
+   const CmdProfStats_t *Stats[48];
+   int Count;
+   int i;
+
+   if(Argc > 1 && strcmp(Argv[1],"reset") == 0) {
+      CmdProfReset();
+      return;
+   }
+
+   Count = CmdProfGet(Stats,48);
+   ConsolePrintf("command                            count   min us   avg us   max us\n");
+   for(i = 0; i < Count; i++) {
+      const CmdProfStats_t *p = Stats[i];
+
+      ConsolePrintf("%-32s%s %7lu %8lu %8lu %8lu\n",CmdProfName(p),p == CmdProfOther() ? "*" : " ",
+                    (unsigned long) p->Count,(unsigned long) cycles_to_us(p->MinCycles),
+                    (unsigned long) cycles_to_us((uint32_t) (p->TotalCycles / p->Count)),
+                    (unsigned long) cycles_to_us(p->MaxCycles));
+   }
+}
+#endif
+
+#ifdef DARWIN_HOST_PROTOCOL
+/***************************************************************************//**
+ *  host: host link frame counters.
+ ******************************************************************************/
+static void cmd_host(int Argc,char **Argv)
+{
+   const HostLinkStats_t *pStats = HostLinkGetStats();
+
+   ConsolePrintf("rx %lu, tx %lu, crc errors %lu, skipped %lu, tx dropped %lu\n",(unsigned long) pStats->RxFrames,
+                 (unsigned long) pStats->TxFrames,(unsigned long) pStats->CrcErrors,(unsigned long) pStats->Skipped,
+                 (unsigned long) pStats->TxDropped);
+}
+#endif
+
+#ifdef DARWIN_TRACE
+/***************************************************************************//**
+ *  trace [dump|clear]: event trace status, binary dump or discard.
+ ******************************************************************************/
+static void cmd_trace(int Argc,char **Argv)
+{
+   TraceStatus_t Status;
+
+   if(Argc > 1 && strcmp(Argv[1],"dump") == 0) {
+#ifdef DARWIN_HOST_PROTOCOL
+      // the raw dump would break the framing of the host link
+      ConsolePrintf("not available with the host protocol\n");
+#else
+      // binary stream, read it with tools/darwin_trace.py
+      TraceDump();
+#endif
+      return;
+   }
+   if(Argc > 1 && strcmp(Argv[1],"clear") == 0) {
+      TraceClear();
+   }
+
+   TraceGetStatus(&Status);
+   ConsolePrintf("records %lu, lost %lu, ram %lu bytes, flash %lu bytes%s\n",(unsigned long) Status.Records,
+                 (unsigned long) Status.Lost,(unsigned long) Status.RamUsed,(unsigned long) Status.FlashUsed,
+                 Status.Dumping ? ", dumping" : "");
+}
+#endif
+
+void app_console_init(void)
+{
+   ConsoleInit(console_rx_signal);
+   ConsoleRegister("lat",cmd_latency,"[reset] event loop latency");
+   ConsoleRegister("cq",cmd_client_queue,"[interval ms] client queue");
+   ConsoleRegister("req",cmd_requests,"[window] acknowledged requests");
+   ConsoleRegister("ll",cmd_link_layer,"[auto|advertise|scan|connection] link layer priorities");
+   ConsoleRegister("scene",cmd_scene,"<scene> <addr>... bulk scene recall");
+   ConsoleRegister("sched",cmd_sched,"[slice us] background tasks");
+   ConsoleRegister("state",cmd_state,"[addr model] state cache");
+   ConsoleRegister("ps",cmd_ps,"[flush] persistent store cache");
+   ConsoleRegister("conn",cmd_connections,"[on|off] open connections, interval and phy tuning");
+   ConsoleRegister("ota",cmd_ota,"firmware update");
+   ConsoleRegister("log",cmd_log,"[module|all none|error|info|trace] log levels");
+#ifdef DARWIN_MEM
+   ConsoleRegister("mem",cmd_mem,"RAM high-watermarks");
+#endif
+#ifdef DARWIN_BOOT
+   ConsoleRegister("boot",cmd_boot,"boot phase times");
+#endif
+#ifdef DARWIN_CMD_PROF
+   ConsoleRegister("cmd",cmd_commands,"[reset] BGAPI command times");
+#endif
+#ifdef DARWIN_HOST_PROTOCOL
+   ConsoleRegister("host",cmd_host,"host link counters");
+#endif
+#ifdef DARWIN_TRACE
+   ConsoleRegister("trace",cmd_trace,"[dump|clear] event trace");
+#endif
+}
+
+/** @} (end addtogroup AppConsole) */
+#endif   // DARWIN_CONSOLE
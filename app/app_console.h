@@ -0,0 +1,34 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef APP_CONSOLE_H
+#define APP_CONSOLE_H
+
+/***************************************************************************//**
+ * \defgroup AppConsole
+ * \brief Runtime query commands of the gateway on the UART console.
+ *
+ * Only built when DARWIN_CONSOLE is defined.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup AppConsole
+ * @{
+ ******************************************************************************/
+
+/***************************************************************************//**
+ *  Start the console and register the application commands.
+ ******************************************************************************/
+void app_console_init(void);
+
+/** @} (end addtogroup AppConsole) */
+
+#endif /* APP_CONSOLE_H */
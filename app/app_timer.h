@@ -61,7 +61,15 @@ typedef enum {
   FACTORY_RESET_TIMER,
   /** Provisioning timer.
    *  This is an auto-reload timer used for LED blinking during provisioning. */
-  PROVISIONING_TIMER
+  PROVISIONING_TIMER,
+  /** Client queue timer.
+   *  This is an auto-reload timer that limits the rate of generic client
+   *  requests, see client_queue.h. */
+  CLIENT_QUEUE_TIMER,
+  /** Timer wheel timer.
+   *  This is an auto-reload timer that drives all timers of the timer
+   *  wheel, see timer_wheel.h. */
+  TIMER_WHEEL_TIMER
 } appTimer_t;
 
 /** @} (end addtogroup app) */
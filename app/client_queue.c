@@ -0,0 +1,205 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "client_queue.h"
+#include "request_tracker.h"
+#include "app_timer.h"
+#define LOG_MODULE   CQ
+#include "darwin_log.h"
+
+/***************************************************************************//**
+ * @addtogroup ClientQueue
+ * @{
+ ******************************************************************************/
+
+typedef struct {
+   bool Used;
+   uint8_t Type;
+   uint8_t Len;
+   uint16_t Address;
+   uint16_t ModelID;
+   uint32_t Order;         ///< Submission order of the first pending value
+   uint32_t Transition;
+   uint8_t Params[CLIENT_QUEUE_MAX_PARAMS];
+} ClientRequest_t;
+
+static ClientRequest_t Queue[CLIENT_QUEUE_SIZE];
+static ClientQueueStats_t Stats;
+static uint32_t NextOrder;
+static uint32_t IntervalTicks = TIMER_MS_2_TIMERTICK(CLIENT_QUEUE_INTERVAL_MS);
+static bool TimerRunning;
+
+static void StartTimer(bool Start)
+{
+   gecko_cmd_hardware_set_soft_timer(Start ? IntervalTicks : TIMER_STOP,CLIENT_QUEUE_TIMER,REPEATING);
+   TimerRunning = Start;
+}
+
+void ClientQueueInit(void)
+{
+   memset(Queue,0,sizeof(Queue));
+   memset(&Stats,0,sizeof(Stats));
+   if(TimerRunning) {
+      StartTimer(false);
+   }
+}
+
+static ClientRequest_t *Find(uint16_t Address,uint16_t ModelID,uint8_t Type)
+{
+   ClientRequest_t *pFree = NULL;
+   int i;
+
+   for(i = 0; i < CLIENT_QUEUE_SIZE; i++) {
+      ClientRequest_t *p = &Queue[i];
+
+      if(!p->Used) {
+         if(pFree == NULL) {
+            pFree = p;
+         }
+      }
+      else if(p->Address == Address && p->ModelID == ModelID && p->Type == Type) {
+         return p;
+      }
+   }
+   return pFree;
+}
+
+bool ClientQueueSet(uint16_t Address,uint16_t ModelID,uint8_t Type,uint32_t Transition,
+                    const uint8_t *pParams,uint8_t Len)
+{
+   ClientRequest_t *p;
+
+   Stats.Submitted++;
+   if(Len > CLIENT_QUEUE_MAX_PARAMS || (p = Find(Address,ModelID,Type)) == NULL) {
+      Stats.Dropped++;
+      return false;
+   }
+
+   if(p->Used) {
+      // keep the place in the queue, only the latest value is sent
+      Stats.Coalesced++;
+   }
+   else {
+      p->Used = true;
+      p->Address = Address;
+      p->ModelID = ModelID;
+      p->Type = Type;
+      p->Order = NextOrder++;
+      if(++Stats.Pending > Stats.MaxPending) {
+         Stats.MaxPending = Stats.Pending;
+      }
+   }
+   p->Transition = Transition;
+   p->Len = Len;
+   memcpy(p->Params,pParams,Len);
+
+   if(!TimerRunning) {
+      // nothing was sent within the last interval, no need to wait
+      ClientQueueFlush();
+   }
+   return true;
+}
+
+bool ClientQueueOnOff(uint16_t Address,uint8_t OnOff,uint32_t Transition)
+{
+   return ClientQueueSet(Address,MESH_GENERIC_ON_OFF_CLIENT_MODEL_ID,mesh_generic_request_on_off,
+                         Transition,&OnOff,1);
+}
+
+bool ClientQueueLightness(uint16_t Address,uint16_t Lightness,uint32_t Transition)
+{
+   uint8_t Params[2] = {Lightness,Lightness >> 8};
+
+   return ClientQueueSet(Address,MESH_LIGHTING_LIGHTNESS_CLIENT_MODEL_ID,
+                         mesh_lighting_request_lightness_actual,Transition,Params,sizeof(Params));
+}
+
+bool ClientQueueCtl(uint16_t Address,uint16_t Lightness,uint16_t Temperature,int16_t DeltaUv,
+                    uint32_t Transition)
+{
+   uint8_t Params[6] = {
+      Lightness,Lightness >> 8,
+      Temperature,Temperature >> 8,
+      (uint16_t) DeltaUv,(uint16_t) DeltaUv >> 8
+   };
+
+   return ClientQueueSet(Address,MESH_LIGHTING_CTL_CLIENT_MODEL_ID,mesh_lighting_request_ctl,
+                         Transition,Params,sizeof(Params));
+}
+
+/// Oldest entry whose destination takes another request
+static ClientRequest_t *Oldest(void)
+{
+   ClientRequest_t *pOldest = NULL;
+   int i;
+
+   for(i = 0; i < CLIENT_QUEUE_SIZE; i++) {
+      if(Queue[i].Used && (pOldest == NULL || (int32_t) (Queue[i].Order - pOldest->Order) < 0)
+         && ReqWindowOpen(Queue[i].Address)) {
+         pOldest = &Queue[i];
+      }
+   }
+   return pOldest;
+}
+
+void ClientQueueFlush(void)
+{
+   ClientRequest_t *p;
+   uint16_t Result;
+   int Sent;
+
+   for(Sent = 0; Sent < CLIENT_QUEUE_BURST && (p = Oldest()) != NULL; Sent++) {
+      Result = ReqGenericSet(p->Address,p->ModelID,p->Type,p->Transition,p->Params,p->Len);
+      if(Result == bg_err_out_of_memory) {
+         // the stack is busy, try again with the next flush
+         break;
+      }
+      if(Result != bg_err_success) {
+         ELOG("mesh_generic_client_set to 0x%04x failed: 0x%x\n",p->Address,Result);
+         Stats.Failed++;
+      }
+      else {
+         Stats.Sent++;
+      }
+      p->Used = false;
+      Stats.Pending--;
+   }
+
+   // the timer keeps running one interval after the last transmission to
+   // limit the rate, then stops so a single request is sent right away
+   if(Sent != 0 || Stats.Pending != 0) {
+      if(!TimerRunning) {
+         StartTimer(true);
+      }
+   }
+   else if(TimerRunning) {
+      StartTimer(false);
+   }
+}
+
+void ClientQueueSetInterval(uint32_t IntervalMs)
+{
+   IntervalTicks = TIMER_MS_2_TIMERTICK(IntervalMs);
+   if(IntervalTicks == 0) {
+      IntervalTicks = 1;
+   }
+   if(TimerRunning) {
+      StartTimer(true);
+   }
+}
+
+const ClientQueueStats_t *ClientQueueGetStats(void)
+{
+   return &Stats;
+}
+
+/** @} (end addtogroup ClientQueue) */
@@ -0,0 +1,114 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef CLIENT_QUEUE_H
+#define CLIENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+#include "mesh_generic_model_capi_types.h"
+
+/***************************************************************************//**
+ * \defgroup ClientQueue
+ * \brief Coalescing queue for generic on/off, lightness and CTL set requests.
+ *
+ * Requests are not sent when they are submitted. Only the latest value per
+ * destination address, model and state is kept, so a burst of intermediate
+ * values (e.g. from a dimmer slider) becomes a single transmission. Requests
+ * to a group address are keyed by the group, one queued entry reaches all
+ * members no matter how many times the group was set.
+ *
+ * The queue is drained in submission order by the CLIENT_QUEUE_TIMER soft
+ * timer, at most CLIENT_QUEUE_BURST requests per flush interval. Requests
+ * are sent through the RequestTracker, entries for a destination whose
+ * window of outstanding requests is full wait while later entries for other
+ * destinations go ahead.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup ClientQueue
+ * @{
+ ******************************************************************************/
+
+/// Maximum number of pending (address, model, state) entries
+#ifndef CLIENT_QUEUE_SIZE
+#define CLIENT_QUEUE_SIZE           32
+#endif
+
+/// Default time between flushes
+#ifndef CLIENT_QUEUE_INTERVAL_MS
+#define CLIENT_QUEUE_INTERVAL_MS    50
+#endif
+
+/// Requests sent per flush
+#ifndef CLIENT_QUEUE_BURST
+#define CLIENT_QUEUE_BURST          2
+#endif
+
+/// Application key used for the requests
+#ifndef CLIENT_QUEUE_APPKEY_INDEX
+#define CLIENT_QUEUE_APPKEY_INDEX   0
+#endif
+
+/// Largest request parameter block (CTL: lightness, temperature, delta UV)
+#define CLIENT_QUEUE_MAX_PARAMS     6
+
+/// Queue statistics
+typedef struct {
+   uint32_t Submitted;  ///< Requests submitted
+   uint32_t Coalesced;  ///< Requests that replaced a pending value
+   uint32_t Sent;       ///< Requests sent to the stack
+   uint32_t Dropped;    ///< Requests rejected because the queue was full
+   uint32_t Failed;     ///< Requests the stack refused
+   uint16_t Pending;    ///< Entries waiting in the queue
+   uint16_t MaxPending; ///< Highest number of waiting entries
+} ClientQueueStats_t;
+
+/***************************************************************************//**
+ *  Clear the queue.
+ ******************************************************************************/
+void ClientQueueInit(void);
+
+/***************************************************************************//**
+ *  Queue a generic client set request.
+ *
+ *  @param[in] Address     Unicast or group destination address.
+ *  @param[in] ModelID     Client model, e.g. MESH_LIGHTING_CTL_CLIENT_MODEL_ID.
+ *  @param[in] Type        Request type, e.g. mesh_lighting_request_ctl.
+ *  @param[in] Transition  Transition time in ms.
+ *  @param[in] pParams     Request parameters.
+ *  @param[in] Len         Length of the parameters.
+ *  @return false if the queue is full or the parameters are too long.
+ ******************************************************************************/
+bool ClientQueueSet(uint16_t Address,uint16_t ModelID,uint8_t Type,uint32_t Transition,
+                    const uint8_t *pParams,uint8_t Len);
+
+bool ClientQueueOnOff(uint16_t Address,uint8_t OnOff,uint32_t Transition);
+bool ClientQueueLightness(uint16_t Address,uint16_t Lightness,uint32_t Transition);
+bool ClientQueueCtl(uint16_t Address,uint16_t Lightness,uint16_t Temperature,int16_t DeltaUv,
+                    uint32_t Transition);
+
+/***************************************************************************//**
+ *  Send the oldest pending requests, called when CLIENT_QUEUE_TIMER expires.
+ ******************************************************************************/
+void ClientQueueFlush(void);
+
+/***************************************************************************//**
+ *  Change the flush interval.
+ ******************************************************************************/
+void ClientQueueSetInterval(uint32_t IntervalMs);
+
+const ClientQueueStats_t *ClientQueueGetStats(void);
+
+/** @} (end addtogroup ClientQueue) */
+
+#endif /* CLIENT_QUEUE_H */
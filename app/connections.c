@@ -0,0 +1,380 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "em_rtcc.h"
+#include "connections.h"
+#include "event_dispatch.h"
+#include "timer_wheel.h"
+#include "ps_cache.h"
+#define LOG_MODULE   CONN
+#include "darwin_log.h"
+
+/***************************************************************************//**
+ * @addtogroup Connections
+ * @{
+ ******************************************************************************/
+
+static Connection_t Table[MAX_CONNECTIONS];
+/// Open order of the entries, to find the newest connection
+static uint32_t Order[MAX_CONNECTIONS];
+static uint32_t NextOrder;
+static ConnStats_t Stats;
+static bool Tuning = true;
+static Timer_t TuneTimer;
+
+static void Clear(Connection_t *p)
+{
+   memset(p,0,sizeof(*p));
+   p->Handle = CONN_INVALID;
+}
+
+Connection_t *ConnFind(uint8_t Handle)
+{
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      if(Table[i].Handle == Handle && Handle != CONN_INVALID) {
+         return &Table[i];
+      }
+   }
+   return NULL;
+}
+
+static void SetInterval(Connection_t *p,bool Fast)
+{
+   uint16_t Result;
+
+   if(Fast) {
+      Result = gecko_cmd_le_connection_set_parameters(p->Handle,CONN_FAST_MIN_INTERVAL,CONN_FAST_MAX_INTERVAL,0,
+                                                      CONN_SUPERVISION_TIMEOUT)->result;
+   }
+   else {
+      Result = gecko_cmd_le_connection_set_parameters(p->Handle,CONN_IDLE_MIN_INTERVAL,CONN_IDLE_MAX_INTERVAL,0,
+                                                      CONN_SUPERVISION_TIMEOUT)->result;
+   }
+   if(Result != bg_err_success) {
+      ELOG("connection %d parameters failed: 0x%x\n",p->Handle,Result);
+      return;
+   }
+   p->Fast = Fast;
+   Stats.ParamRequests++;
+}
+
+static void Tune(Timer_t *pTimer)
+{
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      Connection_t *p = &Table[i];
+      uint32_t Bytes = p->BytesIn + p->BytesOut;
+
+      if(p->Handle == CONN_INVALID) {
+         continue;
+      }
+      p->BytesPerSec = (uint32_t) ((uint64_t) (Bytes - p->PeriodBytes) * 1000 / CONN_TUNE_PERIOD_MS);
+      if(p->BytesPerSec > p->MaxBytesPerSec) {
+         p->MaxBytesPerSec = p->BytesPerSec;
+      }
+
+      if(Bytes != p->PeriodBytes || p->Activity != 0) {
+         p->IdlePeriods = 0;
+      }
+      else if(p->IdlePeriods < CONN_IDLE_PERIODS) {
+         p->IdlePeriods++;
+      }
+      if(Tuning && p->IdlePeriods == 0 && !p->Fast) {
+         SetInterval(p,true);
+      }
+      else if(Tuning && p->IdlePeriods == CONN_IDLE_PERIODS && p->Fast) {
+         SetInterval(p,false);
+      }
+      p->PeriodBytes = Bytes;
+      p->Activity = 0;
+
+      // the PHY is chosen when the reading arrives
+      gecko_cmd_le_connection_get_rssi(p->Handle);
+   }
+}
+
+static void HandleOpened(struct gecko_cmd_packet *pEvt)
+{
+   uint8_t Handle = pEvt->data.evt_le_connection_opened.connection;
+   Connection_t *p;
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS && Table[i].Handle != CONN_INVALID; i++);
+   if(i == MAX_CONNECTIONS) {
+      // the stack is configured for more connections than the table holds
+      ELOG("no entry for connection %d, closing it\n",Handle);
+      Stats.Rejected++;
+      gecko_cmd_le_connection_close(Handle);
+      return;
+   }
+   p = &Table[i];
+
+   Clear(p);
+   p->Handle = Handle;
+   p->Phy = 1;
+   p->Mtu = CONN_DEFAULT_MTU;
+   p->OpenedAt = RTCC_CounterGet();
+   // busy until the first tuning pass shows otherwise
+   p->Activity = 1;
+   Order[i] = NextOrder++;
+
+   Stats.Opened++;
+   if(++Stats.Active > Stats.MaxActive) {
+      Stats.MaxActive = Stats.Active;
+   }
+   LOG("connection %d opened, %d open\n",Handle,Stats.Active);
+
+   if(!TimerIsArmed(&TuneTimer)) {
+      TimerStart(&TuneTimer,CONN_TUNE_PERIOD_MS,CONN_TUNE_PERIOD_MS,Tune,NULL);
+   }
+}
+
+static void HandleClosed(struct gecko_cmd_packet *pEvt)
+{
+   uint8_t Handle = pEvt->data.evt_le_connection_closed.connection;
+   Connection_t *p = ConnFind(Handle);
+   bool Dfu;
+
+   LOG("connection %d closed, reason 0x%x\n",Handle,pEvt->data.evt_le_connection_closed.reason);
+   if(p == NULL) {
+      return;
+   }
+
+   Dfu = p->Dfu;
+   Clear(p);
+   Stats.Closed++;
+   if(--Stats.Active == 0) {
+      TimerStop(&TuneTimer);
+   }
+
+   if(Dfu) {
+      // the OTA client closed its connection, enter DFU OTA mode
+      PsCacheFlush();
+      gecko_cmd_system_reset(2);
+   }
+}
+
+static void HandleParameters(struct gecko_cmd_packet *pEvt)
+{
+   struct gecko_msg_le_connection_parameters_evt_t *pParams = &pEvt->data.evt_le_connection_parameters;
+   Connection_t *p = ConnFind(pParams->connection);
+
+   LOG("connection %d params: interval %d, timeout %d\n",pParams->connection,pParams->interval,
+       pParams->timeout);
+   if(p != NULL) {
+      p->Interval = pParams->interval;
+      p->Latency = pParams->latency;
+      p->Timeout = pParams->timeout;
+   }
+}
+
+static void HandleMtu(struct gecko_cmd_packet *pEvt)
+{
+   Connection_t *p = ConnFind(pEvt->data.evt_gatt_mtu_exchanged.connection);
+
+   if(p != NULL) {
+      p->Mtu = pEvt->data.evt_gatt_mtu_exchanged.mtu;
+   }
+}
+
+static void HandlePhy(struct gecko_cmd_packet *pEvt)
+{
+   Connection_t *p = ConnFind(pEvt->data.evt_le_connection_phy_status.connection);
+
+   if(p != NULL) {
+      p->Phy = pEvt->data.evt_le_connection_phy_status.phy;
+      LOG("connection %d phy %d\n",p->Handle,p->Phy);
+   }
+}
+
+/// Asks for a PHY once, a peer that refuses 2M is not asked again until the
+/// RSSI dropped below CONN_1M_RSSI
+static void RequestPhy(Connection_t *p,uint8_t Phy)
+{
+   uint16_t Result;
+
+   if(p->Phy == Phy || p->PhyRequested == Phy) {
+      return;
+   }
+   Result = gecko_cmd_le_connection_set_phy(p->Handle,Phy)->result;
+   if(Result != bg_err_success) {
+      ELOG("connection %d phy %d failed: 0x%x\n",p->Handle,Phy,Result);
+      return;
+   }
+   p->PhyRequested = Phy;
+   Stats.PhyRequests++;
+}
+
+static void HandleRssi(struct gecko_cmd_packet *pEvt)
+{
+   struct gecko_msg_le_connection_rssi_evt_t *pRssi = &pEvt->data.evt_le_connection_rssi;
+   Connection_t *p = ConnFind(pRssi->connection);
+
+   if(p == NULL || pRssi->status != 0) {
+      return;
+   }
+   p->Rssi = pRssi->rssi;
+   if(!Tuning) {
+      return;
+   }
+   if(p->Rssi >= CONN_2M_RSSI) {
+      RequestPhy(p,2);
+   }
+   else if(p->Rssi < CONN_1M_RSSI) {
+      // forget a refused 2M request, it is made again once the signal is back
+      if(p->PhyRequested == 2) {
+         p->PhyRequested = 0;
+      }
+      RequestPhy(p,1);
+   }
+}
+
+/// Writes to attributes the stack handles itself, e.g. the mesh proxy data in
+static void HandleAttributeValue(struct gecko_cmd_packet *pEvt)
+{
+   struct gecko_msg_gatt_server_attribute_value_evt_t *pValue = &pEvt->data.evt_gatt_server_attribute_value;
+   Connection_t *p = ConnFind(pValue->connection);
+
+   if(p != NULL) {
+      p->BytesIn += pValue->value.len;
+      p->Activity++;
+   }
+}
+
+void ConnInit(void)
+{
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      Clear(&Table[i]);
+   }
+   memset(&Stats,0,sizeof(Stats));
+
+   EventDispatchRegister(gecko_evt_le_connection_opened_id,HandleOpened);
+   EventDispatchRegister(gecko_evt_le_connection_closed_id,HandleClosed);
+   EventDispatchRegister(gecko_evt_le_connection_parameters_id,HandleParameters);
+   EventDispatchRegister(gecko_evt_gatt_mtu_exchanged_id,HandleMtu);
+   EventDispatchRegister(gecko_evt_le_connection_phy_status_id,HandlePhy);
+   EventDispatchRegister(gecko_evt_le_connection_rssi_id,HandleRssi);
+   EventDispatchRegister(gecko_evt_gatt_server_attribute_value_id,HandleAttributeValue);
+}
+
+const Connection_t *ConnGetTable(void)
+{
+   return Table;
+}
+
+const ConnStats_t *ConnGetStats(void)
+{
+   return &Stats;
+}
+
+void ConnCloseAll(void)
+{
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      if(Table[i].Handle != CONN_INVALID) {
+         gecko_cmd_le_connection_close(Table[i].Handle);
+      }
+   }
+}
+
+void ConnAddBytes(uint8_t Handle,uint32_t In,uint32_t Out)
+{
+   Connection_t *p = ConnFind(Handle);
+
+   if(p != NULL) {
+      p->BytesIn += In;
+      p->BytesOut += Out;
+   }
+}
+
+void ConnRequestDfu(uint8_t Handle)
+{
+   Connection_t *p = ConnFind(Handle);
+
+   if(p != NULL) {
+      p->Dfu = true;
+   }
+}
+
+void ConnProxyOpened(uint32_t ProxyHandle)
+{
+   Connection_t *pNewest = NULL;
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      if(Table[i].Handle != CONN_INVALID && !Table[i].Proxy
+         && (pNewest == NULL || (int32_t) (Order[i] - Order[pNewest - Table]) > 0)) {
+         pNewest = &Table[i];
+      }
+   }
+
+   if(pNewest == NULL) {
+      ELOG("no connection for proxy 0x%lx\n",(unsigned long) ProxyHandle);
+      return;
+   }
+   pNewest->Proxy = true;
+   pNewest->ProxyHandle = ProxyHandle;
+}
+
+void ConnProxyClosed(uint32_t ProxyHandle)
+{
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      if(Table[i].Handle != CONN_INVALID && Table[i].Proxy && Table[i].ProxyHandle == ProxyHandle) {
+         Table[i].Proxy = false;
+         return;
+      }
+   }
+}
+
+int ConnProxyCount(void)
+{
+   int Count = 0;
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      if(Table[i].Handle != CONN_INVALID && Table[i].Proxy) {
+         Count++;
+      }
+   }
+   return Count;
+}
+
+void ConnProxyActivity(void)
+{
+   int i;
+
+   for(i = 0; i < MAX_CONNECTIONS; i++) {
+      if(Table[i].Handle != CONN_INVALID && Table[i].Proxy) {
+         Table[i].Activity++;
+      }
+   }
+}
+
+void ConnSetTuning(bool On)
+{
+   Tuning = On;
+}
+
+bool ConnGetTuning(void)
+{
+   return Tuning;
+}
+
+/** @} (end addtogroup Connections) */
@@ -0,0 +1,195 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef CONNECTIONS_H
+#define CONNECTIONS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+
+/***************************************************************************//**
+ * \defgroup Connections
+ * \brief State of the open LE connections.
+ *
+ * One table entry per connection holds its handle, the negotiated MTU,
+ * connection parameters and PHY and the ATT bytes exchanged by the
+ * application. The table handles the LE connection, MTU and PHY events
+ * itself.
+ *
+ * Mesh proxy connections report a proxy handle instead of the connection
+ * handle. A new proxy is attributed to the most recently opened connection
+ * that does not carry one yet.
+ *
+ * While connections are open they are tuned every CONN_TUNE_PERIOD_MS. A
+ * connection with traffic in the period gets the short CONN_FAST_ interval,
+ * after CONN_IDLE_PERIODS periods without traffic the long CONN_IDLE_
+ * interval, which leaves the radio to the mesh scanner. New connections
+ * start out as busy. Traffic is the ATT payload counted by the application,
+ * the writes to the stack's own attributes (e.g. the mesh proxy data in) and
+ * the mesh configuration messages while a proxy is open. The RSSI is read
+ * every period, the 2M PHY is requested above CONN_2M_RSSI and the 1M PHY
+ * below CONN_1M_RSSI. The ATT payload rate of the last period is kept per
+ * connection, also while the tuning is turned off.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Connections
+ * @{
+ ******************************************************************************/
+
+/// Maximum number of simultaneous LE connections, sizes the stack heap
+#ifndef MAX_CONNECTIONS
+#define MAX_CONNECTIONS    4
+#endif
+
+/// Handle of an unused table entry
+#define CONN_INVALID       0xFF
+
+/// ATT MTU before the MTU exchange
+#define CONN_DEFAULT_MTU   23
+
+/// Largest ATT MTU offered in the MTU exchange
+#ifndef CONN_MAX_MTU
+#define CONN_MAX_MTU       247
+#endif
+
+/// Time between two tuning passes
+#ifndef CONN_TUNE_PERIOD_MS
+#define CONN_TUNE_PERIOD_MS   1000
+#endif
+
+/// Connection interval with traffic, in 1.25 ms units
+#ifndef CONN_FAST_MIN_INTERVAL
+#define CONN_FAST_MIN_INTERVAL   6
+#define CONN_FAST_MAX_INTERVAL   12
+#endif
+
+/// Connection interval when idle, in 1.25 ms units
+#ifndef CONN_IDLE_MIN_INTERVAL
+#define CONN_IDLE_MIN_INTERVAL   80
+#define CONN_IDLE_MAX_INTERVAL   120
+#endif
+
+/// Supervision timeout requested with the intervals, in 10 ms units
+#ifndef CONN_SUPERVISION_TIMEOUT
+#define CONN_SUPERVISION_TIMEOUT 400
+#endif
+
+/// Tuning periods without traffic before the idle interval is requested
+#ifndef CONN_IDLE_PERIODS
+#define CONN_IDLE_PERIODS  5
+#endif
+
+/// RSSI in dBm from which the 2M PHY is requested, and below which 1M
+#ifndef CONN_2M_RSSI
+#define CONN_2M_RSSI       -70
+#define CONN_1M_RSSI       -80
+#endif
+
+/// State of one connection
+typedef struct {
+   uint8_t Handle;         ///< LE connection handle, CONN_INVALID if unused
+   uint8_t Phy;            ///< PHY in use: 1 = 1M, 2 = 2M, 4 = coded
+   bool Proxy;             ///< Carries a mesh proxy connection
+   bool Dfu;               ///< Reboot into DFU mode when this connection closes
+   uint16_t Mtu;           ///< ATT MTU
+   uint16_t Interval;      ///< Connection interval in 1.25 ms units
+   uint16_t Latency;       ///< Slave latency in connection intervals
+   uint16_t Timeout;       ///< Supervision timeout in 10 ms units
+   uint32_t ProxyHandle;   ///< Mesh proxy handle if Proxy is set
+   uint32_t BytesIn;       ///< ATT payload bytes received by the application
+   uint32_t BytesOut;      ///< ATT payload bytes sent by the application
+   uint32_t OpenedAt;      ///< RTCC ticks when the connection was opened
+   int8_t Rssi;            ///< Last RSSI reading in dBm, 0 before the first
+   uint8_t PhyRequested;   ///< PHY asked for last, 0 if none
+   bool Fast;              ///< The short interval was requested last
+   uint8_t IdlePeriods;    ///< Tuning periods in a row without traffic
+   uint32_t Activity;      ///< Stack writes and mesh messages in the period
+   uint32_t PeriodBytes;   ///< BytesIn + BytesOut at the start of the period
+   uint32_t BytesPerSec;   ///< ATT payload rate of the last period
+   uint32_t MaxBytesPerSec;
+} Connection_t;
+
+/// Connection counters
+typedef struct {
+   uint32_t Opened;        ///< Connections opened since boot
+   uint32_t Closed;        ///< Connections closed since boot
+   uint32_t Rejected;      ///< Connections closed because the table was full
+   uint32_t ParamRequests; ///< Connection interval changes requested
+   uint32_t PhyRequests;   ///< PHY changes requested
+   uint8_t Active;         ///< Open connections
+   uint8_t MaxActive;      ///< Highest number of open connections
+} ConnStats_t;
+
+/***************************************************************************//**
+ *  Clear the table and register the connection event handlers.
+ ******************************************************************************/
+void ConnInit(void);
+
+/***************************************************************************//**
+ *  Find an open connection.
+ *
+ *  @param[in] Handle  LE connection handle.
+ *  @return Table entry, NULL if the connection is not open.
+ ******************************************************************************/
+Connection_t *ConnFind(uint8_t Handle);
+
+/***************************************************************************//**
+ *  Get the table.
+ *
+ *  @return MAX_CONNECTIONS entries, unused ones have Handle == CONN_INVALID.
+ ******************************************************************************/
+const Connection_t *ConnGetTable(void);
+
+const ConnStats_t *ConnGetStats(void);
+
+/***************************************************************************//**
+ *  Close all open connections, e.g. before a factory reset.
+ ******************************************************************************/
+void ConnCloseAll(void);
+
+/***************************************************************************//**
+ *  Count ATT payload bytes handled by the application on a connection.
+ ******************************************************************************/
+void ConnAddBytes(uint8_t Handle,uint32_t In,uint32_t Out);
+
+/***************************************************************************//**
+ *  Reboot into DFU mode once the given connection is closed.
+ ******************************************************************************/
+void ConnRequestDfu(uint8_t Handle);
+
+/***************************************************************************//**
+ *  Track mesh proxy connections, called from the mesh proxy events.
+ ******************************************************************************/
+void ConnProxyOpened(uint32_t ProxyHandle);
+void ConnProxyClosed(uint32_t ProxyHandle);
+
+/// Number of open mesh proxy connections
+int ConnProxyCount(void);
+
+/***************************************************************************//**
+ *  Count a mesh message that may have come over a proxy connection as
+ *  traffic on all of them, e.g. a configuration message from a phone.
+ ******************************************************************************/
+void ConnProxyActivity(void);
+
+/***************************************************************************//**
+ *  Turn the interval and PHY tuning on or off, on by default. Connections
+ *  keep the parameters they have when it is turned off.
+ ******************************************************************************/
+void ConnSetTuning(bool On);
+
+bool ConnGetTuning(void);
+
+/** @} (end addtogroup Connections) */
+
+#endif /* CONNECTIONS_H */
@@ -0,0 +1,275 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "event_dispatch.h"
+#include "darwin_cycles.h"
+#define LOG_MODULE   DISPATCH
+#include "darwin_log.h"
+
+/***************************************************************************//**
+ * @addtogroup EventDispatch
+ * @{
+ ******************************************************************************/
+
+/// Class byte -> method page number (1 based, 0 = no handlers in this class)
+static uint8_t ClassPage[256];
+/// Method byte -> handler number (1 based, 0 = no handler)
+static uint8_t MethodPage[DISPATCH_MAX_CLASSES][DISPATCH_METHODS_PER_CLASS];
+/// Number of method pages in use
+static uint8_t NumPages;
+
+/// Registered handlers
+static EventHandler_t Handlers[DISPATCH_MAX_HANDLERS];
+/// Statistics of the registered handlers, same index as Handlers[]
+static EventHandlerStats_t Stats[DISPATCH_MAX_HANDLERS];
+/// Number of registered handlers
+static uint8_t NumHandlers;
+/// Statistics of the events without a registered handler
+static EventHandlerStats_t Unhandled;
+/// Number of events with a latency above EVENT_STALL_MS
+static uint32_t Stalls;
+/// EVENT_STALL_MS in CPU cycles
+static uint32_t StallCycles;
+
+void EventDispatchInit(void)
+{
+   memset(ClassPage,0,sizeof(ClassPage));
+   memset(MethodPage,0,sizeof(MethodPage));
+   memset(Stats,0,sizeof(Stats));
+   memset(&Unhandled,0,sizeof(Unhandled));
+   NumPages = 0;
+   NumHandlers = 0;
+   Stalls = 0;
+   StallCycles = SystemCoreClockGet() / 1000 * EVENT_STALL_MS;
+   CycleCounterInit();
+}
+
+bool EventDispatchRegister(uint32_t ID,EventHandler_t Handler)
+{
+   uint8_t Class = BGLIB_MSG_CLASS(ID);
+   uint8_t Method = BGLIB_MSG_METHOD(ID);
+   uint8_t *pSlot;
+
+   if(Handler == NULL || (ID & gecko_msg_type_evt) == 0) {
+      ELOG("0x%08lx is not an event\n",(unsigned long) ID);
+      return false;
+   }
+
+   if(Method >= DISPATCH_METHODS_PER_CLASS) {
+      ELOG("method of 0x%08lx out of range, raise DISPATCH_METHODS_PER_CLASS\n",(unsigned long) ID);
+      return false;
+   }
+
+   if(ClassPage[Class] == 0) {
+      if(NumPages == DISPATCH_MAX_CLASSES) {
+         ELOG("no page for 0x%08lx, raise DISPATCH_MAX_CLASSES\n",(unsigned long) ID);
+         return false;
+      }
+      ClassPage[Class] = ++NumPages;
+   }
+
+   pSlot = &MethodPage[ClassPage[Class] - 1][Method];
+   if(*pSlot != 0) {
+      ELOG("0x%08lx already registered\n",(unsigned long) ID);
+      return false;
+   }
+
+   if(NumHandlers == DISPATCH_MAX_HANDLERS) {
+      ELOG("no slot for 0x%08lx, raise DISPATCH_MAX_HANDLERS\n",(unsigned long) ID);
+      return false;
+   }
+
+   Handlers[NumHandlers] = Handler;
+   Stats[NumHandlers].ID = ID;
+   *pSlot = ++NumHandlers;
+
+   return true;
+}
+
+void EventRecordLatency(EventHandlerStats_t *pStats,uint32_t Latency)
+{
+   int Bucket = 32 - __CLZ(Latency >> LATENCY_HIST_SHIFT);
+   int i;
+
+   if(Bucket >= LATENCY_HIST_BUCKETS) {
+      Bucket = LATENCY_HIST_BUCKETS - 1;
+   }
+
+   if(pStats->Hist[Bucket] == UINT16_MAX) {
+      // halve the whole histogram so the distribution is kept
+      for(i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+         pStats->Hist[i] >>= 1;
+      }
+   }
+   pStats->Hist[Bucket]++;
+
+   if(Latency > pStats->MaxLatency) {
+      pStats->MaxLatency = Latency;
+   }
+}
+
+static void RecordLatency(EventHandlerStats_t *pStats,uint32_t Latency)
+{
+   EventRecordLatency(pStats,Latency);
+   if(Latency > StallCycles) {
+      Stalls++;
+   }
+}
+
+bool EventDispatch(struct gecko_cmd_packet *pEvt,uint32_t Received)
+{
+   uint32_t ID = BGLIB_MSG_ID(pEvt->header);
+   uint8_t Page = ClassPage[BGLIB_MSG_CLASS(ID)];
+   uint8_t Method = BGLIB_MSG_METHOD(ID);
+   uint8_t Index = 0;
+   uint32_t Start;
+   uint32_t Cycles;
+   EventHandlerStats_t *pStats;
+
+   if(Page != 0 && Method < DISPATCH_METHODS_PER_CLASS) {
+      Index = MethodPage[Page - 1][Method];
+   }
+
+   if(Index == 0) {
+      Unhandled.Count++;
+      RecordLatency(&Unhandled,CYCLE_COUNT() - Received);
+      return false;
+   }
+   Index--;
+
+   Start = CYCLE_COUNT();
+   Handlers[Index](pEvt);
+   Cycles = CYCLE_COUNT() - Start;
+
+   pStats = &Stats[Index];
+   pStats->Count++;
+   pStats->TotalCycles += Cycles;
+   if(Cycles > pStats->MaxCycles) {
+      pStats->MaxCycles = Cycles;
+   }
+   RecordLatency(pStats,Start + Cycles - Received);
+
+   return true;
+}
+
+const EventHandlerStats_t *EventDispatchGetStats(int *pCount)
+{
+   *pCount = NumHandlers;
+   return Stats;
+}
+
+const EventHandlerStats_t *EventDispatchGetUnhandled(void)
+{
+   return &Unhandled;
+}
+
+uint32_t EventDispatchStalls(void)
+{
+   return Stalls;
+}
+
+uint32_t EventDispatchP99(const EventHandlerStats_t *pStats)
+{
+   uint32_t Total = 0;
+   uint32_t Sum = 0;
+   int i;
+
+   for(i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+      Total += pStats->Hist[i];
+   }
+   if(Total == 0) {
+      return 0;
+   }
+
+   for(i = 0; i < LATENCY_HIST_BUCKETS - 1; i++) {
+      Sum += pStats->Hist[i];
+      if(Sum * 100 >= Total * 99) {
+         return (1UL << (i + LATENCY_HIST_SHIFT)) - 1;
+      }
+   }
+   return pStats->MaxLatency;
+}
+
+static uint8_t *PutU32(uint8_t *p,uint32_t Value)
+{
+   *p++ = Value;
+   *p++ = Value >> 8;
+   *p++ = Value >> 16;
+   *p++ = Value >> 24;
+   return p;
+}
+
+int EventDispatchSerializeStats(uint8_t *pBuf,int Size)
+{
+   uint8_t *p = pBuf;
+   int Entries = 0;
+   int i;
+
+   if(Size < 6) {
+      return 0;
+   }
+   p += 2;
+   p = PutU32(p,Stalls);
+
+   for(i = -1; i < NumHandlers && (p - pBuf) + 16 <= Size; i++) {
+      const EventHandlerStats_t *pStats = i < 0 ? &Unhandled : &Stats[i];
+
+      p = PutU32(p,pStats->ID);
+      p = PutU32(p,pStats->Count);
+      p = PutU32(p,pStats->MaxLatency);
+      p = PutU32(p,EventDispatchP99(pStats));
+      Entries++;
+   }
+
+   pBuf[0] = 1;
+   pBuf[1] = Entries;
+   return p - pBuf;
+}
+
+void EventDispatchResetStats(void)
+{
+   int i;
+
+   for(i = 0; i < NumHandlers; i++) {
+      uint32_t ID = Stats[i].ID;
+
+      memset(&Stats[i],0,sizeof(Stats[i]));
+      Stats[i].ID = ID;
+   }
+   memset(&Unhandled,0,sizeof(Unhandled));
+   Stalls = 0;
+}
+
+void EventDispatchDumpStats(void)
+{
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+   int i;
+
+   LOG_RAW("event id   count      avg cycles max cycles max latency p99 latency\n");
+   for(i = 0; i < NumHandlers; i++) {
+      uint32_t Avg = 0;
+
+      if(Stats[i].Count != 0) {
+         Avg = (uint32_t) (Stats[i].TotalCycles / Stats[i].Count);
+      }
+      LOG_RAW("%08lx %10lu %10lu %10lu %11lu %11lu\n",(unsigned long) Stats[i].ID,(unsigned long) Stats[i].Count,
+              (unsigned long) Avg,(unsigned long) Stats[i].MaxCycles,(unsigned long) Stats[i].MaxLatency,
+              (unsigned long) EventDispatchP99(&Stats[i]));
+   }
+   LOG_RAW("unhandled %lu, max latency %lu, p99 latency %lu\n",(unsigned long) Unhandled.Count,
+           (unsigned long) Unhandled.MaxLatency,(unsigned long) EventDispatchP99(&Unhandled));
+   LOG_RAW("stalls %lu\n",(unsigned long) Stalls);
+#endif
+}
+
+/** @} (end addtogroup EventDispatch) */
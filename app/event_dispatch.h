@@ -0,0 +1,164 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef EVENT_DISPATCH_H
+#define EVENT_DISPATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+#include "gecko_event_names.h"
+
+/***************************************************************************//**
+ * \defgroup EventDispatch
+ * \brief Table driven dispatch of stack events to registered handlers.
+ *
+ * Event IDs are decoded into their class and method bytes. The class byte
+ * selects a method page, the method byte selects the handler within the page,
+ * so the cost of a dispatch does not depend on the number of registered
+ * handlers. Every handler call is timed with the DWT cycle counter.
+ *
+ * Besides the handler run time, the event loop latency (from the time the
+ * event was returned by the stack until its handler finished) is recorded in
+ * a log2 histogram per event ID. Events without a handler share one
+ * histogram.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup EventDispatch
+ * @{
+ ******************************************************************************/
+
+/// Maximum number of registered event handlers
+#ifndef DISPATCH_MAX_HANDLERS
+#define DISPATCH_MAX_HANDLERS       32
+#endif
+
+/// Maximum number of BGAPI classes with at least one registered handler
+#ifndef DISPATCH_MAX_CLASSES
+#define DISPATCH_MAX_CLASSES        12
+#endif
+
+/// Number of method slots per class page, event methods must be below this
+#ifndef DISPATCH_METHODS_PER_CLASS
+#define DISPATCH_METHODS_PER_CLASS  32
+#endif
+
+/// Number of latency histogram buckets
+#define LATENCY_HIST_BUCKETS        12
+/// Bucket 0 counts latencies below 2^LATENCY_HIST_SHIFT cycles, bucket n
+/// counts [2^(n+SHIFT-1), 2^(n+SHIFT)), the last bucket counts everything above
+#define LATENCY_HIST_SHIFT          10
+
+/// Event loop latency above which an event is counted as a stall
+#ifndef EVENT_STALL_MS
+#define EVENT_STALL_MS              10
+#endif
+
+/// Event handler prototype
+typedef void (*EventHandler_t)(struct gecko_cmd_packet *pEvt);
+
+/// Per handler statistics
+typedef struct {
+   uint32_t ID;            ///< Event ID the handler is registered for
+   uint32_t Count;         ///< Number of calls
+   uint32_t MaxCycles;     ///< Worst case handler duration in CPU cycles
+   uint64_t TotalCycles;   ///< Sum of all handler durations in CPU cycles
+   uint32_t MaxLatency;    ///< Worst case event loop latency in CPU cycles
+   uint16_t Hist[LATENCY_HIST_BUCKETS];   ///< Event loop latency histogram
+} EventHandlerStats_t;
+
+/***************************************************************************//**
+ *  Clear the dispatch tables and start the cycle counter.
+ ******************************************************************************/
+void EventDispatchInit(void);
+
+/***************************************************************************//**
+ *  Register a handler for an event ID.
+ *
+ *  @param[in] ID       Event ID, e.g. gecko_evt_system_boot_id.
+ *  @param[in] Handler  Function called for every event with that ID.
+ *  @return true on success, false if the ID is not an event, is already
+ *          registered or the tables are full.
+ ******************************************************************************/
+bool EventDispatchRegister(uint32_t ID,EventHandler_t Handler);
+
+/***************************************************************************//**
+ *  Call the handler registered for an event.
+ *
+ *  @param[in] pEvt      Pointer to incoming event.
+ *  @param[in] Received  CYCLE_COUNT() when the stack returned the event.
+ *  @return true if a handler was called.
+ ******************************************************************************/
+bool EventDispatch(struct gecko_cmd_packet *pEvt,uint32_t Received);
+
+/***************************************************************************//**
+ *  Get the statistics of the registered handlers.
+ *
+ *  @param[out] pCount  Number of entries in the returned array.
+ *  @return Pointer to the statistics array, in registration order.
+ ******************************************************************************/
+const EventHandlerStats_t *EventDispatchGetStats(int *pCount);
+
+/***************************************************************************//**
+ *  Get the statistics of the events without a registered handler.
+ ******************************************************************************/
+const EventHandlerStats_t *EventDispatchGetUnhandled(void);
+
+/***************************************************************************//**
+ *  Number of events with a latency above EVENT_STALL_MS.
+ ******************************************************************************/
+uint32_t EventDispatchStalls(void);
+
+/***************************************************************************//**
+ *  Add a latency to the histogram and maximum of a statistics entry, for
+ *  other latencies kept in the same format (e.g. the scheduler's).
+ *
+ *  @param[in] pStats   Statistics entry.
+ *  @param[in] Latency  Latency in CPU cycles.
+ ******************************************************************************/
+void EventRecordLatency(EventHandlerStats_t *pStats,uint32_t Latency);
+
+/***************************************************************************//**
+ *  Estimate the 99th percentile of the event loop latency.
+ *
+ *  @param[in] pStats  Statistics of one handler.
+ *  @return Upper bound of the histogram bucket holding the 99th percentile in
+ *          CPU cycles, 0 if no events were recorded.
+ ******************************************************************************/
+uint32_t EventDispatchP99(const EventHandlerStats_t *pStats);
+
+/***************************************************************************//**
+ *  Serialize the latency statistics, e.g. for reading over GATT.
+ *
+ *  Little endian layout: u8 version, u8 entries, u32 stalls, then per entry
+ *  u32 event ID (0 for unhandled events), u32 count, u32 max latency and
+ *  u32 p99 latency in CPU cycles. Entries that do not fit are left out.
+ *
+ *  @param[out] pBuf  Output buffer.
+ *  @param[in]  Size  Size of the output buffer.
+ *  @return Number of bytes written.
+ ******************************************************************************/
+int EventDispatchSerializeStats(uint8_t *pBuf,int Size);
+
+/***************************************************************************//**
+ *  Clear call counts and latencies of all handlers.
+ ******************************************************************************/
+void EventDispatchResetStats(void);
+
+/***************************************************************************//**
+ *  Log call counts and latencies of all handlers.
+ ******************************************************************************/
+void EventDispatchDumpStats(void);
+
+/** @} (end addtogroup EventDispatch) */
+
+#endif /* EVENT_DISPATCH_H */
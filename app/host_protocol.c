@@ -0,0 +1,319 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifdef DARWIN_HOST_PROTOCOL
+#include <string.h>
+#include "native_gecko.h"
+#include "app.h"
+#include "host_protocol.h"
+#include "client_queue.h"
+#include "state_cache.h"
+#include "scene_bulk.h"
+#include "event_dispatch.h"
+#include "scheduler.h"
+#include "host_link.h"
+#include "darwin_console.h"
+#define LOG_MODULE   HOST
+#include "darwin_log.h"
+
+#ifdef DARWIN_LOG_UART
+#error "DARWIN_LOG_UART and DARWIN_HOST_PROTOCOL both use USART0"
+#endif
+
+#if HOST_PROTOCOL_WINDOW * (HOST_FRAME_MAX_PAYLOAD + HOST_FRAME_OVERHEAD) >= UART_DMA_RX_SIZE
+#error "HOST_PROTOCOL_WINDOW frames do not fit into UART_DMA_RX_SIZE"
+#endif
+
+#if HOST_PROTOCOL_QUEUE_RESERVE < HOST_PROTOCOL_WINDOW * HOST_FRAME_MAX_SETS
+#error "the sets of HOST_PROTOCOL_WINDOW frames do not fit into HOST_PROTOCOL_QUEUE_RESERVE"
+#endif
+
+#if HOST_PROTOCOL_QUEUE_RESERVE > CLIENT_QUEUE_SIZE
+#error "HOST_PROTOCOL_QUEUE_RESERVE is larger than CLIENT_QUEUE_SIZE"
+#endif
+
+/***************************************************************************//**
+ * @addtogroup HostProtocol
+ * @{
+ ******************************************************************************/
+
+/// Credits held by the host, frames received but not handled yet included
+static uint8_t host_credits;
+/// A frame was handled since the last reset
+static bool have_last;
+/// Sequence number of the last handled frame
+static uint8_t last_seq;
+/// Ack of the last handled frame, repeated for a retransmission
+static uint8_t last_ack[4 + (HOST_MAX_COMMANDS + 7) / 8];
+static int last_ack_len;
+/// Parses the received frames outside of the event handler
+static Task_t rx_task;
+
+static uint16_t get_u16(const uint8_t *p)
+{
+   return p[0] | (p[1] << 8);
+}
+
+static uint8_t *put_u16(uint8_t *p,uint16_t value)
+{
+   *p++ = value;
+   *p++ = value >> 8;
+   return p;
+}
+
+static uint8_t *put_u32(uint8_t *p,uint32_t value)
+{
+   p = put_u16(p,value);
+   return put_u16(p,value >> 16);
+}
+
+/// Answer a get from the cache or ask the server
+static bool get_state(uint16_t addr,uint16_t model,uint16_t max_age_ms)
+{
+   uint8_t buf[16 + STATE_CACHE_MAX_PARAMS];
+   const StateEntry_t *entry;
+   uint32_t age_ms;
+   bool requested;
+   uint8_t *p = buf;
+
+   entry = StateCacheQuery(addr,0,model,max_age_ms,&age_ms,&requested);
+   if(entry == NULL) {
+      return requested;
+   }
+
+   p = put_u16(p,entry->Address);
+   *p++ = entry->Element;
+   p = put_u16(p,entry->ModelID);
+   *p++ = entry->Type;
+   p = put_u32(p,age_ms);
+   p = put_u32(p,entry->Remaining);
+   memcpy(p,entry->Params,entry->Len);
+   p += entry->Len;
+   // the ack of the frame must still fit into the transmit ring
+   if(UartDmaTxFree() < (p - buf) + 2 * HOST_FRAME_OVERHEAD + (int) sizeof(last_ack)) {
+      return false;
+   }
+   return HostLinkSend(HOST_FRAME_STATE,buf,p - buf);
+}
+
+static void scene_done(const SceneBulkResult_t *result)
+{
+   uint8_t buf[HOST_FRAME_MAX_PAYLOAD];
+   uint8_t *p = buf;
+   int i;
+
+   p = put_u16(p,result->Scene);
+   p = put_u16(p,result->Targets);
+   p = put_u16(p,result->Acked);
+   p = put_u16(p,result->Groups);
+   p = put_u16(p,result->Failed);
+   p = put_u16(p,result->Retries);
+   p = put_u32(p,result->ElapsedMs);
+   for(i = 0; i < result->Failed && p + 2 <= buf + sizeof(buf); i++) {
+      p = put_u16(p,result->pFailed[i]);
+   }
+   if(!HostLinkSend(HOST_FRAME_SCENE,buf,p - buf)) {
+      ELOG("scene %d result not sent\n",result->Scene);
+   }
+}
+
+/// Start a bulk scene recall, the targets follow scene and transition
+static bool recall_scene(const uint8_t *args,uint8_t n)
+{
+   uint16_t targets[SCENE_BULK_MAX_TARGETS];
+   int count = (n - 4) / 2;
+   int i;
+
+   if(n < 6 || count > SCENE_BULK_MAX_TARGETS) {
+      return false;
+   }
+   for(i = 0; i < count; i++) {
+      targets[i] = get_u16(&args[4 + 2 * i]);
+   }
+   return SceneBulkRecall(get_u16(args),get_u16(&args[2]),targets,count,scene_done);
+}
+
+/// Called from the USART0 interrupt, wakes up the main loop
+static void host_rx_signal(void)
+{
+   gecko_external_signal(EXT_SIGNAL_HOST_RX);
+}
+
+#ifdef DARWIN_CONSOLE
+static int console_write(const void *Data,int Len)
+{
+   return HostLinkSend(HOST_FRAME_CONSOLE,Data,Len) ? Len : 0;
+}
+#endif
+
+/// Credits that can be returned now, none unless the client queue has room for
+/// the sets of all frames in flight
+static uint8_t take_credits(void)
+{
+   uint8_t credits;
+
+   if(CLIENT_QUEUE_SIZE - ClientQueueGetStats()->Pending < HOST_PROTOCOL_QUEUE_RESERVE) {
+      return 0;
+   }
+   credits = HOST_PROTOCOL_WINDOW - host_credits;
+   host_credits += credits;
+   return credits;
+}
+
+/// Run the commands of a frame, count the accepted and rejected ones and flag
+/// the rejected ones in the bitmap, returns the number of commands
+static int run_commands(const uint8_t *p,int len,uint8_t *pAccepted,uint8_t *pRejected,uint8_t *bitmap)
+{
+   int count = 0;
+   int sets = 0;
+
+   while(len >= 2 && p[1] + 2 <= len) {
+      const uint8_t *args = &p[2];
+      uint8_t n = p[1];
+      bool ok;
+
+      switch(p[0]) {
+         case HOST_OP_ON_OFF:
+            ok = sets++ < HOST_FRAME_MAX_SETS && n >= 5 && ClientQueueOnOff(get_u16(args),args[4],get_u16(&args[2]));
+            break;
+
+         case HOST_OP_LIGHTNESS:
+            ok = sets++ < HOST_FRAME_MAX_SETS && n >= 6
+                 && ClientQueueLightness(get_u16(args),get_u16(&args[4]),get_u16(&args[2]));
+            break;
+
+         case HOST_OP_CTL:
+            ok = sets++ < HOST_FRAME_MAX_SETS && n >= 10
+                 && ClientQueueCtl(get_u16(args),get_u16(&args[4]),get_u16(&args[6]),(int16_t) get_u16(&args[8]),
+                                   get_u16(&args[2]));
+            break;
+
+         case HOST_OP_GET:
+            ok = n >= 6 && get_state(get_u16(args),get_u16(&args[2]),get_u16(&args[4]));
+            break;
+
+         case HOST_OP_SCENE:
+            ok = recall_scene(args,n);
+            break;
+
+         default:
+            ok = false;
+            break;
+      }
+
+      if(ok) {
+         (*pAccepted)++;
+      }
+      else {
+         (*pRejected)++;
+         bitmap[count / 8] |= 1 << (count % 8);
+      }
+      count++;
+      p += n + 2;
+      len -= n + 2;
+   }
+   return count;
+}
+
+/// Called by the link for every received frame, the payload is in the RX ring
+static void handle_frame(uint8_t Type,uint8_t Seq,const uint8_t *pPayload,int Len)
+{
+   uint8_t credits;
+
+   if(Type == HOST_FRAME_RESET) {
+      have_last = false;
+      host_credits = 0;
+      credits = take_credits();
+      HostLinkSend(HOST_FRAME_CREDIT,&credits,1);
+      return;
+   }
+
+   if(have_last && Seq == last_seq) {
+      // retransmission, the ack got lost
+      HostLinkSend(HOST_FRAME_ACK,last_ack,last_ack_len);
+      return;
+   }
+
+   if(host_credits > 0) {
+      host_credits--;
+   }
+   else {
+      ELOG("frame %d without credit\n",Seq);
+   }
+
+   memset(last_ack,0,sizeof(last_ack));
+   last_ack[0] = Seq;
+   last_ack_len = 4;
+   switch(Type) {
+      case HOST_FRAME_COMMANDS:
+         last_ack_len += (run_commands(pPayload,Len,&last_ack[1],&last_ack[2],&last_ack[4]) + 7) / 8;
+         break;
+
+#ifdef DARWIN_CONSOLE
+      case HOST_FRAME_CONSOLE:
+         ConsoleInput((const char *) pPayload,Len);
+         break;
+#endif
+
+      default:
+         break;
+   }
+   last_ack[3] = take_credits();
+   last_seq = Seq;
+   have_last = true;
+   HostLinkSend(HOST_FRAME_ACK,last_ack,last_ack_len);
+}
+
+void host_protocol_status(struct gecko_cmd_packet *pEvt)
+{
+   uint8_t buf[HOST_FRAME_MAX_PAYLOAD];
+   int len = BGLIB_MSG_LEN(pEvt->header);
+
+   if(len + 4 > (int) sizeof(buf)) {
+      return;
+   }
+   memcpy(buf,&pEvt->header,4);
+   memcpy(&buf[4],&pEvt->data,len);
+   HostLinkSend(HOST_FRAME_EVENT,buf,len + 4);
+}
+
+static bool rx_task_run(Task_t *pTask)
+{
+   // at most HOST_PROTOCOL_WINDOW frames are waiting
+   HostLinkPoll();
+   return false;
+}
+
+void host_protocol_init(void)
+{
+   SchedTaskInit(&rx_task,rx_task_run,NULL,SCHED_PRIO_NORMAL);
+   HostLinkInit(handle_frame,host_rx_signal);
+#ifdef DARWIN_CONSOLE
+   ConsoleSetOutput(console_write);
+#endif
+}
+
+void host_protocol_poll(void)
+{
+   SchedPost(&rx_task);
+}
+
+void host_protocol_grant(void)
+{
+   uint8_t credits = take_credits();
+
+   if(credits != 0 && !HostLinkSend(HOST_FRAME_CREDIT,&credits,1)) {
+      host_credits -= credits;
+   }
+}
+
+/** @} (end addtogroup HostProtocol) */
+#endif   // DARWIN_HOST_PROTOCOL
@@ -0,0 +1,133 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef HOST_PROTOCOL_H
+#define HOST_PROTOCOL_H
+
+#include <stdint.h>
+#include "native_gecko.h"
+
+/***************************************************************************//**
+ * \defgroup HostProtocol
+ * \brief Mesh commands from the host over the framed USART0 link.
+ *
+ * Only built when DARWIN_HOST_PROTOCOL is defined. Frames are described in
+ * host_link.h, this layer defines the frame types and the flow control.
+ *
+ * Host to gateway:
+ *  - HOST_FRAME_RESET: starts a session, answered with a credit frame.
+ *  - HOST_FRAME_COMMANDS: any number of commands, each encoded as op (u8),
+ *    argument length (u8), arguments. Unknown ops are skipped.
+ *  - HOST_FRAME_CONSOLE: console command lines.
+ *
+ * Gateway to host:
+ *  - HOST_FRAME_ACK: acked sequence, accepted commands, rejected commands,
+ *    returned credits (all u8), then one bit per command of the frame in
+ *    the order of the commands, set if the command was rejected.
+ *  - HOST_FRAME_CREDIT: returned credits (u8).
+ *  - HOST_FRAME_CONSOLE: console output.
+ *  - HOST_FRAME_EVENT: BGAPI header (u32) and payload of a forwarded event.
+ *  - HOST_FRAME_STATE: a cached state answering HOST_OP_GET, address (u16),
+ *    element (u8), model (u16), state type (u8), age ms (u32), remaining
+ *    transition ms (u32), state parameters.
+ *  - HOST_FRAME_SCENE: result of HOST_OP_SCENE, scene (u16), targets (u16),
+ *    acked (u16), groups (u16), failed (u16), retries (u16), elapsed ms
+ *    (u32), the addresses of the failed targets (u16) that fit the frame.
+ *
+ * Every frame except HOST_FRAME_RESET costs the host one credit. The host
+ * starts with HOST_PROTOCOL_WINDOW credits, which is sized so that the
+ * frames in flight always fit into the UART receive ring. A credit is
+ * only returned while the client queue has room, so the host is paced by
+ * the rate at which the mesh takes the requests: a frame runs at most
+ * HOST_FRAME_MAX_SETS set commands, later ones are rejected, and a credit
+ * needs room in the queue for the sets of all frames in flight, which is
+ * HOST_PROTOCOL_QUEUE_RESERVE entries. HOST_OP_GET is answered
+ * from the state cache when the cached state is recent enough, otherwise a
+ * get request is sent and the status comes back as an event. A cached
+ * state that does not fit into the transmit ring next to the ack is
+ * rejected, the host should not put more gets into a frame than the ring
+ * takes while HOST_PROTOCOL_WINDOW frames are answered. A frame with the same
+ * sequence number as the previous one is a retransmission: its commands
+ * are not run again and the previous ack is repeated. HOST_OP_SCENE is
+ * rejected while a scene recall is running, its result frame comes when all
+ * targets are done.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup HostProtocol
+ * @{
+ ******************************************************************************/
+
+#define HOST_FRAME_RESET         0x00
+#define HOST_FRAME_COMMANDS      0x01
+#define HOST_FRAME_CONSOLE       0x02
+#define HOST_FRAME_ACK           0x80
+#define HOST_FRAME_CREDIT        0x81
+#define HOST_FRAME_EVENT         0x83
+#define HOST_FRAME_STATE         0x84
+#define HOST_FRAME_SCENE         0x85
+
+/// Set generic on/off: address (u16), transition ms (u16), on/off (u8)
+#define HOST_OP_ON_OFF           0x01
+/// Set lightness: address (u16), transition ms (u16), lightness (u16)
+#define HOST_OP_LIGHTNESS        0x02
+/// Set CTL: address (u16), transition ms (u16), lightness (u16),
+/// temperature (u16), delta UV (s16)
+#define HOST_OP_CTL              0x03
+/// Get a state: address (u16), client model (u16), oldest cached age ms (u16)
+#define HOST_OP_GET              0x04
+/// Recall a scene on many targets: scene (u16), transition ms (u16), group or
+/// unicast addresses (u16)
+#define HOST_OP_SCENE            0x05
+
+/// Most commands in a frame, each takes at least op and argument length
+#define HOST_MAX_COMMANDS        (HOST_FRAME_MAX_PAYLOAD / 2)
+
+/// Frames the host may have in flight
+#ifndef HOST_PROTOCOL_WINDOW
+#define HOST_PROTOCOL_WINDOW     4
+#endif
+
+/// Set commands (on/off, lightness, CTL) run from a frame, later ones are rejected
+#ifndef HOST_FRAME_MAX_SETS
+#define HOST_FRAME_MAX_SETS      4
+#endif
+
+/// Free client queue entries needed before a credit is returned, the sets of
+/// all frames in flight must fit
+#ifndef HOST_PROTOCOL_QUEUE_RESERVE
+#define HOST_PROTOCOL_QUEUE_RESERVE   (HOST_PROTOCOL_WINDOW * HOST_FRAME_MAX_SETS)
+#endif
+
+/***************************************************************************//**
+ *  Start the link.
+ ******************************************************************************/
+void host_protocol_init(void);
+
+/***************************************************************************//**
+ *  Forward a generic client server status event to the host.
+ ******************************************************************************/
+void host_protocol_status(struct gecko_cmd_packet *pEvt);
+
+/***************************************************************************//**
+ *  Queue the received frames for the scheduler, called on EXT_SIGNAL_HOST_RX.
+ ******************************************************************************/
+void host_protocol_poll(void);
+
+/***************************************************************************//**
+ *  Return credits held back while the client queue was full, called after
+ *  the client queue was flushed.
+ ******************************************************************************/
+void host_protocol_grant(void);
+
+/** @} (end addtogroup HostProtocol) */
+
+#endif /* HOST_PROTOCOL_H */
@@ -0,0 +1,191 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include "em_rtcc.h"
+#include "ll_priority.h"
+#include "connections.h"
+#include "request_tracker.h"
+#include "timer_wheel.h"
+#define LOG_MODULE   LL
+#include "darwin_log.h"
+
+/***************************************************************************//**
+ * @addtogroup LinkPriority
+ * @{
+ ******************************************************************************/
+
+static gecko_bluetooth_ll_priorities *pConfigured;
+static gecko_bluetooth_ll_priorities Profiles[LL_PRIO_PROFILES];
+static LlPrioProfile_t Current;
+/// Profile chosen by the controller and the periods in a row it was chosen
+static LlPrioProfile_t Candidate;
+static uint8_t Held;
+static bool Auto;
+static Timer_t Timer;
+static LlPrioStats_t Stats[LL_PRIO_PROFILES];
+/// Request tracker counters and RTCC ticks at the last accounting
+static ReqStats_t Last;
+static uint32_t LastTicks;
+/// Request tracker counters at the start of the period
+static uint32_t PeriodSent;
+static uint32_t PeriodMissed;
+
+/// Adds the requests and the time since the last call to the current profile
+static void Account(void)
+{
+   const ReqStats_t *pReq = ReqGetStats();
+   LlPrioStats_t *p = &Stats[Current];
+   uint32_t Now = RTCC_CounterGet();
+
+   p->TimeMs += (uint32_t) ((uint64_t) (Now - LastTicks) * 1000 / TIMER_CLK_FREQ);
+   p->Sent += pReq->Sent - Last.Sent;
+   p->Acked += pReq->Acked - Last.Acked;
+   p->Retries += pReq->Retries - Last.Retries;
+   p->TimedOut += pReq->TimedOut - Last.TimedOut;
+   p->TotalRttMs += pReq->TotalRttMs - Last.TotalRttMs;
+   Last = *pReq;
+   LastTicks = Now;
+}
+
+static void Apply(LlPrioProfile_t Profile)
+{
+   uint16_t Result;
+
+   Account();
+   if(pConfigured == NULL) {
+      return;
+   }
+   // the stack only read the configured table at init
+   Result = gecko_cmd_system_linklayer_configure(LL_PRIO_CONFIG_KEY,sizeof(Profiles[Profile]),
+                                                 (const uint8 *) &Profiles[Profile])->result;
+   if(Result != 0) {
+      ELOG("gecko_cmd_system_linklayer_configure failed: 0x%x, keeping %s\n",Result,LlPrioName(Current));
+      return;
+   }
+   Current = Profile;
+   Stats[Profile].Selected++;
+   LOG("link layer priorities: %s\n",LlPrioName(Profile));
+}
+
+static LlPrioProfile_t Choose(uint32_t Sent,uint32_t Missed)
+{
+   if(ConnGetStats()->Active != 0) {
+      return LL_PRIO_CONNECTION;
+   }
+   if(Sent >= LL_PRIO_MIN_SENT && Missed * 100 > Sent * LL_PRIO_MISS_PCT) {
+      return LL_PRIO_SCAN;
+   }
+   return LL_PRIO_ADVERTISE;
+}
+
+static void Control(Timer_t *pTimer)
+{
+   const ReqStats_t *pReq = ReqGetStats();
+   uint32_t Missed = pReq->Retries + pReq->TimedOut;
+   LlPrioProfile_t Profile = Choose(pReq->Sent - PeriodSent,Missed - PeriodMissed);
+
+   PeriodSent = pReq->Sent;
+   PeriodMissed = Missed;
+   Account();
+   if(Profile == Current) {
+      Held = 0;
+      return;
+   }
+   if(Profile != Candidate) {
+      Candidate = Profile;
+      Held = 0;
+   }
+   if(++Held >= LL_PRIO_HOLD) {
+      Held = 0;
+      Apply(Profile);
+   }
+}
+
+void LlPrioInit(gecko_bluetooth_ll_priorities *pTable)
+{
+   gecko_bluetooth_ll_priorities *p;
+
+   pConfigured = pTable;
+   if(pTable == NULL) {
+      return;
+   }
+
+   // advertising always interrupts scanning
+   p = &Profiles[LL_PRIO_ADVERTISE];
+   *p = *pTable;
+   p->scan_max = p->adv_min + 1;
+
+   // scanning starts above and escalates above advertising
+   p = &Profiles[LL_PRIO_SCAN];
+   *p = *pTable;
+   p->scan_min = p->adv_min - 1;
+   p->scan_max = p->adv_max - 1;
+
+   // connection events above both, scanning as for advertising
+   p = &Profiles[LL_PRIO_CONNECTION];
+   *p = Profiles[LL_PRIO_ADVERTISE];
+   p->conn_min = p->adv_max - 1;
+
+   *pTable = Profiles[LL_PRIO_ADVERTISE];
+   Current = Candidate = LL_PRIO_ADVERTISE;
+   Stats[LL_PRIO_ADVERTISE].Selected++;
+}
+
+void LlPrioAuto(void)
+{
+   if(pConfigured == NULL) {
+      return;
+   }
+   Account();
+   PeriodSent = Last.Sent;
+   PeriodMissed = Last.Retries + Last.TimedOut;
+   Auto = true;
+   Candidate = Current;
+   Held = 0;
+   TimerStart(&Timer,LL_PRIO_PERIOD_MS,LL_PRIO_PERIOD_MS,Control,NULL);
+}
+
+void LlPrioSelect(LlPrioProfile_t Profile)
+{
+   if(Profile >= LL_PRIO_PROFILES) {
+      return;
+   }
+   Auto = false;
+   TimerStop(&Timer);
+   if(Profile != Current) {
+      Apply(Profile);
+   }
+}
+
+LlPrioProfile_t LlPrioGetProfile(void)
+{
+   return Current;
+}
+
+bool LlPrioIsAuto(void)
+{
+   return Auto;
+}
+
+const char *LlPrioName(LlPrioProfile_t Profile)
+{
+   static const char *Names[LL_PRIO_PROFILES] = {"advertise","scan","connection"};
+
+   return Profile < LL_PRIO_PROFILES ? Names[Profile] : "?";
+}
+
+const LlPrioStats_t *LlPrioGetStats(LlPrioProfile_t Profile)
+{
+   Account();
+   return &Stats[Profile];
+}
+
+/** @} (end addtogroup LinkPriority) */
@@ -0,0 +1,128 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef LL_PRIORITY_H
+#define LL_PRIORITY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+
+/***************************************************************************//**
+ * \defgroup LinkPriority
+ * \brief Link layer priority profiles and the controller choosing them.
+ *
+ * The link layer arbitrates between scanning, advertising and connection
+ * events by a priority table, a lower value wins. The stack copies the table
+ * of its configuration at init, a profile is applied at runtime with
+ * gecko_cmd_system_linklayer_configure(). The profiles are derived from the
+ * table the stack was configured with:
+ *  - LL_PRIO_ADVERTISE: advertising always preempts scanning, relayed and
+ *    sent mesh messages go out with the least delay. The former fixed
+ *    setting and the default.
+ *  - LL_PRIO_SCAN: scanning preempts advertising, fewer mesh messages are
+ *    missed while the gateway is sending.
+ *  - LL_PRIO_CONNECTION: connection events preempt both, proxy and OTA
+ *    connections keep their timing.
+ *
+ * In auto mode the controller looks at the last LL_PRIO_PERIOD_MS every
+ * period. Open connections select LL_PRIO_CONNECTION. Otherwise, when more
+ * than LL_PRIO_MISS_PCT of the acknowledged requests needed a
+ * retransmission, statuses were missed while the scanner was preempted and
+ * LL_PRIO_SCAN is selected. Otherwise LL_PRIO_ADVERTISE is used. A new
+ * profile must be chosen LL_PRIO_HOLD periods in a row before it is
+ * applied, so the profile does not flap.
+ *
+ * The request tracker counters are accounted to the profile that was active,
+ * the average round trip and the retransmissions per profile show its effect
+ * on the latency.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup LinkPriority
+ * @{
+ ******************************************************************************/
+
+/// Key of gecko_cmd_system_linklayer_configure() setting the priority table
+#define LL_PRIO_CONFIG_KEY    1
+
+/// Time between two decisions of the controller
+#ifndef LL_PRIO_PERIOD_MS
+#define LL_PRIO_PERIOD_MS     1000
+#endif
+
+/// Retransmitted or timed out requests in % of the sent ones selecting LL_PRIO_SCAN
+#ifndef LL_PRIO_MISS_PCT
+#define LL_PRIO_MISS_PCT      20
+#endif
+
+/// Requests of a period needed for a miss rate
+#ifndef LL_PRIO_MIN_SENT
+#define LL_PRIO_MIN_SENT      10
+#endif
+
+/// Periods a new profile must be chosen before it is applied
+#ifndef LL_PRIO_HOLD
+#define LL_PRIO_HOLD          3
+#endif
+
+typedef enum {
+   LL_PRIO_ADVERTISE,
+   LL_PRIO_SCAN,
+   LL_PRIO_CONNECTION,
+   LL_PRIO_PROFILES
+} LlPrioProfile_t;
+
+/// Counters while a profile was active
+typedef struct {
+   uint32_t Selected;         ///< Times the profile was applied
+   uint32_t TimeMs;           ///< Time the profile was active
+   uint32_t Sent;             ///< Requests sent
+   uint32_t Acked;
+   uint32_t Retries;
+   uint32_t TimedOut;
+   uint32_t TotalRttMs;       ///< Sum of the round trip times of the acked requests
+} LlPrioStats_t;
+
+/***************************************************************************//**
+ *  Derive the profiles from the configured table and apply
+ *  LL_PRIO_ADVERTISE, called before the stack is initialized.
+ *
+ *  @param[in] pTable  Priority table of the stack configuration, NULL
+ *                     disables the profiles.
+ ******************************************************************************/
+void LlPrioInit(gecko_bluetooth_ll_priorities *pTable);
+
+/***************************************************************************//**
+ *  Start the controller in auto mode, called after the timer wheel is
+ *  initialized.
+ ******************************************************************************/
+void LlPrioAuto(void);
+
+/***************************************************************************//**
+ *  Apply a profile and stop the controller.
+ ******************************************************************************/
+void LlPrioSelect(LlPrioProfile_t Profile);
+
+LlPrioProfile_t LlPrioGetProfile(void);
+
+bool LlPrioIsAuto(void);
+
+const char *LlPrioName(LlPrioProfile_t Profile);
+
+/***************************************************************************//**
+ *  Get the counters of a profile, up to date including the current period.
+ ******************************************************************************/
+const LlPrioStats_t *LlPrioGetStats(LlPrioProfile_t Profile);
+
+/** @} (end addtogroup LinkPriority) */
+
+#endif /* LL_PRIORITY_H */
@@ -17,6 +17,9 @@
 
 #include <stdio.h>
 #include "mesh_proxy.h"
+#include "event_dispatch.h"
+#include "connections.h"
+#define LOG_MODULE   PROXY
 #include "darwin_log.h"
 
 /***************************************************************************//**
@@ -24,31 +27,35 @@
  * @{
  ******************************************************************************/
 
-/// number of active mesh proxy connections
-uint8_t num_mesh_proxy_conn = 0;
+/***************************************************************************//**
+ *  Handling of new mesh proxy connections.
+ *
+ *  @param[in] pEvt  Pointer to incoming event.
+ ******************************************************************************/
+static void handle_proxy_connected(struct gecko_cmd_packet *pEvt)
+{
+  TLOG("evt:gecko_evt_mesh_proxy_connected_id\n");
+  ConnProxyOpened(pEvt->data.evt_mesh_proxy_connected.handle);
+}
 
 /***************************************************************************//**
- *  Handling of mesh proxy events.
+ *  Handling of closed mesh proxy connections.
  *
  *  @param[in] pEvt  Pointer to incoming event.
  ******************************************************************************/
-void handle_mesh_proxy_events(struct gecko_cmd_packet *pEvt)
+static void handle_proxy_disconnected(struct gecko_cmd_packet *pEvt)
 {
-  switch (BGLIB_MSG_ID(pEvt->header)) {
-    case gecko_evt_mesh_proxy_connected_id:
-      LOG("evt:gecko_evt_mesh_proxy_connected_id\n");
-      num_mesh_proxy_conn++;
-      break;
+  TLOG("evt:gecko_evt_mesh_proxy_disconnected_id\n");
+  ConnProxyClosed(pEvt->data.evt_mesh_proxy_disconnected.handle);
+}
 
-    case gecko_evt_mesh_proxy_disconnected_id:
-      LOG("evt:gecko_evt_mesh_proxy_disconnected_id\n");
-      if (num_mesh_proxy_conn > 0) {
-         num_mesh_proxy_conn--;
-      }
-      break;
-    default:
-      break;
-  }
+/***************************************************************************//**
+ *  Register the mesh proxy event handlers.
+ ******************************************************************************/
+void mesh_proxy_init(void)
+{
+  EventDispatchRegister(gecko_evt_mesh_proxy_connected_id, handle_proxy_connected);
+  EventDispatchRegister(gecko_evt_mesh_proxy_disconnected_id, handle_proxy_disconnected);
 }
 
 /** @} (end addtogroup MeshProxy) */
@@ -30,15 +30,10 @@
  * @{
  ******************************************************************************/
 
-/// number of active mesh proxy connections
-extern uint8_t num_mesh_proxy_conn;
-
 /***************************************************************************//**
- *  Handling of mesh proxy events.
- *
- *  @param[in] pEvt  Pointer to incoming event.
+ *  Register the mesh proxy event handlers with the event dispatcher.
  ******************************************************************************/
-void handle_mesh_proxy_events(struct gecko_cmd_packet *pEvt);
+void mesh_proxy_init(void);
 
 /** @} (end addtogroup MeshProxy) */
 
@@ -0,0 +1,334 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "native_gecko.h"
+#include "em_rtcc.h"
+#include "btl_interface.h"
+#include "ota.h"
+#include "scheduler.h"
+#include "timer_wheel.h"
+#include "ps_cache.h"
+#include "darwin_cycles.h"
+#define LOG_MODULE   OTA
+#include "darwin_log.h"
+
+#if OTA_BLOCK_SIZE % OTA_WRITE_CHUNK != 0
+#error "OTA_BLOCK_SIZE must be a multiple of OTA_WRITE_CHUNK"
+#endif
+
+/***************************************************************************//**
+ * @addtogroup Ota
+ * @{
+ ******************************************************************************/
+
+static OtaStats_t Stats;
+static Task_t Task;
+/// Transfer timeout, then the reboot
+static Timer_t Timer;
+
+static uint8_t Buffers[2][OTA_BLOCK_SIZE] __attribute__((aligned(4)));
+/// Buffer being filled
+static int Fill;
+static uint32_t FillLen;
+/// Buffer being programmed, -1 if none
+static int Prog = -1;
+static uint32_t ProgLen;
+static uint32_t ProgDone;
+static uint32_t ProgOffset;
+
+static uint8_t VerifyContext[BOOTLOADER_STORAGE_VERIFICATION_CONTEXT_SIZE] __attribute__((aligned(4)));
+static bool VerifyStarted;
+/// The end write waiting for its response
+static uint8_t EndConnection;
+static uint16_t EndCharacteristic;
+static uint8_t Error;
+static uint32_t StartTicks;
+static uint32_t EndTicks;
+
+static uint32_t TicksToMs(uint32_t Ticks)
+{
+   return (uint32_t) ((uint64_t) Ticks * 1000 / TIMER_CLK_FREQ);
+}
+
+/// CRC-32 as used by zip and the GBL format, a nibble at a time
+static uint32_t Crc32(uint32_t Crc,const uint8_t *p,int Len)
+{
+   static const uint32_t Table[16] = {
+      0x00000000,0x1db71064,0x3b6e20c8,0x26d930ac,0x76dc4190,0x6b6b51f4,0x4db26158,0x5005713c,
+      0xedb88320,0xf00f9344,0xd6d6a3e8,0xcb61b38c,0x9b64c2b0,0x86d3d2d4,0xa00ae278,0xbdbdf21c
+   };
+
+   while(Len-- > 0) {
+      Crc ^= *p++;
+      Crc = (Crc >> 4) ^ Table[Crc & 0xf];
+      Crc = (Crc >> 4) ^ Table[Crc & 0xf];
+   }
+   return Crc;
+}
+
+static void Respond(uint8_t Connection,uint16_t Characteristic,uint8_t Result)
+{
+   gecko_cmd_gatt_server_send_user_write_response(Connection,Characteristic,Result);
+}
+
+static void Fail(uint8_t Result)
+{
+   TimerStop(&Timer);
+   if(Stats.State == OTA_VERIFYING) {
+      Respond(EndConnection,EndCharacteristic,Result);
+   }
+   ELOG("ota failed: 0x%x at %lu bytes\n",Result,(unsigned long) Stats.Size);
+   Stats.State = OTA_FAILED;
+   Error = Result;
+   Prog = -1;
+}
+
+static void ProgramChunk(void)
+{
+   uint32_t Len = ProgLen - ProgDone;
+   int32_t Result;
+
+   if(Len > OTA_WRITE_CHUNK) {
+      Len = OTA_WRITE_CHUNK;
+   }
+   // erases the pages it enters
+   Result = bootloader_eraseWriteStorage(OTA_SLOT,ProgOffset + ProgDone,&Buffers[Prog][ProgDone],Len);
+   if(Result != BOOTLOADER_OK) {
+      ELOG("slot write at %lu failed: 0x%lx\n",(unsigned long) (ProgOffset + ProgDone),(unsigned long) Result);
+      Fail(OTA_ERR_WRITE);
+      return;
+   }
+   ProgDone += Len;
+   if(ProgDone == ProgLen) {
+      Stats.Blocks++;
+      Prog = -1;
+   }
+}
+
+/// Hands the fill buffer to the task
+static void Submit(void)
+{
+   if(Prog >= 0) {
+      // the phone is faster than the flash
+      Stats.Stalls++;
+      while(Prog >= 0) {
+         ProgramChunk();
+      }
+      if(Stats.State == OTA_FAILED) {
+         return;
+      }
+   }
+   Prog = Fill;
+   ProgLen = FillLen;
+   ProgDone = 0;
+   ProgOffset = Stats.Size - FillLen;
+   Fill ^= 1;
+   FillLen = 0;
+   SchedPost(&Task);
+}
+
+static void Reboot(Timer_t *pTimer)
+{
+   PsCacheFlush();
+   gecko_cmd_system_reset(0);
+}
+
+static void Verified(int32_t Result)
+{
+   Stats.VerifyMs = TicksToMs(RTCC_CounterGet() - EndTicks);
+   if(Result != BOOTLOADER_ERROR_PARSE_SUCCESS) {
+      ELOG("image rejected: 0x%lx\n",(unsigned long) Result);
+      Fail(OTA_ERR_IMAGE);
+      return;
+   }
+   Result = bootloader_setImageToBootload(OTA_SLOT);
+   if(Result != BOOTLOADER_OK) {
+      ELOG("set image to bootload failed: 0x%lx\n",(unsigned long) Result);
+      Fail(OTA_ERR_IMAGE);
+      return;
+   }
+   Respond(EndConnection,EndCharacteristic,bg_err_success);
+   LOG("ota: %lu bytes in %lu ms, verified in %lu ms, %lu stalls\n",(unsigned long) Stats.Size,
+       (unsigned long) Stats.ReceiveMs,(unsigned long) Stats.VerifyMs,(unsigned long) Stats.Stalls);
+   Stats.State = OTA_INSTALLING;
+   TimerStart(&Timer,OTA_REBOOT_DELAY_MS,0,Reboot,NULL);
+}
+
+static bool Run(Task_t *pTask)
+{
+   uint32_t Start = CYCLE_COUNT();
+   uint32_t Cycles;
+
+   do {
+      if(Prog >= 0) {
+         ProgramChunk();
+      }
+      else if(Stats.State == OTA_VERIFYING) {
+         int32_t Result;
+
+         if(!VerifyStarted) {
+            VerifyStarted = true;
+            Result = bootloader_initVerifyImage(OTA_SLOT,VerifyContext,sizeof(VerifyContext));
+            if(Result != BOOTLOADER_OK) {
+               Verified(Result);
+               break;
+            }
+         }
+         Result = bootloader_continueVerifyImage(VerifyContext,NULL);
+         if(Result != BOOTLOADER_ERROR_PARSE_CONTINUE) {
+            Verified(Result);
+            break;
+         }
+      }
+      else {
+         break;
+      }
+   } while(!SchedExpired());
+
+   Cycles = CYCLE_COUNT() - Start;
+   if(Cycles > Stats.MaxSliceCycles) {
+      Stats.MaxSliceCycles = Cycles;
+   }
+   return Prog >= 0 || Stats.State == OTA_VERIFYING;
+}
+
+static void TimedOut(Timer_t *pTimer)
+{
+   Fail(OTA_ERR_STATE);
+}
+
+static void Start(void)
+{
+   int32_t Result = bootloader_init();
+
+   memset(&Stats,0,sizeof(Stats));
+   TimerStop(&Timer);
+   Fill = 0;
+   FillLen = 0;
+   Prog = -1;
+   VerifyStarted = false;
+   Error = 0;
+   Stats.Crc = 0xffffffff;
+   StartTicks = RTCC_CounterGet();
+   if(Result != BOOTLOADER_OK) {
+      ELOG("bootloader init failed: 0x%lx\n",(unsigned long) Result);
+      Fail(OTA_ERR_WRITE);
+      return;
+   }
+   Stats.State = OTA_RECEIVING;
+   TimerStart(&Timer,OTA_TIMEOUT_MS,0,TimedOut,NULL);
+   LOG("ota started\n");
+}
+
+/// Answers the end write when the image is verified
+static void End(uint8_t Connection,uint16_t Characteristic,const uint8_t *pData,int Len)
+{
+   TimerStop(&Timer);
+   EndTicks = RTCC_CounterGet();
+   Stats.ReceiveMs = TicksToMs(EndTicks - StartTicks);
+   Stats.Crc ^= 0xffffffff;
+
+   if(Len >= 5) {
+      uint32_t Crc = pData[1] | (pData[2] << 8) | (pData[3] << 16) | ((uint32_t) pData[4] << 24);
+
+      if(Crc != Stats.Crc) {
+         ELOG("image crc 0x%08lx, expected 0x%08lx\n",(unsigned long) Stats.Crc,(unsigned long) Crc);
+         Fail(OTA_ERR_CRC);
+         Respond(Connection,Characteristic,OTA_ERR_CRC);
+         return;
+      }
+   }
+
+   EndConnection = Connection;
+   EndCharacteristic = Characteristic;
+   if(FillLen != 0) {
+      Submit();
+   }
+   if(Stats.State == OTA_FAILED) {
+      Respond(Connection,Characteristic,Error);
+      return;
+   }
+   Stats.State = OTA_VERIFYING;
+   SchedPost(&Task);
+}
+
+void OtaControl(uint8_t Connection,uint16_t Characteristic,const uint8_t *pData,int Len)
+{
+   if(Len < 1) {
+      Respond(Connection,Characteristic,OTA_ERR_STATE);
+      return;
+   }
+
+   switch(pData[0]) {
+      case OTA_CONTROL_START:
+         if(Stats.State == OTA_VERIFYING || Stats.State == OTA_INSTALLING) {
+            Respond(Connection,Characteristic,OTA_ERR_STATE);
+            return;
+         }
+         Start();
+         Respond(Connection,Characteristic,Stats.State == OTA_RECEIVING ? bg_err_success : Error);
+         break;
+
+      case OTA_CONTROL_END:
+         if(Stats.State != OTA_RECEIVING) {
+            Respond(Connection,Characteristic,Stats.State == OTA_FAILED ? Error : OTA_ERR_STATE);
+            return;
+         }
+         End(Connection,Characteristic,pData,Len);
+         break;
+
+      default:
+         Respond(Connection,Characteristic,OTA_ERR_STATE);
+         break;
+   }
+}
+
+void OtaData(const uint8_t *pData,int Len)
+{
+   if(Stats.State != OTA_RECEIVING) {
+      Stats.Dropped++;
+      return;
+   }
+
+   Stats.Crc = Crc32(Stats.Crc,pData,Len);
+   while(Len > 0) {
+      uint32_t n = OTA_BLOCK_SIZE - FillLen;
+
+      if(n > (uint32_t) Len) {
+         n = Len;
+      }
+      memcpy(&Buffers[Fill][FillLen],pData,n);
+      FillLen += n;
+      Stats.Size += n;
+      pData += n;
+      Len -= n;
+      if(FillLen == OTA_BLOCK_SIZE) {
+         Submit();
+         if(Stats.State == OTA_FAILED) {
+            return;
+         }
+      }
+   }
+   TimerStart(&Timer,OTA_TIMEOUT_MS,0,TimedOut,NULL);
+}
+
+void OtaInit(void)
+{
+   SchedTaskInit(&Task,Run,NULL,SCHED_PRIO_LOW);
+}
+
+const OtaStats_t *OtaGetStats(void)
+{
+   return &Stats;
+}
+
+/** @} (end addtogroup Ota) */
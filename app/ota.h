@@ -0,0 +1,119 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * \defgroup Ota
+ * \brief Firmware update received by the running application.
+ *
+ * The image is written into a storage slot of the Gecko bootloader while the
+ * gateway stays on the mesh, it reboots once to install it. The OTA control
+ * and data characteristics follow the in-application OTA of AN1086:
+ *  - control 0x00: start, the slot is written from its beginning.
+ *  - data: image bytes, written without response with up to MTU - 3 bytes.
+ *  - control 0x03: end, optionally followed by the CRC-32 of the image (u32).
+ *    The write is answered when the image is verified, a good image is
+ *    installed by a reboot OTA_REBOOT_DELAY_MS later.
+ *
+ * The data is collected in two buffers of OTA_BLOCK_SIZE. A full buffer is
+ * programmed by a low priority task in OTA_WRITE_CHUNK pieces while the
+ * other one fills. If the other one fills up first, the rest of the block is
+ * programmed at once and counted as a stall. The CRC-32 is updated as the
+ * data arrives and the bootloader checks the image, including its signature
+ * if the bootloader requires one, in task slices after the last block.
+ *
+ * A transfer without data for OTA_TIMEOUT_MS is given up.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Ota
+ * @{
+ ******************************************************************************/
+
+/// Bootloader storage slot for the image
+#ifndef OTA_SLOT
+#define OTA_SLOT              0
+#endif
+
+/// Size of each of the two receive buffers, a multiple of OTA_WRITE_CHUNK
+#ifndef OTA_BLOCK_SIZE
+#define OTA_BLOCK_SIZE        2048
+#endif
+
+/// Bytes programmed per task slice
+#ifndef OTA_WRITE_CHUNK
+#define OTA_WRITE_CHUNK       256
+#endif
+
+#ifndef OTA_TIMEOUT_MS
+#define OTA_TIMEOUT_MS        10000
+#endif
+
+/// Time for the end response to reach the phone before the reboot
+#ifndef OTA_REBOOT_DELAY_MS
+#define OTA_REBOOT_DELAY_MS   1000
+#endif
+
+#define OTA_CONTROL_START     0x00
+#define OTA_CONTROL_END       0x03
+
+/// ATT application errors of the control writes
+#define OTA_ERR_STATE         0x80  ///< No transfer running
+#define OTA_ERR_WRITE         0x81  ///< The slot could not be written
+#define OTA_ERR_CRC           0x82  ///< The CRC-32 of the end write does not match
+#define OTA_ERR_IMAGE         0x83  ///< The bootloader rejected the image
+
+typedef enum {
+   OTA_IDLE,
+   OTA_RECEIVING,
+   OTA_VERIFYING,
+   OTA_INSTALLING,               ///< Waiting for the reboot
+   OTA_FAILED
+} OtaState_t;
+
+typedef struct {
+   OtaState_t State;
+   uint32_t Size;             ///< Image bytes received
+   uint32_t Crc;              ///< CRC-32 of the received bytes
+   uint32_t Blocks;           ///< Blocks programmed
+   uint32_t Stalls;           ///< Blocks programmed at once because both buffers were full
+   uint32_t Dropped;          ///< Data writes outside of a transfer
+   uint32_t ReceiveMs;        ///< From the start to the end write
+   uint32_t VerifyMs;         ///< From the end write to the verdict of the bootloader
+   uint32_t MaxSliceCycles;   ///< Longest programming or verification slice
+} OtaStats_t;
+
+/***************************************************************************//**
+ *  Set up the programming task.
+ ******************************************************************************/
+void OtaInit(void);
+
+/***************************************************************************//**
+ *  Handle a write to the OTA control characteristic, the write is answered
+ *  here, the end write once the image is verified.
+ ******************************************************************************/
+void OtaControl(uint8_t Connection,uint16_t Characteristic,const uint8_t *pData,int Len);
+
+/***************************************************************************//**
+ *  Handle a write to the OTA data characteristic.
+ ******************************************************************************/
+void OtaData(const uint8_t *pData,int Len);
+
+const OtaStats_t *OtaGetStats(void);
+
+/** @} (end addtogroup Ota) */
+
+#endif /* OTA_H */
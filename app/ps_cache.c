@@ -0,0 +1,272 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "native_gecko.h"
+#include "ps_cache.h"
+#include "scheduler.h"
+#include "timer_wheel.h"
+#include "darwin_cycles.h"
+#define LOG_MODULE   PS
+#include "darwin_log.h"
+
+/***************************************************************************//**
+ * @addtogroup PsCache
+ * @{
+ ******************************************************************************/
+
+typedef struct {
+   bool Used;
+   bool Dirty;
+   bool Erased;               ///< The key is erased, Len is 0
+   uint8_t Len;
+   uint16_t Key;
+   uint32_t Order;            ///< Order of the first unsaved change or last use
+   uint8_t Value[PS_CACHE_VALUE_SIZE];
+} PsEntry_t;
+
+static PsEntry_t Cache[PS_CACHE_ENTRIES];
+static PsCacheStats_t Stats;
+static uint32_t NextOrder;
+static Timer_t FlushTimer;
+static Task_t FlushTask;
+
+/// Writes one entry to flash, false if the stack refused it
+static bool Write(PsEntry_t *p)
+{
+   uint32_t Start = CYCLE_COUNT();
+   uint32_t Cycles;
+   uint16_t Result;
+
+   if(p->Erased) {
+      Result = gecko_cmd_flash_ps_erase(p->Key)->result;
+      if(Result == bg_err_not_found) {
+         Result = bg_err_success;
+      }
+   }
+   else {
+      Result = gecko_cmd_flash_ps_save(p->Key,p->Len,p->Value)->result;
+   }
+   Cycles = CYCLE_COUNT() - Start;
+   if(Cycles > Stats.MaxFlushCycles) {
+      Stats.MaxFlushCycles = Cycles;
+   }
+
+   if(Result != bg_err_success) {
+      ELOG("PS key 0x%04x not written, 0x%x\n",p->Key,Result);
+      Stats.Failed++;
+      return false;
+   }
+   p->Dirty = false;
+   Stats.Dirty--;
+   Stats.Writes++;
+   return true;
+}
+
+/// Oldest dirty entry, NULL if all are written
+static PsEntry_t *OldestDirty(void)
+{
+   PsEntry_t *pOldest = NULL;
+   int i;
+
+   for(i = 0; i < PS_CACHE_ENTRIES; i++) {
+      if(Cache[i].Dirty && (pOldest == NULL || (int32_t) (Cache[i].Order - pOldest->Order) < 0)) {
+         pOldest = &Cache[i];
+      }
+   }
+   return pOldest;
+}
+
+static void FlushTimerExpired(Timer_t *pTimer)
+{
+   SchedPost(&FlushTask);
+}
+
+/// Writes the dirty entries in the order of their first change
+static bool FlushRun(Task_t *pTask)
+{
+   PsEntry_t *p;
+
+   while((p = OldestDirty()) != NULL) {
+      if(!Write(p)) {
+         // try again after the next delay
+         TimerStart(&FlushTimer,PS_CACHE_DELAY_MS,0,FlushTimerExpired,NULL);
+         return false;
+      }
+      if(SchedExpired()) {
+         return Stats.Dirty != 0;
+      }
+   }
+   return false;
+}
+
+static PsEntry_t *Find(uint16_t Key)
+{
+   int i;
+
+   for(i = 0; i < PS_CACHE_ENTRIES; i++) {
+      if(Cache[i].Used && Cache[i].Key == Key) {
+         return &Cache[i];
+      }
+   }
+   return NULL;
+}
+
+/// Free entry, the least recently used clean one is reused or the oldest
+/// dirty one is written first
+static PsEntry_t *Allocate(void)
+{
+   PsEntry_t *pLru = NULL;
+   int i;
+
+   for(i = 0; i < PS_CACHE_ENTRIES; i++) {
+      if(!Cache[i].Used) {
+         return &Cache[i];
+      }
+      if(!Cache[i].Dirty && (pLru == NULL || (int32_t) (Cache[i].Order - pLru->Order) < 0)) {
+         pLru = &Cache[i];
+      }
+   }
+   if(pLru == NULL) {
+      pLru = OldestDirty();
+      if(!Write(pLru)) {
+         return NULL;
+      }
+   }
+   pLru->Used = false;
+   return pLru;
+}
+
+void PsCacheInit(void)
+{
+   memset(Cache,0,sizeof(Cache));
+   memset(&Stats,0,sizeof(Stats));
+   TimerStop(&FlushTimer);
+   if(FlushTask.Run == NULL) {
+      // once, the task may be queued on a later call
+      SchedTaskInit(&FlushTask,FlushRun,NULL,SCHED_PRIO_LOW);
+   }
+}
+
+/// Stores a value or an erase in the cache
+static bool Store(uint16_t Key,const void *pValue,uint8_t Len,bool Erased)
+{
+   PsEntry_t *p = Find(Key);
+
+   Stats.Saves++;
+   if(p != NULL) {
+      if(p->Erased == Erased && p->Len == Len && memcmp(p->Value,pValue,Len) == 0) {
+         // unchanged
+         Stats.Saved++;
+         return true;
+      }
+      if(p->Dirty) {
+         // replaces a value that was never written
+         Stats.Saved++;
+      }
+   }
+   else if((p = Allocate()) == NULL) {
+      // the oldest value could not be written, write this one directly
+      if(Erased) {
+         return gecko_cmd_flash_ps_erase(Key)->result == bg_err_success;
+      }
+      return gecko_cmd_flash_ps_save(Key,Len,pValue)->result == bg_err_success;
+   }
+
+   if(!p->Dirty) {
+      p->Dirty = true;
+      p->Order = NextOrder++;
+      Stats.Dirty++;
+   }
+   p->Used = true;
+   p->Key = Key;
+   p->Erased = Erased;
+   p->Len = Len;
+   memcpy(p->Value,pValue,Len);
+
+   if(!TimerIsArmed(&FlushTimer) && !FlushTask.Queued) {
+      TimerStart(&FlushTimer,PS_CACHE_DELAY_MS,0,FlushTimerExpired,NULL);
+   }
+   return true;
+}
+
+bool PsCacheSave(uint16_t Key,const void *pValue,uint8_t Len)
+{
+   if(Len > PS_CACHE_VALUE_SIZE) {
+      return false;
+   }
+   return Store(Key,pValue,Len,false);
+}
+
+void PsCacheErase(uint16_t Key)
+{
+   Store(Key,"",0,true);
+}
+
+int PsCacheLoad(uint16_t Key,void *pValue)
+{
+   struct gecko_msg_flash_ps_load_rsp_t *pRsp;
+   uint8_t Len;
+   PsEntry_t *p = Find(Key);
+
+   Stats.Loads++;
+   if(p != NULL) {
+      Stats.LoadHits++;
+      if(!p->Dirty) {
+         p->Order = NextOrder++;
+      }
+      memcpy(pValue,p->Value,p->Len);
+      return p->Erased ? -1 : p->Len;
+   }
+
+   pRsp = gecko_cmd_flash_ps_load(Key);
+   if(pRsp->result != bg_err_success || pRsp->value.len > PS_CACHE_VALUE_SIZE) {
+      return -1;
+   }
+   // the response buffer is reused by the next command, Allocate() may flush
+   Len = pRsp->value.len;
+   memcpy(pValue,pRsp->value.data,Len);
+
+   // keep it for the next load
+   if((p = Allocate()) != NULL) {
+      p->Used = true;
+      p->Dirty = false;
+      p->Erased = false;
+      p->Key = Key;
+      p->Len = Len;
+      p->Order = NextOrder++;
+      memcpy(p->Value,pValue,Len);
+   }
+   return Len;
+}
+
+void PsCacheEraseAll(void)
+{
+   memset(Cache,0,sizeof(Cache));
+   Stats.Dirty = 0;
+   TimerStop(&FlushTimer);
+   gecko_cmd_flash_ps_erase_all();
+}
+
+void PsCacheFlush(void)
+{
+   PsEntry_t *p;
+
+   TimerStop(&FlushTimer);
+   while((p = OldestDirty()) != NULL && Write(p));
+}
+
+const PsCacheStats_t *PsCacheGetStats(void)
+{
+   return &Stats;
+}
+
+/** @} (end addtogroup PsCache) */
@@ -0,0 +1,101 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef PS_CACHE_H
+#define PS_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * \defgroup PsCache
+ * \brief Write-behind cache over the flash persistent store.
+ *
+ * Saved values are kept in RAM and written to flash PS_CACHE_DELAY_MS after
+ * the first unsaved change, one key per scheduler slice. Saving a key again
+ * before it was written replaces the pending value, saving an unchanged
+ * value does nothing. Loads are answered from RAM when the key is cached.
+ *
+ * Every key is written to flash as a whole by the stack, so after a crash
+ * or power loss each key holds either its last written or an older value.
+ * Values saved within PS_CACHE_DELAY_MS before the loss are gone. Call
+ * PsCacheFlush() before an intended reset.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup PsCache
+ * @{
+ ******************************************************************************/
+
+/// Cached keys
+#ifndef PS_CACHE_ENTRIES
+#define PS_CACHE_ENTRIES      16
+#endif
+
+/// Largest value, the limit of the stack's persistent store
+#define PS_CACHE_VALUE_SIZE   56
+
+/// Time from the first unsaved change to the flush
+#ifndef PS_CACHE_DELAY_MS
+#define PS_CACHE_DELAY_MS     2000
+#endif
+
+typedef struct {
+   uint32_t Saves;            ///< PsCacheSave() calls
+   uint32_t Saved;            ///< Saves that did not cause a flash write
+   uint32_t Writes;           ///< Values written to flash
+   uint32_t Failed;           ///< Flash writes that failed, the value stays dirty
+   uint32_t Loads;            ///< PsCacheLoad() calls
+   uint32_t LoadHits;         ///< Loads answered from RAM
+   uint32_t MaxFlushCycles;   ///< Longest flash write in CPU cycles
+   uint8_t Dirty;             ///< Values not written yet
+} PsCacheStats_t;
+
+/***************************************************************************//**
+ *  Forget the cached values, unsaved ones are lost.
+ ******************************************************************************/
+void PsCacheInit(void);
+
+/***************************************************************************//**
+ *  Save a value.
+ *
+ *  @return false if the value is too long.
+ ******************************************************************************/
+bool PsCacheSave(uint16_t Key,const void *pValue,uint8_t Len);
+
+/***************************************************************************//**
+ *  Load a value.
+ *
+ *  @param[out] pValue  Buffer of at least PS_CACHE_VALUE_SIZE bytes.
+ *  @return Length of the value, -1 if the key is not stored.
+ ******************************************************************************/
+int PsCacheLoad(uint16_t Key,void *pValue);
+
+/***************************************************************************//**
+ *  Erase a key, the erase is written like a save.
+ ******************************************************************************/
+void PsCacheErase(uint16_t Key);
+
+/***************************************************************************//**
+ *  Erase all keys in RAM and flash at once.
+ ******************************************************************************/
+void PsCacheEraseAll(void);
+
+/***************************************************************************//**
+ *  Write all unsaved values now, e.g. before a reset.
+ ******************************************************************************/
+void PsCacheFlush(void);
+
+const PsCacheStats_t *PsCacheGetStats(void);
+
+/** @} (end addtogroup PsCache) */
+
+#endif /* PS_CACHE_H */
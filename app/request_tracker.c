@@ -0,0 +1,344 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "em_rtcc.h"
+#include "request_tracker.h"
+#include "client_queue.h"
+#include "event_dispatch.h"
+#include "timer_wheel.h"
+#define LOG_MODULE   REQ
+#include "darwin_log.h"
+
+/***************************************************************************//**
+ * @addtogroup RequestTracker
+ * @{
+ ******************************************************************************/
+
+/// Request flag asking the server for a status
+#define REQ_RESPONSE_REQUIRED 1
+
+/// Unicast addresses have the top bit clear
+#define IS_UNICAST(Address)   (((Address) & 0x8000) == 0)
+
+/// Status type answering a set request type
+static uint8_t StatusType(uint8_t Type)
+{
+   switch(Type) {
+      case mesh_generic_request_on_off:
+         return mesh_generic_state_on_off;
+      case mesh_generic_request_level:
+         return mesh_generic_state_level;
+      case mesh_lighting_request_lightness_actual:
+         return mesh_lighting_state_lightness_actual;
+      case mesh_lighting_request_ctl:
+         return mesh_lighting_state_ctl;
+      default:
+         return Type;
+   }
+}
+
+typedef struct {
+   bool Used;
+   bool Scene;                ///< Scene recall, the scene number is in Params
+   bool Get;                  ///< Generic get, Type is the state type
+   uint8_t Tid;
+   uint8_t Tries;             ///< Transmissions so far
+   uint8_t Type;              ///< Request type of a set, state type of a get
+   uint8_t Status;            ///< State type of the status answering it
+   uint8_t Len;
+   uint16_t Address;
+   uint16_t ModelID;
+   uint32_t Order;            ///< Order of the first transmission
+   uint32_t Transition;
+   uint32_t Sent;             ///< RTCC ticks of the first transmission
+   ReqDone_t Done;
+   Timer_t Timer;             ///< Retransmission timeout
+   uint8_t Params[REQ_MAX_PARAMS];
+} Request_t;
+
+static Request_t Table[REQ_TRACKER_SIZE];
+static ReqStats_t Stats;
+static uint32_t NextOrder;
+static uint8_t Window = REQ_WINDOW;
+/// Transaction identifier, a new one for every request
+static uint8_t Tid;
+
+static uint16_t Transmit(const Request_t *p,uint16_t Flags)
+{
+   if(p->Scene) {
+      return gecko_cmd_mesh_scene_client_recall(p->Address,0,p->Params[0] | (p->Params[1] << 8),
+                                                CLIENT_QUEUE_APPKEY_INDEX,Flags,p->Tid,p->Transition,0)->result;
+   }
+   if(p->Get) {
+      return gecko_cmd_mesh_generic_client_get(p->ModelID,0,p->Address,CLIENT_QUEUE_APPKEY_INDEX,p->Type)->result;
+   }
+   return gecko_cmd_mesh_generic_client_set(p->ModelID,0,p->Address,CLIENT_QUEUE_APPKEY_INDEX,p->Tid,
+                                            p->Transition,0,Flags,p->Type,p->Len,p->Params)->result;
+}
+
+/// Frees the entry, then tells the owner of the request
+static void Free(Request_t *p,uint16_t Result)
+{
+   TimerStop(&p->Timer);
+   p->Used = false;
+   Stats.InFlight--;
+   if(p->Done != NULL) {
+      p->Done(p->Address,Result,p->Tries);
+   }
+}
+
+/// Timeout after a transmission, doubled for every try, plus up to 25 % so
+/// the retransmissions of a burst spread out
+static uint32_t Timeout(uint8_t Tries)
+{
+   uint32_t Ms = REQ_TIMEOUT_MS << (Tries - 1);
+
+   if(Tries > 8 || Ms > REQ_MAX_TIMEOUT_MS) {
+      Ms = REQ_MAX_TIMEOUT_MS;
+   }
+   return Ms + RTCC_CounterGet() % (Ms / 4 + 1);
+}
+
+static void Expired(Timer_t *pTimer)
+{
+   Request_t *p = pTimer->pArg;
+   uint16_t Result;
+
+   if(p->Tries >= REQ_TRIES) {
+      LOG("no status from 0x%04x after %d tries\n",p->Address,p->Tries);
+      Stats.TimedOut++;
+      Free(p,bg_err_timeout);
+      return;
+   }
+
+   Result = Transmit(p,REQ_RESPONSE_REQUIRED);
+   if(Result == bg_err_out_of_memory) {
+      // the stack is busy, this does not count as a try
+      TimerStart(&p->Timer,REQ_TIMEOUT_MS,0,Expired,p);
+   }
+   else if(Result != bg_err_success) {
+      ELOG("retransmission to 0x%04x failed: 0x%x\n",p->Address,Result);
+      Stats.Failed++;
+      Free(p,Result);
+   }
+   else {
+      Stats.Retries++;
+      p->Tries++;
+      TimerStart(&p->Timer,Timeout(p->Tries),0,Expired,p);
+   }
+}
+
+/// Outstanding requests to a destination
+static int Outstanding(uint16_t Address)
+{
+   int Count = 0;
+   int i;
+
+   for(i = 0; i < REQ_TRACKER_SIZE; i++) {
+      if(Table[i].Used && Table[i].Address == Address) {
+         Count++;
+      }
+   }
+   return Count;
+}
+
+static Request_t *Allocate(void)
+{
+   int i;
+
+   for(i = 0; i < REQ_TRACKER_SIZE; i++) {
+      if(!Table[i].Used) {
+         return &Table[i];
+      }
+   }
+   return NULL;
+}
+
+bool ReqWindowOpen(uint16_t Address)
+{
+   return !IS_UNICAST(Address) || (Stats.InFlight < REQ_TRACKER_SIZE && Outstanding(Address) < Window);
+}
+
+/// Sends a request filled in by the caller
+static uint16_t Send(Request_t *pNew)
+{
+   Request_t *p;
+   uint16_t Result;
+
+   pNew->Tid = Tid;
+   if(!IS_UNICAST(pNew->Address)) {
+      // a group answers with many statuses, send it once
+      Result = Transmit(pNew,0);
+      if(Result == bg_err_success) {
+         Tid++;
+         Stats.Sent++;
+      }
+      return Result;
+   }
+
+   if(Outstanding(pNew->Address) >= Window || (p = Allocate()) == NULL) {
+      Stats.Busy++;
+      return bg_err_out_of_memory;
+   }
+
+   Result = Transmit(pNew,REQ_RESPONSE_REQUIRED);
+   if(Result != bg_err_success) {
+      if(Result != bg_err_out_of_memory) {
+         Stats.Failed++;
+      }
+      return Result;
+   }
+   Tid++;
+   Stats.Sent++;
+   if(++Stats.InFlight > Stats.MaxInFlight) {
+      Stats.MaxInFlight = Stats.InFlight;
+   }
+
+   *p = *pNew;
+   p->Used = true;
+   p->Tries = 1;
+   p->Order = NextOrder++;
+   p->Sent = RTCC_CounterGet();
+   TimerStart(&p->Timer,Timeout(1),0,Expired,p);
+   return bg_err_success;
+}
+
+uint16_t ReqGenericSet(uint16_t Address,uint16_t ModelID,uint8_t Type,uint32_t Transition,
+                       const uint8_t *pParams,uint8_t Len)
+{
+   Request_t Request;
+
+   if(Len > REQ_MAX_PARAMS) {
+      return bg_err_invalid_param;
+   }
+   memset(&Request,0,sizeof(Request));
+   Request.Address = Address;
+   Request.ModelID = ModelID;
+   Request.Type = Type;
+   Request.Transition = Transition;
+   Request.Status = StatusType(Type);
+   Request.Len = Len;
+   memcpy(Request.Params,pParams,Len);
+   return Send(&Request);
+}
+
+uint16_t ReqGenericGet(uint16_t Address,uint16_t ModelID,uint8_t Type)
+{
+   Request_t Request;
+   int i;
+
+   for(i = 0; i < REQ_TRACKER_SIZE; i++) {
+      const Request_t *p = &Table[i];
+
+      if(p->Used && p->Get && p->Address == Address && p->ModelID == ModelID && p->Type == Type) {
+         return bg_err_success;
+      }
+   }
+   memset(&Request,0,sizeof(Request));
+   Request.Get = true;
+   Request.Address = Address;
+   Request.ModelID = ModelID;
+   Request.Type = Type;
+   Request.Status = Type;
+   return Send(&Request);
+}
+
+uint16_t ReqSceneRecall(uint16_t Address,uint16_t Scene,uint32_t Transition,ReqDone_t Done)
+{
+   Request_t Request;
+
+   memset(&Request,0,sizeof(Request));
+   Request.Scene = true;
+   Request.Done = Done;
+   Request.Address = Address;
+   Request.Transition = Transition;
+   Request.Len = 2;
+   Request.Params[0] = Scene;
+   Request.Params[1] = Scene >> 8;
+   return Send(&Request);
+}
+
+/// Completes the oldest request matching a status, Type is the state type of
+/// a generic status
+static void Complete(uint16_t Address,bool Scene,uint16_t ModelID,uint8_t Type)
+{
+   Request_t *pOldest = NULL;
+   uint32_t RttMs;
+   int i;
+
+   for(i = 0; i < REQ_TRACKER_SIZE; i++) {
+      Request_t *p = &Table[i];
+
+      if(p->Used && p->Address == Address && p->Scene == Scene && p->ModelID == ModelID
+         && (Scene || p->Status == Type) && (pOldest == NULL || (int32_t) (p->Order - pOldest->Order) < 0)) {
+         pOldest = p;
+      }
+   }
+
+   if(pOldest == NULL) {
+      // a late status, a status of another state or one of a group
+      Stats.Unmatched++;
+      return;
+   }
+
+   RttMs = (uint32_t) ((uint64_t) (RTCC_CounterGet() - pOldest->Sent) * 1000 / TIMER_CLK_FREQ);
+   Stats.TotalRttMs += RttMs;
+   if(RttMs > Stats.MaxRttMs) {
+      Stats.MaxRttMs = RttMs;
+   }
+   Stats.Acked++;
+   Free(pOldest,bg_err_success);
+}
+
+void ReqGenericStatus(const struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus)
+{
+   if(!IS_UNICAST(pStatus->client_address)) {
+      // published, not an answer
+      Stats.Unmatched++;
+      return;
+   }
+   Complete(pStatus->server_address,false,pStatus->model_id,pStatus->type);
+}
+
+static void HandleSceneStatus(struct gecko_cmd_packet *pEvt)
+{
+   struct gecko_msg_mesh_scene_client_status_evt_t *pStatus = &pEvt->data.evt_mesh_scene_client_status;
+
+   if(pStatus->status != 0) {
+      LOG("scene status 0x%x from 0x%04x\n",pStatus->status,pStatus->server_address);
+   }
+   Complete(pStatus->server_address,true,0,0);
+}
+
+void ReqInit(void)
+{
+   int i;
+
+   for(i = 0; i < REQ_TRACKER_SIZE; i++) {
+      TimerStop(&Table[i].Timer);
+   }
+   memset(Table,0,sizeof(Table));
+   memset(&Stats,0,sizeof(Stats));
+   EventDispatchRegister(gecko_evt_mesh_scene_client_status_id,HandleSceneStatus);
+}
+
+void ReqSetWindow(uint8_t NewWindow)
+{
+   Window = NewWindow != 0 ? NewWindow : 1;
+}
+
+const ReqStats_t *ReqGetStats(void)
+{
+   return &Stats;
+}
+
+/** @} (end addtogroup RequestTracker) */
@@ -0,0 +1,155 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef REQUEST_TRACKER_H
+#define REQUEST_TRACKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+
+/***************************************************************************//**
+ * \defgroup RequestTracker
+ * \brief Acknowledged generic set, generic get and scene recall requests.
+ *
+ * Requests to unicast addresses are sent with the response required flag and
+ * kept in a table of outstanding requests until the server's status arrives.
+ * Gets are kept in the same table, so the status answering a get is not
+ * taken for the status of a set.
+ * Each request gets its own transaction ID, which is kept for the
+ * retransmissions so the server can tell them from new requests. Without a
+ * status the request is sent again after REQ_TIMEOUT_MS, doubling up to
+ * REQ_MAX_TIMEOUT_MS, at most REQ_TRIES times.
+ *
+ * Up to a window of requests may be outstanding per destination. A status
+ * carries no transaction ID, so it completes the oldest outstanding request
+ * of its server, client model and state type, or the oldest scene recall of
+ * its server. Statuses published to a group or virtual address and those
+ * without an outstanding request are counted as unmatched.
+ *
+ * Requests to group and virtual addresses are sent once without a response,
+ * they are not tracked.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup RequestTracker
+ * @{
+ ******************************************************************************/
+
+/// Outstanding requests of all destinations
+#ifndef REQ_TRACKER_SIZE
+#define REQ_TRACKER_SIZE      32
+#endif
+
+/// Default number of outstanding requests per destination
+#ifndef REQ_WINDOW
+#define REQ_WINDOW            4
+#endif
+
+/// Time to the first retransmission
+#ifndef REQ_TIMEOUT_MS
+#define REQ_TIMEOUT_MS        400
+#endif
+
+/// Longest time between retransmissions
+#ifndef REQ_MAX_TIMEOUT_MS
+#define REQ_MAX_TIMEOUT_MS    3200
+#endif
+
+/// Transmissions of a request before it is given up
+#ifndef REQ_TRIES
+#define REQ_TRIES             4
+#endif
+
+/// Largest request parameter block (CTL: lightness, temperature, delta UV)
+#define REQ_MAX_PARAMS        6
+
+/// Called when a tracked request is done, Result is bg_err_success when the
+/// status arrived, bg_err_timeout when no status came after REQ_TRIES
+/// transmissions or the error of the stack. Tries is the number of
+/// transmissions of the request.
+typedef void (*ReqDone_t)(uint16_t Address,uint16_t Result,uint8_t Tries);
+
+typedef struct {
+   uint32_t Sent;             ///< Requests sent the first time
+   uint32_t Retries;          ///< Retransmissions
+   uint32_t Acked;            ///< Requests completed by a status
+   uint32_t TimedOut;         ///< Requests given up after REQ_TRIES transmissions
+   uint32_t Busy;             ///< Requests refused because the window or table was full
+   uint32_t Failed;           ///< Requests the stack refused
+   uint32_t Unmatched;        ///< Status events without an outstanding request
+   uint32_t TotalRttMs;       ///< Sum of the times from the first transmission to the status
+   uint32_t MaxRttMs;
+   uint16_t InFlight;         ///< Outstanding requests
+   uint16_t MaxInFlight;
+} ReqStats_t;
+
+/***************************************************************************//**
+ *  Clear the table and register the scene status handler.
+ ******************************************************************************/
+void ReqInit(void);
+
+/***************************************************************************//**
+ *  Check if a request to a destination would be taken now.
+ ******************************************************************************/
+bool ReqWindowOpen(uint16_t Address);
+
+/***************************************************************************//**
+ *  Send a generic client set request.
+ *
+ *  @param[in] Address     Destination address.
+ *  @param[in] ModelID     Client model, e.g. MESH_LIGHTING_CTL_CLIENT_MODEL_ID.
+ *  @param[in] Type        Request type, e.g. mesh_lighting_request_ctl.
+ *  @param[in] Transition  Transition time in ms.
+ *  @param[in] pParams     Request parameters, at most REQ_MAX_PARAMS bytes.
+ *  @param[in] Len         Length of the parameters.
+ *  @return Result of the stack, bg_err_out_of_memory if the window of the
+ *          destination or the table is full: send it again later.
+ ******************************************************************************/
+uint16_t ReqGenericSet(uint16_t Address,uint16_t ModelID,uint8_t Type,uint32_t Transition,
+                       const uint8_t *pParams,uint8_t Len);
+
+/***************************************************************************//**
+ *  Send a generic client get request, the result is the same as for
+ *  ReqGenericSet(). A get of the same state that is still outstanding is not
+ *  sent again, its status answers both.
+ *
+ *  @param[in] Address  Destination address.
+ *  @param[in] ModelID  Client model, e.g. MESH_LIGHTING_CTL_CLIENT_MODEL_ID.
+ *  @param[in] Type     State type, e.g. mesh_lighting_state_ctl.
+ ******************************************************************************/
+uint16_t ReqGenericGet(uint16_t Address,uint16_t ModelID,uint8_t Type);
+
+/***************************************************************************//**
+ *  Send a scene recall request, the result is the same as for ReqGenericSet().
+ *
+ *  @param[in] Done  Called when a request to a unicast address is done, may
+ *                   be NULL. Not called if the request was not taken.
+ ******************************************************************************/
+uint16_t ReqSceneRecall(uint16_t Address,uint16_t Scene,uint32_t Transition,ReqDone_t Done);
+
+/***************************************************************************//**
+ *  Complete a generic set or get with its status, called for the generic
+ *  client server status events.
+ ******************************************************************************/
+void ReqGenericStatus(const struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus);
+
+/***************************************************************************//**
+ *  Change the number of outstanding requests per destination, 1 sends one
+ *  request at a time.
+ ******************************************************************************/
+void ReqSetWindow(uint8_t Window);
+
+const ReqStats_t *ReqGetStats(void);
+
+/** @} (end addtogroup RequestTracker) */
+
+#endif /* REQUEST_TRACKER_H */
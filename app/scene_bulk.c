@@ -0,0 +1,182 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "em_rtcc.h"
+#include "native_gecko.h"
+#include "scene_bulk.h"
+#include "request_tracker.h"
+#include "timer_wheel.h"
+#define LOG_MODULE   SCENE
+#include "darwin_log.h"
+
+/***************************************************************************//**
+ * @addtogroup SceneBulk
+ * @{
+ ******************************************************************************/
+
+#define IS_UNICAST(Address)   (((Address) & 0x8000) == 0)
+
+enum {
+   TARGET_PENDING,            ///< Not sent yet
+   TARGET_SENT,               ///< Waiting for the status
+   TARGET_DONE,
+};
+
+typedef struct {
+   uint16_t Address;
+   uint8_t State;
+} Target_t;
+
+static Target_t Targets[SCENE_BULK_MAX_TARGETS];
+static uint16_t Failed[SCENE_BULK_MAX_TARGETS];
+static SceneBulkResult_t Result;
+static SceneBulkDone_t DoneCallback;
+static bool Running;
+static int Count;
+/// Next target to send, the ones before it are sent or done
+static int Next;
+static int Outstanding;
+static uint32_t Transition;
+static uint32_t Started;
+static Timer_t SlotTimer;
+
+static void Finish(void)
+{
+   SceneBulkDone_t Done = DoneCallback;
+
+   Result.ElapsedMs = (uint32_t) ((uint64_t) (RTCC_CounterGet() - Started) * 1000 / TIMER_CLK_FREQ);
+   Result.pFailed = Failed;
+   LOG("scene %d: %d targets, %d acked, %d groups, %d failed in %lu ms\n",Result.Scene,Result.Targets,Result.Acked,
+       Result.Groups,Result.Failed,(unsigned long) Result.ElapsedMs);
+   // a new bulk recall may be started from the callback
+   Running = false;
+   if(Done != NULL) {
+      Done(&Result);
+   }
+}
+
+static void Fail(Target_t *p)
+{
+   p->State = TARGET_DONE;
+   Failed[Result.Failed++] = p->Address;
+}
+
+/// Called by the request tracker for the unicast targets
+static void TargetDone(uint16_t Address,uint16_t Status,uint8_t Tries)
+{
+   int i;
+
+   if(!Running) {
+      return;
+   }
+   for(i = 0; i < Next; i++) {
+      Target_t *p = &Targets[i];
+
+      if(p->State == TARGET_SENT && p->Address == Address) {
+         Result.Retries += Tries - 1;
+         if(Status == bg_err_success) {
+            p->State = TARGET_DONE;
+            Result.Acked++;
+         }
+         else {
+            Fail(p);
+         }
+         Outstanding--;
+         break;
+      }
+   }
+   if(Next == Count && Outstanding == 0) {
+      Finish();
+   }
+}
+
+static void SendSlot(Timer_t *pTimer)
+{
+   int Sent;
+
+   for(Sent = 0; Sent < SCENE_BULK_BURST && Next < Count; Sent++) {
+      Target_t *p = &Targets[Next];
+      uint16_t Status = ReqSceneRecall(p->Address,Result.Scene,Transition,TargetDone);
+
+      if(Status == bg_err_out_of_memory) {
+         // the window or the stack is full, try again on the next slot
+         break;
+      }
+      Next++;
+      if(Status != bg_err_success) {
+         ELOG("scene recall to 0x%04x failed: 0x%x\n",p->Address,Status);
+         Fail(p);
+      }
+      else if(IS_UNICAST(p->Address)) {
+         p->State = TARGET_SENT;
+         Outstanding++;
+      }
+      else {
+         p->State = TARGET_DONE;
+         Result.Groups++;
+      }
+   }
+
+   if(Next < Count) {
+      TimerStart(&SlotTimer,SCENE_BULK_STAGGER_MS + RTCC_CounterGet() % SCENE_BULK_STAGGER_MS,0,
+                 SendSlot,NULL);
+   }
+   else if(Outstanding == 0) {
+      Finish();
+   }
+}
+
+bool SceneBulkRecall(uint16_t Scene,uint32_t NewTransition,const uint16_t *pTargets,int NewCount,
+                     SceneBulkDone_t Done)
+{
+   int i;
+
+   if(Running || NewCount <= 0 || NewCount > SCENE_BULK_MAX_TARGETS) {
+      return false;
+   }
+
+   // groups first, then the unicast targets in the given order
+   Count = 0;
+   for(i = 0; i < NewCount; i++) {
+      if(!IS_UNICAST(pTargets[i])) {
+         Targets[Count++].Address = pTargets[i];
+      }
+   }
+   for(i = 0; i < NewCount; i++) {
+      if(IS_UNICAST(pTargets[i])) {
+         Targets[Count++].Address = pTargets[i];
+      }
+   }
+   for(i = 0; i < Count; i++) {
+      Targets[i].State = TARGET_PENDING;
+   }
+
+   memset(&Result,0,sizeof(Result));
+   Result.Scene = Scene;
+   Result.Targets = Count;
+   DoneCallback = Done;
+   Transition = NewTransition;
+   Next = 0;
+   Outstanding = 0;
+   Started = RTCC_CounterGet();
+   Running = true;
+
+   SendSlot(&SlotTimer);
+   return true;
+}
+
+bool SceneBulkBusy(void)
+{
+   return Running;
+}
+
+/** @} (end addtogroup SceneBulk) */
@@ -0,0 +1,90 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef SCENE_BULK_H
+#define SCENE_BULK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/***************************************************************************//**
+ * \defgroup SceneBulk
+ * \brief One scene recall to many targets with one aggregated result.
+ *
+ * The targets are sent by the request tracker, group and virtual addresses
+ * first since one of them reaches many nodes. Every SCENE_BULK_STAGGER_MS,
+ * plus a random part of it, up to SCENE_BULK_BURST recalls are sent, so the
+ * nodes do not all answer at once and the advertising bearer is not flooded.
+ * A recall the tracker cannot take yet is sent again on the next slot.
+ *
+ * Unicast targets are acknowledged by their scene status, the tracker
+ * retransmits only to the targets that have not answered. Groups are sent
+ * once without a status. When every target is done the result is passed to
+ * the done callback. The time of a bulk recall is the number of targets
+ * divided by the send rate plus the retransmissions of the slowest target,
+ * at most REQ_TRIES timeouts.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup SceneBulk
+ * @{
+ ******************************************************************************/
+
+/// Targets of one bulk recall
+#ifndef SCENE_BULK_MAX_TARGETS
+#define SCENE_BULK_MAX_TARGETS   128
+#endif
+
+/// Time between two send slots, a random part of it is added
+#ifndef SCENE_BULK_STAGGER_MS
+#define SCENE_BULK_STAGGER_MS    20
+#endif
+
+/// Recalls sent per slot
+#ifndef SCENE_BULK_BURST
+#define SCENE_BULK_BURST         2
+#endif
+
+typedef struct {
+   uint16_t Scene;
+   uint16_t Targets;
+   uint16_t Acked;            ///< Unicast targets that sent their status
+   uint16_t Groups;           ///< Group targets sent without a status
+   uint16_t Failed;           ///< Targets without status or refused by the stack
+   uint16_t Retries;          ///< Retransmissions to the unicast targets
+   uint32_t ElapsedMs;        ///< From the start to the last target
+   const uint16_t *pFailed;   ///< Addresses of the failed targets
+} SceneBulkResult_t;
+
+typedef void (*SceneBulkDone_t)(const SceneBulkResult_t *pResult);
+
+/***************************************************************************//**
+ *  Start a bulk scene recall.
+ *
+ *  @param[in] Scene       Scene number.
+ *  @param[in] Transition  Transition time in ms.
+ *  @param[in] pTargets    Group and unicast addresses, copied.
+ *  @param[in] Count       Number of targets, at most SCENE_BULK_MAX_TARGETS.
+ *  @param[in] Done        Called with the result, the result is only valid
+ *                         during the call.
+ *  @return false if a bulk recall is running or the arguments are invalid.
+ ******************************************************************************/
+bool SceneBulkRecall(uint16_t Scene,uint32_t Transition,const uint16_t *pTargets,int Count,
+                     SceneBulkDone_t Done);
+
+/***************************************************************************//**
+ *  Check if a bulk recall is running.
+ ******************************************************************************/
+bool SceneBulkBusy(void);
+
+/** @} (end addtogroup SceneBulk) */
+
+#endif /* SCENE_BULK_H */
@@ -0,0 +1,142 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "scheduler.h"
+#include "darwin_cycles.h"
+
+/***************************************************************************//**
+ * @addtogroup Scheduler
+ * @{
+ ******************************************************************************/
+
+/// FIFO of queued tasks per priority
+static Task_t *Head[SCHED_PRIORITIES];
+static Task_t *Tail[SCHED_PRIORITIES];
+static SchedStats_t Stats;
+/// Start of the running slice
+static uint32_t SliceStart;
+static bool Unlimited;
+
+static void Append(Task_t *p)
+{
+   p->pNext = NULL;
+   if(Head[p->Priority] == NULL) {
+      Head[p->Priority] = p;
+   }
+   else {
+      Tail[p->Priority]->pNext = p;
+   }
+   Tail[p->Priority] = p;
+}
+
+void SchedInit(void)
+{
+   memset(Head,0,sizeof(Head));
+   memset(Tail,0,sizeof(Tail));
+   memset(&Stats,0,sizeof(Stats));
+   SchedSetSlice(SCHED_SLICE_US);
+}
+
+void SchedTaskInit(Task_t *pTask,TaskFunc_t Run,void *pArg,uint8_t Priority)
+{
+   memset(pTask,0,sizeof(*pTask));
+   pTask->Run = Run;
+   pTask->pArg = pArg;
+   pTask->Priority = Priority < SCHED_PRIORITIES ? Priority : SCHED_PRIO_LOW;
+}
+
+void SchedPost(Task_t *pTask)
+{
+   if(!pTask->Queued) {
+      pTask->Queued = true;
+      pTask->Posted = CYCLE_COUNT();
+      Append(pTask);
+   }
+}
+
+bool SchedRun(void)
+{
+   EventHandlerStats_t *pStats;
+   Task_t *p = NULL;
+   uint32_t Posted;
+   uint32_t Cycles;
+   bool More;
+   int i;
+
+   for(i = 0; i < SCHED_PRIORITIES && p == NULL; i++) {
+      p = Head[i];
+   }
+   if(p == NULL) {
+      return false;
+   }
+   Head[p->Priority] = p->pNext;
+   // a post from inside Run() queues the task again
+   p->Queued = false;
+   Posted = p->Posted;
+
+   SliceStart = CYCLE_COUNT();
+   More = p->Run(p);
+   Cycles = CYCLE_COUNT() - SliceStart;
+
+   pStats = &Stats.Prio[p->Priority];
+   pStats->Count++;
+   pStats->TotalCycles += Cycles;
+   if(Cycles > pStats->MaxCycles) {
+      pStats->MaxCycles = Cycles;
+   }
+   if(!Unlimited && Cycles > 2 * Stats.SliceCycles) {
+      Stats.Overruns++;
+   }
+
+   if(More) {
+      // behind the other tasks of the same priority, still the same post
+      p->Posted = Posted;
+      if(!p->Queued) {
+         p->Queued = true;
+         Append(p);
+      }
+   }
+   else {
+      EventRecordLatency(pStats,SliceStart + Cycles - Posted);
+   }
+   return true;
+}
+
+bool SchedExpired(void)
+{
+   return !Unlimited && CYCLE_COUNT() - SliceStart >= Stats.SliceCycles;
+}
+
+bool SchedPending(void)
+{
+   int i;
+
+   for(i = 0; i < SCHED_PRIORITIES; i++) {
+      if(Head[i] != NULL) {
+         return true;
+      }
+   }
+   return false;
+}
+
+void SchedSetSlice(uint32_t Us)
+{
+   Unlimited = Us == 0;
+   Stats.SliceCycles = (uint32_t) ((uint64_t) SystemCoreClockGet() * Us / 1000000);
+}
+
+const SchedStats_t *SchedGetStats(void)
+{
+   return &Stats;
+}
+
+/** @} (end addtogroup Scheduler) */
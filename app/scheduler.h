@@ -0,0 +1,114 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "event_dispatch.h"
+
+/***************************************************************************//**
+ * \defgroup Scheduler
+ * \brief Run-to-completion background tasks between stack events.
+ *
+ * Work that takes longer than an event handler should is posted as a task.
+ * The main loop runs one slice of the highest priority task whenever no
+ * stack event is waiting and sleeps only when no task is queued, so an
+ * event never waits longer than one slice.
+ *
+ * A slice is one call of the task function. The task does as much work as
+ * it can until SchedExpired() returns true and returns true if it has more
+ * to do. It is then queued again behind the other tasks of its priority.
+ *
+ * Per priority the time from posting a task to the end of its slices is
+ * kept in the event latency histogram format, handler cycles count the
+ * slice run time.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup Scheduler
+ * @{
+ ******************************************************************************/
+
+/// Default slice budget
+#ifndef SCHED_SLICE_US
+#define SCHED_SLICE_US     1000
+#endif
+
+#define SCHED_PRIO_HIGH    0
+#define SCHED_PRIO_NORMAL  1
+#define SCHED_PRIO_LOW     2
+#define SCHED_PRIORITIES   3
+
+typedef struct Task_s Task_t;
+
+/// Runs one slice, returns true if there is more work
+typedef bool (*TaskFunc_t)(Task_t *pTask);
+
+/// Task, the fields are private to the scheduler
+struct Task_s {
+   Task_t *pNext;
+   TaskFunc_t Run;
+   void *pArg;                ///< For the task function
+   uint32_t Posted;           ///< CYCLE_COUNT() when the task was posted
+   uint8_t Priority;
+   bool Queued;
+};
+
+typedef struct {
+   uint32_t Overruns;         ///< Slices longer than twice the budget
+   uint32_t SliceCycles;      ///< Budget in CPU cycles
+   EventHandlerStats_t Prio[SCHED_PRIORITIES];
+} SchedStats_t;
+
+/***************************************************************************//**
+ *  Clear the queues and statistics.
+ ******************************************************************************/
+void SchedInit(void);
+
+/***************************************************************************//**
+ *  Set up a task, it is not queued.
+ ******************************************************************************/
+void SchedTaskInit(Task_t *pTask,TaskFunc_t Run,void *pArg,uint8_t Priority);
+
+/***************************************************************************//**
+ *  Queue a task, nothing happens if it is queued already. A task that posts
+ *  itself from its function runs again even if the function returns false.
+ ******************************************************************************/
+void SchedPost(Task_t *pTask);
+
+/***************************************************************************//**
+ *  Run one slice of the first task of the highest priority, called from the
+ *  main loop when no event is waiting.
+ *
+ *  @return true if a slice was run.
+ ******************************************************************************/
+bool SchedRun(void);
+
+/***************************************************************************//**
+ *  Check the budget of the current slice, for the task functions.
+ ******************************************************************************/
+bool SchedExpired(void);
+
+/// A task is queued
+bool SchedPending(void);
+
+/***************************************************************************//**
+ *  Change the slice budget, 0 runs every task to completion.
+ ******************************************************************************/
+void SchedSetSlice(uint32_t Us);
+
+const SchedStats_t *SchedGetStats(void);
+
+/** @} (end addtogroup Scheduler) */
+
+#endif /* SCHEDULER_H */
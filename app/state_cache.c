@@ -0,0 +1,203 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "em_rtcc.h"
+#include "state_cache.h"
+#include "app_timer.h"
+#include "client_queue.h"
+#include "request_tracker.h"
+
+/***************************************************************************//**
+ * @addtogroup StateCache
+ * @{
+ ******************************************************************************/
+
+#define MASK   (STATE_CACHE_SIZE - 1)
+
+static StateEntry_t Table[STATE_CACHE_SIZE];
+static StateCacheStats_t Stats;
+
+static uint32_t Home(uint16_t Address,uint8_t Element,uint16_t ModelID)
+{
+   uint32_t Key = ((uint32_t) Address << 16 | ModelID) ^ ((uint32_t) Element << 8);
+
+   // Fibonacci hashing, the top bits of the product are the best mixed
+   return (uint32_t) (Key * 0x9E3779B1UL) >> (32 - STATE_CACHE_BITS);
+}
+
+static bool Match(const StateEntry_t *p,uint16_t Address,uint8_t Element,uint16_t ModelID)
+{
+   return p->Address == Address && p->ModelID == ModelID && p->Element == Element;
+}
+
+/// Slot of a key, or of the free slot ending its probe run
+static uint32_t Find(uint16_t Address,uint8_t Element,uint16_t ModelID)
+{
+   uint32_t i = Home(Address,Element,ModelID);
+   uint16_t Probe = 1;
+
+   while(Table[i].Address != 0 && !Match(&Table[i],Address,Element,ModelID)) {
+      i = (i + 1) & MASK;
+      Probe++;
+   }
+   if(Probe > Stats.MaxProbe) {
+      Stats.MaxProbe = Probe;
+   }
+   return i;
+}
+
+/// Frees a slot and moves the following entries of the run back into it
+static void Remove(uint32_t i)
+{
+   uint32_t j = i;
+
+   Table[i].Address = 0;
+   Stats.Entries--;
+   for(;;) {
+      uint32_t k;
+
+      j = (j + 1) & MASK;
+      if(Table[j].Address == 0) {
+         return;
+      }
+      // an entry may fill the hole unless its home lies cyclically in (i, j]
+      k = Home(Table[j].Address,Table[j].Element,Table[j].ModelID);
+      if(((j - k) & MASK) >= ((j - i) & MASK)) {
+         Table[i] = Table[j];
+         Table[j].Address = 0;
+         i = j;
+      }
+   }
+}
+
+/// Evicts the oldest entry near the home slot of a new key
+static void Evict(uint32_t Home)
+{
+   uint32_t Now = RTCC_CounterGet();
+   uint32_t Oldest = Home;
+   uint32_t i;
+   int n;
+
+   for(n = 0, i = Home; n < STATE_CACHE_EVICT_WINDOW; n++, i = (i + 1) & MASK) {
+      if(Table[i].Address == 0) {
+         continue;
+      }
+      if(Table[Oldest].Address == 0 || Now - Table[i].Updated > Now - Table[Oldest].Updated) {
+         Oldest = i;
+      }
+   }
+   if(Table[Oldest].Address == 0) {
+      // nothing near the home slot, take the first entry after it
+      for(i = Home; Table[i].Address == 0; i = (i + 1) & MASK);
+      Oldest = i;
+   }
+   Remove(Oldest);
+   Stats.Evictions++;
+}
+
+void StateCacheInit(void)
+{
+   memset(Table,0,sizeof(Table));
+   memset(&Stats,0,sizeof(Stats));
+}
+
+void StateCacheUpdate(const struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus)
+{
+   uint16_t Address = pStatus->server_address;
+   uint8_t Element = pStatus->elem_index;
+   uint16_t ModelID = pStatus->model_id;
+   StateEntry_t *p;
+   uint32_t i;
+
+   if(Address == 0 || Address >= 0x8000) {
+      // only unicast servers are cached
+      return;
+   }
+
+   i = Find(Address,Element,ModelID);
+   if(Table[i].Address == 0) {
+      if(Stats.Entries >= STATE_CACHE_MAX_ENTRIES) {
+         Evict(Home(Address,Element,ModelID));
+         i = Find(Address,Element,ModelID);
+      }
+      Stats.Entries++;
+   }
+
+   p = &Table[i];
+   p->Address = Address;
+   p->Element = Element;
+   p->ModelID = ModelID;
+   p->Type = pStatus->type;
+   p->Len = pStatus->parameters.len < STATE_CACHE_MAX_PARAMS ? pStatus->parameters.len : STATE_CACHE_MAX_PARAMS;
+   memcpy(p->Params,pStatus->parameters.data,p->Len);
+   p->Remaining = pStatus->remaining;
+   p->Updated = RTCC_CounterGet();
+   Stats.Updates++;
+}
+
+const StateEntry_t *StateCacheGet(uint16_t Address,uint8_t Element,uint16_t ModelID,uint32_t MaxAgeMs,
+                                  uint32_t *pAgeMs)
+{
+   const StateEntry_t *p = &Table[Find(Address,Element,ModelID)];
+   uint32_t AgeMs;
+
+   if(p->Address == 0) {
+      Stats.Misses++;
+      return NULL;
+   }
+
+   AgeMs = (uint32_t) ((uint64_t) (RTCC_CounterGet() - p->Updated) * 1000 / TIMER_CLK_FREQ);
+   if(pAgeMs != NULL) {
+      *pAgeMs = AgeMs;
+   }
+   if(AgeMs > MaxAgeMs) {
+      Stats.Stale++;
+      return NULL;
+   }
+   Stats.Hits++;
+   return p;
+}
+
+const StateEntry_t *StateCacheQuery(uint16_t Address,uint8_t Element,uint16_t ModelID,uint32_t MaxAgeMs,
+                                    uint32_t *pAgeMs,bool *pRequested)
+{
+   const StateEntry_t *p = StateCacheGet(Address,Element,ModelID,MaxAgeMs,pAgeMs);
+   uint8_t Type;
+
+   *pRequested = false;
+   if(p != NULL) {
+      return p;
+   }
+
+   switch(ModelID) {
+      case MESH_GENERIC_ON_OFF_CLIENT_MODEL_ID:
+         Type = mesh_generic_state_on_off;
+         break;
+      case MESH_LIGHTING_LIGHTNESS_CLIENT_MODEL_ID:
+         Type = mesh_lighting_state_lightness_actual;
+         break;
+      case MESH_LIGHTING_CTL_CLIENT_MODEL_ID:
+         Type = mesh_lighting_state_ctl;
+         break;
+      default:
+         return NULL;
+   }
+   *pRequested = ReqGenericGet(Address,ModelID,Type) == bg_err_success;
+   return NULL;
+}
+
+const StateCacheStats_t *StateCacheGetStats(void)
+{
+   return &Stats;
+}
+
+/** @} (end addtogroup StateCache) */
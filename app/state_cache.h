@@ -0,0 +1,110 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+
+/***************************************************************************//**
+ * \defgroup StateCache
+ * \brief Last state reported by the generic servers of the mesh nodes.
+ *
+ * Every generic client server status event updates the entry of its
+ * (server address, client element, client model) key with the reported
+ * state, the remaining transition time and the RTCC time of the report.
+ *
+ * The entries are kept in a static open addressing table with linear
+ * probing. Deleted entries are closed up by moving the rest of their probe
+ * run back, so lookups never pass tombstones. When the table is at its load
+ * limit the oldest entry near the new key's home slot is evicted.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup StateCache
+ * @{
+ ******************************************************************************/
+
+/// Table slots as a power of 2
+#ifndef STATE_CACHE_BITS
+#define STATE_CACHE_BITS         7
+#endif
+#define STATE_CACHE_SIZE         (1 << STATE_CACHE_BITS)
+
+/// Entries stored before old ones are evicted, 75 % of the slots
+#define STATE_CACHE_MAX_ENTRIES  (STATE_CACHE_SIZE * 3 / 4)
+
+/// Slots from the home slot searched for the entry to evict
+#define STATE_CACHE_EVICT_WINDOW 8
+
+/// Largest state kept (CTL with target values)
+#define STATE_CACHE_MAX_PARAMS   9
+
+/// Cached state, Address 0 marks a free slot
+typedef struct {
+   uint16_t Address;       ///< Unicast address of the server element
+   uint16_t ModelID;       ///< Client model that received the status
+   uint8_t Element;        ///< Element index of the client model
+   uint8_t Type;           ///< mesh_generic_state_t of the parameters
+   uint8_t Len;
+   uint8_t Params[STATE_CACHE_MAX_PARAMS];
+   uint32_t Remaining;     ///< Remaining transition time in ms
+   uint32_t Updated;       ///< RTCC ticks of the last report
+} StateEntry_t;
+
+typedef struct {
+   uint32_t Updates;       ///< Status events stored
+   uint32_t Hits;          ///< Lookups answered from the cache
+   uint32_t Misses;        ///< Lookups without an entry
+   uint32_t Stale;         ///< Lookups with an entry older than asked for
+   uint32_t Evictions;     ///< Entries dropped to make room
+   uint16_t Entries;       ///< Entries in the table
+   uint16_t MaxProbe;      ///< Longest probe run seen
+} StateCacheStats_t;
+
+void StateCacheInit(void);
+
+/***************************************************************************//**
+ *  Store the state of a generic client server status event.
+ ******************************************************************************/
+void StateCacheUpdate(const struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus);
+
+/***************************************************************************//**
+ *  Look up a state.
+ *
+ *  @param[in] Address   Unicast address of the server element.
+ *  @param[in] Element   Element index of the client model.
+ *  @param[in] ModelID   Client model ID.
+ *  @param[in] MaxAgeMs  Oldest report accepted.
+ *  @param[out] pAgeMs   Age of the report, may be NULL.
+ *  @return Entry, NULL if there is none or it is too old.
+ ******************************************************************************/
+const StateEntry_t *StateCacheGet(uint16_t Address,uint8_t Element,uint16_t ModelID,uint32_t MaxAgeMs,
+                                  uint32_t *pAgeMs);
+
+/***************************************************************************//**
+ *  Look up a state, ask the server for it if there is no fresh entry. The
+ *  reply arrives as a status event and updates the cache.
+ *
+ *  @param[out] pRequested  Set when a get request was sent.
+ *  @return Entry, NULL if a request was sent or the model is not known.
+ *  @see StateCacheGet()
+ ******************************************************************************/
+const StateEntry_t *StateCacheQuery(uint16_t Address,uint8_t Element,uint16_t ModelID,uint32_t MaxAgeMs,
+                                    uint32_t *pAgeMs,bool *pRequested);
+
+const StateCacheStats_t *StateCacheGetStats(void);
+
+/** @} (end addtogroup StateCache) */
+
+#endif /* STATE_CACHE_H */
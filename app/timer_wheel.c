@@ -0,0 +1,203 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+#include "native_gecko.h"
+#include "em_rtcc.h"
+#include "timer_wheel.h"
+
+/***************************************************************************//**
+ * @addtogroup TimerWheel
+ * @{
+ ******************************************************************************/
+
+#define SLOT_MASK       (TIMER_WHEEL_SLOTS - 1)
+
+static Timer_t *Slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+/// Current wheel tick, the level 0 slot of this tick is due
+static uint32_t Now;
+/// RTCC count of the last tick
+static uint32_t LastRtcc;
+static bool Running;
+static TimerWheelStats_t Stats;
+
+static void Link(Timer_t *p)
+{
+   uint32_t Delta = p->Expiry - Now;
+   Timer_t **ppSlot;
+   int Level;
+
+   if(Delta > TIMER_WHEEL_MAX_TICKS) {
+      Delta = TIMER_WHEEL_MAX_TICKS;
+      p->Expiry = Now + Delta;
+   }
+   // the level whose slot span still separates the expiry from now
+   for(Level = 0; Level < TIMER_WHEEL_LEVELS - 1; Level++) {
+      if(Delta < (1UL << (TIMER_WHEEL_BITS * (Level + 1)))) {
+         break;
+      }
+   }
+   ppSlot = &Slots[Level][(p->Expiry >> (TIMER_WHEEL_BITS * Level)) & SLOT_MASK];
+
+   p->pNext = *ppSlot;
+   if(p->pNext != NULL) {
+      p->pNext->ppPrev = &p->pNext;
+   }
+   p->ppPrev = ppSlot;
+   *ppSlot = p;
+}
+
+static void Unlink(Timer_t *p)
+{
+   *p->ppPrev = p->pNext;
+   if(p->pNext != NULL) {
+      p->pNext->ppPrev = p->ppPrev;
+   }
+   p->pNext = NULL;
+   p->ppPrev = NULL;
+}
+
+/// Moves the timers of a slot one or more levels down
+static void Cascade(int Level,int Slot)
+{
+   Timer_t *p = Slots[Level][Slot];
+
+   Slots[Level][Slot] = NULL;
+   while(p != NULL) {
+      Timer_t *pNext = p->pNext;
+
+      Link(p);
+      Stats.Cascaded++;
+      p = pNext;
+   }
+}
+
+static void StartTicking(bool Start)
+{
+   if(Start) {
+      LastRtcc = RTCC_CounterGet();
+   }
+   gecko_cmd_hardware_set_soft_timer(Start ? TIMER_WHEEL_TICK_RTCC : TIMER_STOP,TIMER_WHEEL_TIMER,REPEATING);
+   Running = Start;
+}
+
+/// Ticks covering at least Ms, the RTCC tick is not a whole number of ms
+static uint32_t MsToTicks(uint32_t Ms)
+{
+   uint32_t Ticks = (TIMER_MS_2_TIMERTICK(Ms) + TIMER_WHEEL_TICK_RTCC - 1) / TIMER_WHEEL_TICK_RTCC;
+
+   return Ticks != 0 ? Ticks : 1;
+}
+
+void TimerWheelInit(void)
+{
+   if(Running) {
+      StartTicking(false);
+   }
+   memset(Slots,0,sizeof(Slots));
+   memset(&Stats,0,sizeof(Stats));
+   Now = 0;
+}
+
+void TimerStart(Timer_t *pTimer,uint32_t Ms,uint32_t PeriodMs,TimerCallback_t Callback,void *pArg)
+{
+   uint32_t Pending;
+
+   if(TimerIsArmed(pTimer)) {
+      Unlink(pTimer);
+   }
+   else if(++Stats.Armed > Stats.MaxArmed) {
+      Stats.MaxArmed = Stats.Armed;
+   }
+
+   if(!Running) {
+      StartTicking(true);
+   }
+
+   // the ticks since the last soft timer event have not been run yet, the
+   // next TimerWheelTick() catches up on them. If part of a tick has passed
+   // too, one more keeps the timer from expiring early.
+   Pending = RTCC_CounterGet() - LastRtcc;
+   pTimer->Expiry = Now + Pending / TIMER_WHEEL_TICK_RTCC + MsToTicks(Ms) + (Pending % TIMER_WHEEL_TICK_RTCC != 0);
+   pTimer->Period = PeriodMs != 0 ? MsToTicks(PeriodMs) : 0;
+   pTimer->Callback = Callback;
+   pTimer->pArg = pArg;
+   Link(pTimer);
+}
+
+void TimerStop(Timer_t *pTimer)
+{
+   if(TimerIsArmed(pTimer)) {
+      Unlink(pTimer);
+      if(--Stats.Armed == 0 && Running) {
+         StartTicking(false);
+      }
+   }
+}
+
+/// Advances the wheel by one tick and runs the timers due
+static void Tick(void)
+{
+   Timer_t **ppSlot;
+   int Level;
+
+   Now++;
+   Stats.Ticks++;
+   // each level wraps into a cascade of the next level's current slot
+   for(Level = 1; Level < TIMER_WHEEL_LEVELS; Level++) {
+      if((Now & ((1UL << (TIMER_WHEEL_BITS * Level)) - 1)) != 0) {
+         break;
+      }
+      Cascade(Level,(Now >> (TIMER_WHEEL_BITS * Level)) & SLOT_MASK);
+   }
+
+   // a callback may start or stop any timer, including ones in this slot
+   ppSlot = &Slots[0][Now & SLOT_MASK];
+   while(*ppSlot != NULL) {
+      Timer_t *p = *ppSlot;
+
+      Unlink(p);
+      if(p->Period != 0) {
+         p->Expiry += p->Period;
+         Link(p);
+      }
+      else {
+         Stats.Armed--;
+      }
+      Stats.Expired++;
+      p->Callback(p);
+   }
+}
+
+void TimerWheelTick(void)
+{
+   uint32_t Rtcc = RTCC_CounterGet();
+
+   if(!Running) {
+      // event of the soft timer queued before it was stopped
+      return;
+   }
+   while(Rtcc - LastRtcc >= TIMER_WHEEL_TICK_RTCC) {
+      LastRtcc += TIMER_WHEEL_TICK_RTCC;
+      Tick();
+   }
+
+   if(Stats.Armed == 0) {
+      StartTicking(false);
+   }
+}
+
+const TimerWheelStats_t *TimerWheelGetStats(void)
+{
+   return &Stats;
+}
+
+/** @} (end addtogroup TimerWheel) */
@@ -0,0 +1,113 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "app_timer.h"
+
+/***************************************************************************//**
+ * \defgroup TimerWheel
+ * \brief Any number of application timers on the TIMER_WHEEL_TIMER soft timer.
+ *
+ * The timers are kept in a hierarchical wheel of TIMER_WHEEL_LEVELS levels
+ * with TIMER_WHEEL_SLOTS slots each. A level covers TIMER_WHEEL_SLOTS
+ * times the span of the level below, timers move down a level each time
+ * the level below wraps. Starting and stopping a timer is O(1), each timer
+ * is moved at most TIMER_WHEEL_LEVELS - 1 times before it expires.
+ *
+ * The soft timer runs with TIMER_WHEEL_TICK_MS only while a timer is armed.
+ * Ticks missed while the event loop was busy are caught up from the RTCC.
+ * A timer never expires early, and at most one tick late.
+ * Timers are owned by the caller, the wheel only links them.
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @addtogroup TimerWheel
+ * @{
+ ******************************************************************************/
+
+/// Resolution of the timers
+#ifndef TIMER_WHEEL_TICK_MS
+#define TIMER_WHEEL_TICK_MS   10
+#endif
+
+/// Tick in RTCC counts
+#define TIMER_WHEEL_TICK_RTCC TIMER_MS_2_TIMERTICK(TIMER_WHEEL_TICK_MS)
+
+#define TIMER_WHEEL_BITS      6
+#define TIMER_WHEEL_SLOTS     (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS    4
+
+/// Longest timeout in ticks, longer ones are cut to it (46 hours with 10 ms)
+#define TIMER_WHEEL_MAX_TICKS ((1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+typedef struct Timer_s Timer_t;
+
+/// Called when a timer expires, a periodic timer is already re-armed
+typedef void (*TimerCallback_t)(Timer_t *pTimer);
+
+/// Timer, the fields are private to the wheel
+struct Timer_s {
+   Timer_t *pNext;
+   Timer_t **ppPrev;          ///< Link pointing to this timer, NULL if not armed
+   uint32_t Expiry;           ///< Wheel tick of the expiry
+   uint32_t Period;           ///< Period in ticks, 0 for a single shot timer
+   TimerCallback_t Callback;
+   void *pArg;                ///< For the callback
+};
+
+typedef struct {
+   uint32_t Armed;            ///< Timers armed now
+   uint32_t MaxArmed;
+   uint32_t Expired;          ///< Callbacks since boot
+   uint32_t Cascaded;         ///< Timers moved down a level
+   uint32_t Ticks;            ///< Wheel ticks since boot
+} TimerWheelStats_t;
+
+/***************************************************************************//**
+ *  Reset the wheel, all timers are forgotten.
+ ******************************************************************************/
+void TimerWheelInit(void);
+
+/***************************************************************************//**
+ *  Start or restart a timer.
+ *
+ *  @param[in] pTimer    Timer, must stay valid while armed.
+ *  @param[in] Ms        Time to the first expiry, at least one tick.
+ *  @param[in] PeriodMs  Time between expiries, 0 for a single shot.
+ *  @param[in] Callback  Called on expiry.
+ *  @param[in] pArg      Passed to the callback in pTimer->pArg.
+ ******************************************************************************/
+void TimerStart(Timer_t *pTimer,uint32_t Ms,uint32_t PeriodMs,TimerCallback_t Callback,void *pArg);
+
+/***************************************************************************//**
+ *  Stop a timer, nothing happens if it is not armed.
+ ******************************************************************************/
+void TimerStop(Timer_t *pTimer);
+
+static inline bool TimerIsArmed(const Timer_t *pTimer)
+{
+   return pTimer->ppPrev != 0;
+}
+
+/***************************************************************************//**
+ *  Run the expired timers, called on the TIMER_WHEEL_TIMER soft timer event.
+ ******************************************************************************/
+void TimerWheelTick(void);
+
+const TimerWheelStats_t *TimerWheelGetStats(void);
+
+/** @} (end addtogroup TimerWheel) */
+
+#endif /* TIMER_WHEEL_H */
@@ -0,0 +1,122 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifdef DARWIN_BOOT
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_rmu.h"
+#include "darwin_boot.h"
+#include "darwin_cycles.h"
+#define LOG_MODULE   BOOT
+#include "darwin_log.h"
+
+#define BOOT_MAGIC   0xB0075EED
+
+typedef struct {
+   uint32_t Magic;
+   BootRecord_t Record;
+   uint32_t Check;
+} Retained_t;
+
+// Not cleared by the startup code
+static Retained_t Retained __attribute__((section(".noinit")));
+static BootRecord_t LastBoot;
+static bool HaveLast;
+
+// Cycle count and core clock in MHz at the last mark
+static uint32_t LastCycles;
+static uint32_t LastMhz;
+static uint32_t Us;
+
+static const char *PhaseNames[BOOT_PHASES] = {"mcu","hfxo","app","stack","mesh"};
+
+static uint32_t Checksum(void)
+{
+   const uint32_t *p = (const uint32_t *) &Retained;
+   uint32_t Sum = 0;
+   int i;
+
+   for(i = 0; i < (int) (offsetof(Retained_t,Check) / 4); i++) {
+      Sum = (Sum << 1 | Sum >> 31) ^ p[i];
+   }
+   return ~Sum;
+}
+
+static void LogRecord(const char *Label,const BootRecord_t *p)
+{
+   int i;
+
+   LOG_RAW("%s boot %lu, reset cause 0x%lx%s\n",Label,(unsigned long) p->Boots,(unsigned long) p->ResetCause,
+           p->FastBoot ? ", fast boot" : "");
+   for(i = 0; i < BOOT_PHASES; i++) {
+      LOG_RAW("  %-5s done at %8lu us\n",PhaseNames[i],(unsigned long) p->EndUs[i]);
+   }
+}
+
+void BootInit(void)
+{
+   uint32_t Boots = 0;
+
+   CycleCounterInit();
+   LastMhz = SystemCoreClockGet() / 1000000;
+
+   if(Retained.Magic == BOOT_MAGIC && Retained.Check == Checksum()) {
+      LastBoot = Retained.Record;
+      HaveLast = true;
+      Boots = LastBoot.Boots + 1;
+   }
+
+   memset(&Retained,0,sizeof(Retained));
+   Retained.Magic = BOOT_MAGIC;
+   Retained.Record.Boots = Boots;
+   // not cleared, the bootloader and the application read it too
+   Retained.Record.ResetCause = RMU_ResetCauseGet();
+#ifdef DARWIN_FAST_BOOT
+   Retained.Record.FastBoot = true;
+#endif
+   Retained.Check = Checksum();
+}
+
+void BootMark(BootPhase_t Phase)
+{
+   uint32_t Now = CYCLE_COUNT();
+
+   Us += (Now - LastCycles) / LastMhz;
+   LastCycles = Now;
+   LastMhz = SystemCoreClockGet() / 1000000;
+
+   Retained.Record.EndUs[Phase] = Us;
+   Retained.Check = Checksum();
+
+   if(Phase == BOOT_PHASE_STACK && HaveLast) {
+      LogRecord("last",&LastBoot);
+   }
+   else if(Phase == BOOT_PHASE_MESH) {
+      LogRecord("this",&Retained.Record);
+   }
+}
+
+const BootRecord_t *BootGetRecord(bool Last)
+{
+   if(Last) {
+      return HaveLast ? &LastBoot : NULL;
+   }
+   return &Retained.Record;
+}
+
+const char *BootPhaseName(BootPhase_t Phase)
+{
+   return Phase < BOOT_PHASES ? PhaseNames[Phase] : "?";
+}
+
+#endif   // DARWIN_BOOT
@@ -0,0 +1,65 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _DARWIN_BOOT_H_
+#define _DARWIN_BOOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Boot phase profiler, enabled by DARWIN_BOOT.
+//
+// BOOT_MARK() stores the time from the start of main() to the end of a boot
+// phase. The record lives in RAM that the startup code does not initialize
+// (section .noinit, placed after .bss by the linker), so the record of the
+// previous boot survives a watchdog, software or DFU reset. It is checked
+// with a checksum, after a power on reset there is no previous record.
+//
+// Time is counted with the DWT cycle counter and converted with the core
+// clock in effect at the start of each phase. The time spent in the
+// bootloader and the startup code before main() is not included.
+//
+// The previous boot is logged when the stack has booted, the current one
+// when the mesh node is initialized.
+
+typedef enum {
+   BOOT_PHASE_MCU,      // initMcu(), with the HFXO wait unless DARWIN_FAST_BOOT
+   BOOT_PHASE_HFXO,     // board init and RAM painting overlapped with the HFXO start
+   BOOT_PHASE_APP,      // SWO, initApp() and the rest of main()
+   BOOT_PHASE_STACK,    // gecko_init() until gecko_evt_system_boot_id
+   BOOT_PHASE_MESH,     // until gecko_evt_mesh_node_initialized_id
+   BOOT_PHASES
+} BootPhase_t;
+
+typedef struct {
+   uint32_t ResetCause;             // RMU reset cause flags, sticky until cleared by someone else
+   uint32_t Boots;                  // boots since the last power on reset
+   uint32_t EndUs[BOOT_PHASES];     // us from main() to the end of each phase, 0 if not reached
+   bool FastBoot;                   // built with DARWIN_FAST_BOOT
+} BootRecord_t;
+
+#ifdef DARWIN_BOOT
+// Starts the record of this boot, the first thing in main()
+void BootInit(void);
+// Ends a phase
+void BootMark(BootPhase_t Phase);
+// Returns the record of this or the previous boot, NULL if there is none
+const BootRecord_t *BootGetRecord(bool Last);
+const char *BootPhaseName(BootPhase_t Phase);
+
+#define BOOT_INIT()        BootInit()
+#define BOOT_MARK(Phase)   BootMark(Phase)
+#else
+#define BOOT_INIT()
+#define BOOT_MARK(Phase)
+#endif
+
+#endif   // _DARWIN_BOOT_H_
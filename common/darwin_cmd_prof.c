@@ -0,0 +1,223 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "gecko_event_names.h"
+#include "darwin_cmd_prof.h"
+#include "darwin_cycles.h"
+#define LOG_MODULE   SYS
+#include "darwin_log.h"
+
+#define CMD_PREFIX_LEN     10    // "gecko_cmd_"
+
+// Function name of a command without the prefix
+static inline const char *ShortName(const char *Function)
+{
+   return strncmp(Function,"gecko_cmd_",CMD_PREFIX_LEN) == 0 ? &Function[CMD_PREFIX_LEN] : Function;
+}
+
+#ifdef DARWIN_CMD_PROF
+// One array of entries per BGAPI class indexed by the method byte, and one
+// array of classes indexed by the class byte, built by the compiler from
+// the command ID constants as in gecko_event_names.c. Add the commands the
+// application uses to the array of their class, add new classes to
+// CmdClasses[].
+
+#define CMD_ENTRY(id)         [BGLIB_MSG_METHOD(id)] = {id}
+#define CMD_CLASS(id,cmds)    [BGLIB_MSG_CLASS(id)] = {cmds,sizeof(cmds) / sizeof(cmds[0])}
+
+typedef struct {
+   CmdProfStats_t *pCmds;
+   uint8_t Count;
+} CmdClass_t;
+
+static CmdProfStats_t SystemCmds[] = {
+   CMD_ENTRY(gecko_cmd_system_reset_id),
+   CMD_ENTRY(gecko_cmd_system_get_bt_address_id),
+};
+
+static CmdProfStats_t LeConnectionCmds[] = {
+   CMD_ENTRY(gecko_cmd_le_connection_set_parameters_id),
+   CMD_ENTRY(gecko_cmd_le_connection_get_rssi_id),
+   CMD_ENTRY(gecko_cmd_le_connection_set_phy_id),
+   CMD_ENTRY(gecko_cmd_le_connection_close_id),
+};
+
+static CmdProfStats_t GattCmds[] = {
+   CMD_ENTRY(gecko_cmd_gatt_set_max_mtu_id),
+};
+
+static CmdProfStats_t GattServerCmds[] = {
+   CMD_ENTRY(gecko_cmd_gatt_server_write_attribute_value_id),
+   CMD_ENTRY(gecko_cmd_gatt_server_send_user_read_response_id),
+   CMD_ENTRY(gecko_cmd_gatt_server_send_user_write_response_id),
+};
+
+static CmdProfStats_t HardwareCmds[] = {
+   CMD_ENTRY(gecko_cmd_hardware_set_soft_timer_id),
+};
+
+static CmdProfStats_t FlashCmds[] = {
+   CMD_ENTRY(gecko_cmd_flash_ps_erase_all_id),
+   CMD_ENTRY(gecko_cmd_flash_ps_save_id),
+   CMD_ENTRY(gecko_cmd_flash_ps_load_id),
+   CMD_ENTRY(gecko_cmd_flash_ps_erase_id),
+};
+
+static CmdProfStats_t MeshNodeCmds[] = {
+   CMD_ENTRY(gecko_cmd_mesh_node_init_id),
+   CMD_ENTRY(gecko_cmd_mesh_node_start_unprov_beaconing_id),
+};
+
+static CmdProfStats_t MeshGenericClientCmds[] = {
+   CMD_ENTRY(gecko_cmd_mesh_generic_client_get_id),
+   CMD_ENTRY(gecko_cmd_mesh_generic_client_set_id),
+   CMD_ENTRY(gecko_cmd_mesh_generic_client_init_common_id),
+   CMD_ENTRY(gecko_cmd_mesh_generic_client_init_on_off_id),
+   CMD_ENTRY(gecko_cmd_mesh_generic_client_init_lightness_id),
+   CMD_ENTRY(gecko_cmd_mesh_generic_client_init_ctl_id),
+};
+
+static CmdProfStats_t MeshSceneClientCmds[] = {
+   CMD_ENTRY(gecko_cmd_mesh_scene_client_recall_id),
+   CMD_ENTRY(gecko_cmd_mesh_scene_client_init_id),
+};
+
+static const CmdClass_t CmdClasses[256] = {
+   CMD_CLASS(gecko_cmd_system_reset_id,SystemCmds),
+   CMD_CLASS(gecko_cmd_le_connection_close_id,LeConnectionCmds),
+   CMD_CLASS(gecko_cmd_gatt_set_max_mtu_id,GattCmds),
+   CMD_CLASS(gecko_cmd_gatt_server_write_attribute_value_id,GattServerCmds),
+   CMD_CLASS(gecko_cmd_hardware_set_soft_timer_id,HardwareCmds),
+   CMD_CLASS(gecko_cmd_flash_ps_save_id,FlashCmds),
+   CMD_CLASS(gecko_cmd_mesh_node_init_id,MeshNodeCmds),
+   CMD_CLASS(gecko_cmd_mesh_generic_client_set_id,MeshGenericClientCmds),
+   CMD_CLASS(gecko_cmd_mesh_scene_client_recall_id,MeshSceneClientCmds),
+};
+
+// The commands that are not listed
+static CmdProfStats_t Other;
+
+void CmdProfRecord(uint32_t Header,const char *Function,uint32_t Cycles)
+{
+   const CmdClass_t *pClass = &CmdClasses[BGLIB_MSG_CLASS(Header)];
+   uint8_t Method = BGLIB_MSG_METHOD(Header);
+   CmdProfStats_t *p = &Other;
+
+   if(Method < pClass->Count && pClass->pCmds[Method].ID != 0) {
+      p = &pClass->pCmds[Method];
+   }
+   else {
+      Other.ID = BGLIB_MSG_ID(Header);
+   }
+   p->Name = Function;
+   if(p->Count == 0 || Cycles < p->MinCycles) {
+      p->MinCycles = Cycles;
+   }
+   if(Cycles > p->MaxCycles) {
+      p->MaxCycles = Cycles;
+   }
+   p->TotalCycles += Cycles;
+   p->Count++;
+}
+
+int CmdProfGet(const CmdProfStats_t **pStats,int Max)
+{
+   int Count = 0;
+   int i;
+   int j;
+
+   for(i = 0; i < 256; i++) {
+      for(j = 0; j < CmdClasses[i].Count; j++) {
+         if(CmdClasses[i].pCmds[j].Count != 0 && Count < Max) {
+            pStats[Count++] = &CmdClasses[i].pCmds[j];
+         }
+      }
+   }
+   if(Other.Count != 0 && Count < Max) {
+      pStats[Count++] = &Other;
+   }
+   return Count;
+}
+
+void CmdProfReset(void)
+{
+   int i;
+   int j;
+
+   for(i = 0; i < 256; i++) {
+      for(j = 0; j < CmdClasses[i].Count; j++) {
+         CmdProfStats_t *p = &CmdClasses[i].pCmds[j];
+
+         p->Count = 0;
+         p->MinCycles = 0;
+         p->MaxCycles = 0;
+         p->TotalCycles = 0;
+      }
+   }
+   memset(&Other,0,sizeof(Other));
+}
+
+const char *CmdProfName(const CmdProfStats_t *p)
+{
+   return p->Name != NULL ? ShortName(p->Name) : "?";
+}
+
+const CmdProfStats_t *CmdProfOther(void)
+{
+   return &Other;
+}
+
+void CmdProfDump(void)
+{
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+   const CmdProfStats_t *Stats[64];
+   int Count = CmdProfGet(Stats,64);
+   int i;
+
+   LOG_RAW("command                              count  min cycles  avg cycles  max cycles\n");
+   for(i = 0; i < Count; i++) {
+      const CmdProfStats_t *p = Stats[i];
+
+      LOG_RAW("%-34s%s %7lu %11lu %11lu %11lu\n",CmdProfName(p),p == &Other ? "*" : " ",(unsigned long) p->Count,
+              (unsigned long) p->MinCycles,(unsigned long) (p->TotalCycles / p->Count),
+              (unsigned long) p->MaxCycles);
+   }
+#endif
+}
+#endif   // DARWIN_CMD_PROF
+
+#ifdef sli_bt_cmd_handler_delegate
+#undef sli_bt_cmd_handler_delegate
+void sli_bt_cmd_handler_delegate(uint32_t header, gecko_cmd_handler, const void*);
+
+void SLI_BT_CMD_HANDLER_DELEGATE(uint32_t ID, gecko_cmd_handler handler, const void* arg,const char *Function)
+{
+#ifdef DARWIN_CMD_PROF
+   uint32_t Start;
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_TRACE
+   if(LOG_ON(LOG_LEVEL_TRACE)) {
+      LOG_PRINT("cmd: %s\n",ShortName(Function));
+   }
+#endif
+#ifdef DARWIN_CMD_PROF
+   Start = CYCLE_COUNT();
+   sli_bt_cmd_handler_delegate(ID,handler,arg);
+   CmdProfRecord(ID,Function,CYCLE_COUNT() - Start);
+#else
+   sli_bt_cmd_handler_delegate(ID,handler,arg);
+#endif
+}
+#endif
@@ -0,0 +1,60 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _DARWIN_CMD_PROF_H_
+#define _DARWIN_CMD_PROF_H_
+
+#include <stdint.h>
+
+// BGAPI command profiler, enabled by DARWIN_CMD_PROF.
+//
+// The stack is built with sli_bt_cmd_handler_delegate defined to
+// SLI_BT_CMD_HANDLER_DELEGATE(header,handler,arg,__FUNCTION__), so every
+// gecko_cmd_*() goes through the wrapper in darwin_cmd_prof.c. The wrapper
+// counts the DWT cycles the stack takes for the command, including the time
+// it blocks, and adds them to the entry of the command.
+//
+// The entries are listed per BGAPI class in darwin_cmd_prof.c and indexed
+// with the class and method bytes of the command ID, the same way as the
+// event names. Commands that are not listed share one entry, it keeps the
+// ID and name of the last one. The name is the function name given to the
+// wrapper, so no strings are stored for commands that are never called.
+
+typedef struct {
+   uint32_t ID;               // command ID, 0 for unused slots
+   const char *Name;          // e.g. "gecko_cmd_flash_ps_save", NULL until called
+   uint32_t Count;
+   uint32_t MinCycles;
+   uint32_t MaxCycles;
+   uint64_t TotalCycles;
+} CmdProfStats_t;
+
+#ifdef DARWIN_CMD_PROF
+// Adds a command that took Cycles, Header is the BGAPI header or the ID
+void CmdProfRecord(uint32_t Header,const char *Function,uint32_t Cycles);
+
+// Fills pStats with the entries of the commands called so far, the one of
+// the unlisted commands last, and returns their number
+int CmdProfGet(const CmdProfStats_t **pStats,int Max);
+
+void CmdProfReset(void);
+
+// Logs the entries, LOG_LEVEL_INFO of the SYS module
+void CmdProfDump(void);
+
+// Name without the "gecko_cmd_" prefix
+const char *CmdProfName(const CmdProfStats_t *p);
+
+// Entry of the commands that are not listed
+const CmdProfStats_t *CmdProfOther(void);
+#endif
+
+#endif   // _DARWIN_CMD_PROF_H_
@@ -0,0 +1,138 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "uart_dma.h"
+#include "darwin_console.h"
+
+static struct {
+   const char *Name;
+   ConsoleCmd_t Cmd;
+   const char *Help;
+} Commands[CONSOLE_MAX_COMMANDS];
+static int NumCommands;
+
+static int (*Output)(const void *Data,int Len) = UartDmaWrite;
+
+static char Line[CONSOLE_MAX_LINE];
+static int LineLen;
+
+static void Help(int Argc,char **Argv)
+{
+   int i;
+
+   for(i = 0; i < NumCommands; i++) {
+      ConsolePrintf("%-8s %s\n",Commands[i].Name,Commands[i].Help);
+   }
+}
+
+void ConsoleInit(void (*RxSignal)(void))
+{
+   static bool Started;
+
+   if(!Started) {
+      Started = true;
+      UartDmaInit(UART_DMA_BAUDRATE);
+      ConsoleRegister("help",Help,"list commands");
+   }
+   UartDmaSetRxCallback(RxSignal);
+}
+
+bool ConsoleRegister(const char *Name,ConsoleCmd_t Cmd,const char *Help)
+{
+   if(NumCommands == CONSOLE_MAX_COMMANDS) {
+      return false;
+   }
+   Commands[NumCommands].Name = Name;
+   Commands[NumCommands].Cmd = Cmd;
+   Commands[NumCommands].Help = Help;
+   NumCommands++;
+   return true;
+}
+
+void ConsoleSetOutput(int (*Write)(const void *Data,int Len))
+{
+   Output = Write;
+}
+
+void ConsolePrintf(const char *Format,...)
+{
+   char Buf[96];
+   va_list Args;
+   int Len;
+
+   va_start(Args,Format);
+   Len = vsnprintf(Buf,sizeof(Buf),Format,Args);
+   va_end(Args);
+
+   if(Len > (int) sizeof(Buf) - 1) {
+      Len = sizeof(Buf) - 1;
+   }
+   if(Len > 0) {
+      Output(Buf,Len);
+   }
+}
+
+static void Execute(void)
+{
+   char *Argv[CONSOLE_MAX_ARGS];
+   int Argc = 0;
+   char *p = strtok(Line," \t");
+   int i;
+
+   while(p != NULL && Argc < CONSOLE_MAX_ARGS) {
+      Argv[Argc++] = p;
+      p = strtok(NULL," \t");
+   }
+
+   if(Argc == 0) {
+      return;
+   }
+
+   for(i = 0; i < NumCommands; i++) {
+      if(strcmp(Argv[0],Commands[i].Name) == 0) {
+         Commands[i].Cmd(Argc,Argv);
+         return;
+      }
+   }
+   ConsolePrintf("unknown command '%s', try help\n",Argv[0]);
+}
+
+void ConsoleInput(const char *Data,int Len)
+{
+   int i;
+
+   for(i = 0; i < Len; i++) {
+      char c = Data[i];
+
+      if(c == '\r' || c == '\n') {
+         Line[LineLen] = 0;
+         Execute();
+         LineLen = 0;
+      }
+      else if(LineLen < CONSOLE_MAX_LINE - 1) {
+         Line[LineLen++] = c;
+      }
+   }
+   UartDmaPoll();
+}
+
+void ConsolePoll(void)
+{
+   char Buf[32];
+   int Len;
+
+   while((Len = UartDmaRead(Buf,sizeof(Buf))) > 0) {
+      ConsoleInput(Buf,Len);
+   }
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _DARWIN_CONSOLE_H_
+#define _DARWIN_CONSOLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Line based query console on USART0. Commands are registered with a name
+// and run from ConsolePoll() in the main loop, never from interrupt context.
+// Output always goes to the UART, independent of DARWIN_DEBUG.
+
+#ifndef CONSOLE_MAX_COMMANDS
+#define CONSOLE_MAX_COMMANDS  24
+#endif
+
+#ifndef CONSOLE_MAX_LINE
+#define CONSOLE_MAX_LINE      64
+#endif
+
+#ifndef CONSOLE_MAX_ARGS
+#define CONSOLE_MAX_ARGS      6
+#endif
+
+typedef void (*ConsoleCmd_t)(int Argc,char **Argv);
+
+// Starts the UART, RxSignal is called from interrupt context when input
+// is waiting
+void ConsoleInit(void (*RxSignal)(void));
+
+bool ConsoleRegister(const char *Name,ConsoleCmd_t Cmd,const char *Help);
+
+// Reads pending input from the UART and runs complete command lines
+void ConsolePoll(void);
+
+// Runs command lines received by other means, e.g. over GATT
+void ConsoleInput(const char *Data,int Len);
+
+// Sends the console output somewhere else than the UART, e.g. wrapped into
+// host link frames
+void ConsoleSetOutput(int (*Write)(const void *Data,int Len));
+
+void ConsolePrintf(const char *Format,...) __attribute__((format(printf,1,2)));
+
+#endif   // _DARWIN_CONSOLE_H_
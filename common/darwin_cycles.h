@@ -0,0 +1,46 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _DARWIN_CYCLES_H_
+#define _DARWIN_CYCLES_H_
+
+#include <stdint.h>
+#include "em_device.h"
+
+// Cycle accurate timing based on the Cortex-M DWT cycle counter.
+// The counter is 32 bits wide and wraps after ~110 seconds at 38.4 MHz,
+// differences between two reads are valid as long as the interval is
+// shorter than that.
+
+#ifdef DARWIN_HOST
+// The host build counts host time scaled to the simulated core clock
+uint32_t SimCycleCount(void);
+
+static inline void CycleCounterInit(void)
+{
+}
+
+#define CYCLE_COUNT()   SimCycleCount()
+
+#else    // DARWIN_HOST
+
+static inline void CycleCounterInit(void)
+{
+   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+   DWT->CYCCNT = 0;
+   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#define CYCLE_COUNT()   (DWT->CYCCNT)
+
+#endif   // DARWIN_HOST
+
+#endif   // _DARWIN_CYCLES_H_
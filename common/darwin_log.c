@@ -11,121 +11,297 @@
 
 #include <stdio.h>
 #include <ctype.h>
+#include <string.h>
 #include <time.h>
 #include "native_gecko.h"
+#define LOG_MODULE   SYS
 #include "darwin_log.h"
+#include "gecko_event_names.h"
 
+#ifdef DARWIN_LOG_UART
+#include "uart_dma.h"
+#endif
+
+// traces are only on by default in debug builds
 #ifdef DARWIN_DEBUG
-void DumpHex(void *AdrIn,int Len)
+#define LOG_TRACE_DEFAULT  ((1UL << LOG_MODULES) - 1)
+#else
+#define LOG_TRACE_DEFAULT  0
+#endif
+
+uint32_t LogMask[LOG_LEVELS] = {
+   0,
+   (1UL << LOG_MODULES) - 1,
+   (1UL << LOG_MODULES) - 1,
+   LOG_TRACE_DEFAULT
+};
+
+#define LOG_MODULE_NAME_(Name)  #Name,
+static const char *ModuleNames[LOG_MODULES] = {LOG_MODULE_LIST(LOG_MODULE_NAME_)};
+
+static const char *LevelNames[LOG_LEVELS] = {"none","error","info","trace"};
+
+#define LOG_MODULE_LEVEL_(Name)  DARWIN_LOG_LEVEL_##Name,
+static const uint8_t CompiledLevels[LOG_MODULES] = {LOG_MODULE_LIST(LOG_MODULE_LEVEL_)};
+
+void LogSetLevel(int Module,int Level)
 {
-   unsigned char *Adr = (unsigned char *) AdrIn;
-   int i = 0;
-   int j;
+   uint32_t Bits;
+   int i;
 
-   while(i < Len) {
-      for(j = 0; j < 16; j++) {
-         if((i + j) == Len) {
-            break;
-         }
-         LOG_RAW("%02x ",Adr[i+j]);
+   if(Module < 0 || Module > LOG_MODULES) {
+      return;
+   }
+   Bits = Module == LOG_MODULES ? (1UL << LOG_MODULES) - 1 : 1UL << Module;
+   for(i = LOG_LEVEL_ERROR; i < LOG_LEVELS; i++) {
+      if(i <= Level) {
+         LogMask[i] |= Bits;
+      }
+      else {
+         LogMask[i] &= ~Bits;
       }
+   }
+}
+
+int LogGetLevel(int Module)
+{
+   int Level = LOG_LEVEL_NONE;
+
+   while(Level + 1 < LOG_LEVELS && (LogMask[Level + 1] & (1UL << Module)) != 0) {
+      Level++;
+   }
+   return Level;
+}
+
+int LogGetCompiledLevel(int Module)
+{
+   return Module >= 0 && Module < LOG_MODULES ? CompiledLevels[Module] : LOG_LEVEL_NONE;
+}
+
+int LogFindModule(const char *Name)
+{
+   int i;
 
-      LOG_RAW(" ");
-      for(j = 0; j < 16; j++) {
-         if((i + j) == Len) {
-            break;
-         }
-         if(isprint(Adr[i+j])) {
-            LOG_RAW("%c",Adr[i+j]);
-         }
-         else {
-            LOG_RAW(".");
-         }
+   if(strcasecmp(Name,"all") == 0) {
+      return LOG_MODULES;
+   }
+   for(i = 0; i < LOG_MODULES; i++) {
+      if(strcasecmp(Name,ModuleNames[i]) == 0) {
+         return i;
       }
-      i += 16;
-      LOG_RAW("\n");
-   }
-}
-
-
-const struct {
-   uint32 ID;
-   const char *Desc;
-} EventLookup[] = {
-   {gecko_evt_system_boot_id,"system_boot"},
-   {gecko_evt_system_external_signal_id,"system_external_signal"},
-   {gecko_evt_system_awake_id,"system_awake"},
-   {gecko_evt_system_hardware_error_id,"system_hardware_error"},
-   {gecko_evt_le_gap_scan_response_id,"le_gap_scan_response"},
-   {gecko_evt_le_gap_adv_timeout_id,"le_gap_adv_timeout"},
-   {gecko_evt_le_gap_scan_request_id,"le_gap_scan_request"},
-   {gecko_evt_le_connection_opened_id,"le_connection_opened"},
-   {gecko_evt_le_connection_closed_id,"le_connection_closed"},
-   {gecko_evt_le_connection_parameters_id,"le_connection_parameters"},
-   {gecko_evt_le_connection_rssi_id,"le_connection_rssi"},
-   {gecko_evt_le_connection_phy_status_id,"le_connection_phy_status"},
-   {gecko_evt_gatt_mtu_exchanged_id,"gatt_mtu_exchanged"},
-   {gecko_evt_gatt_service_id,"gatt_service"},
-   {gecko_evt_gatt_characteristic_id,"gatt_characteristic"},
-   {gecko_evt_gatt_descriptor_id,"gatt_descriptor"},
-   {gecko_evt_gatt_characteristic_value_id,"gatt_characteristic_value"},
-   {gecko_evt_gatt_descriptor_value_id,"gatt_descriptor_value"},
-   {gecko_evt_gatt_procedure_completed_id,"gatt_procedure_completed"},
-   {gecko_evt_gatt_server_attribute_value_id,"gatt_server_attribute_value"},
-   {gecko_evt_gatt_server_user_read_request_id,"gatt_server_user_read_request"},
-   {gecko_evt_gatt_server_user_write_request_id,"gatt_server_user_write_request"},
-   {gecko_evt_gatt_server_characteristic_status_id,"gatt_server_characteristic_status"},
-   {gecko_evt_gatt_server_execute_write_completed_id,"gatt_server_execute_write_completed"},
-   {gecko_evt_hardware_soft_timer_id,"hardware_soft_timer"},
-   {gecko_evt_test_dtm_completed_id,"test_dtm_completed"},
-   {gecko_evt_sm_passkey_display_id,"sm_passkey_display"},
-   {gecko_evt_sm_passkey_request_id,"sm_passkey_request"},
-   {gecko_evt_sm_confirm_passkey_id,"sm_confirm_passkey"},
-   {gecko_evt_sm_bonded_id,"sm_bonded"},
-   {gecko_evt_sm_bonding_failed_id,"sm_bonding_failed"},
-   {gecko_evt_sm_list_bonding_entry_id,"sm_list_bonding_entry"},
-   {gecko_evt_sm_list_all_bondings_complete_id,"sm_list_all_bondings_complete"},
-   {gecko_evt_sm_confirm_bonding_id,"sm_confirm_bonding"},
-   {gecko_evt_user_message_to_host_id,"user_message_to_host"},
-   {0}
-};
+   }
+   return -1;
+}
 
+const char *LogModuleName(int Module)
+{
+   return Module >= 0 && Module < LOG_MODULES ? ModuleNames[Module] : "?";
+}
 
-void LogGeckoEvent(void *Pkt,const char *Function)
+const char *LogLevelName(int Level)
+{
+   return Level >= 0 && Level < LOG_LEVELS ? LevelNames[Level] : "?";
+}
+
+int LogFindLevel(const char *Name)
 {
    int i;
-   struct gecko_cmd_packet *p = (struct gecko_cmd_packet *) Pkt;
 
-   uint32 ID = BGLIB_MSG_ID(p->header);
+   for(i = 0; i < LOG_LEVELS; i++) {
+      if(strcasecmp(Name,LevelNames[i]) == 0) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+#ifdef DARWIN_LOG
+#ifdef DARWIN_LOG_DEFERRED
+#include <stdarg.h>
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_rtcc.h"
+
+// Size of the deferred log ring in 32 bit words, must be a power of 2
+#ifndef DLOG_RING_WORDS
+#define DLOG_RING_WORDS    512
+#endif
+
+// ITM stimulus port used for the binary log stream, port 0 carries printf
+#ifndef DLOG_ITM_PORT
+#define DLOG_ITM_PORT      1
+#endif
+
+// Record layout in the ring and on the wire:
+//   word 0: NArgs << 24 | format string address
+//   word 1: RTCC counter
+//   word 2..: arguments
+// A record with a format address of 0 reports the number of dropped records
+// in its only argument.
+#define DLOG_HDR(Fmt,NArgs)   (((uint32_t) (NArgs) << 24) | ((uint32_t) (Fmt) & 0x00FFFFFF))
+#define DLOG_RING_MASK        (DLOG_RING_WORDS - 1)
+
+static uint32_t DLogRing[DLOG_RING_WORDS];
+// Written by DeferredLog() only
+static volatile uint32_t DLogHead;
+// Written by DeferredLogDrain() only
+static volatile uint32_t DLogTail;
+static uint32_t DLogDropped;
+static uint32_t DLogDroppedReported;
+
+void DeferredLogInit(void)
+{
+   ITM->TER |= 1UL << DLOG_ITM_PORT;
+}
+
+// Single producer: must not be called from interrupt handlers
+void DeferredLog(const char *Format,int NArgs,...)
+{
+   uint32_t Head = DLogHead;
+   va_list Args;
+   int i;
+
+   if(DLOG_RING_WORDS - (Head - DLogTail) < 2 + (uint32_t) NArgs) {
+      DLogDropped++;
+      return;
+   }
+
+   DLogRing[Head++ & DLOG_RING_MASK] = DLOG_HDR(Format,NArgs);
+   DLogRing[Head++ & DLOG_RING_MASK] = RTCC_CounterGet();
+   va_start(Args,NArgs);
+   for(i = 0; i < NArgs; i++) {
+      DLogRing[Head++ & DLOG_RING_MASK] = va_arg(Args,uint32_t);
+   }
+   va_end(Args);
+
+   __DMB();
+   DLogHead = Head;
+}
+
+static bool DLogPut(uint32_t Word)
+{
+   if(ITM->PORT[DLOG_ITM_PORT].u32 == 0) {
+      // stimulus FIFO full, try again on the next idle pass
+      return false;
+   }
+   ITM->PORT[DLOG_ITM_PORT].u32 = Word;
+   return true;
+}
 
-   for(i = 0; EventLookup[i].ID != 0; i++) {
-      if(ID == EventLookup[i].ID) {
-         LOG_RAW("%s: %s\n",Function,EventLookup[i].Desc);
+// Sends out as many words as the ITM accepts without waiting, so a
+// record may be split across idle passes.
+void DeferredLogDrain(void)
+{
+   uint32_t Tail = DLogTail;
+   uint32_t Head = DLogHead;
+
+   if((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0 || (ITM->TER & (1UL << DLOG_ITM_PORT)) == 0) {
+      // nobody is listening, discard
+      DLogTail = Head;
+      return;
+   }
+
+   while(Tail != Head) {
+      if(!DLogPut(DLogRing[Tail & DLOG_RING_MASK])) {
          break;
       }
+      Tail++;
+   }
+   DLogTail = Tail;
+
+   if(Tail == Head && DLogDropped != DLogDroppedReported) {
+      uint32_t Dropped = DLogDropped;
+
+      DLogDroppedReported = Dropped;
+      DeferredLog(NULL,1,Dropped);
+   }
+}
+
+uint32_t DeferredLogDropped(void)
+{
+   return DLogDropped;
+}
+#endif   // DARWIN_LOG_DEFERRED
+
+#ifdef DARWIN_LOG_DEFERRED
+// Format strings are not available on target in deferred mode, each line is
+// sent as up to four words with the bytes in memory order
+void (DumpHex)(void *AdrIn,int Len)
+{
+   unsigned char *Adr = (unsigned char *) AdrIn;
+   int i;
+
+   for(i = 0; i < Len; i += 16) {
+      uint32_t Words[4] = {0};
+      int n = Len - i < 16 ? Len - i : 16;
+
+      memcpy(Words,&Adr[i],n);
+      LOG_PRINT("%08lx %08lx %08lx %08lx (%d)\n",(unsigned long) __REV(Words[0]),(unsigned long) __REV(Words[1]),
+                (unsigned long) __REV(Words[2]),(unsigned long) __REV(Words[3]),n);
    }
+}
+#else
+static const char HexDigits[16] = "0123456789abcdef";
+
+// Each line is rendered into a local buffer and written with a single call,
+// the caller checked the level
+void (DumpHex)(void *AdrIn,int Len)
+{
+   unsigned char *Adr = (unsigned char *) AdrIn;
+   // 16 * "xx " + " " + 16 ASCII + "\n" + terminator
+   char Line[16 * 3 + 1 + 16 + 2];
+   int i = 0;
+   int j;
 
-   if(EventLookup[i].ID == 0) {
-      LOG_RAW("%s: unknown event ID 0x%x\n",Function,ID);
+   while(i < Len) {
+      int n = Len - i < 16 ? Len - i : 16;
+      char *p = Line;
+
+      for(j = 0; j < n; j++) {
+         *p++ = HexDigits[Adr[i+j] >> 4];
+         *p++ = HexDigits[Adr[i+j] & 0xf];
+         *p++ = ' ';
+      }
+
+      *p++ = ' ';
+      for(j = 0; j < n; j++) {
+         *p++ = isprint(Adr[i+j]) ? Adr[i+j] : '.';
+      }
+      *p++ = '\n';
+      *p = 0;
+
+      i += 16;
+      LOG_PRINT("%s",Line);
    }
 }
+#endif   // DARWIN_LOG_DEFERRED
 
-#ifdef sli_bt_cmd_handler_delegate
-#undef sli_bt_cmd_handler_delegate
-void sli_bt_cmd_handler_delegate(uint32_t header, gecko_cmd_handler, const void*);
 
-void SLI_BT_CMD_HANDLER_DELEGATE(uint32_t ID, gecko_cmd_handler handler, const void* arg,const char *Function)
+void LogGeckoEvent(void *Pkt,const char *Function)
 {
-   int Len = strlen(Function);
-   if(Len > 10) {
-      LOG_RAW("cmd: %s\n",&Function[10]);
+   struct gecko_cmd_packet *p = (struct gecko_cmd_packet *) Pkt;
+   uint32 ID = BGLIB_MSG_ID(p->header);
+   const char *Desc = GeckoEventName(ID);
+
+   if(Desc != NULL) {
+      LOG_PRINT("%s: %s\n",Function,Desc);
    }
    else {
-      LOG_RAW("cmd: %s\n",Function);
+      LOG_PRINT("%s: unknown event ID 0x%x\n",Function,ID);
    }
-   sli_bt_cmd_handler_delegate(ID,handler,arg);
 }
 #endif
+
+#if (defined(DARWIN_LOG) && defined(DARWIN_LOG_DEFERRED)) || defined(DARWIN_LOG_UART)
+void LogDrain(void)
+{
+#if defined(DARWIN_LOG) && defined(DARWIN_LOG_DEFERRED)
+   DeferredLogDrain();
+#endif
+#ifdef DARWIN_LOG_UART
+   UartDmaPoll();
+#endif
+}
 #endif
 
 void ErrorBreakPoint(const char *Funct,int Line)
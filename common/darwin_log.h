@@ -2,7 +2,7 @@
 * (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
 *******************************************************************************
 * This file is licensed under the Darwin Tech Embedded Software License Agreement.
-* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for 
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
 * details. Read the terms of that agreement carefully.
 *
 * Using or distributing any product utilizing this software for any purpose
@@ -12,41 +12,210 @@
 #ifndef _DARWIN_LOG_H_
 #define _DARWIN_LOG_H_
 
+#include <stdint.h>
+#include <stdio.h>
+
+// Every source file logs for a module, selected by defining LOG_MODULE
+// before this file is included, e.g. #define LOG_MODULE PROXY. Files
+// without one log for APP.
+//
+// A message has a level: ELOG is LOG_LEVEL_ERROR, LOG, LOG_RAW and DumpHex
+// are LOG_LEVEL_INFO, TLOG and LOG_GECKO_EVENT are LOG_LEVEL_TRACE.
+//
+// The levels compiled in are set per module by DARWIN_LOG_LEVEL_<module>,
+// by default DARWIN_LOG_LEVEL. Levels above it expand to nothing, no code
+// and no strings. DARWIN_DEBUG compiles in everything, otherwise DARWIN_LOG
+// compiles in the errors and the levels of the modules given, e.g.
+// -DDARWIN_LOG -DDARWIN_LOG_LEVEL_PROXY=LOG_LEVEL_TRACE, and nothing is
+// compiled in without either.
+//
+// The levels compiled in are checked against the runtime mask of the level
+// before anything is formatted, LogSetLevel() changes it from the console or
+// over GATT. By default errors and info messages are on and traces are only
+// on with DARWIN_DEBUG.
+
+#define LOG_LEVEL_NONE     0
+#define LOG_LEVEL_ERROR    1
+#define LOG_LEVEL_INFO     2
+#define LOG_LEVEL_TRACE    3
+#define LOG_LEVELS         4
+
+#define LOG_MODULE_LIST(X) \
+   X(APP) X(CONN) X(PROXY) X(DISPATCH) X(REQ) X(SCENE) X(OTA) X(PS) X(LL) X(CQ) X(HOST) X(BOOT) X(SYS)
+
+#define LOG_MODULE_ID_(Name)  LOG_MOD_##Name,
+enum {
+   LOG_MODULE_LIST(LOG_MODULE_ID_)
+   LOG_MODULES
+};
+
+#ifdef DARWIN_DEBUG
+#ifndef DARWIN_LOG
+#define DARWIN_LOG
+#endif
+#endif
+
+#ifndef DARWIN_LOG_LEVEL
+#if defined(DARWIN_DEBUG)
+#define DARWIN_LOG_LEVEL   LOG_LEVEL_TRACE
+#elif defined(DARWIN_LOG)
+#define DARWIN_LOG_LEVEL   LOG_LEVEL_ERROR
+#else
+#define DARWIN_LOG_LEVEL   LOG_LEVEL_NONE
+#endif
+#endif
+
+#ifndef DARWIN_LOG_LEVEL_APP
+#define DARWIN_LOG_LEVEL_APP        DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_CONN
+#define DARWIN_LOG_LEVEL_CONN       DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_PROXY
+#define DARWIN_LOG_LEVEL_PROXY      DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_DISPATCH
+#define DARWIN_LOG_LEVEL_DISPATCH   DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_REQ
+#define DARWIN_LOG_LEVEL_REQ        DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_SCENE
+#define DARWIN_LOG_LEVEL_SCENE      DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_OTA
+#define DARWIN_LOG_LEVEL_OTA        DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_PS
+#define DARWIN_LOG_LEVEL_PS         DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_LL
+#define DARWIN_LOG_LEVEL_LL         DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_CQ
+#define DARWIN_LOG_LEVEL_CQ         DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_HOST
+#define DARWIN_LOG_LEVEL_HOST       DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_BOOT
+#define DARWIN_LOG_LEVEL_BOOT       DARWIN_LOG_LEVEL
+#endif
+#ifndef DARWIN_LOG_LEVEL_SYS
+#define DARWIN_LOG_LEVEL_SYS        DARWIN_LOG_LEVEL
+#endif
+
+#ifndef LOG_MODULE
+#define LOG_MODULE   APP
+#endif
+
+#define LOG_CAT(a,b)       LOG_CAT_(a,b)
+#define LOG_CAT_(a,b)      a##b
+#define LOG_MODULE_ID      LOG_CAT(LOG_MOD_,LOG_MODULE)
+#define LOG_MODULE_LEVEL   LOG_CAT(DARWIN_LOG_LEVEL_,LOG_MODULE)
+
+#if LOG_MODULE_LEVEL > LOG_LEVEL_NONE && !defined(DARWIN_LOG)
+#error "module log levels need DARWIN_LOG"
+#endif
+
+/// Modules enabled per level, bit n is module n
+extern uint32_t LogMask[LOG_LEVELS];
+
+#define LOG_ON(Level)      ((LogMask[Level] & (1UL << LOG_MODULE_ID)) != 0)
+
+/// Set the runtime level of a module, LOG_MODULES sets all of them, other
+/// modules are ignored
+void LogSetLevel(int Module,int Level);
+
+/// Highest level enabled at runtime for a module
+int LogGetLevel(int Module);
+
+/// Highest level compiled in for a module
+int LogGetCompiledLevel(int Module);
+
+/// Module by its name, LOG_MODULES for "all", -1 if unknown
+int LogFindModule(const char *Name);
+
+const char *LogModuleName(int Module);
+
+const char *LogLevelName(int Level);
+
+/// Level by its name, -1 if unknown
+int LogFindLevel(const char *Name);
+
+void ErrorBreakPoint(const char *Funct,int Line);
+
 // The ALOG macro always prints
 #ifndef ALOG
 #define ALOG(format, ...) printf(format,## __VA_ARGS__)
 #endif
 
-#ifdef DARWIN_DEBUG
+#ifdef DARWIN_LOG
+#ifdef DARWIN_LOG_DEFERRED
+// In deferred mode the log macros do not format anything. They store the
+// address of the format string, a timestamp and the raw arguments as 32 bit
+// words in a RAM ring, LOG_DRAIN() sends the records out over ITM stimulus
+// port DLOG_ITM_PORT from the idle path and tools/darwin_log_decode.py
+// rebuilds the text using the string table of the ELF file.
+// %s arguments are only decoded if they point into flash.
+#define DLOG_NARGS(...) DLOG_NARGS_(0,## __VA_ARGS__,8,7,6,5,4,3,2,1,0)
+#define DLOG_NARGS_(_0,_1,_2,_3,_4,_5,_6,_7,_8,N,...) N
+
+void DeferredLogInit(void);
+void DeferredLog(const char *Format,int NArgs,...);
+void DeferredLogDrain(void);
+uint32_t DeferredLogDropped(void);
+
+#define LOG_PRINT(format, ...) DeferredLog(format,DLOG_NARGS(__VA_ARGS__),## __VA_ARGS__)
+#else
+#define LOG_PRINT(format, ...) printf(format,## __VA_ARGS__)
+#endif   // DARWIN_LOG_DEFERRED
+
 void DumpHex(void *AdrIn,int Len);
+void LogGeckoEvent(void *Pkt,const char *Function);
+#endif   // DARWIN_LOG
 
-// The ELOG macro always prints and also calls ErrorBreakPoint.
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR
+// The ELOG macro prints and calls ErrorBreakPoint
+#ifndef ELOG
+#define ELOG(format, ...) do { \
+           if(LOG_ON(LOG_LEVEL_ERROR)) { \
+              LOG_PRINT("%s#%d: " format,__FUNCTION__,__LINE__,## __VA_ARGS__); \
+           } \
+           ErrorBreakPoint(0,__LINE__); \
+        } while(0)
+#endif
+#else
 #ifndef ELOG
-#define ELOG(format, ...) printf("%s#%d: " format,__FUNCTION__,__LINE__,## __VA_ARGS__); \
-        ErrorBreakPoint(0,__LINE__)
+#define ELOG(format, ...) ErrorBreakPoint(__FUNCTION__,__LINE__)
 #endif
-      
-// The LOG macro only prints when the DEBUG define is set
-// This macro adds the function name in from of the log message
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+// The LOG macro adds the function name in front of the log message
 #ifndef LOG
-#define LOG(format, ...) printf("%s: " format,__FUNCTION__,## __VA_ARGS__)
+#define LOG(format, ...) do { \
+           if(LOG_ON(LOG_LEVEL_INFO)) { \
+              LOG_PRINT("%s: " format,__FUNCTION__,## __VA_ARGS__); \
+           } \
+        } while(0)
 #endif
 
-// The LOG_RAW macro only prints when the DEBUG define is set
-// This macro is the same as LOG but without adding the function name
+// The LOG_RAW macro is the same as LOG but without adding the function name
 #ifndef LOG_RAW
-#define LOG_RAW(format, ...) printf(format,## __VA_ARGS__)
+#define LOG_RAW(format, ...) do { \
+           if(LOG_ON(LOG_LEVEL_INFO)) { \
+              LOG_PRINT(format,## __VA_ARGS__); \
+           } \
+        } while(0)
 #endif
 
-void LogGeckoEvent(void *Pkt,const char *Function);
-#define LOG_GECKO_EVENT(x) LogGeckoEvent(x,__FUNCTION__)
-
-#else    // DEBUG
-
-#ifndef ELOG
-#define ELOG(format, ...) ErrorBreakPoint(__FUNCTION__,__LINE__)
-#endif
-      
+#define DumpHex(x,y) do { \
+           if(LOG_ON(LOG_LEVEL_INFO)) { \
+              (DumpHex)(x,y); \
+           } \
+        } while(0)
+#else
 #ifndef LOG
 #define LOG(format, ...)
 #endif
@@ -56,10 +225,38 @@ void LogGeckoEvent(void *Pkt,const char *Function);
 #endif
 
 #define DumpHex(x,y)
+#endif
 
-void LOG_GECKO_EVENT(x)
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_TRACE
+// The TLOG macro is LOG for messages of every event or request
+#ifndef TLOG
+#define TLOG(format, ...) do { \
+           if(LOG_ON(LOG_LEVEL_TRACE)) { \
+              LOG_PRINT("%s: " format,__FUNCTION__,## __VA_ARGS__); \
+           } \
+        } while(0)
+#endif
 
-#endif   // DARWIN_DEBUG
+#define LOG_GECKO_EVENT(x) do { \
+           if(LOG_ON(LOG_LEVEL_TRACE)) { \
+              LogGeckoEvent(x,__FUNCTION__); \
+           } \
+        } while(0)
+#else
+#ifndef TLOG
+#define TLOG(format, ...)
+#endif
 
-#endif   // _DARWIN_LOG_H_
+#define LOG_GECKO_EVENT(x)
+#endif
+
+// LOG_DRAIN is called from the idle path of the main loop to move queued
+// log output to the debug interface
+#if (defined(DARWIN_LOG) && defined(DARWIN_LOG_DEFERRED)) || defined(DARWIN_LOG_UART)
+void LogDrain(void);
+#define LOG_DRAIN() LogDrain()
+#else
+#define LOG_DRAIN()
+#endif
 
+#endif   // _DARWIN_LOG_H_
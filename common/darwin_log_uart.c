@@ -0,0 +1,40 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Log transport over USART0. When DARWIN_LOG_UART is defined this file
+// replaces retargetswo.c in the build: printf output is queued in the
+// transmit ring of uart_dma.c and sent by the LDMA instead of busy waiting
+// on the SWO stimulus port.
+
+#ifdef DARWIN_LOG_UART
+#include "uart_dma.h"
+
+void RETARGET_SwoInit(void)
+{
+   UartDmaInit(UART_DMA_BAUDRATE);
+}
+
+int RETARGET_WriteChar(char c)
+{
+   UartDmaWrite(&c,1);
+   // start sending complete lines right away, the rest goes out from the
+   // idle path
+   if(c == '\n') {
+      UartDmaPoll();
+   }
+   return c;
+}
+
+int RETARGET_ReadChar(void)
+{
+   return -1;
+}
+#endif   // DARWIN_LOG_UART
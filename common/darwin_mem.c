@@ -0,0 +1,98 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifdef DARWIN_MEM
+#include "em_device.h"
+#include "darwin_mem.h"
+
+typedef struct {
+   const char *Name;
+   uint32_t *pBase;
+   uint32_t Words;
+   bool GrowsDown;
+} Region_t;
+
+static Region_t Regions[MEM_MAX_REGIONS];
+static int NumRegions;
+
+void MemPaint(const char *Name,void *pBase,uint32_t Size,bool GrowsDown)
+{
+   // only whole words inside the region are painted and checked
+   uint32_t First = ((uint32_t) pBase + 3) & ~3;
+   uint32_t Last = ((uint32_t) pBase + Size) & ~3;
+   Region_t *p;
+   uint32_t i;
+
+   if(NumRegions == MEM_MAX_REGIONS || Last <= First) {
+      return;
+   }
+   p = &Regions[NumRegions++];
+   p->Name = Name;
+   p->pBase = (uint32_t *) First;
+   p->Words = (Last - First) / 4;
+   p->GrowsDown = GrowsDown;
+
+   for(i = 0; i < p->Words; i++) {
+      p->pBase[i] = MEM_PAINT_WORD;
+   }
+}
+
+#ifdef __GNUC__
+extern uint32_t __StackLimit;
+extern uint32_t __StackTop;
+
+void MemPaintStack(void)
+{
+   uint32_t *pBase = &__StackLimit;
+   uint32_t *pTop = &__StackTop;
+   uint32_t *pEnd = (uint32_t *) (__get_MSP() - MEM_STACK_GUARD);
+   uint32_t *p;
+
+   if(NumRegions == MEM_MAX_REGIONS) {
+      return;
+   }
+   Regions[NumRegions].Name = "stack";
+   Regions[NumRegions].pBase = pBase;
+   Regions[NumRegions].Words = pTop - pBase;
+   Regions[NumRegions].GrowsDown = true;
+   NumRegions++;
+
+   for(p = pBase; p < pEnd; p++) {
+      *p = MEM_PAINT_WORD;
+   }
+}
+#endif
+
+int MemGetUsage(MemUsage_t *pUsage,int Max)
+{
+   int i;
+
+   for(i = 0; i < NumRegions && i < Max; i++) {
+      const Region_t *p = &Regions[i];
+      uint32_t Used = 0;
+      uint32_t j;
+
+      if(p->GrowsDown) {
+         for(j = 0; j < p->Words && p->pBase[j] == MEM_PAINT_WORD; j++);
+         Used = p->Words - j;
+      }
+      else {
+         for(j = p->Words; j > 0 && p->pBase[j - 1] == MEM_PAINT_WORD; j--);
+         Used = j;
+      }
+      pUsage[i].Name = p->Name;
+      pUsage[i].Size = p->Words * 4;
+      pUsage[i].Used = Used * 4;
+   }
+   return NumRegions;
+}
+
+#endif   // DARWIN_MEM
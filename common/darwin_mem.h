@@ -0,0 +1,61 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _DARWIN_MEM_H_
+#define _DARWIN_MEM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// RAM high-watermarks, enabled by DARWIN_MEM.
+//
+// Regions are painted with MEM_PAINT_WORD at boot before they are used, the
+// watermark is found later by looking for the paint that was overwritten.
+// A region growing up (a heap) is used up to its last overwritten word, a
+// region growing down (the call stack) from its first overwritten word to
+// the top. Words that happen to be written with the paint value are counted
+// as unused, so the watermarks are a close lower bound.
+//
+// The heaps must be painted before gecko_init() hands them to the stack and
+// the call stack as early as possible in main(). The words below the
+// current stack pointer plus MEM_STACK_GUARD are not painted.
+
+#define MEM_PAINT_WORD     0xCDCDCDCD
+
+#ifndef MEM_MAX_REGIONS
+#define MEM_MAX_REGIONS    4
+#endif
+
+/// Bytes below the stack pointer left alone by MemPaintStack()
+#define MEM_STACK_GUARD    64
+
+typedef struct {
+   const char *Name;
+   uint32_t Size;       // bytes in the region
+   uint32_t Used;       // high-watermark in bytes
+} MemUsage_t;
+
+#ifdef DARWIN_MEM
+// Paints a region and registers it for the watermark report
+void MemPaint(const char *Name,void *pBase,uint32_t Size,bool GrowsDown);
+// Paints the unused part of the main stack (GCC linker symbols)
+void MemPaintStack(void);
+// Returns the number of regions, fills in up to Max entries
+int MemGetUsage(MemUsage_t *pUsage,int Max);
+
+#define MEM_PAINT(Name,p,Size,Down)   MemPaint(Name,p,Size,Down)
+#define MEM_PAINT_STACK()              MemPaintStack()
+#else
+#define MEM_PAINT(Name,p,Size,Down)
+#define MEM_PAINT_STACK()
+#endif
+
+#endif   // _DARWIN_MEM_H_
@@ -0,0 +1,357 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifdef DARWIN_TRACE
+#include <string.h>
+#include "em_device.h"
+#include "em_rtcc.h"
+#include "darwin_trace.h"
+#include "uart_dma.h"
+
+#ifdef TRACE_FLASH_SIZE
+#include "em_msc.h"
+
+#if (TRACE_FLASH_BASE % FLASH_PAGE_SIZE) != 0 || (TRACE_FLASH_SIZE % FLASH_PAGE_SIZE) != 0
+#error "TRACE_FLASH_BASE and TRACE_FLASH_SIZE must be multiples of FLASH_PAGE_SIZE"
+#endif
+
+#define FLASH_PAGES        (TRACE_FLASH_SIZE / FLASH_PAGE_SIZE)
+#define PAGE_WORDS         (FLASH_PAGE_SIZE / 4)
+#endif
+
+#define RAM_MASK           (TRACE_RAM_WORDS - 1)
+#define MAX_PAYLOAD        sizeof(((struct gecko_cmd_packet *) 0)->data)
+#define MAX_RECORD_WORDS   (2 + (MAX_PAYLOAD + 3) / 4)
+
+static uint32_t Ring[TRACE_RAM_WORDS];
+static uint32_t Head;
+static uint32_t Tail;
+static uint32_t Records;
+static uint32_t Lost;
+// Events not recorded since the last record, reported with a TRACE_LOST record
+static uint32_t PendingLost;
+// One record copied out of the ring, it may wrap around the end
+static uint32_t Record[MAX_RECORD_WORDS];
+
+static enum {
+   DUMP_IDLE,
+   DUMP_HEADER,
+   DUMP_FLASH,
+   DUMP_RAM,
+   DUMP_END,
+   DUMP_FLUSH,
+} DumpState;
+static uint32_t DumpPos;
+
+#ifdef TRACE_FLASH_SIZE
+static uint32_t *const FlashBase = (uint32_t *) TRACE_FLASH_BASE;
+// Page currently written
+static uint32_t FlashPage;
+// Next free word in that page
+static uint32_t FlashWord;
+// Sequence number of that page, 0 = nothing written yet
+static uint32_t FlashSeq;
+// Pages left to dump, page and word of the next record dumped from flash
+static uint32_t DumpPages;
+static uint32_t DumpPage;
+static uint32_t DumpWord;
+
+static uint32_t *PageAddr(uint32_t Page)
+{
+   return FlashBase + Page * PAGE_WORDS;
+}
+
+// Returns the index of the first free word in a page
+static uint32_t PageEnd(const uint32_t *pPage)
+{
+   uint32_t i = 1;
+
+   while(i < PAGE_WORDS && pPage[i] != TRACE_END) {
+      i += TRACE_RECORD_WORDS(pPage[i]);
+   }
+   return i < PAGE_WORDS ? i : PAGE_WORDS;
+}
+
+// Continues after the page with the highest sequence number
+static void FlashInit(void)
+{
+   uint32_t Page;
+
+   FlashPage = FLASH_PAGES - 1;
+   FlashWord = PAGE_WORDS;
+   FlashSeq = 0;
+
+   for(Page = 0; Page < FLASH_PAGES; Page++) {
+      uint32_t Seq = PageAddr(Page)[0];
+
+      if(Seq != TRACE_END && (FlashSeq == 0 || (int32_t) (Seq - FlashSeq) > 0)) {
+         FlashSeq = Seq;
+         FlashPage = Page;
+      }
+   }
+
+   if(FlashSeq != 0) {
+      FlashWord = PageEnd(PageAddr(FlashPage));
+   }
+}
+
+// Records never span pages, the rest of a page stays erased
+static void FlashWrite(const uint32_t *pData,uint32_t Words)
+{
+   if(FlashWord + Words > PAGE_WORDS) {
+      FlashPage = (FlashPage + 1) % FLASH_PAGES;
+      FlashSeq++;
+      MSC_ErasePage(PageAddr(FlashPage));
+      MSC_WriteWord(PageAddr(FlashPage),&FlashSeq,4);
+      FlashWord = 1;
+   }
+   MSC_WriteWord(PageAddr(FlashPage) + FlashWord,pData,Words * 4);
+   FlashWord += Words;
+}
+#endif   // TRACE_FLASH_SIZE
+
+static uint32_t RamUsed(void)
+{
+   return Head - Tail;
+}
+
+static void Put(uint32_t Word)
+{
+   Ring[Head++ & RAM_MASK] = Word;
+}
+
+// Copies the record at Pos into Record[], returns its size in words
+static uint32_t CopyRecord(uint32_t Pos)
+{
+   uint32_t Words = TRACE_RECORD_WORDS(Ring[Pos & RAM_MASK]);
+   uint32_t i;
+
+   for(i = 0; i < Words; i++) {
+      Record[i] = Ring[(Pos + i) & RAM_MASK];
+   }
+   return Words;
+}
+
+void TraceInit(void)
+{
+   UartDmaInit(UART_DMA_BAUDRATE);
+#ifdef TRACE_FLASH_SIZE
+   FlashInit();
+#endif
+}
+
+void TraceEvent(const struct gecko_cmd_packet *pEvt)
+{
+   uint32_t Stamp = RTCC_CounterGet();
+   uint32_t Words = TRACE_RECORD_WORDS(pEvt->header);
+   const uint32_t *pPayload = (const uint32_t *) &pEvt->data;
+   uint32_t i;
+
+   // recording is paused while dumping, the gap is marked when it resumes
+   if(DumpState != DUMP_IDLE || TRACE_PAYLOAD_LEN(pEvt->header) > MAX_PAYLOAD) {
+      Lost++;
+      PendingLost++;
+      return;
+   }
+
+#ifndef TRACE_FLASH_SIZE
+   // without flash keep the newest events, the trace just starts later
+   while(TRACE_RAM_WORDS - RamUsed() < Words + (PendingLost != 0 ? 3 : 0)) {
+      Tail += TRACE_RECORD_WORDS(Ring[Tail & RAM_MASK]);
+      Lost++;
+   }
+#endif
+
+   // otherwise keep the trace contiguous with what is in flash and mark
+   // the gap
+   if(TRACE_RAM_WORDS - RamUsed() < Words + (PendingLost != 0 ? 3 : 0)) {
+      Lost++;
+      PendingLost++;
+      return;
+   }
+
+   if(PendingLost != 0) {
+      Put(TRACE_LOST);
+      Put(Stamp);
+      Put(PendingLost);
+      PendingLost = 0;
+   }
+
+   Put(pEvt->header);
+   Put(Stamp);
+   for(i = 2; i < Words; i++) {
+      Put(*pPayload++);
+   }
+   Records++;
+}
+
+// Sends Words from Data if they fit into the transmit ring
+static bool Send(const uint32_t *pData,uint32_t Words)
+{
+   if(UartDmaTxFree() < (int) (Words * 4)) {
+      UartDmaPoll();
+      return false;
+   }
+   UartDmaWrite(pData,Words * 4);
+   return true;
+}
+
+static void DumpPoll(void)
+{
+   static const uint32_t Header[] = {TRACE_MAGIC,TRACE_VERSION,32768};
+   static const uint32_t End = TRACE_END;
+
+   for(;;) {
+      switch(DumpState) {
+         case DUMP_HEADER:
+            if(!Send(Header,3)) {
+               return;
+            }
+#ifdef TRACE_FLASH_SIZE
+            // oldest page first, the page currently written comes last
+            DumpPages = FLASH_PAGES;
+            DumpPage = (FlashPage + 1) % FLASH_PAGES;
+            DumpWord = 1;
+            DumpState = DUMP_FLASH;
+#else
+            DumpPos = Tail;
+            DumpState = DUMP_RAM;
+#endif
+            break;
+
+#ifdef TRACE_FLASH_SIZE
+         case DUMP_FLASH: {
+            const uint32_t *pPage = PageAddr(DumpPage);
+
+            // a page ends at its first erased word or when a record fills it
+            if(pPage[0] == TRACE_END || DumpWord >= PAGE_WORDS || pPage[DumpWord] == TRACE_END ||
+               DumpWord + TRACE_RECORD_WORDS(pPage[DumpWord]) > PAGE_WORDS) {
+               if(--DumpPages == 0) {
+                  DumpPos = Tail;
+                  DumpState = DUMP_RAM;
+               }
+               else {
+                  DumpPage = (DumpPage + 1) % FLASH_PAGES;
+                  DumpWord = 1;
+               }
+               break;
+            }
+            if(!Send(&pPage[DumpWord],TRACE_RECORD_WORDS(pPage[DumpWord]))) {
+               return;
+            }
+            DumpWord += TRACE_RECORD_WORDS(pPage[DumpWord]);
+            break;
+         }
+#endif
+
+         case DUMP_RAM: {
+            uint32_t Words;
+
+            if(DumpPos == Head) {
+               DumpState = DUMP_END;
+               break;
+            }
+            Words = CopyRecord(DumpPos);
+            if(!Send(Record,Words)) {
+               return;
+            }
+            DumpPos += Words;
+            break;
+         }
+
+         case DUMP_END:
+            if(!Send(&End,1)) {
+               return;
+            }
+            DumpState = DUMP_FLUSH;
+            break;
+
+         case DUMP_FLUSH:
+            // keep the loop awake until the last byte is out
+            UartDmaPoll();
+            if(UartDmaTxFree() == UART_DMA_TX_SIZE) {
+               DumpState = DUMP_IDLE;
+            }
+            return;
+
+         default:
+            return;
+      }
+   }
+}
+
+bool TraceIdle(void)
+{
+   if(DumpState != DUMP_IDLE) {
+      DumpPoll();
+      return true;
+   }
+
+#ifdef TRACE_FLASH_SIZE
+   // one record per call, a page erase stalls the CPU for tens of ms
+   if(RamUsed() > TRACE_RAM_WORDS / 2) {
+      uint32_t Words = CopyRecord(Tail);
+
+      MSC_Init();
+      FlashWrite(Record,Words);
+      MSC_Deinit();
+      Tail += Words;
+      return RamUsed() > TRACE_RAM_WORDS / 2;
+   }
+#endif
+   return false;
+}
+
+void TraceDump(void)
+{
+   if(DumpState == DUMP_IDLE) {
+      DumpState = DUMP_HEADER;
+   }
+}
+
+void TraceClear(void)
+{
+#ifdef TRACE_FLASH_SIZE
+   uint32_t Page;
+
+   MSC_Init();
+   for(Page = 0; Page < FLASH_PAGES; Page++) {
+      if(PageAddr(Page)[0] != TRACE_END) {
+         MSC_ErasePage(PageAddr(Page));
+      }
+   }
+   MSC_Deinit();
+   FlashInit();
+#endif
+   DumpState = DUMP_IDLE;
+   Head = Tail = 0;
+   Records = 0;
+   Lost = 0;
+   PendingLost = 0;
+}
+
+void TraceGetStatus(TraceStatus_t *pStatus)
+{
+   pStatus->Records = Records;
+   pStatus->Lost = Lost;
+   pStatus->RamUsed = RamUsed() * 4;
+   pStatus->FlashUsed = 0;
+#ifdef TRACE_FLASH_SIZE
+   if(FlashSeq != 0) {
+      uint32_t Pages = FlashSeq < FLASH_PAGES ? FlashSeq : FLASH_PAGES;
+
+      pStatus->FlashUsed = ((Pages - 1) * PAGE_WORDS + FlashWord) * 4;
+   }
+#endif
+   pStatus->Dumping = DumpState != DUMP_IDLE;
+}
+
+#endif   // DARWIN_TRACE
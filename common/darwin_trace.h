@@ -0,0 +1,82 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _DARWIN_TRACE_H_
+#define _DARWIN_TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+
+// Event trace recorder, enabled by DARWIN_TRACE.
+//
+// Every event returned by the stack is stored together with its RTCC time
+// stamp in a RAM ring. Without a flash region the oldest records are
+// overwritten when the ring is full. When TRACE_FLASH_BASE and
+// TRACE_FLASH_SIZE are defined, records are moved from the RAM ring into a
+// circular flash region while the main loop is idle, so the trace survives
+// a reset and covers a longer time span.
+//
+// All values are 32 bit little endian words:
+//
+//   record:       BGAPI header, RTCC time stamp, payload padded to a word
+//   lost record:  TRACE_LOST, RTCC time stamp, number of events not recorded
+//   flash page:   page sequence number, records, erased words (TRACE_END)
+//   dump stream:  TRACE_MAGIC, TRACE_VERSION, RTCC ticks per second,
+//                 records from oldest to newest, TRACE_END
+//
+// The dump stream is sent over USART0 and can be captured with
+// tools/darwin_trace.py and replayed with the host build (host/gateway_sim -r).
+
+/// Size of the RAM ring in 32 bit words, must be a power of 2
+#ifndef TRACE_RAM_WORDS
+#define TRACE_RAM_WORDS    1024
+#endif
+
+#define TRACE_MAGIC        0x43525444     // "DTRC"
+#define TRACE_VERSION      1
+#define TRACE_LOST         0x00000000
+#define TRACE_END          0xFFFFFFFF
+
+/// Payload length in bytes of a record
+#define TRACE_PAYLOAD_LEN(Header)   ((((Header) & 0x7) << 8) | (((Header) >> 8) & 0xff))
+/// Size of a record in words including the header and time stamp
+#define TRACE_RECORD_WORDS(Header)  ((Header) == TRACE_LOST ? 3 : 2 + (TRACE_PAYLOAD_LEN(Header) + 3) / 4)
+
+typedef struct {
+   uint32_t Records;    // events recorded since boot or the last clear
+   uint32_t Lost;       // events overwritten or not recorded
+   uint32_t RamUsed;    // bytes used in the RAM ring
+   uint32_t FlashUsed;  // bytes used in the flash region
+   bool Dumping;        // a dump is in progress
+} TraceStatus_t;
+
+#ifdef DARWIN_TRACE
+void TraceInit(void);
+// Records an event, called from the main loop for every event
+void TraceEvent(const struct gecko_cmd_packet *pEvt);
+// Moves records to flash and sends the dump, returns true while there is
+// more work to do and the main loop should not go to sleep
+bool TraceIdle(void);
+// Starts sending the trace over USART0, recording is paused until done
+void TraceDump(void);
+// Discards the recorded trace in RAM and flash
+void TraceClear(void);
+void TraceGetStatus(TraceStatus_t *pStatus);
+
+#define TRACE_EVENT(x)     TraceEvent(x)
+#define TRACE_IDLE()       TraceIdle()
+#else
+#define TRACE_EVENT(x)
+#define TRACE_IDLE()       false
+#endif
+
+#endif   // _DARWIN_TRACE_H_
@@ -0,0 +1,169 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stddef.h>
+#include "native_gecko.h"
+#include "gecko_event_names.h"
+
+// One array of names per BGAPI class indexed by the method byte, and one
+// array of classes indexed by the class byte. Both are built by the compiler
+// from the event ID constants in the stack headers, so entries can be listed
+// in any order and an ID that is missing from the headers fails the build.
+// Add new events to the array of their class, add new classes to
+// EventClasses[].
+
+#define EVT_NAME(id,name)     [BGLIB_MSG_METHOD(id)] = name
+#define EVT_CLASS(id,names)    [BGLIB_MSG_CLASS(id)] = {names,sizeof(names) / sizeof(names[0])}
+
+typedef struct {
+   const char * const *Names;
+   uint8_t Count;
+} EventClass_t;
+
+static const char * const DfuEvents[] = {
+   EVT_NAME(gecko_evt_dfu_boot_id,"dfu_boot"),
+   EVT_NAME(gecko_evt_dfu_boot_failure_id,"dfu_boot_failure"),
+};
+
+static const char * const SystemEvents[] = {
+   EVT_NAME(gecko_evt_system_boot_id,"system_boot"),
+   EVT_NAME(gecko_evt_system_external_signal_id,"system_external_signal"),
+   EVT_NAME(gecko_evt_system_awake_id,"system_awake"),
+   EVT_NAME(gecko_evt_system_hardware_error_id,"system_hardware_error"),
+   EVT_NAME(gecko_evt_system_error_id,"system_error"),
+};
+
+static const char * const LeGapEvents[] = {
+   EVT_NAME(gecko_evt_le_gap_scan_response_id,"le_gap_scan_response"),
+   EVT_NAME(gecko_evt_le_gap_adv_timeout_id,"le_gap_adv_timeout"),
+   EVT_NAME(gecko_evt_le_gap_scan_request_id,"le_gap_scan_request"),
+};
+
+static const char * const LeConnectionEvents[] = {
+   EVT_NAME(gecko_evt_le_connection_opened_id,"le_connection_opened"),
+   EVT_NAME(gecko_evt_le_connection_closed_id,"le_connection_closed"),
+   EVT_NAME(gecko_evt_le_connection_parameters_id,"le_connection_parameters"),
+   EVT_NAME(gecko_evt_le_connection_rssi_id,"le_connection_rssi"),
+   EVT_NAME(gecko_evt_le_connection_phy_status_id,"le_connection_phy_status"),
+};
+
+static const char * const GattEvents[] = {
+   EVT_NAME(gecko_evt_gatt_mtu_exchanged_id,"gatt_mtu_exchanged"),
+   EVT_NAME(gecko_evt_gatt_service_id,"gatt_service"),
+   EVT_NAME(gecko_evt_gatt_characteristic_id,"gatt_characteristic"),
+   EVT_NAME(gecko_evt_gatt_descriptor_id,"gatt_descriptor"),
+   EVT_NAME(gecko_evt_gatt_characteristic_value_id,"gatt_characteristic_value"),
+   EVT_NAME(gecko_evt_gatt_descriptor_value_id,"gatt_descriptor_value"),
+   EVT_NAME(gecko_evt_gatt_procedure_completed_id,"gatt_procedure_completed"),
+};
+
+static const char * const GattServerEvents[] = {
+   EVT_NAME(gecko_evt_gatt_server_attribute_value_id,"gatt_server_attribute_value"),
+   EVT_NAME(gecko_evt_gatt_server_user_read_request_id,"gatt_server_user_read_request"),
+   EVT_NAME(gecko_evt_gatt_server_user_write_request_id,"gatt_server_user_write_request"),
+   EVT_NAME(gecko_evt_gatt_server_characteristic_status_id,"gatt_server_characteristic_status"),
+   EVT_NAME(gecko_evt_gatt_server_execute_write_completed_id,"gatt_server_execute_write_completed"),
+};
+
+static const char * const HardwareEvents[] = {
+   EVT_NAME(gecko_evt_hardware_soft_timer_id,"hardware_soft_timer"),
+};
+
+static const char * const TestEvents[] = {
+   EVT_NAME(gecko_evt_test_dtm_completed_id,"test_dtm_completed"),
+};
+
+static const char * const SmEvents[] = {
+   EVT_NAME(gecko_evt_sm_passkey_display_id,"sm_passkey_display"),
+   EVT_NAME(gecko_evt_sm_passkey_request_id,"sm_passkey_request"),
+   EVT_NAME(gecko_evt_sm_confirm_passkey_id,"sm_confirm_passkey"),
+   EVT_NAME(gecko_evt_sm_bonded_id,"sm_bonded"),
+   EVT_NAME(gecko_evt_sm_bonding_failed_id,"sm_bonding_failed"),
+   EVT_NAME(gecko_evt_sm_list_bonding_entry_id,"sm_list_bonding_entry"),
+   EVT_NAME(gecko_evt_sm_list_all_bondings_complete_id,"sm_list_all_bondings_complete"),
+   EVT_NAME(gecko_evt_sm_confirm_bonding_id,"sm_confirm_bonding"),
+};
+
+static const char * const MeshNodeEvents[] = {
+   EVT_NAME(gecko_evt_mesh_node_initialized_id,"mesh_node_initialized"),
+   EVT_NAME(gecko_evt_mesh_node_provisioned_id,"mesh_node_provisioned"),
+   EVT_NAME(gecko_evt_mesh_node_config_get_id,"mesh_node_config_get"),
+   EVT_NAME(gecko_evt_mesh_node_config_set_id,"mesh_node_config_set"),
+   EVT_NAME(gecko_evt_mesh_node_display_output_oob_id,"mesh_node_display_output_oob"),
+   EVT_NAME(gecko_evt_mesh_node_input_oob_request_id,"mesh_node_input_oob_request"),
+   EVT_NAME(gecko_evt_mesh_node_provisioning_started_id,"mesh_node_provisioning_started"),
+   EVT_NAME(gecko_evt_mesh_node_provisioning_failed_id,"mesh_node_provisioning_failed"),
+   EVT_NAME(gecko_evt_mesh_node_key_added_id,"mesh_node_key_added"),
+   EVT_NAME(gecko_evt_mesh_node_model_config_changed_id,"mesh_node_model_config_changed"),
+   EVT_NAME(gecko_evt_mesh_node_reset_id,"mesh_node_reset"),
+   EVT_NAME(gecko_evt_mesh_node_ivrecovery_needed_id,"mesh_node_ivrecovery_needed"),
+   EVT_NAME(gecko_evt_mesh_node_changed_ivupdate_state_id,"mesh_node_changed_ivupdate_state"),
+   EVT_NAME(gecko_evt_mesh_node_static_oob_request_id,"mesh_node_static_oob_request"),
+   EVT_NAME(gecko_evt_mesh_node_key_removed_id,"mesh_node_key_removed"),
+   EVT_NAME(gecko_evt_mesh_node_key_updated_id,"mesh_node_key_updated"),
+   EVT_NAME(gecko_evt_mesh_node_heartbeat_id,"mesh_node_heartbeat"),
+   EVT_NAME(gecko_evt_mesh_node_heartbeat_start_id,"mesh_node_heartbeat_start"),
+   EVT_NAME(gecko_evt_mesh_node_heartbeat_stop_id,"mesh_node_heartbeat_stop"),
+};
+
+static const char * const MeshProxyEvents[] = {
+   EVT_NAME(gecko_evt_mesh_proxy_connected_id,"mesh_proxy_connected"),
+   EVT_NAME(gecko_evt_mesh_proxy_disconnected_id,"mesh_proxy_disconnected"),
+   EVT_NAME(gecko_evt_mesh_proxy_filter_status_id,"mesh_proxy_filter_status"),
+};
+
+static const char * const MeshLpnEvents[] = {
+   EVT_NAME(gecko_evt_mesh_lpn_friendship_established_id,"mesh_lpn_friendship_established"),
+   EVT_NAME(gecko_evt_mesh_lpn_friendship_failed_id,"mesh_lpn_friendship_failed"),
+   EVT_NAME(gecko_evt_mesh_lpn_friendship_terminated_id,"mesh_lpn_friendship_terminated"),
+};
+
+static const char * const MeshGenericClientEvents[] = {
+   EVT_NAME(gecko_evt_mesh_generic_client_server_status_id,"mesh_generic_client_server_status"),
+};
+
+static const char * const MeshSceneClientEvents[] = {
+   EVT_NAME(gecko_evt_mesh_scene_client_status_id,"mesh_scene_client_status"),
+   EVT_NAME(gecko_evt_mesh_scene_client_register_status_id,"mesh_scene_client_register_status"),
+};
+
+static const char * const UserEvents[] = {
+   EVT_NAME(gecko_evt_user_message_to_host_id,"user_message_to_host"),
+};
+
+static const EventClass_t EventClasses[256] = {
+   EVT_CLASS(gecko_evt_dfu_boot_id,DfuEvents),
+   EVT_CLASS(gecko_evt_system_boot_id,SystemEvents),
+   EVT_CLASS(gecko_evt_le_gap_scan_response_id,LeGapEvents),
+   EVT_CLASS(gecko_evt_le_connection_opened_id,LeConnectionEvents),
+   EVT_CLASS(gecko_evt_gatt_mtu_exchanged_id,GattEvents),
+   EVT_CLASS(gecko_evt_gatt_server_attribute_value_id,GattServerEvents),
+   EVT_CLASS(gecko_evt_hardware_soft_timer_id,HardwareEvents),
+   EVT_CLASS(gecko_evt_test_dtm_completed_id,TestEvents),
+   EVT_CLASS(gecko_evt_sm_passkey_display_id,SmEvents),
+   EVT_CLASS(gecko_evt_mesh_node_initialized_id,MeshNodeEvents),
+   EVT_CLASS(gecko_evt_mesh_proxy_connected_id,MeshProxyEvents),
+   EVT_CLASS(gecko_evt_mesh_lpn_friendship_established_id,MeshLpnEvents),
+   EVT_CLASS(gecko_evt_mesh_generic_client_server_status_id,MeshGenericClientEvents),
+   EVT_CLASS(gecko_evt_mesh_scene_client_status_id,MeshSceneClientEvents),
+   EVT_CLASS(gecko_evt_user_message_to_host_id,UserEvents),
+};
+
+const char *GeckoEventName(uint32_t ID)
+{
+   const EventClass_t *pClass = &EventClasses[BGLIB_MSG_CLASS(ID)];
+   uint8_t Method = BGLIB_MSG_METHOD(ID);
+
+   if((ID & gecko_msg_type_evt) == 0 || Method >= pClass->Count) {
+      return NULL;
+   }
+   return pClass->Names[Method];
+}
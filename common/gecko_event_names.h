@@ -0,0 +1,28 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _GECKO_EVENT_NAMES_H_
+#define _GECKO_EVENT_NAMES_H_
+
+#include <stdint.h>
+
+// Class byte of a BGAPI message ID
+#define BGLIB_MSG_CLASS(id)   (((id) >> 16) & 0xFF)
+// Method byte of a BGAPI message ID
+#define BGLIB_MSG_METHOD(id)  (((id) >> 24) & 0xFF)
+
+// Returns the name of a stack event, e.g. "mesh_node_initialized" for
+// gecko_evt_mesh_node_initialized_id, or NULL for unknown events.
+// The lookup indexes constant tables with the class and method bytes of
+// the ID so it takes the same time for every event.
+const char *GeckoEventName(uint32_t ID);
+
+#endif   // _GECKO_EVENT_NAMES_H_
@@ -0,0 +1,67 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _HOST_LINK_H_
+#define _HOST_LINK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "uart_dma.h"
+
+// Framed binary link to the host on USART0.
+//
+// Frame layout, multi byte values are little endian:
+//   SOF (0xA5), payload length (u16), sequence (u8), type (u8), payload,
+//   CRC-16/CCITT (u16) over everything from the length to the payload
+//
+// Received frames are checked and handed to the frame handler straight out
+// of the UART DMA receive ring, the payload is only valid during the call.
+// After a CRC error or a bad length the parser drops one byte and looks for
+// the next SOF. Each direction numbers its frames with its own sequence.
+
+#define HOST_FRAME_SOF           0xA5
+#define HOST_FRAME_HEADER        5
+#define HOST_FRAME_OVERHEAD      (HOST_FRAME_HEADER + 2)
+
+// Largest payload, a whole frame must fit into UART_DMA_RX_SPILL
+#ifndef HOST_FRAME_MAX_PAYLOAD
+#define HOST_FRAME_MAX_PAYLOAD   240
+#endif
+
+#if HOST_FRAME_MAX_PAYLOAD + HOST_FRAME_OVERHEAD > UART_DMA_RX_SPILL
+#error "HOST_FRAME_MAX_PAYLOAD does not fit into UART_DMA_RX_SPILL"
+#endif
+
+typedef void (*HostFrameHandler_t)(uint8_t Type,uint8_t Seq,const uint8_t *pPayload,int Len);
+
+typedef struct {
+   uint32_t RxFrames;
+   uint32_t TxFrames;
+   uint32_t CrcErrors;
+   uint32_t Skipped;       // bytes dropped while looking for a frame
+   uint32_t TxDropped;     // frames not sent because the transmit ring was full
+} HostLinkStats_t;
+
+// Starts the UART, RxSignal is called from interrupt context when input
+// is waiting and HostLinkPoll() should be called
+void HostLinkInit(HostFrameHandler_t Handler,void (*RxSignal)(void));
+
+// Parses all complete frames waiting in the receive ring
+void HostLinkPoll(void);
+
+// Queues a frame, returns false if it does not fit into the transmit ring
+bool HostLinkSend(uint8_t Type,const void *pPayload,int Len);
+
+const HostLinkStats_t *HostLinkGetStats(void);
+
+uint16_t Crc16(uint16_t Crc,const uint8_t *pData,int Len);
+
+#endif   // _HOST_LINK_H_
@@ -0,0 +1,247 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAL_CONFIG)
+#include "bsphalconfig.h"
+#include "hal-config.h"
+#else
+#include "bspconfig.h"
+#endif
+
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+#include "sleep.h"
+#include "uart_dma.h"
+
+// Default to the VCOM pins of the WSTK if the board does not define them
+#ifndef BSP_SERIAL_APP_TX_PORT
+#define BSP_SERIAL_APP_TX_PORT   gpioPortA
+#define BSP_SERIAL_APP_TX_PIN    0
+#define BSP_SERIAL_APP_TX_LOC    0
+#define BSP_SERIAL_APP_RX_PORT   gpioPortA
+#define BSP_SERIAL_APP_RX_PIN    1
+#define BSP_SERIAL_APP_RX_LOC    0
+#endif
+
+#define TX_MASK   (UART_DMA_TX_SIZE - 1)
+#define RX_MASK   (UART_DMA_RX_SIZE - 1)
+
+static uint8_t TxRing[UART_DMA_TX_SIZE];
+// Free running ring indexes
+static volatile uint32_t TxHead;
+static volatile uint32_t TxTail;
+// Length of the transfer in progress, 0 if the channel is idle
+static uint32_t TxBusy;
+static uint32_t TxDropped;
+static bool Initialized;
+
+// The DMA only writes the first UART_DMA_RX_SIZE bytes, the spill area
+// behind them takes a copy of wrapped data so it can be read in one piece
+static uint8_t RxRing[UART_DMA_RX_SIZE + UART_DMA_RX_SPILL];
+// Read index into RxRing, the write index is the LDMA destination address
+static uint32_t RxTail;
+static LDMA_Descriptor_t RxDesc;
+static void (*RxCallback)(void);
+
+static void StartRx(void)
+{
+   LDMA_TransferCfg_t Cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_RXDATAV);
+
+   // a single descriptor linked to itself keeps filling the ring forever
+   RxDesc = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&USART0->RXDATA,RxRing,UART_DMA_RX_SIZE,0);
+   RxDesc.xfer.doneIfs = 0;
+   RxTail = 0;
+   LDMA_StartTransfer(UART_DMA_RX_CH,&Cfg,&RxDesc);
+
+   // RX timeout: TCMP1 fires when the line has been idle after a frame
+   USART0->TIMECMP1 = USART_TIMECMP1_TSTART_RXEOF | USART_TIMECMP1_TSTOP_RXACT
+                      | (UART_DMA_RX_IDLE_BITS << _USART_TIMECMP1_TCMPVAL_SHIFT);
+   USART_IntClear(USART0,USART_IF_TCMP1);
+   USART_IntEnable(USART0,USART_IEN_TCMP1);
+   NVIC_ClearPendingIRQ(USART0_RX_IRQn);
+   NVIC_EnableIRQ(USART0_RX_IRQn);
+}
+
+void USART0_RX_IRQHandler(void)
+{
+   USART_IntClear(USART0,USART_IF_TCMP1);
+   if(RxCallback != NULL) {
+      RxCallback();
+   }
+}
+
+void UartDmaInit(uint32_t Baudrate)
+{
+   USART_InitAsync_TypeDef UartInit = USART_INITASYNC_DEFAULT;
+   LDMA_Init_t DmaInit = LDMA_INIT_DEFAULT;
+
+   if(Initialized) {
+      // shared by the log transport and the console
+      return;
+   }
+
+   CMU_ClockEnable(cmuClock_GPIO, true);
+   CMU_ClockEnable(cmuClock_USART0, true);
+
+   GPIO_PinModeSet(BSP_SERIAL_APP_TX_PORT, BSP_SERIAL_APP_TX_PIN, gpioModePushPull, 1);
+   GPIO_PinModeSet(BSP_SERIAL_APP_RX_PORT, BSP_SERIAL_APP_RX_PIN, gpioModeInputPull, 1);
+
+   UartInit.baudrate = Baudrate;
+   USART_InitAsync(USART0, &UartInit);
+   USART0->ROUTELOC0 = (BSP_SERIAL_APP_TX_LOC << _USART_ROUTELOC0_TXLOC_SHIFT)
+                       | (BSP_SERIAL_APP_RX_LOC << _USART_ROUTELOC0_RXLOC_SHIFT);
+   USART0->ROUTEPEN = USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
+
+   LDMA_Init(&DmaInit);
+
+   TxHead = TxTail = 0;
+   TxBusy = 0;
+   StartRx();
+   // USART0 and the LDMA stop in EM2
+   SLEEP_SleepBlockBegin(sleepEM2);
+   Initialized = true;
+}
+
+void UartDmaSetRxCallback(void (*Callback)(void))
+{
+   RxCallback = Callback;
+}
+
+static uint32_t RxHead(void)
+{
+   return (LDMA->CH[UART_DMA_RX_CH].DST - (uint32_t) RxRing) & RX_MASK;
+}
+
+int UartDmaRxAvailable(void)
+{
+   if(!Initialized) {
+      return 0;
+   }
+   return (RxHead() - RxTail) & RX_MASK;
+}
+
+int UartDmaRead(void *Buf,int Len)
+{
+   uint8_t *p = (uint8_t *) Buf;
+   int Available = UartDmaRxAvailable();
+   int First;
+
+   if(Len > Available) {
+      Len = Available;
+   }
+
+   First = UART_DMA_RX_SIZE - RxTail;
+   if(First > Len) {
+      First = Len;
+   }
+   memcpy(p,&RxRing[RxTail],First);
+   memcpy(p + First,RxRing,Len - First);
+
+   RxTail = (RxTail + Len) & RX_MASK;
+   return Len;
+}
+
+const uint8_t *UartDmaRxPeek(int Len)
+{
+   int First = UART_DMA_RX_SIZE - RxTail;
+
+   if(Len > UART_DMA_RX_SPILL || Len > UartDmaRxAvailable()) {
+      return NULL;
+   }
+   if(Len > First) {
+      memcpy(&RxRing[UART_DMA_RX_SIZE],RxRing,Len - First);
+   }
+   return &RxRing[RxTail];
+}
+
+void UartDmaRxConsume(int Len)
+{
+   RxTail = (RxTail + Len) & RX_MASK;
+}
+
+int UartDmaTxFree(void)
+{
+   return UART_DMA_TX_SIZE - (TxHead - TxTail);
+}
+
+int UartDmaWrite(const void *Data,int Len)
+{
+   const uint8_t *p = (const uint8_t *) Data;
+   uint32_t Head = TxHead;
+   int Free = UartDmaTxFree();
+   int First;
+
+   if(Len > Free) {
+      TxDropped += Len - Free;
+      Len = Free;
+   }
+
+   // copy in at most two pieces, the second one after wrapping
+   First = UART_DMA_TX_SIZE - (Head & TX_MASK);
+   if(First > Len) {
+      First = Len;
+   }
+   memcpy(&TxRing[Head & TX_MASK],p,First);
+   memcpy(TxRing,p + First,Len - First);
+
+   TxHead = Head + Len;
+   return Len;
+}
+
+void UartDmaPoll(void)
+{
+   static LDMA_Descriptor_t Desc;
+   LDMA_TransferCfg_t Cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART0_TXBL);
+   uint32_t Tail;
+   uint32_t Len;
+
+   if(!Initialized) {
+      return;
+   }
+
+   if(TxBusy != 0) {
+      if(!LDMA_TransferDone(UART_DMA_TX_CH)) {
+         return;
+      }
+      TxTail += TxBusy;
+      TxBusy = 0;
+   }
+
+   Tail = TxTail;
+   Len = TxHead - Tail;
+   if(Len == 0) {
+      return;
+   }
+
+   // one transfer never wraps, the rest goes out on the next poll
+   if(Len > UART_DMA_TX_SIZE - (Tail & TX_MASK)) {
+      Len = UART_DMA_TX_SIZE - (Tail & TX_MASK);
+   }
+   // the LDMA transfer count is limited to 2048
+   if(Len > 2048) {
+      Len = 2048;
+   }
+
+   Desc = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&TxRing[Tail & TX_MASK],&USART0->TXDATA,Len);
+   TxBusy = Len;
+   LDMA_StartTransfer(UART_DMA_TX_CH,&Cfg,&Desc);
+}
+
+uint32_t UartDmaTxDropped(void)
+{
+   return TxDropped;
+}
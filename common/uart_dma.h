@@ -0,0 +1,92 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _UART_DMA_H_
+#define _UART_DMA_H_
+
+#include <stdint.h>
+
+// USART0 driver with a transmit ring that is drained by the LDMA.
+// UartDmaWrite() only copies into the ring, the DMA transfer of the data
+// is started by UartDmaPoll() which must be called from the main loop.
+// Nothing here waits for the hardware.
+// Received data is written into a receive ring by a second, self linked
+// LDMA descriptor. When the line goes idle after receiving, the RX callback
+// is called from interrupt context so the main loop can be woken up, e.g.
+// with gecko_external_signal().
+
+// Size of the transmit ring in bytes, must be a power of 2
+#ifndef UART_DMA_TX_SIZE
+#define UART_DMA_TX_SIZE      1024
+#endif
+
+// LDMA channel used for transmit
+#ifndef UART_DMA_TX_CH
+#define UART_DMA_TX_CH        7
+#endif
+
+// Size of the receive ring in bytes, must be a power of 2
+#ifndef UART_DMA_RX_SIZE
+#define UART_DMA_RX_SIZE      1024
+#endif
+
+// Longest run of received bytes UartDmaRxPeek() returns in one piece
+#ifndef UART_DMA_RX_SPILL
+#define UART_DMA_RX_SPILL     256
+#endif
+
+// LDMA channel used for receive
+#ifndef UART_DMA_RX_CH
+#define UART_DMA_RX_CH        6
+#endif
+
+// Idle time on the RX line in bit times before the RX callback is called
+#ifndef UART_DMA_RX_IDLE_BITS
+#define UART_DMA_RX_IDLE_BITS 20
+#endif
+
+#ifndef UART_DMA_BAUDRATE
+#define UART_DMA_BAUDRATE     115200
+#endif
+
+void UartDmaInit(uint32_t Baudrate);
+
+// Queues up to Len bytes, returns the number of bytes queued
+int UartDmaWrite(const void *Data,int Len);
+
+// Number of bytes that can be queued without dropping data
+int UartDmaTxFree(void);
+
+// Starts the next DMA transfer if the previous one has finished
+void UartDmaPoll(void);
+
+// Number of bytes dropped because the transmit ring was full
+uint32_t UartDmaTxDropped(void);
+
+// Sets the function called from interrupt context when the RX line goes idle
+void UartDmaSetRxCallback(void (*Callback)(void));
+
+// Number of received bytes waiting in the receive ring
+int UartDmaRxAvailable(void);
+
+// Copies up to Len received bytes, returns the number of bytes copied
+int UartDmaRead(void *Buf,int Len);
+
+// Returns the next Len received bytes in place, without copying unless they
+// wrap around the end of the ring. Returns NULL if fewer than Len bytes are
+// waiting or Len is above UART_DMA_RX_SPILL. The data stays valid until it
+// is consumed.
+const uint8_t *UartDmaRxPeek(int Len);
+
+// Releases Len received bytes
+void UartDmaRxConsume(int Len);
+
+#endif   // _UART_DMA_H_
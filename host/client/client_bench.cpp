@@ -0,0 +1,184 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Throughput and latency of the host client against a gateway, e.g. the
+// simulated dongle (make client-bench runs both).
+//
+// usage: client_bench [-n commands] [-a addresses] [-w window] [-b baud] device
+//
+// Runs these phases one after the other and reports commands per second,
+// the latency from submitting a command to its completion (median, 99th
+// percentile, worst) and the commands per frame:
+//  - serial:    lightness sets, each submitted when the previous one is done
+//  - pipelined: lightness sets to the addresses in turn, up to -w in flight
+//  - cached:    gets of the states just set, answered from the state cache
+//  - node:      gets the nodes have to answer, up to -w in flight
+// Exits with 1 if a command was not accepted.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "host_client.h"
+#include "mesh_generic_model_capi_types.h"
+
+using namespace darwin;
+using Clock = std::chrono::steady_clock;
+
+static HostClient Client;
+static uint32_t Addresses = 16;
+static uint32_t Window = 64;
+/// Serial and node phases take this fraction of the commands
+static const uint32_t SlowShare = 10;
+
+/// One phase, the completions come from the transport thread
+class Phase {
+public:
+   Phase(const char *Name,uint32_t Count,uint32_t InFlight) : Name(Name),Count(Count),InFlight(InFlight)
+   {
+      Latency.reserve(Count);
+   }
+
+   /// Submits the commands with Issue(i,Done) and waits for all of them
+   template<typename IssueFn>
+   bool Run(IssueFn Issue)
+   {
+      HostClient::Stats Before = Client.GetStats();
+      std::unique_lock<std::mutex> Guard(Lock);
+
+      Start = Clock::now();
+      while(Submitted < Count) {
+         Ready.wait(Guard,[this] { return Submitted - Completed < InFlight; });
+         uint32_t i = Submitted++;
+         Clock::time_point Sent = Clock::now();
+
+         Guard.unlock();
+         Issue(i,[this,Sent](bool Ok) { Done(Sent,Ok); });
+         Guard.lock();
+      }
+      Ready.wait(Guard,[this] { return Completed == Count; });
+      Report(Clock::now() - Start,Before);
+      return Failed == 0;
+   }
+
+private:
+   void Done(Clock::time_point Sent,bool Ok)
+   {
+      std::lock_guard<std::mutex> Guard(Lock);
+
+      Latency.push_back(std::chrono::duration<double,std::micro>(Clock::now() - Sent).count());
+      Failed += !Ok;
+      Completed++;
+      Ready.notify_one();
+   }
+
+   void Report(Clock::duration Elapsed,const HostClient::Stats &Before)
+   {
+      HostClient::Stats After = Client.GetStats();
+      double Seconds = std::chrono::duration<double>(Elapsed).count();
+      uint64_t Frames = After.Frames - Before.Frames;
+
+      std::sort(Latency.begin(),Latency.end());
+      printf("%-10s %7u commands %8.2f s %9.0f cmd/s  latency us p50 %8.0f p99 %8.0f max %8.0f  %5.1f cmd/frame"
+             "  %u failed\n",Name,Count,Seconds,Count / Seconds,Latency[Latency.size() / 2],
+             Latency[Latency.size() * 99 / 100],Latency.back(),Frames ? (double) Count / Frames : 0.0,Failed);
+   }
+
+   const char *Name;
+   uint32_t Count;
+   uint32_t InFlight;
+   std::mutex Lock;
+   std::condition_variable Ready;
+   uint32_t Submitted = 0;
+   uint32_t Completed = 0;
+   uint32_t Failed = 0;
+   Clock::time_point Start;
+   std::vector<double> Latency;
+};
+
+static uint16_t Address(uint32_t i)
+{
+   return 0x0100 + i % Addresses;
+}
+
+int main(int argc,char **argv)
+{
+   HostClient::Options Options;
+   std::atomic<uint64_t> Statuses{0};
+   uint32_t Count = 2000;
+   bool Ok = true;
+   int c;
+
+   while((c = getopt(argc,argv,"n:a:w:b:")) != -1) {
+      switch(c) {
+         case 'n':
+            Count = strtoul(optarg,NULL,0);
+            break;
+         case 'a':
+            Addresses = std::max(1UL,strtoul(optarg,NULL,0));
+            break;
+         case 'w':
+            Window = std::max(1UL,strtoul(optarg,NULL,0));
+            break;
+         case 'b':
+            Options.Baudrate = strtoul(optarg,NULL,0);
+            break;
+         default:
+            optind = argc;
+            break;
+      }
+   }
+   if(optind != argc - 1) {
+      fprintf(stderr,"usage: %s [-n commands] [-a addresses] [-w window] [-b baud] device\n",argv[0]);
+      return 1;
+   }
+
+   // the statuses are only counted, they are read in place
+   Client.SetStatusHandler([&Statuses](const StatusView &View) { Statuses++; });
+   if(!Client.Open(argv[optind],Options)) {
+      perror(argv[optind]);
+      return 1;
+   }
+
+   auto Set = [](uint32_t i,std::function<void(bool)> Done) {
+      Client.Lightness(Address(i),i,0,[Done](Status Result) { Done(Result == Status::Accepted); });
+   };
+   auto Get = [](uint16_t MaxAgeMs) {
+      return [MaxAgeMs](uint32_t i,std::function<void(bool)> Done) {
+         Client.Get(Address(i),MESH_LIGHTING_LIGHTNESS_CLIENT_MODEL_ID,MaxAgeMs,
+                    [Done](const State &Answer) { Done(Answer.Result == Status::Accepted); });
+      };
+   };
+
+   Ok &= Phase("serial",std::max(1U,Count / SlowShare),1).Run(Set);
+   Ok &= Phase("pipelined",Count,Window).Run(Set);
+   // let the nodes report the last values so the cache holds them
+   usleep(300000);
+   Ok &= Phase("cached",Count,Window).Run(Get(60000));
+   Ok &= Phase("node",std::max(1U,Count / SlowShare),Window).Run(Get(0));
+
+   HostClient::Stats Stats = Client.GetStats();
+   printf("client: %llu frames, %llu retransmits, %llu timed out, %llu crc errors, %llu resets, most commands in a "
+          "frame %u\n",(unsigned long long) Stats.Frames,(unsigned long long) Stats.Retransmits,
+          (unsigned long long) Stats.TimedOut,(unsigned long long) Stats.CrcErrors,(unsigned long long) Stats.Resets,
+          Stats.MaxBatch);
+   printf("link: %llu bytes out, %llu bytes in, %llu events, %llu statuses\n",(unsigned long long) Client.TxBytes(),
+          (unsigned long long) Client.RxBytes(),(unsigned long long) Stats.Events,
+          (unsigned long long) Statuses.load());
+   Client.Close();
+   return Ok ? 0 : 1;
+}
@@ -0,0 +1,714 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include "host_client.h"
+
+namespace darwin {
+
+/// Console frames are not commands, their ack has no bitmap
+#define OP_CONSOLE   0
+
+static uint16_t GetU16(const uint8_t *p)
+{
+   return p[0] | (p[1] << 8);
+}
+
+static uint32_t GetU32(const uint8_t *p)
+{
+   return GetU16(p) | ((uint32_t) GetU16(&p[2]) << 16);
+}
+
+static uint8_t *PutU16(uint8_t *p,uint16_t Value)
+{
+   *p++ = Value;
+   *p++ = Value >> 8;
+   return p;
+}
+
+/// Commands that take a client queue entry of the gateway
+static bool IsSet(uint8_t Op)
+{
+   return Op == HOST_OP_ON_OFF || Op == HOST_OP_LIGHTNESS || Op == HOST_OP_CTL;
+}
+
+/// Same as Crc16() of host_link.c, bit by bit
+static uint16_t Crc16(uint16_t Crc,const uint8_t *p,size_t Len)
+{
+   while(Len-- > 0) {
+      Crc ^= *p++ << 8;
+      for(int i = 0; i < 8; i++) {
+         Crc = Crc & 0x8000 ? (Crc << 1) ^ 0x1021 : Crc << 1;
+      }
+   }
+   return Crc;
+}
+
+const char *StatusName(Status Value)
+{
+   switch(Value) {
+      case Status::Accepted:  return "accepted";
+      case Status::Rejected:  return "rejected";
+      case Status::TimedOut:  return "timed out";
+      case Status::Closed:    return "closed";
+   }
+   return "?";
+}
+
+HostClient::HostClient() : Transport(*this)
+{
+}
+
+HostClient::~HostClient()
+{
+   Close();
+}
+
+bool HostClient::Open(const std::string &Path,const Options &Config)
+{
+   uint8_t Wire[HOST_FRAME_OVERHEAD] = {HOST_FRAME_SOF,0,0,0,HOST_FRAME_RESET};
+   uint16_t Crc = Crc16(0xFFFF,&Wire[1],HOST_FRAME_HEADER - 1);
+   bool Started;
+
+   Opts = Config;
+   if(!Transport.Open(Path,Opts.Baudrate)) {
+      return false;
+   }
+
+   std::unique_lock<std::mutex> Guard(Lock);
+   Session = false;
+   Window = 0;
+   LastCredit = Clock::now();
+   Wire[HOST_FRAME_HEADER] = Crc;
+   Wire[HOST_FRAME_HEADER + 1] = Crc >> 8;
+   Transport.Send(Wire,sizeof(Wire));
+   Started = SessionStarted.wait_for(Guard,std::chrono::milliseconds(Opts.ResetTimeoutMs),[this] { return Session; });
+   Guard.unlock();
+   if(!Started) {
+      Close();
+      errno = ETIMEDOUT;
+   }
+   return Started;
+}
+
+void HostClient::Close()
+{
+   Transport.Close();
+   FailAll(Status::Closed);
+   RunReady();
+}
+
+/*******************************************************************************
+ * Commands
+ ******************************************************************************/
+void HostClient::Submit(Command &&Cmd,const uint8_t *pArgs,uint8_t Len)
+{
+   bool Wake = false;
+   std::unique_lock<std::mutex> Guard(Lock);
+
+   if(!Session) {
+      Complete(Cmd,Status::Closed);
+      Guard.unlock();
+      RunReady();
+      return;
+   }
+
+   if(Cmd.Op == OP_CONSOLE || Queued.empty() || Queued.back().Type != HOST_FRAME_COMMANDS
+      || Queued.back().Payload.size() + 2 + Len > HOST_FRAME_MAX_PAYLOAD
+      || (Cmd.Op == HOST_OP_GET && Queued.back().Gets >= Opts.GetsPerFrame)
+      || (IsSet(Cmd.Op) && Queued.back().Sets >= Opts.SetsPerFrame)) {
+      // a frame already queued has its wake up pending or waits for a credit
+      Wake = Queued.empty();
+      Queued.emplace_back();
+      Queued.back().Type = Cmd.Op == OP_CONSOLE ? HOST_FRAME_CONSOLE : HOST_FRAME_COMMANDS;
+   }
+
+   Frame &F = Queued.back();
+   if(Cmd.Op != OP_CONSOLE) {
+      F.Payload.push_back(Cmd.Op);
+      F.Payload.push_back(Len);
+   }
+   F.Payload.insert(F.Payload.end(),pArgs,pArgs + Len);
+   F.Gets += Cmd.Op == HOST_OP_GET;
+   F.Sets += IsSet(Cmd.Op);
+   F.Commands.push_back(std::move(Cmd));
+   Counters.Commands++;
+   Guard.unlock();
+
+   if(Wake) {
+      Transport.Wake();
+   }
+}
+
+void HostClient::OnOff(uint16_t Address,bool On,uint16_t TransitionMs,Done Callback)
+{
+   uint8_t Args[5];
+   Command Cmd;
+
+   PutU16(PutU16(Args,Address),TransitionMs)[0] = On;
+   Cmd.Op = HOST_OP_ON_OFF;
+   Cmd.SetDone = std::move(Callback);
+   Submit(std::move(Cmd),Args,sizeof(Args));
+}
+
+void HostClient::Lightness(uint16_t Address,uint16_t Lightness,uint16_t TransitionMs,Done Callback)
+{
+   uint8_t Args[6];
+   Command Cmd;
+
+   PutU16(PutU16(PutU16(Args,Address),TransitionMs),Lightness);
+   Cmd.Op = HOST_OP_LIGHTNESS;
+   Cmd.SetDone = std::move(Callback);
+   Submit(std::move(Cmd),Args,sizeof(Args));
+}
+
+void HostClient::Ctl(uint16_t Address,uint16_t Lightness,uint16_t Temperature,int16_t DeltaUv,uint16_t TransitionMs,
+                     Done Callback)
+{
+   uint8_t Args[10];
+   Command Cmd;
+
+   PutU16(PutU16(PutU16(PutU16(PutU16(Args,Address),TransitionMs),Lightness),Temperature),DeltaUv);
+   Cmd.Op = HOST_OP_CTL;
+   Cmd.SetDone = std::move(Callback);
+   Submit(std::move(Cmd),Args,sizeof(Args));
+}
+
+void HostClient::Get(uint16_t Address,uint16_t ModelID,uint16_t MaxAgeMs,StateDone Callback)
+{
+   uint8_t Args[6];
+   Command Cmd;
+
+   PutU16(PutU16(PutU16(Args,Address),ModelID),MaxAgeMs);
+   Cmd.Op = HOST_OP_GET;
+   Cmd.Address = Address;
+   Cmd.ModelID = ModelID;
+   Cmd.GetDone = std::move(Callback);
+   Submit(std::move(Cmd),Args,sizeof(Args));
+}
+
+void HostClient::RecallScene(uint16_t Scene,uint16_t TransitionMs,const std::vector<uint16_t> &Targets,
+                             SceneDone Callback)
+{
+   uint8_t Args[HOST_FRAME_MAX_PAYLOAD - 2];
+   uint8_t *p = PutU16(PutU16(Args,Scene),TransitionMs);
+   Command Cmd;
+
+   for(size_t i = 0; i < Targets.size() && p + 2 <= Args + sizeof(Args); i++) {
+      p = PutU16(p,Targets[i]);
+   }
+   Cmd.Op = HOST_OP_SCENE;
+   Cmd.ModelID = Scene;
+   Cmd.RecallDone = std::move(Callback);
+   Submit(std::move(Cmd),Args,p - Args);
+}
+
+void HostClient::Console(const std::string &Line,Done Callback)
+{
+   std::string Text = Line.substr(0,HOST_FRAME_MAX_PAYLOAD - 1) + "\n";
+   Command Cmd;
+
+   Cmd.Op = OP_CONSOLE;
+   Cmd.SetDone = std::move(Callback);
+   Submit(std::move(Cmd),(const uint8_t *) Text.data(),Text.size());
+}
+
+std::future<Status> HostClient::OnOff(uint16_t Address,bool On,uint16_t TransitionMs)
+{
+   auto Promise = std::make_shared<std::promise<Status>>();
+
+   OnOff(Address,On,TransitionMs,[Promise](Status Result) { Promise->set_value(Result); });
+   return Promise->get_future();
+}
+
+std::future<Status> HostClient::Lightness(uint16_t Address,uint16_t Lightness,uint16_t TransitionMs)
+{
+   auto Promise = std::make_shared<std::promise<Status>>();
+
+   this->Lightness(Address,Lightness,TransitionMs,[Promise](Status Result) { Promise->set_value(Result); });
+   return Promise->get_future();
+}
+
+std::future<Status> HostClient::Ctl(uint16_t Address,uint16_t Lightness,uint16_t Temperature,int16_t DeltaUv,
+                                    uint16_t TransitionMs)
+{
+   auto Promise = std::make_shared<std::promise<Status>>();
+
+   Ctl(Address,Lightness,Temperature,DeltaUv,TransitionMs,[Promise](Status Result) { Promise->set_value(Result); });
+   return Promise->get_future();
+}
+
+std::future<State> HostClient::Get(uint16_t Address,uint16_t ModelID,uint16_t MaxAgeMs)
+{
+   auto Promise = std::make_shared<std::promise<State>>();
+
+   Get(Address,ModelID,MaxAgeMs,[Promise](const State &Answer) { Promise->set_value(Answer); });
+   return Promise->get_future();
+}
+
+std::future<SceneResult> HostClient::RecallScene(uint16_t Scene,uint16_t TransitionMs,
+                                                 const std::vector<uint16_t> &Targets)
+{
+   auto Promise = std::make_shared<std::promise<SceneResult>>();
+
+   RecallScene(Scene,TransitionMs,Targets,[Promise](const SceneResult &Result) { Promise->set_value(Result); });
+   return Promise->get_future();
+}
+
+std::future<Status> HostClient::Console(const std::string &Line)
+{
+   auto Promise = std::make_shared<std::promise<Status>>();
+
+   Console(Line,[Promise](Status Result) { Promise->set_value(Result); });
+   return Promise->get_future();
+}
+
+HostClient::Stats HostClient::GetStats() const
+{
+   std::lock_guard<std::mutex> Guard(Lock);
+
+   return Counters;
+}
+
+int HostClient::Credits() const
+{
+   std::lock_guard<std::mutex> Guard(Lock);
+
+   return Window;
+}
+
+size_t HostClient::Pending() const
+{
+   std::lock_guard<std::mutex> Guard(Lock);
+   size_t Count = Waiting.size();
+
+   for(const auto *List : {&Queued,&InFlight}) {
+      for(const Frame &F : *List) {
+         Count += F.Commands.size();
+      }
+   }
+   return Count;
+}
+
+/*******************************************************************************
+ * Completion, called with the lock held, the callbacks run in RunReady()
+ ******************************************************************************/
+void HostClient::Complete(Command &Cmd,Status Result)
+{
+   switch(Result) {
+      case Status::Accepted:  Counters.Accepted++;  break;
+      case Status::Rejected:  Counters.Rejected++;  break;
+      case Status::TimedOut:  Counters.TimedOut++;  break;
+      default:                break;
+   }
+
+   if(Cmd.GetDone) {
+      State Answer;
+
+      Answer.Result = Result;
+      Answer.Address = Cmd.Address;
+      Answer.ModelID = Cmd.ModelID;
+      Ready.push_back([Done = std::move(Cmd.GetDone),Answer] { Done(Answer); });
+   }
+   else if(Cmd.RecallDone) {
+      SceneResult Scene;
+
+      Scene.Result = Result;
+      Scene.Scene = Cmd.ModelID;
+      Ready.push_back([Done = std::move(Cmd.RecallDone),Scene] { Done(Scene); });
+   }
+   else if(Cmd.SetDone) {
+      Ready.push_back([Done = std::move(Cmd.SetDone),Result] { Done(Result); });
+   }
+}
+
+void HostClient::FailAll(Status Result)
+{
+   std::lock_guard<std::mutex> Guard(Lock);
+
+   for(auto *List : {&InFlight,&Queued}) {
+      for(Frame &F : *List) {
+         for(Command &Cmd : F.Commands) {
+            if(!Cmd.Answered) {
+               Complete(Cmd,Result);
+            }
+         }
+      }
+      List->clear();
+   }
+   for(Command &Cmd : Waiting) {
+      Complete(Cmd,Result);
+   }
+   Waiting.clear();
+   Session = false;
+   Window = 0;
+}
+
+void HostClient::RunReady()
+{
+   std::vector<std::function<void()>> Run;
+
+   {
+      std::lock_guard<std::mutex> Guard(Lock);
+
+      Run.swap(Ready);
+   }
+   for(auto &Done : Run) {
+      Done();
+   }
+}
+
+/*******************************************************************************
+ * Transport thread
+ ******************************************************************************/
+void HostClient::SendFrame(Frame &F)
+{
+   size_t Len = F.Payload.size();
+   uint16_t Crc;
+
+   F.Seq = TxSeq++;
+   F.Wire.resize(Len + HOST_FRAME_OVERHEAD);
+   F.Wire[0] = HOST_FRAME_SOF;
+   F.Wire[1] = Len;
+   F.Wire[2] = Len >> 8;
+   F.Wire[3] = F.Seq;
+   F.Wire[4] = F.Type;
+   std::copy(F.Payload.begin(),F.Payload.end(),F.Wire.begin() + HOST_FRAME_HEADER);
+   Crc = Crc16(0xFFFF,&F.Wire[1],Len + HOST_FRAME_HEADER - 1);
+   F.Wire[Len + HOST_FRAME_HEADER] = Crc;
+   F.Wire[Len + HOST_FRAME_HEADER + 1] = Crc >> 8;
+   F.Sent = Clock::now();
+   F.Tries = 1;
+   Transport.Send(F.Wire.data(),F.Wire.size());
+
+   Counters.Frames++;
+   if(F.Type == HOST_FRAME_COMMANDS && F.Commands.size() > Counters.MaxBatch) {
+      Counters.MaxBatch = F.Commands.size();
+   }
+}
+
+/// Sends the queued frames the credits allow, with the lock held
+void HostClient::SendQueued()
+{
+   while(Session && Window > 0 && !Queued.empty()) {
+      InFlight.push_back(std::move(Queued.front()));
+      Queued.pop_front();
+      Window--;
+      SendFrame(InFlight.back());
+   }
+}
+
+size_t HostClient::Received(const uint8_t *pData,size_t Len)
+{
+   size_t Pos = 0;
+
+   while(Len - Pos >= HOST_FRAME_HEADER) {
+      const uint8_t *p = &pData[Pos];
+      size_t Payload = GetU16(&p[1]);
+
+      if(p[0] != HOST_FRAME_SOF || Payload > HOST_FRAME_MAX_PAYLOAD) {
+         std::lock_guard<std::mutex> Guard(Lock);
+
+         Counters.Skipped++;
+         Pos++;
+         continue;
+      }
+      if(Len - Pos < Payload + HOST_FRAME_OVERHEAD) {
+         // wait for the rest of the frame
+         break;
+      }
+      if(Crc16(0xFFFF,&p[1],Payload + HOST_FRAME_HEADER - 1) != GetU16(&p[Payload + HOST_FRAME_HEADER])) {
+         std::lock_guard<std::mutex> Guard(Lock);
+
+         Counters.CrcErrors++;
+         Pos++;
+         continue;
+      }
+      HandleFrame(p[4],&p[HOST_FRAME_HEADER],Payload);
+      Pos += Payload + HOST_FRAME_OVERHEAD;
+   }
+   RunReady();
+   return Pos;
+}
+
+void HostClient::HandleFrame(uint8_t Type,const uint8_t *p,size_t Len)
+{
+   if(Type == HOST_FRAME_EVENT && Len >= 4) {
+      uint32_t Header = GetU32(p);
+
+      // the handlers read the event where it is
+      if(OnEvent) {
+         OnEvent(Header,&p[4],Len - 4);
+      }
+      if(BGLIB_MSG_ID(Header) == gecko_evt_mesh_generic_client_server_status_id
+         && Len >= 4 + sizeof(gecko_msg_mesh_generic_client_server_status_evt_t)
+         && Len >= 4 + sizeof(gecko_msg_mesh_generic_client_server_status_evt_t)
+                   + p[4 + offsetof(gecko_msg_mesh_generic_client_server_status_evt_t,parameters)]) {
+         StatusView View((const gecko_msg_mesh_generic_client_server_status_evt_t *) &p[4]);
+
+         if(OnStatus) {
+            OnStatus(View);
+         }
+         HandleStatus(View);
+      }
+      std::lock_guard<std::mutex> Guard(Lock);
+      Counters.Events++;
+      return;
+   }
+   if(Type == HOST_FRAME_CONSOLE) {
+      if(OnConsole) {
+         OnConsole((const char *) p,Len);
+      }
+      return;
+   }
+
+   std::lock_guard<std::mutex> Guard(Lock);
+   switch(Type) {
+      case HOST_FRAME_CREDIT:
+         if(Len >= 1) {
+            Window += p[0];
+            LastCredit = Clock::now();
+            if(!Session) {
+               Session = true;
+               SessionStarted.notify_all();
+            }
+         }
+         break;
+
+      case HOST_FRAME_ACK:
+         HandleAck(p,Len);
+         break;
+
+      case HOST_FRAME_STATE:
+         HandleState(p,Len);
+         break;
+
+      case HOST_FRAME_SCENE:
+         HandleScene(p,Len);
+         break;
+
+      default:
+         break;
+   }
+}
+
+/// Completes the commands of the acked frame, with the lock held
+void HostClient::HandleAck(const uint8_t *p,size_t Len)
+{
+   auto F = InFlight.begin();
+
+   if(Len < 4) {
+      return;
+   }
+   while(F != InFlight.end() && F->Seq != p[0]) {
+      F++;
+   }
+   if(F == InFlight.end()) {
+      // the ack of a retransmission that came after the first one
+      return;
+   }
+
+   Window += p[3];
+   if(p[3] != 0) {
+      LastCredit = Clock::now();
+   }
+   for(size_t i = 0; i < F->Commands.size(); i++) {
+      Command &Cmd = F->Commands[i];
+      // without the bitmap every command of a frame with a rejection failed
+      bool Rejected = Len > 4 + i / 8 ? (p[4 + i / 8] >> (i % 8)) & 1 : p[2] != 0;
+
+      if(Cmd.Answered) {
+         continue;
+      }
+      if(Rejected || Cmd.Op == OP_CONSOLE || (Cmd.Op != HOST_OP_GET && Cmd.Op != HOST_OP_SCENE)) {
+         Complete(Cmd,Rejected ? Status::Rejected : Status::Accepted);
+         continue;
+      }
+      Cmd.Deadline = Clock::now() + std::chrono::milliseconds(Opts.AnswerTimeoutMs);
+      Waiting.push_back(std::move(Cmd));
+   }
+   InFlight.erase(F);
+}
+
+/// Completes gets of the address and model, with the lock held. A cached
+/// state answers the oldest get of a frame in flight, the gateway sends one
+/// per get. A status of the node answers all of them, the client queue of
+/// the gateway sends one request for all gets of a node.
+void HostClient::AnswerGet(const State &Answer)
+{
+   auto Matches = [&Answer](const Command &Cmd) {
+      return Cmd.Op == HOST_OP_GET && !Cmd.Answered && Cmd.Address == Answer.Address
+             && Cmd.ModelID == Answer.ModelID;
+   };
+
+   if(!Answer.Cached) {
+      for(auto Cmd = Waiting.begin(); Cmd != Waiting.end();) {
+         if(Matches(*Cmd)) {
+            Counters.Accepted++;
+            Ready.push_back([Done = std::move(Cmd->GetDone),Answer] { Done(Answer); });
+            Cmd = Waiting.erase(Cmd);
+         }
+         else {
+            Cmd++;
+         }
+      }
+   }
+   for(Frame &F : InFlight) {
+      for(Command &Cmd : F.Commands) {
+         if(Matches(Cmd)) {
+            Counters.Accepted++;
+            Cmd.Answered = true;
+            Ready.push_back([Done = std::move(Cmd.GetDone),Answer] { Done(Answer); });
+            if(Answer.Cached) {
+               return;
+            }
+         }
+      }
+   }
+}
+
+/// A get answered from the cache, comes before the ack of its frame
+void HostClient::HandleState(const uint8_t *p,size_t Len)
+{
+   State Answer;
+
+   if(Len < 16) {
+      return;
+   }
+   Answer.Result = Status::Accepted;
+   Answer.Cached = true;
+   Answer.Address = GetU16(p);
+   Answer.Element = p[2];
+   Answer.ModelID = GetU16(&p[3]);
+   Answer.Type = p[5];
+   Answer.AgeMs = GetU32(&p[6]);
+   Answer.RemainingMs = GetU32(&p[10]);
+   Answer.Len = std::min<size_t>(Len - 16,State::MaxParams);
+   memcpy(Answer.Params,&p[16],Answer.Len);
+   AnswerGet(Answer);
+}
+
+void HostClient::HandleStatus(const StatusView &View)
+{
+   std::lock_guard<std::mutex> Guard(Lock);
+   State Answer;
+
+   if(Waiting.empty() && InFlight.empty()) {
+      return;
+   }
+   Answer.Result = Status::Accepted;
+   Answer.Address = View.ServerAddress();
+   Answer.ModelID = View.ModelID();
+   Answer.Type = View.Type();
+   Answer.RemainingMs = View.RemainingMs();
+   Answer.Len = std::min<size_t>(View.ParamsLen(),State::MaxParams);
+   memcpy(Answer.Params,View.Params(),Answer.Len);
+   AnswerGet(Answer);
+}
+
+void HostClient::HandleScene(const uint8_t *p,size_t Len)
+{
+   SceneResult Result;
+   auto Cmd = Waiting.begin();
+
+   if(Len < 16) {
+      return;
+   }
+   Result.Result = Status::Accepted;
+   Result.Scene = GetU16(p);
+   Result.Targets = GetU16(&p[2]);
+   Result.Acked = GetU16(&p[4]);
+   Result.Groups = GetU16(&p[6]);
+   Result.Failed = GetU16(&p[8]);
+   Result.Retries = GetU16(&p[10]);
+   Result.ElapsedMs = GetU32(&p[12]);
+   for(size_t i = 16; i + 2 <= Len; i += 2) {
+      Result.FailedAddresses.push_back(GetU16(&p[i]));
+   }
+
+   while(Cmd != Waiting.end() && !(Cmd->Op == HOST_OP_SCENE && Cmd->ModelID == Result.Scene)) {
+      Cmd++;
+   }
+   if(Cmd != Waiting.end()) {
+      Counters.Accepted++;
+      Ready.push_back([Done = std::move(Cmd->RecallDone),Result] { Done(Result); });
+      Waiting.erase(Cmd);
+   }
+}
+
+void HostClient::Woken()
+{
+   std::lock_guard<std::mutex> Guard(Lock);
+
+   SendQueued();
+}
+
+void HostClient::Tick()
+{
+   std::unique_lock<std::mutex> Guard(Lock);
+   Clock::time_point Now = Clock::now();
+
+   while(!InFlight.empty() && Now - InFlight.front().Sent > std::chrono::milliseconds(Opts.AckTimeoutMs)) {
+      Frame &F = InFlight.front();
+
+      if(InFlight.size() == 1 && F.Tries <= Opts.Retransmits) {
+         // the gateway repeats the ack if it has seen the frame
+         F.Tries++;
+         F.Sent = Now;
+         Counters.Retransmits++;
+         Transport.Send(F.Wire.data(),F.Wire.size());
+         break;
+      }
+      for(Command &Cmd : F.Commands) {
+         if(!Cmd.Answered) {
+            Complete(Cmd,Status::TimedOut);
+         }
+      }
+      InFlight.pop_front();
+   }
+
+   for(auto Cmd = Waiting.begin(); Cmd != Waiting.end();) {
+      if(Now > Cmd->Deadline) {
+         Complete(*Cmd,Status::TimedOut);
+         Cmd = Waiting.erase(Cmd);
+      }
+      else {
+         Cmd++;
+      }
+   }
+
+   if(Session && Window == 0 && InFlight.empty() && !Queued.empty()
+      && Now - LastCredit > std::chrono::milliseconds(Opts.ResetTimeoutMs)) {
+      // credits of lost frames never come back, start over
+      uint8_t Wire[HOST_FRAME_OVERHEAD] = {HOST_FRAME_SOF,0,0,TxSeq,HOST_FRAME_RESET};
+      uint16_t Crc = Crc16(0xFFFF,&Wire[1],HOST_FRAME_HEADER - 1);
+
+      Wire[HOST_FRAME_HEADER] = Crc;
+      Wire[HOST_FRAME_HEADER + 1] = Crc >> 8;
+      Transport.Send(Wire,sizeof(Wire));
+      LastCredit = Now;
+      Counters.Resets++;
+   }
+   Guard.unlock();
+   RunReady();
+}
+
+void HostClient::Disconnected()
+{
+   FailAll(Status::Closed);
+   RunReady();
+}
+
+}  // namespace darwin
@@ -0,0 +1,269 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _HOST_CLIENT_H_
+#define _HOST_CLIENT_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "serial_transport.h"
+
+extern "C" {
+#include "host_link.h"
+#include "host_protocol.h"
+#include "state_cache.h"
+}
+
+namespace darwin {
+
+// Host side of the host protocol of the gateway (see host_protocol.h and
+// host_link.h, which this library shares with the firmware).
+//
+// Every command returns at once. It is completed later from the transport
+// thread, either through the callback given or through the future the
+// other overload returns, so any number of commands can be in flight.
+// Callbacks must not block, they may submit more commands.
+//
+// Commands are batched: a command is appended to the last frame that is
+// still waiting for a credit if it fits, otherwise it starts a new frame.
+// A frame is sent as soon as the gateway has returned a credit for it, so
+// a lone command goes out at once and a burst fills frames while the
+// credits are used up. Each command of a frame is completed from the
+// rejected bitmap of its ack. A set is done when the gateway took it, a get
+// when its state comes from the state cache or the node reports it, a
+// scene recall when the gateway reports its result.
+//
+// A frame without an ack after AckTimeoutMs is sent again with the same
+// sequence number while it is the only frame in flight, the gateway then
+// repeats the ack if only the ack was lost. Otherwise its commands time out.
+//
+// Status events forwarded by the gateway are parsed in place: the handlers
+// get a view into the receive buffer of the transport that is only valid
+// during the call, nothing is copied.
+
+enum class Status : uint8_t {
+   Accepted,      ///< The gateway took the command
+   Rejected,      ///< The gateway refused it, e.g. the client queue was full
+   TimedOut,      ///< No ack or no answer in time
+   Closed         ///< The client was closed or the port hung up
+};
+
+const char *StatusName(Status Value);
+
+/// Answer to a get
+struct State {
+   static constexpr int MaxParams = 16;
+
+   Status Result = Status::Closed;
+   bool Cached = false;             ///< From the state cache of the gateway, otherwise reported by the node
+   uint16_t Address = 0;
+   uint8_t Element = 0;
+   uint16_t ModelID = 0;
+   uint8_t Type = 0;
+   uint32_t AgeMs = 0;
+   uint32_t RemainingMs = 0;
+   uint8_t Len = 0;
+   uint8_t Params[MaxParams] = {};
+};
+
+/// Result of a bulk scene recall
+struct SceneResult {
+   Status Result = Status::Closed;
+   uint16_t Scene = 0;
+   uint16_t Targets = 0;
+   uint16_t Acked = 0;
+   uint16_t Groups = 0;
+   uint16_t Failed = 0;
+   uint16_t Retries = 0;
+   uint32_t ElapsedMs = 0;
+   std::vector<uint16_t> FailedAddresses;   ///< as many as fit into the result frame
+};
+
+/// Generic client server status in the receive buffer, the gateway and the
+/// host are both little endian
+class StatusView {
+public:
+   explicit StatusView(const gecko_msg_mesh_generic_client_server_status_evt_t *pStatus) : p(pStatus) {}
+
+   uint16_t ModelID() const { return p->model_id; }
+   uint16_t ElementIndex() const { return p->elem_index; }
+   uint16_t ClientAddress() const { return p->client_address; }
+   uint16_t ServerAddress() const { return p->server_address; }
+   uint32_t RemainingMs() const { return p->remaining; }
+   uint16_t Flags() const { return p->flags; }
+   uint8_t Type() const { return p->type; }
+   const uint8_t *Params() const { return p->parameters.data; }
+   uint8_t ParamsLen() const { return p->parameters.len; }
+
+private:
+   const gecko_msg_mesh_generic_client_server_status_evt_t *p;
+};
+
+class HostClient : private SerialTransport::Listener {
+public:
+   using Clock = std::chrono::steady_clock;
+   using Done = std::function<void(Status)>;
+   using StateDone = std::function<void(const State &)>;
+   using SceneDone = std::function<void(const SceneResult &)>;
+   using StatusHandler = std::function<void(const StatusView &)>;
+   using EventHandler = std::function<void(uint32_t Header,const uint8_t *pPayload,size_t Len)>;
+   using ConsoleHandler = std::function<void(const char *pText,size_t Len)>;
+
+   struct Options {
+      uint32_t Baudrate = 0;           ///< 0 keeps the rate of the port, e.g. for a pseudo terminal
+      int AckTimeoutMs = 500;
+      int Retransmits = 3;             ///< of a frame without ack
+      int AnswerTimeoutMs = 10000;     ///< for the node answering a get, for a scene result
+      int ResetTimeoutMs = 1000;       ///< for the first credit, then to start over without credits
+      /// Gets in a frame, the cached states of all frames in flight fit into the transmit ring of the gateway
+      size_t GetsPerFrame = UART_DMA_TX_SIZE / HOST_PROTOCOL_WINDOW
+                            / (HOST_FRAME_OVERHEAD + 16 + STATE_CACHE_MAX_PARAMS) - 1;
+      /// Sets in a frame, the gateway rejects those past HOST_FRAME_MAX_SETS
+      size_t SetsPerFrame = HOST_FRAME_MAX_SETS;
+   };
+
+   struct Stats {
+      uint64_t Commands = 0;
+      uint64_t Frames = 0;             ///< command and console frames sent, without retransmissions
+      uint64_t Retransmits = 0;
+      uint64_t Accepted = 0;
+      uint64_t Rejected = 0;
+      uint64_t TimedOut = 0;
+      uint64_t Events = 0;
+      uint64_t CrcErrors = 0;
+      uint64_t Skipped = 0;            ///< bytes dropped while looking for a frame
+      uint64_t Resets = 0;             ///< sessions started again because the credits were lost
+      uint32_t MaxBatch = 0;           ///< most commands in a frame
+   };
+
+   HostClient();
+   ~HostClient() override;
+
+   // The handlers are called from the transport thread, set them before Open()
+   void SetStatusHandler(StatusHandler Handler) { OnStatus = std::move(Handler); }
+   void SetEventHandler(EventHandler Handler) { OnEvent = std::move(Handler); }
+   void SetConsoleHandler(ConsoleHandler Handler) { OnConsole = std::move(Handler); }
+
+   // Opens the port and starts a session, false with errno set if the port
+   // cannot be opened or the gateway does not answer
+   bool Open(const std::string &Path,const Options &Opts);
+   bool Open(const std::string &Path) { return Open(Path,Options()); }
+
+   // Completes everything still pending with Status::Closed
+   void Close();
+
+   void OnOff(uint16_t Address,bool On,uint16_t TransitionMs,Done Callback);
+   std::future<Status> OnOff(uint16_t Address,bool On,uint16_t TransitionMs = 0);
+
+   void Lightness(uint16_t Address,uint16_t Lightness,uint16_t TransitionMs,Done Callback);
+   std::future<Status> Lightness(uint16_t Address,uint16_t Lightness,uint16_t TransitionMs = 0);
+
+   void Ctl(uint16_t Address,uint16_t Lightness,uint16_t Temperature,int16_t DeltaUv,uint16_t TransitionMs,
+            Done Callback);
+   std::future<Status> Ctl(uint16_t Address,uint16_t Lightness,uint16_t Temperature,int16_t DeltaUv = 0,
+                           uint16_t TransitionMs = 0);
+
+   // A state cached for at most MaxAgeMs is answered by the gateway,
+   // otherwise the node is asked
+   void Get(uint16_t Address,uint16_t ModelID,uint16_t MaxAgeMs,StateDone Callback);
+   std::future<State> Get(uint16_t Address,uint16_t ModelID,uint16_t MaxAgeMs);
+
+   // Group or unicast targets, as many as fit into a frame
+   void RecallScene(uint16_t Scene,uint16_t TransitionMs,const std::vector<uint16_t> &Targets,SceneDone Callback);
+   std::future<SceneResult> RecallScene(uint16_t Scene,uint16_t TransitionMs,const std::vector<uint16_t> &Targets);
+
+   // A console command line, done when the gateway took it, the output
+   // goes to the console handler
+   void Console(const std::string &Line,Done Callback);
+   std::future<Status> Console(const std::string &Line);
+
+   Stats GetStats() const;
+
+   // Frames the gateway has room for
+   int Credits() const;
+
+   // Commands sent or queued and not completed yet
+   size_t Pending() const;
+
+   uint64_t TxBytes() const { return Transport.TxBytes(); }
+   uint64_t RxBytes() const { return Transport.RxBytes(); }
+
+private:
+   struct Command {
+      uint8_t Op = 0;
+      uint16_t Address = 0;            ///< target of a get
+      uint16_t ModelID = 0;            ///< model of a get, scene of a recall
+      bool Answered = false;           ///< a get answered from the cache before the ack
+      Clock::time_point Deadline;      ///< for the answer once accepted
+      Done SetDone;
+      StateDone GetDone;
+      SceneDone RecallDone;
+   };
+
+   struct Frame {
+      uint8_t Type = HOST_FRAME_COMMANDS;
+      uint8_t Seq = 0;
+      int Tries = 0;
+      size_t Gets = 0;
+      size_t Sets = 0;
+      Clock::time_point Sent;
+      std::vector<uint8_t> Payload;
+      std::vector<uint8_t> Wire;       ///< the frame as sent, for retransmissions
+      std::vector<Command> Commands;
+   };
+
+   size_t Received(const uint8_t *pData,size_t Len) override;
+   void Woken() override;
+   void Tick() override;
+   void Disconnected() override;
+
+   void Submit(Command &&Cmd,const uint8_t *pArgs,uint8_t Len);
+   void SendFrame(Frame &F);
+   void SendQueued();
+   void HandleFrame(uint8_t Type,const uint8_t *p,size_t Len);
+   void HandleAck(const uint8_t *p,size_t Len);
+   void HandleState(const uint8_t *p,size_t Len);
+   void HandleStatus(const StatusView &Status);
+   void HandleScene(const uint8_t *p,size_t Len);
+   void AnswerGet(const State &Answer);
+   void Complete(Command &Cmd,Status Result);
+   void FailAll(Status Result);
+   void RunReady();
+
+   SerialTransport Transport;
+   Options Opts;
+   StatusHandler OnStatus;
+   EventHandler OnEvent;
+   ConsoleHandler OnConsole;
+
+   mutable std::mutex Lock;
+   std::condition_variable SessionStarted;
+   bool Session = false;
+   int Window = 0;                     ///< credits of the host
+   uint8_t TxSeq = 0;
+   Clock::time_point LastCredit;
+   std::deque<Frame> Queued;           ///< waiting for a credit, the last one takes more commands
+   std::deque<Frame> InFlight;         ///< sent, waiting for the ack
+   std::deque<Command> Waiting;        ///< accepted gets and scene recalls waiting for their answer
+   std::vector<std::function<void()>> Ready;   ///< completions to run without the lock
+   Stats Counters;
+};
+
+}  // namespace darwin
+
+#endif   // _HOST_CLIENT_H_
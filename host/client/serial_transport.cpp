@@ -0,0 +1,223 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <unistd.h>
+#include "serial_transport.h"
+
+namespace darwin {
+
+static speed_t Speed(uint32_t Baudrate)
+{
+   switch(Baudrate) {
+      case 9600:     return B9600;
+      case 19200:    return B19200;
+      case 38400:    return B38400;
+      case 57600:    return B57600;
+      case 115200:   return B115200;
+      case 230400:   return B230400;
+      case 460800:   return B460800;
+      case 921600:   return B921600;
+      case 1000000:  return B1000000;
+      default:       return B0;
+   }
+}
+
+SerialTransport::SerialTransport(Listener &Owner) : Owner(Owner)
+{
+}
+
+SerialTransport::~SerialTransport()
+{
+   Close();
+}
+
+bool SerialTransport::Open(const std::string &Path,uint32_t Baudrate)
+{
+   struct termios Tio;
+   struct epoll_event Event = {};
+   struct itimerspec Tick = {{0,TickMs * 1000000},{0,TickMs * 1000000}};
+
+   if(Fd >= 0) {
+      errno = EBUSY;
+      return false;
+   }
+   if((Fd = open(Path.c_str(),O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)) < 0) {
+      return false;
+   }
+   if(tcgetattr(Fd,&Tio) == 0) {
+      cfmakeraw(&Tio);
+      if(Baudrate != 0) {
+         if(Speed(Baudrate) == B0) {
+            Close();
+            errno = EINVAL;
+            return false;
+         }
+         cfsetispeed(&Tio,Speed(Baudrate));
+         cfsetospeed(&Tio,Speed(Baudrate));
+      }
+      Tio.c_cflag |= CLOCAL | CREAD;
+      tcsetattr(Fd,TCSANOW,&Tio);
+      tcflush(Fd,TCIOFLUSH);
+   }
+
+   EpollFd = epoll_create1(EPOLL_CLOEXEC);
+   WakeFd = eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+   TimerFd = timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK | TFD_CLOEXEC);
+   if(EpollFd < 0 || WakeFd < 0 || TimerFd < 0 || timerfd_settime(TimerFd,0,&Tick,nullptr) != 0) {
+      int Error = errno;
+
+      Close();
+      errno = Error;
+      return false;
+   }
+   Event.events = EPOLLIN;
+   Event.data.fd = Fd;
+   epoll_ctl(EpollFd,EPOLL_CTL_ADD,Fd,&Event);
+   Event.data.fd = WakeFd;
+   epoll_ctl(EpollFd,EPOLL_CTL_ADD,WakeFd,&Event);
+   Event.data.fd = TimerFd;
+   epoll_ctl(EpollFd,EPOLL_CTL_ADD,TimerFd,&Event);
+
+   RxLen = 0;
+   Tx.clear();
+   WaitingOut = false;
+   TxTotal = 0;
+   RxTotal = 0;
+   Stopping = false;
+   Thread = std::thread(&SerialTransport::Run,this);
+   return true;
+}
+
+void SerialTransport::Close()
+{
+   if(Thread.joinable()) {
+      Stopping = true;
+      Wake();
+      Thread.join();
+   }
+   for(int *p : {&Fd,&EpollFd,&WakeFd,&TimerFd}) {
+      if(*p >= 0) {
+         close(*p);
+         *p = -1;
+      }
+   }
+}
+
+void SerialTransport::Send(const uint8_t *pData,size_t Len)
+{
+   {
+      std::lock_guard<std::mutex> Lock(TxLock);
+
+      Tx.insert(Tx.end(),pData,pData + Len);
+   }
+   Wake();
+}
+
+void SerialTransport::Wake()
+{
+   uint64_t One = 1;
+
+   if(write(WakeFd,&One,sizeof(One)) < 0) {
+      // the counter is already set, the loop wakes up anyway
+   }
+}
+
+/// Writes what the port takes, waits for EPOLLOUT if anything is left
+void SerialTransport::Flush()
+{
+   std::lock_guard<std::mutex> Lock(TxLock);
+   struct epoll_event Event = {};
+   ssize_t Len = 0;
+
+   if(!Tx.empty()) {
+      Len = write(Fd,Tx.data(),Tx.size());
+      if(Len > 0) {
+         Tx.erase(Tx.begin(),Tx.begin() + Len);
+         TxTotal += Len;
+      }
+      else if(Len < 0 && errno != EAGAIN && errno != EINTR) {
+         // the port is gone
+         Tx.clear();
+      }
+   }
+   if(Tx.empty() == !WaitingOut) {
+      return;
+   }
+   WaitingOut = !Tx.empty();
+   Event.events = EPOLLIN | (WaitingOut ? EPOLLOUT : 0);
+   Event.data.fd = Fd;
+   epoll_ctl(EpollFd,EPOLL_CTL_MOD,Fd,&Event);
+}
+
+/// Returns false once the port is gone
+bool SerialTransport::Read()
+{
+   ssize_t Len;
+
+   while((Len = read(Fd,&Rx[RxLen],sizeof(Rx) - RxLen)) > 0) {
+      size_t Used;
+
+      RxTotal += Len;
+      RxLen += Len;
+      // the listener parses in place, only the unused tail moves
+      Used = Owner.Received(Rx,RxLen);
+      if(Used == 0 && RxLen == sizeof(Rx)) {
+         // nothing the listener can use fills the buffer, drop it
+         Used = RxLen;
+      }
+      RxLen -= Used;
+      memmove(Rx,&Rx[Used],RxLen);
+   }
+   return Len < 0 && (errno == EAGAIN || errno == EINTR);
+}
+
+void SerialTransport::Run()
+{
+   struct epoll_event Events[4];
+
+   while(!Stopping) {
+      int Count = epoll_wait(EpollFd,Events,4,-1);
+      bool Woken = false;
+
+      for(int i = 0; i < Count; i++) {
+         uint64_t Value;
+
+         if(Events[i].data.fd == Fd) {
+            if((Events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !Read()) {
+               epoll_ctl(EpollFd,EPOLL_CTL_DEL,Fd,nullptr);
+               Owner.Disconnected();
+            }
+            Woken = true;
+         }
+         else if(Events[i].data.fd == WakeFd) {
+            if(read(WakeFd,&Value,sizeof(Value)) > 0) {
+               Woken = true;
+            }
+         }
+         else if(read(TimerFd,&Value,sizeof(Value)) > 0) {
+            Owner.Tick();
+         }
+      }
+      if(Woken && !Stopping) {
+         Owner.Woken();
+      }
+      Flush();
+   }
+}
+
+}  // namespace darwin
@@ -0,0 +1,104 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef _SERIAL_TRANSPORT_H_
+#define _SERIAL_TRANSPORT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace darwin {
+
+// Serial port in raw mode driven by an epoll loop on its own thread.
+//
+// Send() may be called from any thread, it only appends to the transmit
+// buffer and wakes the loop, which writes as much as the port takes and
+// waits for EPOLLOUT for the rest. Received bytes are collected in a buffer
+// owned by the loop and handed to the listener in place, the listener
+// returns how many of them it used and the rest is kept for the next call.
+// All listener calls are made from the loop thread.
+class SerialTransport {
+public:
+   class Listener {
+   public:
+      virtual ~Listener() = default;
+
+      // Received data, returns the number of bytes consumed
+      virtual size_t Received(const uint8_t *pData,size_t Len) = 0;
+
+      // Called after Wake() and after received data was handled
+      virtual void Woken() = 0;
+
+      // Called every TickMs while the port is open
+      virtual void Tick() = 0;
+
+      // The port hung up or failed, nothing is read or written any more
+      virtual void Disconnected() = 0;
+   };
+
+   static constexpr int TickMs = 10;
+   static constexpr size_t RxBufferSize = 4096;
+
+   explicit SerialTransport(Listener &Owner);
+   ~SerialTransport();
+
+   SerialTransport(const SerialTransport &) = delete;
+   SerialTransport &operator=(const SerialTransport &) = delete;
+
+   // Opens the port and starts the loop, Baudrate 0 leaves the rate alone
+   // as for a pseudo terminal. Returns false and sets errno on failure.
+   bool Open(const std::string &Path,uint32_t Baudrate);
+
+   // Stops the loop and closes the port, not from the loop thread
+   void Close();
+
+   bool IsOpen() const { return Fd >= 0; }
+
+   void Send(const uint8_t *pData,size_t Len);
+
+   // Makes the loop call Listener::Woken()
+   void Wake();
+
+   // Bytes written and read since the port was opened
+   uint64_t TxBytes() const { return TxTotal; }
+   uint64_t RxBytes() const { return RxTotal; }
+
+private:
+   void Run();
+   void Flush();
+   bool Read();
+
+   Listener &Owner;
+   int Fd = -1;
+   int EpollFd = -1;
+   int WakeFd = -1;
+   int TimerFd = -1;
+   std::thread Thread;
+   std::atomic<bool> Stopping{false};
+
+   std::mutex TxLock;
+   std::vector<uint8_t> Tx;
+   bool WaitingOut = false;
+
+   uint8_t Rx[RxBufferSize];
+   size_t RxLen = 0;
+   std::atomic<uint64_t> TxTotal{0};
+   std::atomic<uint64_t> RxTotal{0};
+};
+
+}  // namespace darwin
+
+#endif   // _SERIAL_TRANSPORT_H_
@@ -0,0 +1,205 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Checks that the cost of EventDispatch() does not depend on the number of
+// registered handlers (make dispatch-bench).
+//
+// usage: dispatch_bench [-p percent] [-r repeats]
+//
+// Built with DISPATCH_MAX_CLASSES 8 and DISPATCH_MAX_HANDLERS 255, so all
+// but one of the 8 * DISPATCH_METHODS_PER_CLASS method slots can be filled.
+// The same events of DISPATCH_BENCH_HANDLERS handlers are timed twice:
+//  - few:  only those handlers are registered
+//  - full: every class page and method slot the tables take has a handler
+// A third run, spread, dispatches events of all the handlers of the full
+// tables, which touches every page. The handlers only count their calls.
+// On the host CYCLE_COUNT() reads the clock, which is most of the cost of a
+// dispatch, but the same in every run.
+//
+// Each run is a batch of DISPATCH_BENCH_OPS dispatches. -r rounds (15 by
+// default) time one batch of every run, the tables are registered again
+// before each batch. The fastest batch of a run counts. The results are
+// printed as CSV:
+//    run,handlers,ns_per_op
+// The bench exits with 1 if full or spread take more than -p percent
+// (25 by default) plus DISPATCH_BENCH_SLACK_NS longer than few.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "native_gecko.h"
+#include "event_dispatch.h"
+
+/// Handlers of the few run, in two classes
+#define DISPATCH_BENCH_HANDLERS  4
+/// Dispatches per batch
+#define DISPATCH_BENCH_OPS       (1U << 18)
+/// Added to the limit, the timer overhead of one dispatch varies by that much
+#define DISPATCH_BENCH_SLACK_NS  2.0
+/// Classes of the full tables, the first DISPATCH_MAX_CLASSES of them are used
+#define DISPATCH_BENCH_CLASS(i)  (0x10 + (i))
+
+#if DISPATCH_MAX_HANDLERS != 255 || DISPATCH_MAX_CLASSES != 8
+#error "dispatch_bench is built with DISPATCH_MAX_HANDLERS 255 and DISPATCH_MAX_CLASSES 8"
+#endif
+
+typedef enum {
+   RUN_FEW,
+   RUN_FULL,
+   RUN_SPREAD,
+   NUM_RUNS
+} Run_t;
+
+static const char *RunNames[NUM_RUNS] = {"few","full","spread"};
+
+/// Events of the few handlers
+static const uint32_t FewIDs[DISPATCH_BENCH_HANDLERS] = {
+   SIM_EVT_ID(DISPATCH_BENCH_CLASS(0),0x00),SIM_EVT_ID(DISPATCH_BENCH_CLASS(0),0x05),
+   SIM_EVT_ID(DISPATCH_BENCH_CLASS(3),0x02),SIM_EVT_ID(DISPATCH_BENCH_CLASS(3),0x1f)
+};
+
+static struct gecko_cmd_packet FewEvents[DISPATCH_BENCH_HANDLERS];
+static struct gecko_cmd_packet AllEvents[DISPATCH_MAX_HANDLERS];
+static int NumAll;
+static volatile uint32_t Calls;
+
+static int Repeats = 15;
+static int Percent = 25;
+
+static void Handler(struct gecko_cmd_packet *pEvt)
+{
+   Calls++;
+}
+
+/// Registers the few handlers, then fills the tables if Full is set
+static int Register(bool Full)
+{
+   int Count = 0;
+   int Class;
+   int Method;
+   int i;
+
+   EventDispatchInit();
+   for(i = 0; i < DISPATCH_BENCH_HANDLERS; i++) {
+      Count += EventDispatchRegister(FewIDs[i],Handler);
+   }
+   for(Class = 0; Full && Class < DISPATCH_MAX_CLASSES; Class++) {
+      for(Method = 0; Method < DISPATCH_METHODS_PER_CLASS && Count < DISPATCH_MAX_HANDLERS; Method++) {
+         uint32_t ID = SIM_EVT_ID(DISPATCH_BENCH_CLASS(Class),Method);
+         bool Few = false;
+
+         for(i = 0; i < DISPATCH_BENCH_HANDLERS; i++) {
+            Few |= ID == FewIDs[i];
+         }
+         if(!Few && !EventDispatchRegister(ID,Handler)) {
+            fprintf(stderr,"0x%08lx not registered\n",(unsigned long) ID);
+            exit(1);
+         }
+         Count += !Few;
+      }
+   }
+   return Count;
+}
+
+static double ElapsedNs(const struct timespec *pFrom)
+{
+   struct timespec Now;
+
+   clock_gettime(CLOCK_MONOTONIC,&Now);
+   return (Now.tv_sec - pFrom->tv_sec) * 1e9 + (Now.tv_nsec - pFrom->tv_nsec);
+}
+
+/// One batch of a run, returns its duration
+static double TimeBatch(Run_t Run,int *pHandlers)
+{
+   struct gecko_cmd_packet *pEvents = Run == RUN_SPREAD ? AllEvents : FewEvents;
+   int Count = Run == RUN_SPREAD ? NumAll : DISPATCH_BENCH_HANDLERS;
+   struct timespec Start;
+   uint32_t Before;
+   uint32_t i;
+
+   *pHandlers = Register(Run != RUN_FEW);
+   Before = Calls;
+   clock_gettime(CLOCK_MONOTONIC,&Start);
+   for(i = 0; i < DISPATCH_BENCH_OPS; i++) {
+      EventDispatch(&pEvents[i % Count],0);
+   }
+   if(Calls - Before != DISPATCH_BENCH_OPS) {
+      fprintf(stderr,"%s: %lu of %u events handled\n",RunNames[Run],(unsigned long) (Calls - Before),
+              DISPATCH_BENCH_OPS);
+      exit(1);
+   }
+   return ElapsedNs(&Start);
+}
+
+int main(int argc,char *argv[])
+{
+   double Best[NUM_RUNS];
+   int Handlers[NUM_RUNS];
+   double Limit;
+   bool Ok = true;
+   int Round;
+   int Opt;
+   int i;
+
+   while((Opt = getopt(argc,argv,"p:r:")) != -1) {
+      switch(Opt) {
+         case 'p':
+            Percent = strtol(optarg,NULL,0);
+            break;
+
+         case 'r':
+            Repeats = strtol(optarg,NULL,0);
+            if(Repeats < 1) {
+               Repeats = 1;
+            }
+            break;
+
+         default:
+            fprintf(stderr,"usage: %s [-p percent] [-r repeats]\n",argv[0]);
+            return 1;
+      }
+   }
+
+   for(i = 0; i < DISPATCH_BENCH_HANDLERS; i++) {
+      FewEvents[i].header = FewIDs[i];
+   }
+   for(i = 0; i < DISPATCH_MAX_CLASSES * DISPATCH_METHODS_PER_CLASS && NumAll < DISPATCH_MAX_HANDLERS; i++) {
+      AllEvents[NumAll++].header = SIM_EVT_ID(DISPATCH_BENCH_CLASS(i / DISPATCH_METHODS_PER_CLASS),
+                                              i % DISPATCH_METHODS_PER_CLASS);
+   }
+
+   for(Round = 0; Round < Repeats; Round++) {
+      for(i = 0; i < NUM_RUNS; i++) {
+         double Ns = TimeBatch(i,&Handlers[i]);
+
+         if(Round == 0 || Ns < Best[i]) {
+            Best[i] = Ns;
+         }
+      }
+   }
+
+   printf("run,handlers,ns_per_op\n");
+   for(i = 0; i < NUM_RUNS; i++) {
+      Best[i] /= DISPATCH_BENCH_OPS;
+      printf("%s,%d,%.1f\n",RunNames[i],Handlers[i],Best[i]);
+   }
+   Limit = Best[RUN_FEW] * (100 + Percent) / 100 + DISPATCH_BENCH_SLACK_NS;
+   for(i = RUN_FULL; i < NUM_RUNS; i++) {
+      if(Best[i] > Limit) {
+         printf("%s is slower than few, limit %.1f ns\n",RunNames[i],Limit);
+         Ok = false;
+      }
+   }
+   return Ok ? 0 : 1;
+}
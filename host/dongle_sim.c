@@ -0,0 +1,300 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated gateway dongle on a pseudo terminal. Runs appMain(), built with
+// DARWIN_HOST_PROTOCOL and DARWIN_CONSOLE, against the simulated stack with
+// USART0 on the master side of a pseudo terminal. A host talks to the slave
+// side as it would to the serial port of the real dongle, e.g. with the
+// client library in client/.
+//
+// usage: gateway_dongle [-l link] [-b baud] [-d min ms] [-D max ms] [-t seconds] [-s seed]
+//
+// The path of the slave side is printed at the start, -l also makes a
+// symbolic link to it. The UART runs at UART_DMA_BAUDRATE unless -b gives
+// another rate, -b 0 runs it as fast as the pseudo terminal goes. Time is
+// real, not virtual.
+//
+// The simulated mesh answers every acknowledged set, every get and every
+// scene recall with a status from the target after a random delay between
+// -d and -D ms. A node reports the state it was set to last, zero before.
+// Runs until interrupted or for -t seconds, then prints the link and queue
+// counters.
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "app.h"
+#include "connections.h"
+#include "timer_wheel.h"
+#include "client_queue.h"
+#include "request_tracker.h"
+#include "host_link.h"
+#include "mesh_generic_model_capi_types.h"
+
+/// Statuses on their way back and node states remembered
+#define DONGLE_REPLIES        128
+#define DONGLE_STATES         256
+#define DONGLE_MAX_PARAMS     6
+
+static gecko_configuration_t config = {
+   .max_connections = MAX_CONNECTIONS,
+   .max_timers = 16,
+};
+
+static uint32_t Seed = 1;
+static uint32_t MinMs = 20;
+static uint32_t MaxMs = 80;
+static uint32_t Seconds;
+static const char *Link;
+static volatile sig_atomic_t Stop;
+static uint32_t Answered;
+static uint32_t Busy;
+
+static struct {
+   uint16_t Address;
+   uint8_t Type;              ///< state type
+   uint8_t Len;
+   uint8_t Params[DONGLE_MAX_PARAMS];
+} States[DONGLE_STATES];
+static int NumStates;
+
+static struct {
+   Timer_t Timer;
+   uint16_t Address;
+   uint16_t ModelID;          ///< 0 for a scene status
+   uint8_t Type;
+   uint16_t Scene;
+} Replies[DONGLE_REPLIES];
+
+static uint32_t Random(void)
+{
+   Seed = Seed * 1103515245 + 12345;
+   return Seed >> 16;
+}
+
+/// State type reported for a set request type and the length of its parameters
+static uint8_t StateType(uint8_t Request,uint8_t *pLen)
+{
+   switch(Request) {
+      case mesh_generic_request_on_off:
+         *pLen = 1;
+         return mesh_generic_state_on_off;
+      case mesh_lighting_request_lightness_actual:
+         *pLen = 2;
+         return mesh_lighting_state_lightness_actual;
+      case mesh_lighting_request_ctl:
+         // lightness and temperature, no delta UV
+         *pLen = 4;
+         return mesh_lighting_state_ctl;
+      default:
+         *pLen = 0;
+         return Request;
+   }
+}
+
+static int FindState(uint16_t Address,uint8_t Type,bool Add)
+{
+   int i;
+
+   for(i = 0; i < NumStates; i++) {
+      if(States[i].Address == Address && States[i].Type == Type) {
+         return i;
+      }
+   }
+   if(!Add || NumStates == DONGLE_STATES) {
+      return -1;
+   }
+   States[NumStates].Address = Address;
+   States[NumStates].Type = Type;
+   States[NumStates].Len = 0;
+   return NumStates++;
+}
+
+static void Reply(Timer_t *pTimer)
+{
+   uint8_t Buf[sizeof(struct gecko_msg_mesh_generic_client_server_status_evt_t) + DONGLE_MAX_PARAMS] = {0};
+   struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus = (void *) Buf;
+   int i = (int) (intptr_t) pTimer->pArg;
+   int State;
+
+   Answered++;
+   if(Replies[i].ModelID == 0) {
+      struct gecko_msg_mesh_scene_client_status_evt_t Scene = {0};
+
+      Scene.server_address = Replies[i].Address;
+      Scene.current_scene = Replies[i].Scene;
+      SimPushEvent(gecko_evt_mesh_scene_client_status_id,&Scene,sizeof(Scene));
+      return;
+   }
+
+   pStatus->model_id = Replies[i].ModelID;
+   pStatus->server_address = Replies[i].Address;
+   pStatus->type = Replies[i].Type;
+   State = FindState(Replies[i].Address,Replies[i].Type,false);
+   if(State >= 0) {
+      pStatus->parameters.len = States[State].Len;
+      memcpy(pStatus->parameters.data,States[State].Params,States[State].Len);
+   }
+   SimPushEvent(gecko_evt_mesh_generic_client_server_status_id,Buf,sizeof(*pStatus) + pStatus->parameters.len);
+}
+
+/// The simulated nodes
+static uint16_t Mesh(const SimMeshRequest_t *pRequest)
+{
+   uint8_t Type = pRequest->Type;
+   int i;
+
+   if(pRequest->ModelID != 0 && !pRequest->Get) {
+      uint8_t Len;
+      int State;
+
+      Type = StateType(pRequest->Type,&Len);
+      if(Len > pRequest->Len) {
+         Len = pRequest->Len;
+      }
+      if((State = FindState(pRequest->Address,Type,true)) >= 0) {
+         States[State].Len = Len;
+         memcpy(States[State].Params,pRequest->pParams,Len);
+      }
+      if(!(pRequest->Flags & 1)) {
+         return bg_err_success;
+      }
+   }
+
+   for(i = 0; i < DONGLE_REPLIES && TimerIsArmed(&Replies[i].Timer); i++);
+   if(i == DONGLE_REPLIES) {
+      Busy++;
+      return bg_err_out_of_memory;
+   }
+   Replies[i].Address = pRequest->Address;
+   Replies[i].ModelID = pRequest->ModelID;
+   Replies[i].Type = Type;
+   Replies[i].Scene = pRequest->Scene;
+   TimerStart(&Replies[i].Timer,MinMs + (MaxMs > MinMs ? Random() % (MaxMs - MinMs) : 0),0,Reply,
+              (void *) (intptr_t) i);
+   return bg_err_success;
+}
+
+static void Interrupted(int Signal)
+{
+   Stop = 1;
+}
+
+static void Report(void)
+{
+   const HostLinkStats_t *pLink = HostLinkGetStats();
+   const ClientQueueStats_t *pQueue = ClientQueueGetStats();
+   const ReqStats_t *pReq = ReqGetStats();
+
+   printf("link: %lu frames in, %lu frames out, %lu crc errors, %lu bytes skipped, %lu frames not sent\n",
+          (unsigned long) pLink->RxFrames,(unsigned long) pLink->TxFrames,(unsigned long) pLink->CrcErrors,
+          (unsigned long) pLink->Skipped,(unsigned long) pLink->TxDropped);
+   printf("client queue: %lu submitted, %lu coalesced, %lu sent, %lu dropped, %u most pending\n",
+          (unsigned long) pQueue->Submitted,(unsigned long) pQueue->Coalesced,(unsigned long) pQueue->Sent,
+          (unsigned long) pQueue->Dropped,pQueue->MaxPending);
+   printf("mesh: %lu requests, %lu acked, %lu timed out, %lu statuses, %lu refused\n",(unsigned long) pReq->Sent,
+          (unsigned long) pReq->Acked,(unsigned long) pReq->TimedOut,(unsigned long) Answered,
+          (unsigned long) Busy);
+   if(Link != NULL) {
+      unlink(Link);
+   }
+}
+
+static void Idle(void)
+{
+   if(Stop) {
+      Report();
+      exit(0);
+   }
+}
+
+static void Done(int ResetType)
+{
+   printf("device reset (%d) requested\n",ResetType);
+   Report();
+}
+
+int main(int argc,char **argv)
+{
+   struct termios Raw;
+   const char *Slave;
+   int Master;
+   int c;
+
+   while((c = getopt(argc,argv,"l:b:d:D:t:s:")) != -1) {
+      switch(c) {
+         case 'l':
+            Link = optarg;
+            break;
+         case 'b':
+            SimUartSetBaudrate(strtoul(optarg,NULL,0));
+            break;
+         case 'd':
+            MinMs = strtoul(optarg,NULL,0);
+            break;
+         case 'D':
+            MaxMs = strtoul(optarg,NULL,0);
+            break;
+         case 't':
+            Seconds = strtoul(optarg,NULL,0);
+            break;
+         case 's':
+            Seed = strtoul(optarg,NULL,0);
+            break;
+         default:
+            fprintf(stderr,"usage: %s [-l link] [-b baud] [-d min ms] [-D max ms] [-t seconds] [-s seed]\n",argv[0]);
+            return 1;
+      }
+   }
+
+   Master = posix_openpt(O_RDWR | O_NOCTTY);
+   if(Master < 0 || grantpt(Master) != 0 || unlockpt(Master) != 0 || (Slave = ptsname(Master)) == NULL) {
+      perror("pseudo terminal");
+      return 1;
+   }
+   // keep the slave open so the master does not hang up between clients
+   c = open(Slave,O_RDWR | O_NOCTTY);
+   if(c < 0 || tcgetattr(c,&Raw) != 0) {
+      perror(Slave);
+      return 1;
+   }
+   cfmakeraw(&Raw);
+   tcsetattr(c,TCSANOW,&Raw);
+   fcntl(Master,F_SETFL,fcntl(Master,F_GETFL) | O_NONBLOCK);
+
+   if(Link != NULL) {
+      unlink(Link);
+      if(symlink(Slave,Link) != 0) {
+         perror(Link);
+         return 1;
+      }
+   }
+   printf("dongle on %s\n",Slave);
+   fflush(stdout);
+
+   signal(SIGINT,Interrupted);
+   signal(SIGTERM,Interrupted);
+   signal(SIGALRM,Interrupted);
+   alarm(Seconds);
+   SimUartAttach(Master);
+   SimSetMeshHook(Mesh);
+   SimSetIdleHook(Idle);
+   SimSetDoneHook(Done);
+   appMain(&config);
+   return 0;
+}
@@ -0,0 +1,213 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Compares GeckoEventName() with the linear EventLookup[] scan that
+// LogGeckoEvent() used before it (make event-name-bench).
+//
+// usage: event_name_bench [-r repeats]
+//
+// Both lookups are timed for three sets of IDs:
+//  - first:   the first entry of the old table, its best case
+//  - last:    the last entry of the old table
+//  - mesh:    mesh events, which the old table did not have, so the scan
+//             ran through all of it before logging them as unknown
+// Each set is a batch of NAME_BENCH_OPS lookups, -r rounds (15 by default)
+// time one batch of every set and lookup and the fastest batch counts. The
+// results are printed as CSV:
+//    ids,linear_ns,indexed_ns
+// The bench checks that the new table names every event of the old one the
+// same way and exits with 1 if it does not or if the indexed lookup is
+// slower than the scan for last or mesh.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "native_gecko.h"
+#include "gecko_event_names.h"
+
+/// Lookups per batch
+#define NAME_BENCH_OPS  (1U << 20)
+
+/// The table of LogGeckoEvent() before GeckoEventName()
+static const struct {
+   uint32 ID;
+   const char *Desc;
+} EventLookup[] = {
+   {gecko_evt_system_boot_id,"system_boot"},
+   {gecko_evt_system_external_signal_id,"system_external_signal"},
+   {gecko_evt_system_awake_id,"system_awake"},
+   {gecko_evt_system_hardware_error_id,"system_hardware_error"},
+   {gecko_evt_le_gap_scan_response_id,"le_gap_scan_response"},
+   {gecko_evt_le_gap_adv_timeout_id,"le_gap_adv_timeout"},
+   {gecko_evt_le_gap_scan_request_id,"le_gap_scan_request"},
+   {gecko_evt_le_connection_opened_id,"le_connection_opened"},
+   {gecko_evt_le_connection_closed_id,"le_connection_closed"},
+   {gecko_evt_le_connection_parameters_id,"le_connection_parameters"},
+   {gecko_evt_le_connection_rssi_id,"le_connection_rssi"},
+   {gecko_evt_le_connection_phy_status_id,"le_connection_phy_status"},
+   {gecko_evt_gatt_mtu_exchanged_id,"gatt_mtu_exchanged"},
+   {gecko_evt_gatt_service_id,"gatt_service"},
+   {gecko_evt_gatt_characteristic_id,"gatt_characteristic"},
+   {gecko_evt_gatt_descriptor_id,"gatt_descriptor"},
+   {gecko_evt_gatt_characteristic_value_id,"gatt_characteristic_value"},
+   {gecko_evt_gatt_descriptor_value_id,"gatt_descriptor_value"},
+   {gecko_evt_gatt_procedure_completed_id,"gatt_procedure_completed"},
+   {gecko_evt_gatt_server_attribute_value_id,"gatt_server_attribute_value"},
+   {gecko_evt_gatt_server_user_read_request_id,"gatt_server_user_read_request"},
+   {gecko_evt_gatt_server_user_write_request_id,"gatt_server_user_write_request"},
+   {gecko_evt_gatt_server_characteristic_status_id,"gatt_server_characteristic_status"},
+   {gecko_evt_gatt_server_execute_write_completed_id,"gatt_server_execute_write_completed"},
+   {gecko_evt_hardware_soft_timer_id,"hardware_soft_timer"},
+   {gecko_evt_test_dtm_completed_id,"test_dtm_completed"},
+   {gecko_evt_sm_passkey_display_id,"sm_passkey_display"},
+   {gecko_evt_sm_passkey_request_id,"sm_passkey_request"},
+   {gecko_evt_sm_confirm_passkey_id,"sm_confirm_passkey"},
+   {gecko_evt_sm_bonded_id,"sm_bonded"},
+   {gecko_evt_sm_bonding_failed_id,"sm_bonding_failed"},
+   {gecko_evt_sm_list_bonding_entry_id,"sm_list_bonding_entry"},
+   {gecko_evt_sm_list_all_bondings_complete_id,"sm_list_all_bondings_complete"},
+   {gecko_evt_sm_confirm_bonding_id,"sm_confirm_bonding"},
+   {gecko_evt_user_message_to_host_id,"user_message_to_host"},
+   {0}
+};
+
+#define NUM_OLD_EVENTS  (sizeof(EventLookup) / sizeof(EventLookup[0]) - 1)
+
+static const uint32_t FirstIDs[] = {gecko_evt_system_boot_id};
+static const uint32_t LastIDs[] = {gecko_evt_user_message_to_host_id};
+static const uint32_t MeshIDs[] = {
+   gecko_evt_mesh_generic_client_server_status_id,gecko_evt_mesh_node_initialized_id,
+   gecko_evt_mesh_node_provisioned_id,gecko_evt_mesh_proxy_connected_id
+};
+
+static const struct {
+   const char *Name;
+   const uint32_t *pIDs;
+   int Count;
+} Sets[] = {
+   {"first",FirstIDs,sizeof(FirstIDs) / sizeof(FirstIDs[0])},
+   {"last",LastIDs,sizeof(LastIDs) / sizeof(LastIDs[0])},
+   {"mesh",MeshIDs,sizeof(MeshIDs) / sizeof(MeshIDs[0])},
+};
+
+#define NUM_SETS  (sizeof(Sets) / sizeof(Sets[0]))
+
+static int Repeats = 15;
+static volatile uintptr_t Sink;
+
+/// The loop of the old LogGeckoEvent()
+static const char *LinearName(uint32_t ID)
+{
+   int i;
+
+   for(i = 0; EventLookup[i].ID != 0; i++) {
+      if(ID == EventLookup[i].ID) {
+         return EventLookup[i].Desc;
+      }
+   }
+   return NULL;
+}
+
+static double ElapsedNs(const struct timespec *pFrom)
+{
+   struct timespec Now;
+
+   clock_gettime(CLOCK_MONOTONIC,&Now);
+   return (Now.tv_sec - pFrom->tv_sec) * 1e9 + (Now.tv_nsec - pFrom->tv_nsec);
+}
+
+/// One batch of lookups of a set, returns its duration
+static double TimeBatch(const char *(*Lookup)(uint32_t),int Set)
+{
+   const uint32_t *pIDs = Sets[Set].pIDs;
+   int Count = Sets[Set].Count;
+   struct timespec Start;
+   uint32_t i;
+
+   clock_gettime(CLOCK_MONOTONIC,&Start);
+   for(i = 0; i < NAME_BENCH_OPS; i++) {
+      Sink += (uintptr_t) Lookup(pIDs[i % Count]);
+   }
+   return ElapsedNs(&Start);
+}
+
+/// The new table names the events of the old one the same way
+static bool SameNames(void)
+{
+   bool Ok = true;
+   unsigned i;
+
+   for(i = 0; i < NUM_OLD_EVENTS; i++) {
+      const char *Name = GeckoEventName(EventLookup[i].ID);
+
+      if(Name == NULL || strcmp(Name,EventLookup[i].Desc) != 0) {
+         printf("0x%08lx: %s, was %s\n",(unsigned long) EventLookup[i].ID,Name != NULL ? Name : "unknown",
+                EventLookup[i].Desc);
+         Ok = false;
+      }
+   }
+   return Ok;
+}
+
+int main(int argc,char *argv[])
+{
+   double Linear[NUM_SETS];
+   double Indexed[NUM_SETS];
+   bool Ok;
+   int Round;
+   int Opt;
+   unsigned i;
+
+   while((Opt = getopt(argc,argv,"r:")) != -1) {
+      switch(Opt) {
+         case 'r':
+            Repeats = strtol(optarg,NULL,0);
+            if(Repeats < 1) {
+               Repeats = 1;
+            }
+            break;
+
+         default:
+            fprintf(stderr,"usage: %s [-r repeats]\n",argv[0]);
+            return 1;
+      }
+   }
+
+   Ok = SameNames();
+   for(Round = 0; Round < Repeats; Round++) {
+      for(i = 0; i < NUM_SETS; i++) {
+         double Ns = TimeBatch(LinearName,i);
+
+         if(Round == 0 || Ns < Linear[i]) {
+            Linear[i] = Ns;
+         }
+         Ns = TimeBatch(GeckoEventName,i);
+         if(Round == 0 || Ns < Indexed[i]) {
+            Indexed[i] = Ns;
+         }
+      }
+   }
+
+   printf("ids,linear_ns,indexed_ns\n");
+   for(i = 0; i < NUM_SETS; i++) {
+      Linear[i] /= NAME_BENCH_OPS;
+      Indexed[i] /= NAME_BENCH_OPS;
+      printf("%s,%.2f,%.2f\n",Sets[i].Name,Linear[i],Indexed[i]);
+      // first is where the scan stops at once
+      if(i != 0 && Indexed[i] > Linear[i]) {
+         printf("%s: the indexed lookup is slower than the scan\n",Sets[i].Name);
+         Ok = false;
+      }
+   }
+   return Ok ? 0 : 1;
+}
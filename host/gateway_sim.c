@@ -0,0 +1,199 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Linux host build of the gateway. Runs appMain() against the simulated
+// stack and pushes a deterministic synthetic event mix or one of the
+// scenarios in scenarios/ through the event loop, then reports the
+// throughput, the per handler statistics and the results of the scenario.
+//
+// usage: gateway_sim -r trace.bin [-x speed]
+//        gateway_sim -c rounds [-s seed]
+//        gateway_sim -b jobs [-B slice us]
+//        gateway_sim -o bytes [-e 1|2] [-s seed]
+//        gateway_sim -g bytes [-G] [-R rssi]
+//        gateway_sim -f targets [-s seed]
+//        gateway_sim -a requests [-w window] [-l loss %] [-s seed]
+//        gateway_sim -p saves [-s seed]
+//        gateway_sim -t timers [-s seed]
+//        gateway_sim [-n events] [-s seed]
+//
+// Each scenario is described in its source file. The first option of a
+// scenario selects it, -s seeds the random numbers all of them share.
+// A scenario that fails its checks makes the program exit with 1.
+//
+// Built with DEFINES=-DDARWIN_CMD_PROF the commands are profiled as the
+// command handler delegate does it on the target and reported at the end.
+// The times are those of the simulated commands on the host, they only show
+// how often each command is called.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "native_gecko.h"
+#include "em_device.h"
+#include "sim_gecko.h"
+#include "app.h"
+#include "connections.h"
+#include "state_cache.h"
+#include "event_dispatch.h"
+#include "gecko_event_names.h"
+#include "darwin_cmd_prof.h"
+#include "gateway_sim.h"
+
+/// In the order they are given the idle hook, the synthetic mix runs if no
+/// other one was selected
+static const Scenario_t *const Scenarios[] = {
+#ifdef DARWIN_TRACE
+   &TraceScenario,
+#endif
+   &ReplayScenario,&ChurnScenario,&SchedScenario,&OtaScenario,&GattScenario,&SceneScenario,&ReqScenario,
+   &PsScenario,&TimerScenario,&SyntheticScenario
+};
+
+#define NUM_SCENARIOS   (sizeof(Scenarios) / sizeof(Scenarios[0]))
+
+gecko_configuration_t ScenarioConfig = {
+   .max_connections = MAX_CONNECTIONS,
+   .max_timers = 16,
+};
+
+uint64_t ScenarioPushed;
+
+static uint32_t Seed = 1;
+static struct timespec Start;
+static bool Started;
+
+uint32_t ScenarioRandom(void)
+{
+   // deterministic LCG so every run sees the same event sequence
+   Seed = Seed * 1103515245 + 12345;
+   return Seed >> 16;
+}
+
+static void Idle(void)
+{
+   unsigned i;
+
+   if(!Started) {
+      // boot and node initialization are done, start measuring
+      Started = true;
+      clock_gettime(CLOCK_MONOTONIC,&Start);
+   }
+
+   for(i = 0; i < NUM_SCENARIOS && !Scenarios[i]->Idle(); i++);
+}
+
+static void Done(int ResetType)
+{
+   struct timespec End;
+   double Seconds;
+   const EventHandlerStats_t *pStats;
+   const EventHandlerStats_t *pUnhandled = EventDispatchGetUnhandled();
+   bool Ok = true;
+   int Count;
+   int i;
+
+   clock_gettime(CLOCK_MONOTONIC,&End);
+   Seconds = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+
+   if(ResetType >= 0) {
+      printf("device reset (%d) requested\n",ResetType);
+   }
+   printf("events %llu, %.3f s, %.0f events/s\n",(unsigned long long) ScenarioPushed,Seconds,
+          Seconds > 0 ? ScenarioPushed / Seconds : 0);
+
+   pStats = EventDispatchGetStats(&Count);
+   printf("%-34s %10s %10s %10s %10s\n","event","count","avg ns","max ns","p99 lat ns");
+   for(i = 0; i < Count; i++) {
+      const char *Name = GeckoEventName(pStats[i].ID);
+      double Avg = pStats[i].Count ? (double) pStats[i].TotalCycles / pStats[i].Count : 0;
+
+      printf("%-34s %10lu %10.0f %10.0f %10.0f\n",Name != NULL ? Name : "?",(unsigned long) pStats[i].Count,
+             Avg * 1e9 / SIM_CORE_CLOCK,pStats[i].MaxCycles * 1e9 / SIM_CORE_CLOCK,
+             EventDispatchP99(&pStats[i]) * 1e9 / SIM_CORE_CLOCK);
+   }
+   printf("%-34s %10lu\n","(unhandled)",(unsigned long) pUnhandled->Count);
+
+#ifdef DARWIN_CMD_PROF
+   {
+      const CmdProfStats_t *Commands[64];
+
+      Count = CmdProfGet(Commands,64);
+      printf("%-34s %10s %10s %10s %10s\n","command","count","min ns","avg ns","max ns");
+      for(i = 0; i < Count; i++) {
+         const CmdProfStats_t *p = Commands[i];
+
+         printf("%-34s %10lu %10.0f %10.0f %10.0f\n",CmdProfName(p),(unsigned long) p->Count,
+                p->MinCycles * 1e9 / SIM_CORE_CLOCK,(double) p->TotalCycles / p->Count * 1e9 / SIM_CORE_CLOCK,
+                p->MaxCycles * 1e9 / SIM_CORE_CLOCK);
+      }
+   }
+#endif
+   if(StateCacheGetStats()->Updates != 0) {
+      const StateCacheStats_t *pCache = StateCacheGetStats();
+
+      printf("state cache: %lu updates, %u entries, %lu evictions, longest probe %u\n",
+             (unsigned long) pCache->Updates,pCache->Entries,(unsigned long) pCache->Evictions,pCache->MaxProbe);
+   }
+   for(i = 0; i < NUM_SCENARIOS; i++) {
+      if(Scenarios[i]->Report != NULL && !Scenarios[i]->Report()) {
+         Ok = false;
+      }
+   }
+   if(!Ok) {
+      exit(1);
+   }
+}
+
+static void Usage(const char *Name)
+{
+   unsigned i;
+
+   for(i = 0; i < NUM_SCENARIOS; i++) {
+      fprintf(stderr,"%s %s %s\n",i == 0 ? "usage:" : "      ",Name,Scenarios[i]->Usage);
+   }
+}
+
+int main(int argc,char **argv)
+{
+   char Options[64] = "s:";
+   unsigned i;
+   int c;
+
+   for(i = 0; i < NUM_SCENARIOS; i++) {
+      strcat(Options,Scenarios[i]->Options);
+   }
+
+   while((c = getopt(argc,argv,Options)) != -1) {
+      if(c == 's') {
+         Seed = strtoul(optarg,NULL,0);
+         continue;
+      }
+      for(i = 0; i < NUM_SCENARIOS && (c == '?' || strchr(Scenarios[i]->Options,c) == NULL); i++);
+      if(i == NUM_SCENARIOS) {
+         Usage(argv[0]);
+         return 1;
+      }
+      if(!Scenarios[i]->Option(c,optarg)) {
+         return 1;
+      }
+   }
+
+   SimSetIdleHook(Idle);
+   SimSetDoneHook(Done);
+#ifdef DARWIN_CMD_PROF
+   SimSetCommandProfileHook(CmdProfRecord);
+#endif
+   appMain(&ScenarioConfig);
+   return 0;
+}
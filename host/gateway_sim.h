@@ -0,0 +1,66 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Harness of the gateway_sim scenarios in scenarios/. gateway_sim.c runs
+// appMain() against the simulated stack and gives the idle hook to the first
+// scenario that was selected on the command line, the synthetic event mix if
+// none was. When nothing is left to do every scenario reports its results.
+
+#ifndef _GATEWAY_SIM_H_
+#define _GATEWAY_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "native_gecko.h"
+
+typedef struct {
+   /// getopt() letters of its options, the first one selects it
+   const char *Options;
+   /// Options as printed in the usage
+   const char *Usage;
+   /// Takes one of its options, returns false if the argument is not valid
+   bool (*Option)(int Opt,const char *Arg);
+   /// Called from the idle hook, returns false if it was not selected
+   bool (*Idle)(void);
+   /// Prints the results if it ran, returns false if they are wrong, may be NULL
+   bool (*Report)(void);
+} Scenario_t;
+
+extern const Scenario_t TraceScenario;
+extern const Scenario_t ReplayScenario;
+extern const Scenario_t ChurnScenario;
+extern const Scenario_t SchedScenario;
+extern const Scenario_t OtaScenario;
+extern const Scenario_t GattScenario;
+extern const Scenario_t SceneScenario;
+extern const Scenario_t ReqScenario;
+extern const Scenario_t PsScenario;
+extern const Scenario_t TimerScenario;
+extern const Scenario_t SyntheticScenario;
+
+/// Configuration given to appMain()
+extern gecko_configuration_t ScenarioConfig;
+
+/// Events pushed by the scenario, reported with the time of the run
+extern uint64_t ScenarioPushed;
+
+/// Deterministic LCG, every run with the same -s seed sees the same sequence
+uint32_t ScenarioRandom(void);
+
+/// Simulated mesh nodes of the request tracker and scene scenarios, a status
+/// comes back after a random delay unless the request or status is lost
+void MeshNodesStart(void);
+/// Chance in % that a request or its status is lost
+void MeshNodesSetLoss(uint32_t Percent);
+/// Requests and statuses lost so far
+uint32_t MeshNodesLost(void);
+
+#endif /* _GATEWAY_SIM_H_ */
@@ -0,0 +1,469 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Micro benchmarks of the hot paths of the gateway, checked against a
+// stored baseline (make bench).
+//
+// usage: hot_bench [-c baseline] [-w baseline] [-r repeats]
+//
+// Boots appMain() against the simulated stack and, once the node is
+// initialized, times each path from the idle hook:
+//  - event_dispatch:   EventDispatch() of a mix of handled and unhandled events
+//  - gecko_event_name: GeckoEventName() of known and unknown event IDs
+//  - log_gecko_event:  LogGeckoEvent(), formatting included
+//  - dump_hex:         DumpHex() of 64 bytes
+//  - set_device_name:  set_device_name() with the GATT write
+//  - timer_ms_2_tick:  TIMER_MS_2_TIMERTICK() of a varying value
+//  - proxy_connect:    connection opened, proxy connected, proxy disconnected
+//                      and connection closed through EventDispatch()
+//
+// Each path is run in batches that take at least BENCH_MIN_NS, the batch
+// size is doubled until they do. Then -r rounds run one batch of every
+// path, so a busy spell of the host slows a round rather than all batches
+// of one path. The fastest batch of a path counts, it is the least
+// disturbed by the rest of the host. Log output goes to
+// /dev/null through a fully buffered stdout so the formatting is timed,
+// not the terminal.
+//
+// The results are printed as CSV, one line per path:
+//    path,ops,ns_per_op,baseline_ns,limit_ns,result
+// -c reads a baseline (see hot_bench.baseline) and exits with 1 if a path
+// takes longer than its limit, the baseline plus the percentage given for
+// the path plus BENCH_SLACK_NS. -w writes the results as a new baseline,
+// keeping the percentages of -c if both are given. The times are those of
+// the host, a baseline only holds for the machine it was taken on.
+//
+// Built with -DDARWIN_LOG, so the log functions are there and the modules
+// log errors only, as a release build does.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "app.h"
+#include "app_timer.h"
+#include "connections.h"
+#include "darwin_cycles.h"
+#include "darwin_log.h"
+#include "event_dispatch.h"
+#include "gecko_event_names.h"
+#include "mesh_generic_model_capi_types.h"
+
+/// Shortest batch that is timed
+#define BENCH_MIN_NS          2000000
+/// Added to every limit, the timer and loop overhead of the fastest paths
+#define BENCH_SLACK_NS        1.0
+/// Regression allowed for paths new to the baseline when it is written
+#define BENCH_DEFAULT_PERCENT 30
+#define BENCH_MAX_PATHS       16
+/// Soft timer handle no handler knows
+#define BENCH_TIMER_HANDLE    0xee
+
+typedef struct {
+   const char *Name;
+   void (*Run)(uint32_t Ops);
+   bool Logs;                 ///< writes to stdout
+} Bench_t;
+
+typedef struct {
+   char Name[32];
+   double Ns;
+   int Percent;
+} Baseline_t;
+
+static gecko_configuration_t config = {
+   .max_connections = MAX_CONNECTIONS,
+   .max_timers = 16,
+};
+
+static const char *CheckPath;
+static const char *WritePath;
+static int Repeats = 15;
+static bool Ran;
+
+static Baseline_t Baseline[BENCH_MAX_PATHS];
+static int NumBaseline;
+
+/// Results by path, in the order of Benches
+static uint32_t ResultOps[BENCH_MAX_PATHS];
+static double ResultNs[BENCH_MAX_PATHS];
+
+/// Keeps the compiler from dropping the work
+static volatile uint32_t Sink;
+
+/// Events of the dispatch mix and of one proxy connection
+static struct gecko_cmd_packet Mix[6];
+static struct gecko_cmd_packet ProxyEvents[4];
+
+static void MakeEvent(struct gecko_cmd_packet *p,uint32_t ID,const void *Data,int Len)
+{
+   p->header = ID | ((Len & 0xff) << 8) | ((Len >> 8) & 0x7);
+   memcpy(p->data.payload,Data,Len);
+}
+
+static void MakeEvents(void)
+{
+   uint8_t Buf[sizeof(struct gecko_msg_mesh_generic_client_server_status_evt_t) + 2] = {0};
+   struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus = (void *) Buf;
+   struct gecko_msg_le_connection_parameters_evt_t Params = {0,24,0,100,1,27};
+   struct gecko_msg_hardware_soft_timer_evt_t Timer = {BENCH_TIMER_HANDLE};
+   struct gecko_msg_le_connection_opened_evt_t Opened = {{{0}},0,0,1,0,0};
+   struct gecko_msg_mesh_proxy_connected_evt_t Proxy = {1};
+   struct gecko_msg_mesh_proxy_disconnected_evt_t Disc = {1,0x13};
+   struct gecko_msg_le_connection_closed_evt_t Closed = {0x13,1};
+
+   // the synthetic mix of gateway_sim -n: statuses, advertising timeouts
+   // nobody handles, connection parameters, configuration and timers
+   pStatus->model_id = MESH_GENERIC_ON_OFF_CLIENT_MODEL_ID;
+   pStatus->server_address = 0x0010;
+   pStatus->type = mesh_generic_state_on_off;
+   pStatus->parameters.len = 1;
+   pStatus->parameters.data[0] = 1;
+   MakeEvent(&Mix[0],gecko_evt_mesh_generic_client_server_status_id,Buf,sizeof(Buf));
+   MakeEvent(&Mix[1],gecko_evt_le_gap_adv_timeout_id,NULL,0);
+   MakeEvent(&Mix[2],gecko_evt_mesh_generic_client_server_status_id,Buf,sizeof(Buf));
+   MakeEvent(&Mix[3],gecko_evt_le_connection_parameters_id,&Params,sizeof(Params));
+   MakeEvent(&Mix[4],gecko_evt_mesh_node_config_set_id,NULL,0);
+   MakeEvent(&Mix[5],gecko_evt_hardware_soft_timer_id,&Timer,sizeof(Timer));
+
+   MakeEvent(&ProxyEvents[0],gecko_evt_le_connection_opened_id,&Opened,sizeof(Opened));
+   MakeEvent(&ProxyEvents[1],gecko_evt_mesh_proxy_connected_id,&Proxy,sizeof(Proxy));
+   MakeEvent(&ProxyEvents[2],gecko_evt_mesh_proxy_disconnected_id,&Disc,sizeof(Disc));
+   MakeEvent(&ProxyEvents[3],gecko_evt_le_connection_closed_id,&Closed,sizeof(Closed));
+}
+
+static void RunDispatch(uint32_t Ops)
+{
+   uint32_t i;
+
+   for(i = 0; i < Ops; i++) {
+      EventDispatch(&Mix[i % 6],CYCLE_COUNT());
+   }
+}
+
+static void RunEventName(uint32_t Ops)
+{
+   // known events of several classes and one the tables do not have
+   static const uint32_t IDs[] = {
+      gecko_evt_mesh_generic_client_server_status_id,gecko_evt_le_connection_opened_id,
+      gecko_evt_hardware_soft_timer_id,gecko_evt_gatt_mtu_exchanged_id,SIM_EVT_ID(0x7f,0x1f)
+   };
+   uint32_t i;
+
+   for(i = 0; i < Ops; i++) {
+      Sink += GeckoEventName(IDs[i % 5]) != NULL;
+   }
+}
+
+static void RunLogEvent(uint32_t Ops)
+{
+   uint32_t i;
+
+   for(i = 0; i < Ops; i++) {
+      LogGeckoEvent(&Mix[i % 6],__FUNCTION__);
+   }
+}
+
+static void RunDumpHex(uint32_t Ops)
+{
+   static uint8_t Data[64];
+   uint32_t i;
+
+   for(i = 0; i < sizeof(Data); i++) {
+      Data[i] = i * 7;
+   }
+   for(i = 0; i < Ops; i++) {
+      // the function, the macro is compiled out at the error level
+      (DumpHex)(Data,sizeof(Data));
+   }
+}
+
+static void RunDeviceName(uint32_t Ops)
+{
+   bd_addr Addr = {{0x11,0x22,0x33,0x44,0x55,0x66}};
+   uint32_t i;
+
+   for(i = 0; i < Ops; i++) {
+      Addr.addr[0] = i;
+      Addr.addr[1] = i >> 8;
+      set_device_name(&Addr);
+   }
+}
+
+static void RunTimerTicks(uint32_t Ops)
+{
+   volatile uint32_t Ms = 0;
+   uint32_t i;
+
+   for(i = 0; i < Ops; i++) {
+      Ms = i & 0xffff;
+      Sink += TIMER_MS_2_TIMERTICK(Ms);
+   }
+}
+
+static void RunProxy(uint32_t Ops)
+{
+   uint32_t i;
+   int j;
+
+   for(i = 0; i < Ops; i++) {
+      for(j = 0; j < 4; j++) {
+         EventDispatch(&ProxyEvents[j],CYCLE_COUNT());
+      }
+   }
+}
+
+static const Bench_t Benches[] = {
+   {"event_dispatch",RunDispatch,false},
+   {"gecko_event_name",RunEventName,false},
+   {"log_gecko_event",RunLogEvent,true},
+   {"dump_hex",RunDumpHex,true},
+   {"set_device_name",RunDeviceName,false},
+   {"timer_ms_2_tick",RunTimerTicks,false},
+   {"proxy_connect",RunProxy,false},
+};
+
+#define NUM_BENCHES  ((int) (sizeof(Benches) / sizeof(Benches[0])))
+
+static double ElapsedNs(const struct timespec *pFrom)
+{
+   struct timespec Now;
+
+   clock_gettime(CLOCK_MONOTONIC,&Now);
+   return (Now.tv_sec - pFrom->tv_sec) * 1e9 + (Now.tv_nsec - pFrom->tv_nsec);
+}
+
+/// Drops the events the handlers generated, the idle hook is not called
+/// while some are queued
+static void DropEvents(void)
+{
+   while(SimQueued() > 0) {
+      gecko_peek_event();
+   }
+}
+
+/// One batch, returns its duration
+static double TimeBatch(const Bench_t *pBench,uint32_t Ops)
+{
+   struct timespec Start;
+   double Ns;
+
+   clock_gettime(CLOCK_MONOTONIC,&Start);
+   pBench->Run(Ops);
+   if(pBench->Logs) {
+      fflush(stdout);
+   }
+   Ns = ElapsedNs(&Start);
+   DropEvents();
+   return Ns;
+}
+
+/// Batch size of a path, doubled until a batch takes BENCH_MIN_NS
+static uint32_t Calibrate(const Bench_t *pBench,double *pNs)
+{
+   uint32_t Ops = 64;
+
+   while((*pNs = TimeBatch(pBench,Ops)) < BENCH_MIN_NS && Ops < (1U << 30)) {
+      Ops *= 2;
+   }
+   return Ops;
+}
+
+/// Fastest ns per op of every path, one batch of each path per round
+static void Measure(void)
+{
+   int Round;
+   int i;
+
+   for(i = 0; i < NUM_BENCHES; i++) {
+      ResultOps[i] = Calibrate(&Benches[i],&ResultNs[i]);
+   }
+   for(Round = 1; Round < Repeats; Round++) {
+      for(i = 0; i < NUM_BENCHES; i++) {
+         double Ns = TimeBatch(&Benches[i],ResultOps[i]);
+
+         if(Ns < ResultNs[i]) {
+            ResultNs[i] = Ns;
+         }
+      }
+   }
+   for(i = 0; i < NUM_BENCHES; i++) {
+      ResultNs[i] /= ResultOps[i];
+   }
+}
+
+static Baseline_t *FindBaseline(const char *Name)
+{
+   int i;
+
+   for(i = 0; i < NumBaseline; i++) {
+      if(strcmp(Baseline[i].Name,Name) == 0) {
+         return &Baseline[i];
+      }
+   }
+   return NULL;
+}
+
+/// Lines of path, ns per op and allowed regression in %, # starts a comment
+static bool LoadBaseline(const char *Path)
+{
+   FILE *fp = fopen(Path,"r");
+   char Line[128];
+   int LineNum = 0;
+
+   if(fp == NULL) {
+      perror(Path);
+      return false;
+   }
+   while(fgets(Line,sizeof(Line),fp) != NULL) {
+      Baseline_t *p = &Baseline[NumBaseline];
+      char *pComment = strchr(Line,'#');
+      int Fields;
+
+      LineNum++;
+      if(pComment != NULL) {
+         *pComment = 0;
+      }
+      Fields = sscanf(Line,"%31s %lf %d",p->Name,&p->Ns,&p->Percent);
+      if(Fields <= 0) {
+         continue;
+      }
+      if(Fields != 3 || p->Ns <= 0 || p->Percent < 0 || NumBaseline == BENCH_MAX_PATHS) {
+         fprintf(stderr,"%s:%d: expected path, ns per op and percent\n",Path,LineNum);
+         fclose(fp);
+         return false;
+      }
+      NumBaseline++;
+   }
+   fclose(fp);
+   return true;
+}
+
+static bool WriteBaseline(const char *Path)
+{
+   FILE *fp = fopen(Path,"w");
+   int i;
+
+   if(fp == NULL) {
+      perror(Path);
+      return false;
+   }
+   fprintf(fp,"# hot_bench baseline, make bench-baseline rewrites the times\n");
+   fprintf(fp,"# path               ns/op   allowed regression %%\n");
+   for(i = 0; i < NUM_BENCHES; i++) {
+      const Baseline_t *p = FindBaseline(Benches[i].Name);
+
+      fprintf(fp,"%-20s %8.1f %4d\n",Benches[i].Name,ResultNs[i],p != NULL ? p->Percent : BENCH_DEFAULT_PERCENT);
+   }
+   return fclose(fp) == 0;
+}
+
+/// Prints the results, false if a path regressed
+static bool Report(void)
+{
+   bool Ok = true;
+   int i;
+
+   printf("path,ops,ns_per_op,baseline_ns,limit_ns,result\n");
+   for(i = 0; i < NUM_BENCHES; i++) {
+      const Baseline_t *p = FindBaseline(Benches[i].Name);
+
+      if(p == NULL) {
+         printf("%s,%lu,%.1f,,,%s\n",Benches[i].Name,(unsigned long) ResultOps[i],ResultNs[i],
+                CheckPath != NULL ? "new" : "-");
+      }
+      else {
+         double Limit = p->Ns * (100 + p->Percent) / 100 + BENCH_SLACK_NS;
+         bool Regressed = ResultNs[i] > Limit;
+
+         printf("%s,%lu,%.1f,%.1f,%.1f,%s\n",Benches[i].Name,(unsigned long) ResultOps[i],ResultNs[i],p->Ns,Limit,
+                Regressed ? "regressed" : "ok");
+         Ok &= !Regressed;
+      }
+   }
+   return Ok;
+}
+
+static void Idle(void)
+{
+   int Null;
+   int Out;
+   bool Ok;
+
+   if(Ran) {
+      return;
+   }
+   // boot and node initialization are done
+   Ran = true;
+   MakeEvents();
+
+   fflush(stdout);
+   Null = open("/dev/null",O_WRONLY);
+   Out = dup(STDOUT_FILENO);
+   dup2(Null,STDOUT_FILENO);
+   Measure();
+   fflush(stdout);
+   dup2(Out,STDOUT_FILENO);
+   close(Null);
+   close(Out);
+
+   Ok = Report();
+   fflush(stdout);
+   if(WritePath != NULL && !WriteBaseline(WritePath)) {
+      exit(1);
+   }
+   exit(Ok || WritePath != NULL ? 0 : 1);
+}
+
+static void Done(int ResetType)
+{
+   fprintf(stderr,"stopped before the benchmarks ran (%d)\n",ResetType);
+   exit(1);
+}
+
+int main(int argc,char **argv)
+{
+   int c;
+
+   while((c = getopt(argc,argv,"c:w:r:")) != -1) {
+      switch(c) {
+         case 'c':
+            CheckPath = optarg;
+            break;
+         case 'w':
+            WritePath = optarg;
+            break;
+         case 'r':
+            Repeats = strtol(optarg,NULL,0);
+            if(Repeats < 1) {
+               Repeats = 1;
+            }
+            break;
+         default:
+            fprintf(stderr,"usage: %s [-c baseline] [-w baseline] [-r repeats]\n",argv[0]);
+            return 1;
+      }
+   }
+   if(CheckPath != NULL && !LoadBaseline(CheckPath)) {
+      return 1;
+   }
+
+   // the log output is thrown away, do it in large writes
+   setvbuf(stdout,NULL,_IOFBF,1 << 16);
+   SimSetIdleHook(Idle);
+   SimSetDoneHook(Done);
+   appMain(&config);
+   return 0;
+}
@@ -0,0 +1,114 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -c churns the connection table: every round opens up to one connection
+// more than MAX_CONNECTIONS, each with a mesh proxy, and closes them again
+// in random order. The table must be empty and balanced at the end.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "connections.h"
+#include "gateway_sim.h"
+
+/// Connection churn rounds still to run
+static uint32_t ChurnRounds;
+/// Connections that must have been rejected because the table was full
+static uint32_t ChurnRejects;
+static bool Churn;
+
+/// One churn round, the events of all connections are interleaved
+static void PushChurn(void)
+{
+   uint8_t Handles[MAX_CONNECTIONS + 1];
+   int Count = 1 + ScenarioRandom() % (MAX_CONNECTIONS + 1);
+   int i;
+
+   for(i = 0; i < Count; i++) {
+      struct gecko_msg_le_connection_opened_evt_t Opened = {{{0}},0,0,0,0,0};
+      struct gecko_msg_gatt_mtu_exchanged_evt_t Mtu = {0,23 + ScenarioRandom() % 225};
+      struct gecko_msg_le_connection_phy_status_evt_t Phy = {0,1 << (ScenarioRandom() % 2)};
+      struct gecko_msg_le_connection_parameters_evt_t Params = {0,6 + ScenarioRandom() % 100,0,100,1,27};
+      struct gecko_msg_mesh_proxy_connected_evt_t Proxy = {ChurnRounds * 16 + i};
+
+      // the stack hands out the lowest free handle
+      Handles[i] = i + 1;
+      Opened.connection = Mtu.connection = Phy.connection = Params.connection = Handles[i];
+      SimPushEvent(gecko_evt_le_connection_opened_id,&Opened,sizeof(Opened));
+      ScenarioPushed++;
+      if(i == MAX_CONNECTIONS) {
+         // rejected and closed by the application
+         ChurnRejects++;
+         break;
+      }
+      SimPushEvent(gecko_evt_mesh_proxy_connected_id,&Proxy,sizeof(Proxy));
+      SimPushEvent(gecko_evt_gatt_mtu_exchanged_id,&Mtu,sizeof(Mtu));
+      SimPushEvent(gecko_evt_le_connection_phy_status_id,&Phy,sizeof(Phy));
+      SimPushEvent(gecko_evt_le_connection_parameters_id,&Params,sizeof(Params));
+      ScenarioPushed += 4;
+   }
+   if(Count > MAX_CONNECTIONS) {
+      Count = MAX_CONNECTIONS;
+   }
+
+   // close in random order, the proxy goes down first
+   for(i = Count - 1; i >= 0; i--) {
+      int j = ScenarioRandom() % (i + 1);
+      uint8_t Handle = Handles[j];
+      struct gecko_msg_mesh_proxy_disconnected_evt_t Disc = {ChurnRounds * 16 + Handle - 1,0x13};
+      struct gecko_msg_le_connection_closed_evt_t Closed = {0x13,Handle};
+
+      Handles[j] = Handles[i];
+      Handles[i] = Handle;
+      SimPushEvent(gecko_evt_mesh_proxy_disconnected_id,&Disc,sizeof(Disc));
+      SimPushEvent(gecko_evt_le_connection_closed_id,&Closed,sizeof(Closed));
+      ScenarioPushed += 2;
+   }
+   ChurnRounds--;
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   ChurnRounds = strtoul(Arg,NULL,0);
+   Churn = true;
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(!Churn) {
+      return false;
+   }
+   if(ChurnRounds > 0) {
+      PushChurn();
+   }
+   return true;
+}
+
+/// Checks the connection table after the churn rounds
+static bool Report(void)
+{
+   const ConnStats_t *pStats = ConnGetStats();
+   bool Ok;
+
+   if(!Churn) {
+      return true;
+   }
+   Ok = pStats->Active == 0 && pStats->Opened == pStats->Closed && pStats->Rejected == ChurnRejects
+        && ConnProxyCount() == 0 && pStats->MaxActive <= MAX_CONNECTIONS;
+   printf("connections: opened %lu, closed %lu, rejected %lu, max open %d of %d, %s\n",
+          (unsigned long) pStats->Opened,(unsigned long) pStats->Closed,(unsigned long) pStats->Rejected,
+          pStats->MaxActive,MAX_CONNECTIONS,Ok ? "ok" : "MISMATCH");
+   return Ok;
+}
+
+const Scenario_t ChurnScenario = {"c:","-c rounds [-s seed]",Option,Idle,Report};
@@ -0,0 +1,153 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -g connects a simulated phone that writes the given number of bytes to a
+// stack attribute, as the mesh proxy data in during a bulk configuration,
+// then stays idle for GATT_BENCH_IDLE_MS and disconnects. The phone offers
+// an MTU of GATT_BENCH_MTU, starts at a 45 ms interval and accepts every
+// parameter and PHY request. It sends one write of MTU - 3 bytes per
+// connection event, so the modeled rate only depends on MTU and interval,
+// not on the PHY. -G turns the interval and PHY tuning off, -R sets the
+// RSSI the phone is seen with.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "timer_wheel.h"
+#include "connections.h"
+#include "gateway_sim.h"
+
+/// MTU offered by the phone, initial interval, idle time before disconnecting
+#define GATT_BENCH_MTU        185
+#define GATT_BENCH_INTERVAL   36
+#define GATT_BENCH_IDLE_MS    10000
+#define GATT_BENCH_HANDLE     1
+#define GATT_BENCH_ATTRIBUTE  0x30
+
+static uint32_t GattBytes;
+static uint32_t GattSent;
+static bool GattStarted;
+static bool GattNoTuning;
+static uint32_t GattStart;
+static uint32_t GattEnd;
+static uint32_t GattWrites;
+static double GattCredit;
+static Timer_t GattTimer;
+/// Connection state just before the disconnect
+static Connection_t GattConn;
+
+/// The phone, called every wheel tick while it is connected
+static void GattTick(Timer_t *pTimer)
+{
+   Connection_t *p = ConnFind(GATT_BENCH_HANDLE);
+   uint8_t Buf[sizeof(struct gecko_msg_gatt_server_attribute_value_evt_t) + GATT_BENCH_MTU];
+   struct gecko_msg_gatt_server_attribute_value_evt_t *pValue = (void *) Buf;
+
+   if(p == NULL || p->Interval == 0) {
+      return;
+   }
+   if(GattSent == GattBytes) {
+      if(SimNow() - GattEnd >= (uint64_t) GATT_BENCH_IDLE_MS * SIM_TICKS_PER_SEC / 1000) {
+         struct gecko_msg_le_connection_closed_evt_t Closed = {0x13,GATT_BENCH_HANDLE};
+
+         GattConn = *p;
+         SimPushEvent(gecko_evt_le_connection_closed_id,&Closed,sizeof(Closed));
+         TimerStop(&GattTimer);
+      }
+      return;
+   }
+
+   // connection events in this tick, one write each
+   GattCredit += TIMER_WHEEL_TICK_MS / (p->Interval * 1.25);
+   while(GattCredit >= 1 && GattSent < GattBytes) {
+      int Len = p->Mtu - 3;
+
+      if(Len > (int) (GattBytes - GattSent)) {
+         Len = GattBytes - GattSent;
+      }
+      memset(Buf,0,sizeof(Buf));
+      pValue->connection = GATT_BENCH_HANDLE;
+      pValue->attribute = GATT_BENCH_ATTRIBUTE;
+      pValue->value.len = Len;
+      SimPushEvent(gecko_evt_gatt_server_attribute_value_id,Buf,sizeof(*pValue) + Len);
+      GattSent += Len;
+      GattWrites++;
+      GattCredit--;
+   }
+   if(GattSent == GattBytes) {
+      GattEnd = SimNow();
+   }
+}
+
+static void GattBenchRun(void)
+{
+   struct gecko_msg_le_connection_opened_evt_t Opened = {{{0}},0,0,GATT_BENCH_HANDLE,0xff,0};
+   struct gecko_msg_le_connection_parameters_evt_t Params = {GATT_BENCH_HANDLE,GATT_BENCH_INTERVAL,0,500,1,27};
+   struct gecko_msg_gatt_mtu_exchanged_evt_t Mtu = {GATT_BENCH_HANDLE,GATT_BENCH_MTU};
+
+   GattStarted = true;
+   if(GattNoTuning) {
+      ConnSetTuning(false);
+   }
+   SimPushEvent(gecko_evt_le_connection_opened_id,&Opened,sizeof(Opened));
+   SimPushEvent(gecko_evt_le_connection_parameters_id,&Params,sizeof(Params));
+   SimPushEvent(gecko_evt_gatt_mtu_exchanged_id,&Mtu,sizeof(Mtu));
+   GattStart = SimNow();
+   TimerStart(&GattTimer,TIMER_WHEEL_TICK_MS,TIMER_WHEEL_TICK_MS,GattTick,NULL);
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   switch(Opt) {
+      case 'g':
+         GattBytes = strtoul(Arg,NULL,0);
+         break;
+      case 'G':
+         GattNoTuning = true;
+         break;
+      case 'R':
+         SimSetRssi(strtol(Arg,NULL,0));
+         break;
+   }
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(GattBytes == 0) {
+      return false;
+   }
+   if(!GattStarted) {
+      GattBenchRun();
+   }
+   return true;
+}
+
+static bool Report(void)
+{
+   const ConnStats_t *pStats = ConnGetStats();
+   double Seconds = (double) (GattEnd - GattStart) / SIM_TICKS_PER_SEC;
+
+   if(!GattStarted) {
+      return true;
+   }
+   printf("gatt: %lu bytes in %lu writes, %.2f s, %.0f bytes/s, best second %lu bytes/s, tuning %s\n",
+          (unsigned long) GattSent,(unsigned long) GattWrites,Seconds,Seconds > 0 ? GattSent / Seconds : 0,
+          (unsigned long) GattConn.MaxBytesPerSec,ConnGetTuning() ? "on" : "off");
+   printf("gatt: mtu %u, interval %.2f ms and phy %u when idle, rssi %d, %lu parameter and %lu phy requests\n",
+          GattConn.Mtu,GattConn.Interval * 1.25,GattConn.Phy,GattConn.Rssi,(unsigned long) pStats->ParamRequests,
+          (unsigned long) pStats->PhyRequests);
+   return true;
+}
+
+const Scenario_t GattScenario = {"g:GR:","-g bytes [-G] [-R rssi]",Option,Idle,Report};
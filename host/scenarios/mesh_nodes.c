@@ -0,0 +1,105 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated mesh nodes shared by the request tracker (-a) and scene (-f)
+// scenarios. Every acknowledged set and scene recall is answered by its
+// target after a random multi-hop delay, requests and statuses are lost now
+// and then. Gets are not answered.
+
+#include <string.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "timer_wheel.h"
+#include "mesh_generic_model_capi_types.h"
+#include "gateway_sim.h"
+
+/// Status delay range, loss of a request or status in %, statuses on their way back
+#define MESH_NODES_MIN_MS     60
+#define MESH_NODES_MAX_MS     300
+#define MESH_NODES_LOSS       5
+#define MESH_NODES_REPLIES    128
+
+static uint32_t Loss = 2 * MESH_NODES_LOSS;
+static uint32_t Lost;
+/// Statuses on their way back, scene statuses have model 0
+static struct {
+   Timer_t Timer;
+   uint16_t Address;
+   uint16_t ModelID;
+   uint8_t Params[2];
+} Replies[MESH_NODES_REPLIES];
+
+static void Reply(Timer_t *pTimer)
+{
+   uint8_t Buf[sizeof(struct gecko_msg_mesh_generic_client_server_status_evt_t) + 2] = {0};
+   struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus = (void *) Buf;
+   int i = (int) (intptr_t) pTimer->pArg;
+
+   if(Replies[i].ModelID == 0) {
+      struct gecko_msg_mesh_scene_client_status_evt_t Scene = {0};
+
+      Scene.server_address = Replies[i].Address;
+      Scene.current_scene = Replies[i].Params[0] | (Replies[i].Params[1] << 8);
+      SimPushEvent(gecko_evt_mesh_scene_client_status_id,&Scene,sizeof(Scene));
+      return;
+   }
+
+   pStatus->model_id = Replies[i].ModelID;
+   pStatus->server_address = Replies[i].Address;
+   pStatus->type = mesh_lighting_state_lightness_actual;
+   pStatus->parameters.len = 2;
+   memcpy(pStatus->parameters.data,Replies[i].Params,2);
+   SimPushEvent(gecko_evt_mesh_generic_client_server_status_id,Buf,sizeof(Buf));
+}
+
+static uint16_t Request(const SimMeshRequest_t *pRequest)
+{
+   int i;
+
+   if(!(pRequest->Flags & 1) || pRequest->Get) {
+      return bg_err_success;
+   }
+   if(ScenarioRandom() % 100 < Loss) {
+      Lost++;
+      return bg_err_success;
+   }
+   for(i = 0; i < MESH_NODES_REPLIES && TimerIsArmed(&Replies[i].Timer); i++);
+   if(i == MESH_NODES_REPLIES) {
+      return bg_err_out_of_memory;
+   }
+   Replies[i].Address = pRequest->Address;
+   Replies[i].ModelID = pRequest->ModelID;
+   if(pRequest->ModelID == 0) {
+      Replies[i].Params[0] = pRequest->Scene;
+      Replies[i].Params[1] = pRequest->Scene >> 8;
+   }
+   else {
+      memcpy(Replies[i].Params,pRequest->pParams,2);
+   }
+   TimerStart(&Replies[i].Timer,MESH_NODES_MIN_MS + ScenarioRandom() % (MESH_NODES_MAX_MS - MESH_NODES_MIN_MS),0,
+              Reply,(void *) (intptr_t) i);
+   return bg_err_success;
+}
+
+void MeshNodesStart(void)
+{
+   SimSetMeshHook(Request);
+}
+
+void MeshNodesSetLoss(uint32_t Percent)
+{
+   Loss = Percent;
+}
+
+uint32_t MeshNodesLost(void)
+{
+   return Lost;
+}
@@ -0,0 +1,230 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -o updates the firmware over the air with an image of the given size,
+// ending with the CRC-32 of the bytes before it as the simulated bootloader
+// expects. The phone writes start to the OTA control characteristic, the
+// image to the OTA data characteristic with MTU - 3 bytes per write and
+// OTA_BENCH_WRITES per connection event, then end with the CRC-32 of the
+// image. The image is programmed into the simulated flash slot while the
+// gateway keeps running, the reset must install it. -e 1 sends a wrong
+// CRC-32 with the end write, it must be refused. -e 2 sends an image with a
+// wrong CRC-32 at its end, the bootloader must reject it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "em_device.h"
+#include "sim_gecko.h"
+#include "timer_wheel.h"
+#include "connections.h"
+#include "ota.h"
+#include "btl_interface.h"
+#include "gatt_db.h"
+#include "gateway_sim.h"
+
+/// MTU offered by the phone, initial interval, writes per connection event
+#define OTA_BENCH_MTU         247
+#define OTA_BENCH_INTERVAL    36
+#define OTA_BENCH_WRITES      4
+#define OTA_BENCH_HANDLE      1
+
+enum {
+   OTA_PHONE_STARTING,        ///< Start written, waiting for the response
+   OTA_PHONE_SENDING,
+   OTA_PHONE_ENDING,          ///< End written, waiting for the response
+   OTA_PHONE_DONE
+};
+
+static uint32_t OtaBytes;
+static uint8_t *OtaImage;
+static uint32_t OtaSent;
+static uint32_t OtaError;
+static bool OtaStarted;
+static int OtaPhone;
+static uint8_t OtaResult = 0xff;
+static uint32_t OtaEnded;
+static double OtaCredit;
+static Timer_t OtaTimer;
+
+static uint32_t Crc32(uint32_t Crc,const uint8_t *p,uint32_t Len)
+{
+   int i;
+
+   while(Len-- > 0) {
+      Crc ^= *p++;
+      for(i = 0; i < 8; i++) {
+         Crc = (Crc >> 1) ^ (0xedb88320 & -(Crc & 1));
+      }
+   }
+   return Crc;
+}
+
+static void OtaWrite(uint16_t Characteristic,uint8_t Opcode,const uint8_t *pData,int Len)
+{
+   uint8_t Buf[sizeof(struct gecko_msg_gatt_server_user_write_request_evt_t) + OTA_BENCH_MTU];
+   struct gecko_msg_gatt_server_user_write_request_evt_t *pReq = (void *) Buf;
+
+   memset(Buf,0,sizeof(Buf));
+   pReq->connection = OTA_BENCH_HANDLE;
+   pReq->characteristic = Characteristic;
+   pReq->att_opcode = Opcode;
+   pReq->value.len = Len;
+   memcpy(pReq->value.data,pData,Len);
+   SimPushEvent(gecko_evt_gatt_server_user_write_request_id,Buf,sizeof(*pReq) + Len);
+}
+
+static void OtaResponse(uint16_t Characteristic,uint8_t Error)
+{
+   if(Characteristic != gattdb_ota_control) {
+      return;
+   }
+   if(OtaPhone == OTA_PHONE_STARTING && Error == 0) {
+      OtaPhone = OTA_PHONE_SENDING;
+   }
+   else if(OtaPhone == OTA_PHONE_STARTING || OtaPhone == OTA_PHONE_ENDING) {
+      struct gecko_msg_le_connection_closed_evt_t Closed = {0x13,OTA_BENCH_HANDLE};
+
+      OtaResult = Error;
+      OtaEnded = SimNow();
+      OtaPhone = OTA_PHONE_DONE;
+      TimerStop(&OtaTimer);
+      SimPushEvent(gecko_evt_le_connection_closed_id,&Closed,sizeof(Closed));
+   }
+}
+
+/// The phone, called every wheel tick while it is connected
+static void OtaTick(Timer_t *pTimer)
+{
+   Connection_t *p = ConnFind(OTA_BENCH_HANDLE);
+
+   if(p == NULL || p->Interval == 0 || OtaPhone != OTA_PHONE_SENDING) {
+      return;
+   }
+
+   OtaCredit += TIMER_WHEEL_TICK_MS * OTA_BENCH_WRITES / (p->Interval * 1.25);
+   while(OtaCredit >= 1 && OtaSent < OtaBytes) {
+      int Len = p->Mtu - 3;
+
+      if(Len > (int) (OtaBytes - OtaSent)) {
+         Len = OtaBytes - OtaSent;
+      }
+      if(SimQueued() >= SIM_QUEUE_SIZE / 2) {
+         // the link layer buffers of the gateway are full
+         return;
+      }
+      OtaWrite(gattdb_ota_data,gatt_write_command,&OtaImage[OtaSent],Len);
+      OtaSent += Len;
+      OtaCredit--;
+   }
+   if(OtaSent == OtaBytes) {
+      uint32_t Crc = Crc32(0xffffffff,OtaImage,OtaBytes) ^ 0xffffffff;
+      uint8_t End[5] = {OTA_CONTROL_END,Crc,Crc >> 8,Crc >> 16,Crc >> 24};
+
+      if(OtaError == 1) {
+         // the control write carries the CRC-32 of the image, not of what was sent
+         End[1] ^= 0x01;
+      }
+      OtaWrite(gattdb_ota_control,gatt_write_request,End,sizeof(End));
+      OtaPhone = OTA_PHONE_ENDING;
+   }
+}
+
+static void OtaBenchRun(void)
+{
+   struct gecko_msg_le_connection_opened_evt_t Opened = {{{0}},0,0,OTA_BENCH_HANDLE,0xff,0};
+   struct gecko_msg_le_connection_parameters_evt_t Params = {OTA_BENCH_HANDLE,OTA_BENCH_INTERVAL,0,500,1,27};
+   struct gecko_msg_gatt_mtu_exchanged_evt_t Mtu = {OTA_BENCH_HANDLE,OTA_BENCH_MTU};
+   uint8_t Start = OTA_CONTROL_START;
+   uint32_t Crc;
+   uint32_t i;
+
+   OtaStarted = true;
+   OtaImage = malloc(OtaBytes);
+   for(i = 0; i < OtaBytes - 4; i++) {
+      OtaImage[i] = ScenarioRandom();
+   }
+   Crc = Crc32(0xffffffff,OtaImage,OtaBytes - 4) ^ 0xffffffff;
+   if(OtaError == 2) {
+      Crc ^= 0x80000000;
+   }
+   for(i = 0; i < 4; i++) {
+      OtaImage[OtaBytes - 4 + i] = Crc >> (8 * i);
+   }
+
+   SimSetWriteResponseHook(OtaResponse);
+   SimPushEvent(gecko_evt_le_connection_opened_id,&Opened,sizeof(Opened));
+   SimPushEvent(gecko_evt_le_connection_parameters_id,&Params,sizeof(Params));
+   SimPushEvent(gecko_evt_gatt_mtu_exchanged_id,&Mtu,sizeof(Mtu));
+   OtaPhone = OTA_PHONE_STARTING;
+   OtaWrite(gattdb_ota_control,gatt_write_request,&Start,1);
+   TimerStart(&OtaTimer,TIMER_WHEEL_TICK_MS,TIMER_WHEEL_TICK_MS,OtaTick,NULL);
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   if(Opt == 'e') {
+      OtaError = strtoul(Arg,NULL,0);
+      return true;
+   }
+   OtaBytes = strtoul(Arg,NULL,0);
+   if(OtaBytes < 8) {
+      OtaBytes = 8;
+   }
+   if(OtaBytes > SIM_SLOT_SIZE) {
+      OtaBytes = SIM_SLOT_SIZE;
+   }
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(OtaBytes == 0) {
+      return false;
+   }
+   if(!OtaStarted) {
+      OtaBenchRun();
+   }
+   return true;
+}
+
+/// Returns false if the outcome is not the expected one
+static bool Report(void)
+{
+   static const uint8_t Expected[3] = {bg_err_success,OTA_ERR_CRC,OTA_ERR_IMAGE};
+   const OtaStats_t *pStats = OtaGetStats();
+   double Seconds = pStats->ReceiveMs / 1000.0;
+   uint32_t Length;
+   const uint8_t *pSlot = SimSlot(&Length);
+   bool Installed = SimSlotToBootload() == OTA_SLOT;
+
+   if(!OtaStarted) {
+      return true;
+   }
+   printf("ota: %lu bytes in %.2f s, %.0f bytes/s, %lu blocks, %lu stalls, verified in %lu ms, longest slice %.0f us\n",
+          (unsigned long) pStats->Size,Seconds,Seconds > 0 ? pStats->Size / Seconds : 0,
+          (unsigned long) pStats->Blocks,(unsigned long) pStats->Stalls,(unsigned long) pStats->VerifyMs,
+          pStats->MaxSliceCycles * 1e6 / SIM_CORE_CLOCK);
+   printf("ota: end response 0x%02x after %.2f s, image %s\n",OtaResult,(double) OtaEnded / SIM_TICKS_PER_SEC,
+          Installed ? "installed" : "not installed");
+
+   if(OtaError > 2 || OtaResult != Expected[OtaError] || Installed != (OtaError == 0)) {
+      return false;
+   }
+   if(Installed && (Length != OtaBytes || memcmp(pSlot,OtaImage,OtaBytes) != 0)) {
+      printf("ota: slot differs from the image\n");
+      return false;
+   }
+   return true;
+}
+
+const Scenario_t OtaScenario = {"o:e:","-o bytes [-e 1|2] [-s seed]",Option,Idle,Report};
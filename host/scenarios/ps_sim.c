@@ -0,0 +1,181 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -p saves values to hot persistent store keys through the write-behind
+// cache while virtual time passes, with a flush checkpoint now and then and
+// simulated crashes that drop the cache without flushing. After each crash
+// every key in flash must hold a version saved after its last checkpoint
+// and not newer than the last save, and loads must return the last save.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "em_device.h"
+#include "sim_gecko.h"
+#include "timer_wheel.h"
+#include "ps_cache.h"
+#include "gateway_sim.h"
+
+/// Keys, saves per idle call, checkpoint and crash periods
+#define PS_TEST_KEY           0x4000
+#define PS_TEST_KEYS          24
+#define PS_TEST_HOT_KEYS      4
+#define PS_TEST_BATCH         8
+#define PS_TEST_CHECKPOINT    1000
+#define PS_TEST_CRASH         3000
+
+static uint32_t PsSaves;
+static uint32_t PsDone;
+static bool PsStarted;
+static Timer_t PsTimer;
+/// Counters of the cache instances dropped by crashes
+static uint32_t PsWrites;
+static uint32_t PsSaved;
+static uint32_t PsMaxCycles;
+/// Last saved version and the oldest version flash may hold, per key
+static uint32_t PsLatest[PS_TEST_KEYS];
+static uint32_t PsOldest[PS_TEST_KEYS];
+static uint32_t PsCrashes;
+static uint32_t PsErrors;
+
+/// Value of a key version, the length depends on the key
+static uint8_t PsValue(int Key,uint32_t Version,uint8_t *pValue)
+{
+   uint8_t Len = 8 + Key % (PS_CACHE_VALUE_SIZE - 7);
+
+   memset(pValue,Key,Len);
+   memcpy(pValue,&Version,sizeof(Version));
+   return Len;
+}
+
+/// Checks a loaded value, returns its version or -1 if it is not one of the key's values
+static int64_t PsVersion(int Key,const uint8_t *pValue,int Len)
+{
+   uint8_t Expected[PS_CACHE_VALUE_SIZE];
+   uint32_t Version;
+
+   memcpy(&Version,pValue,sizeof(Version));
+   if(Len != PsValue(Key,Version,Expected) || memcmp(pValue,Expected,Len) != 0) {
+      return -1;
+   }
+   return Version;
+}
+
+/// Drops the cache like a reset without a flush and checks what reached flash
+static void PsCrash(void)
+{
+   const PsCacheStats_t *pStats = PsCacheGetStats();
+   uint8_t Value[PS_CACHE_VALUE_SIZE];
+   int i;
+
+   PsWrites += pStats->Writes;
+   PsSaved += pStats->Saved;
+   if(pStats->MaxFlushCycles > PsMaxCycles) {
+      PsMaxCycles = pStats->MaxFlushCycles;
+   }
+   PsCacheInit();
+   PsCrashes++;
+   for(i = 0; i < PS_TEST_KEYS; i++) {
+      struct gecko_msg_flash_ps_load_rsp_t *pRsp = gecko_cmd_flash_ps_load(PS_TEST_KEY + i);
+      int64_t Version = -1;
+
+      if(pRsp->result == bg_err_success) {
+         Version = PsVersion(i,pRsp->value.data,pRsp->value.len);
+      }
+      else if(PsOldest[i] == 0) {
+         // never written
+         PsLatest[i] = 0;
+         continue;
+      }
+      if(Version < PsOldest[i] || Version > PsLatest[i]) {
+         printf("key 0x%x: flash version %lld, expected %lu..%lu\n",PS_TEST_KEY + i,(long long) Version,
+                (unsigned long) PsOldest[i],(unsigned long) PsLatest[i]);
+         PsErrors++;
+         continue;
+      }
+      // the lost saves are gone, the next save gets the following number
+      PsOldest[i] = PsLatest[i] = Version;
+      if(PsCacheLoad(PS_TEST_KEY + i,Value) < 0 || PsVersion(i,Value,pRsp->value.len) != Version) {
+         printf("key 0x%x: load after the crash differs from flash\n",PS_TEST_KEY + i);
+         PsErrors++;
+      }
+   }
+}
+
+/// One batch of saves, runs from a timer so the cache sees virtual time pass
+static void PsTestBatch(Timer_t *pTimer)
+{
+   uint8_t Value[PS_CACHE_VALUE_SIZE];
+   int i;
+
+   for(i = 0; i < PS_TEST_BATCH && PsDone < PsSaves; i++) {
+      int Key = ScenarioRandom() % 4 != 0 ? ScenarioRandom() % PS_TEST_HOT_KEYS : ScenarioRandom() % PS_TEST_KEYS;
+      int Len;
+
+      PsCacheSave(PS_TEST_KEY + Key,Value,PsValue(Key,++PsLatest[Key],Value));
+      PsDone++;
+
+      Key = ScenarioRandom() % PS_TEST_KEYS;
+      Len = PsCacheLoad(PS_TEST_KEY + Key,Value);
+      if(PsLatest[Key] != 0 && (Len < 0 || PsVersion(Key,Value,Len) != PsLatest[Key])) {
+         printf("key 0x%x: load differs from the last save\n",PS_TEST_KEY + Key);
+         PsErrors++;
+      }
+
+      if(ScenarioRandom() % PS_TEST_CHECKPOINT == 0) {
+         PsCacheFlush();
+         memcpy(PsOldest,PsLatest,sizeof(PsOldest));
+      }
+      if(ScenarioRandom() % PS_TEST_CRASH == 0) {
+         PsCrash();
+      }
+   }
+   if(PsDone < PsSaves) {
+      // up to 100 ms between the batches
+      TimerStart(&PsTimer,1 + ScenarioRandom() % 100,0,PsTestBatch,NULL);
+   }
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   PsSaves = strtoul(Arg,NULL,0);
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(PsSaves == 0) {
+      return false;
+   }
+   if(!PsStarted) {
+      PsStarted = true;
+      PsCacheEraseAll();
+      PsTestBatch(&PsTimer);
+   }
+   return true;
+}
+
+static bool Report(void)
+{
+   if(!PsStarted) {
+      return true;
+   }
+   // the last crash also collects the counters
+   PsCrash();
+   printf("ps cache: %lu saves, %lu flash writes, %lu saved, longest write %.0f ns\n",(unsigned long) PsDone,
+          (unsigned long) PsWrites,(unsigned long) PsSaved,PsMaxCycles * 1e9 / SIM_CORE_CLOCK);
+   printf("ps crash test: %lu crashes, %lu errors, %s\n",(unsigned long) PsCrashes,(unsigned long) PsErrors,
+          PsErrors == 0 ? "ok" : "MISMATCH");
+   return PsErrors == 0;
+}
+
+const Scenario_t PsScenario = {"p:","-p saves [-s seed]",Option,Idle,Report};
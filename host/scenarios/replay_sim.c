@@ -0,0 +1,168 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -r replays a trace recorded on the device (see darwin_trace.h). The
+// virtual clock follows the recorded time stamps, scaled from the tick rate
+// in the trace header. The trace is replayed as fast as possible unless -x
+// gives a speed: 1 keeps the recorded timing, 10 replays ten times faster.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "darwin_trace.h"
+#include "gateway_sim.h"
+
+/// Events pushed per call of the idle hook
+#define BATCH   64
+
+static uint32_t *Trace;
+static uint32_t TraceWords;
+static uint32_t TracePos;
+static uint32_t TraceStamp;
+static uint32_t TraceLost;
+/// RTCC ticks per second of the recorded time stamps and ticks replayed
+static uint32_t TicksPerSec;
+static uint64_t TraceTicks;
+static double Speed;
+static bool Started;
+static struct timespec Start;
+
+static bool LoadTrace(const char *Path)
+{
+   FILE *f = fopen(Path,"rb");
+   long Size;
+
+   if(f == NULL) {
+      perror(Path);
+      return false;
+   }
+   fseek(f,0,SEEK_END);
+   Size = ftell(f);
+   fseek(f,0,SEEK_SET);
+   Trace = malloc(Size + 4);
+   TraceWords = fread(Trace,1,Size,f) / 4;
+   fclose(f);
+
+   if(TraceWords < 3 || Trace[0] != TRACE_MAGIC || Trace[1] != TRACE_VERSION || Trace[2] == 0) {
+      fprintf(stderr,"%s is not an event trace\n",Path);
+      return false;
+   }
+   TicksPerSec = Trace[2];
+   TracePos = 3;
+   return true;
+}
+
+/// Waits until the virtual time has come in scaled wall clock time
+static void Pace(void)
+{
+   double Due = SimNow() / (double) SIM_TICKS_PER_SEC / Speed;
+   struct timespec Now;
+   double Elapsed;
+
+   clock_gettime(CLOCK_MONOTONIC,&Now);
+   Elapsed = (Now.tv_sec - Start.tv_sec) + (Now.tv_nsec - Start.tv_nsec) / 1e9;
+   if(Due > Elapsed) {
+      struct timespec Sleep = {(time_t) (Due - Elapsed),(long) ((Due - Elapsed - (time_t) (Due - Elapsed)) * 1e9)};
+
+      nanosleep(&Sleep,NULL);
+   }
+}
+
+static void PushRecorded(void)
+{
+   int i;
+
+   for(i = 0; i < BATCH && TracePos + 2 <= TraceWords; i++) {
+      uint32_t Header = Trace[TracePos];
+      uint32_t Stamp = Trace[TracePos + 1];
+      uint32_t Words;
+      uint32_t Delta;
+      uint64_t Elapsed;
+
+      if(Header == TRACE_END) {
+         TracePos = TraceWords;
+         break;
+      }
+      Words = TRACE_RECORD_WORDS(Header);
+      if(TracePos + Words > TraceWords) {
+         fprintf(stderr,"trace truncated at word %u\n",TracePos);
+         TracePos = TraceWords;
+         break;
+      }
+
+      // the virtual clock follows the recorded time, it does not go back
+      // when the device was reset during a trace kept in flash
+      Delta = Stamp - TraceStamp;
+      if(TracePos == 3 || (int32_t) Delta < 0) {
+         Delta = 0;
+      }
+      TraceStamp = Stamp;
+      // scaled from the total so the remainders do not add up
+      Elapsed = TraceTicks * SIM_TICKS_PER_SEC / TicksPerSec;
+      TraceTicks += Delta;
+      SimAdvance(TraceTicks * SIM_TICKS_PER_SEC / TicksPerSec - Elapsed);
+
+      if(Header == TRACE_LOST) {
+         TraceLost += Trace[TracePos + 2];
+      }
+      else {
+         if(Speed > 0) {
+            Pace();
+         }
+         SimPushEvent(BGLIB_MSG_ID(Header),&Trace[TracePos + 2],TRACE_PAYLOAD_LEN(Header));
+         ScenarioPushed++;
+      }
+      TracePos += Words;
+
+      if(Speed > 0 && Header != TRACE_LOST) {
+         // one event at a time so it is handled at its recorded time
+         break;
+      }
+   }
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   if(Opt == 'x') {
+      Speed = strtod(Arg,NULL);
+      return true;
+   }
+   if(!LoadTrace(Arg)) {
+      return false;
+   }
+   SimSetReplay(true);
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(Trace == NULL) {
+      return false;
+   }
+   if(!Started) {
+      Started = true;
+      clock_gettime(CLOCK_MONOTONIC,&Start);
+   }
+   PushRecorded();
+   return true;
+}
+
+static bool Report(void)
+{
+   if(TraceLost != 0) {
+      printf("trace has a gap of %u lost events\n",TraceLost);
+   }
+   return true;
+}
+
+const Scenario_t ReplayScenario = {"r:x:","-r trace.bin [-x speed]",Option,Idle,Report};
@@ -0,0 +1,143 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -a sends acknowledged lightness sets to REQ_BENCH_NODES simulated nodes as
+// fast as the request tracker takes them. Each node answers after a random
+// multi-hop delay, requests and statuses are lost now and then. Reports the
+// virtual time until all requests were acknowledged or given up. -w sets
+// the window of outstanding requests per node, 1 sends one at a time. -l
+// sets the chance in % that a request or its status is lost, also for -f.
+// The link layer priority controller runs in auto mode, its counters per
+// profile are reported. The simulated mesh does not depend on the profile.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "timer_wheel.h"
+#include "request_tracker.h"
+#include "ll_priority.h"
+#include "mesh_generic_model_capi_types.h"
+#include "gateway_sim.h"
+
+/// Nodes the requests go to
+#define REQ_BENCH_NODES       8
+
+/// Only given to the stack for -a, the priority controller keeps a timer armed
+static gecko_bluetooth_ll_priorities LinkLayerPriorities = GECKO_BLUETOOTH_PRIORITIES_DEFAULT;
+
+static uint32_t ReqRequests;
+static uint32_t ReqSubmitted;
+static int ReqWindow;
+static bool ReqStarted;
+static uint32_t ReqStart;
+static uint32_t ReqEnd;
+static Timer_t ReqTimer;
+
+/// Fills the window of every node
+static void ReqBenchRun(Timer_t *pTimer)
+{
+   uint16_t Node;
+
+   if(!ReqStarted) {
+      ReqStarted = true;
+      ReqStart = SimNow();
+      if(ReqWindow > 0) {
+         ReqSetWindow(ReqWindow);
+      }
+      MeshNodesStart();
+   }
+
+   for(Node = 1; Node <= REQ_BENCH_NODES; Node++) {
+      while(ReqSubmitted < ReqRequests && ReqWindowOpen(Node)) {
+         uint8_t Params[2] = {ReqSubmitted,ReqSubmitted >> 8};
+
+         if(ReqGenericSet(Node,MESH_LIGHTING_LIGHTNESS_CLIENT_MODEL_ID,mesh_lighting_request_lightness_actual,0,
+                          Params,sizeof(Params)) != bg_err_success) {
+            break;
+         }
+         ReqSubmitted++;
+      }
+   }
+
+   if(ReqSubmitted < ReqRequests || ReqGetStats()->InFlight != 0) {
+      TimerStart(&ReqTimer,TIMER_WHEEL_TICK_MS,0,ReqBenchRun,NULL);
+   }
+   else {
+      ReqEnd = SimNow();
+      // stops the controller
+      LlPrioSelect(LlPrioGetProfile());
+   }
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   switch(Opt) {
+      case 'a':
+         ReqRequests = strtoul(Arg,NULL,0);
+         ScenarioConfig.bluetooth.linklayer_priorities = &LinkLayerPriorities;
+         break;
+      case 'w':
+         ReqWindow = strtol(Arg,NULL,0);
+         break;
+      case 'l':
+         MeshNodesSetLoss(strtoul(Arg,NULL,0));
+         break;
+   }
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(ReqRequests == 0) {
+      return false;
+   }
+   if(!ReqStarted) {
+      ReqBenchRun(&ReqTimer);
+   }
+   return true;
+}
+
+static bool Report(void)
+{
+   const ReqStats_t *pStats = ReqGetStats();
+   const gecko_bluetooth_ll_priorities *pTable = SimLinkLayerPriorities();
+   int i;
+   double Seconds = (double) (ReqEnd - ReqStart) / SIM_TICKS_PER_SEC;
+
+   if(!ReqStarted) {
+      return true;
+   }
+   printf("requests: %lu sent, %lu acked, %lu retries, %lu timed out, %lu lost in the mesh\n",
+          (unsigned long) pStats->Sent,(unsigned long) pStats->Acked,(unsigned long) pStats->Retries,
+          (unsigned long) pStats->TimedOut,(unsigned long) MeshNodesLost());
+   printf("requests: %.1f s virtual time, %.0f acked/s, round trip avg %lu ms, max %lu ms, max in flight %u\n",
+          Seconds,Seconds > 0 ? pStats->Acked / Seconds : 0,
+          (unsigned long) (pStats->Acked ? pStats->TotalRttMs / pStats->Acked : 0),
+          (unsigned long) pStats->MaxRttMs,pStats->MaxInFlight);
+   for(i = 0; i < LL_PRIO_PROFILES; i++) {
+      const LlPrioStats_t *p = LlPrioGetStats(i);
+
+      if(p->Selected != 0) {
+         printf("link layer %-10s: selected %lu, %lu ms, %lu sent, %lu retries, round trip avg %lu ms\n",
+                LlPrioName(i),(unsigned long) p->Selected,(unsigned long) p->TimeMs,(unsigned long) p->Sent,
+                (unsigned long) p->Retries,(unsigned long) (p->Acked ? p->TotalRttMs / p->Acked : 0));
+      }
+   }
+   if(pTable != NULL) {
+      // the table the stack arbitrates by, as last set at runtime
+      printf("link layer table: scan %u-%u, adv %u-%u, conn %u-%u\n",pTable->scan_min,pTable->scan_max,
+             pTable->adv_min,pTable->adv_max,pTable->conn_min,pTable->conn_max);
+   }
+   return true;
+}
+
+const Scenario_t ReqScenario = {"a:w:l:","-a requests [-w window] [-l loss %] [-s seed]",Option,Idle,Report};
@@ -0,0 +1,125 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -f recalls a scene on the given number of simulated nodes plus
+// SCENE_BENCH_GROUPS groups, with the delays and losses of -a. First one
+// target at a time, each after the status of the previous one as the host
+// used to do it, then all of them with one bulk recall. Reports the virtual
+// time of both.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "timer_wheel.h"
+#include "request_tracker.h"
+#include "scene_bulk.h"
+#include "gateway_sim.h"
+
+/// Group targets added to the nodes, scene recalled
+#define SCENE_BENCH_GROUPS    2
+#define SCENE_BENCH_SCENE     7
+
+static uint16_t SceneTargets;
+static uint16_t SceneList[SCENE_BULK_MAX_TARGETS];
+static bool SceneStarted;
+/// Next target of the serial run
+static uint16_t SceneNext;
+static uint16_t SceneSerialAcked;
+static uint32_t SceneStart;
+static uint32_t SceneSerialTicks;
+static SceneBulkResult_t SceneResult;
+static bool SceneDone;
+static Timer_t SceneTimer;
+
+static void SceneBulkDone(const SceneBulkResult_t *pResult)
+{
+   SceneResult = *pResult;
+   SceneDone = true;
+}
+
+static void SceneStartBulk(Timer_t *pTimer)
+{
+   SceneStart = SimNow();
+   if(!SceneBulkRecall(SCENE_BENCH_SCENE,0,SceneList,SceneTargets + SCENE_BENCH_GROUPS,SceneBulkDone)) {
+      printf("scene bulk recall refused\n");
+   }
+}
+
+/// Serial run, the next target is sent when the previous one is done
+static void SceneSerialDone(uint16_t Address,uint16_t Result,uint8_t Tries)
+{
+   if(Result == bg_err_success) {
+      SceneSerialAcked++;
+   }
+   if(++SceneNext < SceneTargets) {
+      ReqSceneRecall(SceneNext + 1,SCENE_BENCH_SCENE,0,SceneSerialDone);
+      return;
+   }
+   // the groups take no time, let the late statuses of the serial run pass
+   SceneSerialTicks = SimNow() - SceneStart;
+   TimerStart(&SceneTimer,REQ_MAX_TIMEOUT_MS,0,SceneStartBulk,NULL);
+}
+
+static void SceneBenchRun(void)
+{
+   int i;
+
+   SceneStarted = true;
+   MeshNodesStart();
+   for(i = 0; i < SCENE_BENCH_GROUPS; i++) {
+      SceneList[i] = 0xC000 + i;
+   }
+   for(i = 0; i < SceneTargets; i++) {
+      SceneList[SCENE_BENCH_GROUPS + i] = i + 1;
+   }
+   SceneStart = SimNow();
+   ReqSceneRecall(1,SCENE_BENCH_SCENE,0,SceneSerialDone);
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   SceneTargets = strtoul(Arg,NULL,0);
+   if(SceneTargets + SCENE_BENCH_GROUPS > SCENE_BULK_MAX_TARGETS) {
+      SceneTargets = SCENE_BULK_MAX_TARGETS - SCENE_BENCH_GROUPS;
+   }
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(SceneTargets == 0) {
+      return false;
+   }
+   if(!SceneStarted) {
+      SceneBenchRun();
+   }
+   return true;
+}
+
+static bool Report(void)
+{
+   if(!SceneStarted) {
+      return true;
+   }
+   printf("scene serial: %u targets, %u acked, %.2f s virtual time\n",SceneTargets,SceneSerialAcked,
+          (double) SceneSerialTicks / SIM_TICKS_PER_SEC);
+   if(!SceneDone) {
+      printf("scene bulk: not done\n");
+      return false;
+   }
+   printf("scene bulk: %u targets, %u acked, %u groups, %u failed, %u retries, %.2f s virtual time\n",
+          SceneResult.Targets,SceneResult.Acked,SceneResult.Groups,SceneResult.Failed,SceneResult.Retries,
+          SceneResult.ElapsedMs / 1000.0);
+   return true;
+}
+
+const Scenario_t SceneScenario = {"f:","-f targets [-s seed]",Option,Idle,Report};
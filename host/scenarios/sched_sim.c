@@ -0,0 +1,140 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -b posts the given number of background jobs to the scheduler while
+// events arrive at a fixed rate in wall clock time, and reports the delay
+// from the arrival of each event until it was handled. -B 0 runs every job
+// to completion for comparison.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "em_device.h"
+#include "sim_gecko.h"
+#include "scheduler.h"
+#include "event_dispatch.h"
+#include "darwin_cycles.h"
+#include "gateway_sim.h"
+
+/// Time between events, events per job, work per job
+#define SCHED_BENCH_EVENT_US  500
+#define SCHED_BENCH_EVENTS    100
+#define SCHED_BENCH_JOB_US    20000
+/// A job is done in units of this length, checking the slice budget after each
+#define SCHED_BENCH_UNIT_US   100
+
+static uint32_t BenchEvents;
+static int32_t BenchSliceUs = -1;
+static bool BenchStarted;
+static Task_t BenchTask;
+static uint32_t BenchUnits;
+static uint32_t BenchArrival;
+static uint32_t BenchJobs;
+static EventHandlerStats_t BenchLatency;
+
+static void Spin(uint32_t Us)
+{
+   uint32_t From = CYCLE_COUNT();
+
+   while(CYCLE_COUNT() - From < Us * (SIM_CORE_CLOCK / 1000000));
+}
+
+static bool BenchJob(Task_t *pTask)
+{
+   do {
+      Spin(SCHED_BENCH_UNIT_US);
+      BenchUnits--;
+   } while(BenchUnits != 0 && !SchedExpired());
+   return BenchUnits != 0;
+}
+
+/// Handler of the benchmark events, the payload is the arrival cycle count
+static void BenchEvent(struct gecko_cmd_packet *pEvt)
+{
+   uint32_t Arrival;
+
+   memcpy(&Arrival,pEvt->data.payload,sizeof(Arrival));
+   EventRecordLatency(&BenchLatency,CYCLE_COUNT() - Arrival);
+}
+
+/// Pushes the events that arrived by now, waits for the next one if the
+/// application has nothing else to do
+static void PushBench(void)
+{
+   const uint32_t Interval = SCHED_BENCH_EVENT_US * (SIM_CORE_CLOCK / 1000000);
+
+   if(!BenchStarted) {
+      BenchStarted = true;
+      EventDispatchRegister(gecko_evt_le_gap_adv_timeout_id,BenchEvent);
+      SchedTaskInit(&BenchTask,BenchJob,NULL,SCHED_PRIO_LOW);
+      if(BenchSliceUs >= 0) {
+         SchedSetSlice(BenchSliceUs);
+      }
+      BenchArrival = CYCLE_COUNT();
+   }
+
+   while(BenchJobs != 0) {
+      if((int32_t) (CYCLE_COUNT() - BenchArrival) >= 0) {
+         // stamped with the time it arrived, not the time it is pushed
+         SimPushEvent(gecko_evt_le_gap_adv_timeout_id,&BenchArrival,sizeof(BenchArrival));
+         BenchArrival += Interval;
+         ScenarioPushed++;
+         if(++BenchEvents % SCHED_BENCH_EVENTS == 0) {
+            BenchUnits += SCHED_BENCH_JOB_US / SCHED_BENCH_UNIT_US;
+            SchedPost(&BenchTask);
+            BenchJobs--;
+         }
+         break;
+      }
+      if(SchedPending()) {
+         break;
+      }
+   }
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   if(Opt == 'B') {
+      BenchSliceUs = strtol(Arg,NULL,0);
+   }
+   else {
+      BenchJobs = strtoul(Arg,NULL,0);
+   }
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(!BenchStarted && BenchJobs == 0) {
+      return false;
+   }
+   PushBench();
+   return true;
+}
+
+static bool Report(void)
+{
+   const SchedStats_t *pStats = SchedGetStats();
+   const EventHandlerStats_t *pLow = &pStats->Prio[SCHED_PRIO_LOW];
+
+   if(!BenchStarted) {
+      return true;
+   }
+   printf("sched: slice %.0f us, %lu slices, longest %.0f us, overruns %lu\n",
+          pStats->SliceCycles * 1e6 / SIM_CORE_CLOCK,(unsigned long) pLow->Count,
+          pLow->MaxCycles * 1e6 / SIM_CORE_CLOCK,(unsigned long) pStats->Overruns);
+   printf("sched: event delay p99 %.0f us, max %.0f us\n",EventDispatchP99(&BenchLatency) * 1e6 / SIM_CORE_CLOCK,
+          BenchLatency.MaxLatency * 1e6 / SIM_CORE_CLOCK);
+   return true;
+}
+
+const Scenario_t SchedScenario = {"b:B:","-b jobs [-B slice us]",Option,Idle,Report};
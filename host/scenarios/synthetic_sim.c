@@ -0,0 +1,83 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -n pushes the given number of events, one million by default, of a
+// deterministic mix of mesh statuses, proxy and connection events. Runs when
+// no other scenario was selected.
+
+#include <stdlib.h>
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "mesh_generic_model_capi_types.h"
+#include "gateway_sim.h"
+
+/// Events pushed per call of the idle hook
+#define BATCH   64
+
+static uint64_t Target = 1000000;
+
+static void PushSynthetic(void)
+{
+   uint32_t r = ScenarioRandom() % 100;
+
+   if(r < 40) {
+      uint8_t Buf[sizeof(struct gecko_msg_mesh_generic_client_server_status_evt_t) + 1] = {0};
+      struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus = (void *) Buf;
+
+      // on/off status of one of 80 nodes
+      pStatus->model_id = MESH_GENERIC_ON_OFF_CLIENT_MODEL_ID;
+      pStatus->server_address = 1 + ScenarioRandom() % 80;
+      pStatus->type = mesh_generic_state_on_off;
+      pStatus->parameters.len = 1;
+      pStatus->parameters.data[0] = ScenarioRandom() & 1;
+      SimPushEvent(gecko_evt_mesh_generic_client_server_status_id,Buf,sizeof(Buf));
+   }
+   else if(r < 60) {
+      SimPushEvent(gecko_evt_le_gap_adv_timeout_id,NULL,0);
+   }
+   else if(r < 70) {
+      struct gecko_msg_mesh_proxy_connected_evt_t Conn = {ScenarioRandom() & 3};
+
+      SimPushEvent(gecko_evt_mesh_proxy_connected_id,&Conn,sizeof(Conn));
+   }
+   else if(r < 80) {
+      struct gecko_msg_mesh_proxy_disconnected_evt_t Disc = {ScenarioRandom() & 3,0x13};
+
+      SimPushEvent(gecko_evt_mesh_proxy_disconnected_id,&Disc,sizeof(Disc));
+   }
+   else if(r < 90) {
+      struct gecko_msg_le_connection_parameters_evt_t Params = {0,24,0,100,1,27};
+
+      SimPushEvent(gecko_evt_le_connection_parameters_id,&Params,sizeof(Params));
+   }
+   else {
+      SimPushEvent(gecko_evt_mesh_node_config_set_id,NULL,0);
+   }
+   ScenarioPushed++;
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   Target = strtoull(Arg,NULL,0);
+   return true;
+}
+
+static bool Idle(void)
+{
+   int i;
+
+   for(i = 0; i < BATCH && ScenarioPushed < Target; i++) {
+      PushSynthetic();
+   }
+   return true;
+}
+
+const Scenario_t SyntheticScenario = {"n:","[-n events] [-s seed]",Option,Idle,NULL};
@@ -0,0 +1,221 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -t arms the given number of timer wheel timers, measures the start/stop
+// cost and then runs them for TIMER_BENCH_SECONDS of virtual time. Every
+// expired single shot timer is restarted so the number of armed timers
+// stays the same. Now and then the main loop is kept busy for up to
+// TIMER_BENCH_STALL_TICKS wheel ticks, the wheel then catches up on them in
+// one soft timer event. The run fails if a timer expires before it is due or
+// more than one wheel tick after it, or after the stall it was due in, or if the start/stop cost with all
+// timers armed is more than TIMER_BENCH_FLAT times the cost with only
+// TIMER_BENCH_FEW of them armed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "native_gecko.h"
+#include "em_device.h"
+#include "sim_gecko.h"
+#include "timer_wheel.h"
+#include "event_dispatch.h"
+#include "gateway_sim.h"
+
+/// Virtual time the timer benchmark runs for
+#define TIMER_BENCH_SECONDS   120
+/// Longest timeout of the timer benchmark
+#define TIMER_BENCH_MAX_MS    60000
+/// Timers armed for the cost with few timers, restarts and runs per measurement
+#define TIMER_BENCH_FEW       10
+#define TIMER_BENCH_OPS       100000
+#define TIMER_BENCH_RUNS      3
+/// A stall of the main loop every so many idle calls on average, longest stall
+#define TIMER_BENCH_STALL_ODDS   100
+#define TIMER_BENCH_STALL_TICKS  5
+/// Allowed growth of the start/stop cost from few to all timers armed
+#define TIMER_BENCH_FLAT      3
+
+static uint32_t NumTimers;
+static Timer_t *Timers;
+/// RTCC count at which each timer is due
+static uint32_t *TimerDue;
+static uint32_t TimersLate;
+/// End of the last stall, timers due during it expire when it ends
+static uint32_t StallEnd;
+static bool TimersStarted;
+/// Cost of a stop and start with few and with all timers armed
+static uint32_t TimerFew;
+static double TimerFewNs;
+static double TimerOpNs;
+
+static double ElapsedNs(const struct timespec *pFrom)
+{
+   struct timespec Now;
+
+   clock_gettime(CLOCK_MONOTONIC,&Now);
+   return (Now.tv_sec - pFrom->tv_sec) * 1e9 + (Now.tv_nsec - pFrom->tv_nsec);
+}
+
+static void TimerExpired(Timer_t *pTimer);
+
+static void ArmTimer(uint32_t i)
+{
+   uint32_t Ms = 1 + ScenarioRandom() % TIMER_BENCH_MAX_MS;
+   uint32_t PeriodMs = (i & 7) == 0 ? Ms : 0;
+
+   TimerDue[i] = SimNow() + TIMER_MS_2_TIMERTICK(Ms);
+   TimerStart(&Timers[i],Ms,PeriodMs,TimerExpired,NULL);
+}
+
+static void TimerExpired(Timer_t *pTimer)
+{
+   uint32_t i = pTimer - Timers;
+   int32_t Late = SimNow() - TimerDue[i];
+
+   if((int32_t) (StallEnd - TimerDue[i]) > 0 && SimNow() == StallEnd) {
+      Late = 0;
+   }
+   if(Late > (int32_t) TIMER_WHEEL_TICK_RTCC || Late < 0) {
+      TimersLate++;
+   }
+   if(TimerIsArmed(pTimer)) {
+      // periodic, keeps its phase across a stall
+      TimerDue[i] += pTimer->Period * TIMER_WHEEL_TICK_RTCC;
+   }
+   else {
+      ArmTimer(i);
+   }
+}
+
+/// Cost of restarting random ones of the first Armed timers, the best of
+/// TIMER_BENCH_RUNS runs so a preempted run does not count
+static double RestartNs(uint32_t Armed)
+{
+   struct timespec From;
+   double Best = 0;
+   double Ns;
+   int Run;
+   uint32_t i;
+
+   for(Run = 0; Run < TIMER_BENCH_RUNS; Run++) {
+      clock_gettime(CLOCK_MONOTONIC,&From);
+      for(i = 0; i < TIMER_BENCH_OPS; i++) {
+         uint32_t j = ScenarioRandom() % Armed;
+
+         TimerStop(&Timers[j]);
+         ArmTimer(j);
+      }
+      Ns = ElapsedNs(&From) / TIMER_BENCH_OPS;
+      if(Run == 0 || Ns < Best) {
+         Best = Ns;
+      }
+   }
+   return Best;
+}
+
+/// Arms the timers and measures the cost of restarting them with few and
+/// with all of them armed
+static void StartTimerBench(void)
+{
+   uint32_t i;
+
+   Timers = calloc(NumTimers,sizeof(*Timers));
+   TimerDue = calloc(NumTimers,sizeof(*TimerDue));
+   TimerFew = NumTimers < TIMER_BENCH_FEW ? NumTimers : TIMER_BENCH_FEW;
+   for(i = 0; i < TimerFew; i++) {
+      ArmTimer(i);
+   }
+   TimerFewNs = RestartNs(TimerFew);
+
+   for(; i < NumTimers; i++) {
+      ArmTimer(i);
+   }
+   TimerOpNs = RestartNs(NumTimers);
+   TimersStarted = true;
+}
+
+static void StopTimerBench(void)
+{
+   uint32_t i;
+
+   for(i = 0; i < NumTimers; i++) {
+      TimerStop(&Timers[i]);
+   }
+   NumTimers = 0;
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   NumTimers = strtoul(Arg,NULL,0);
+   return true;
+}
+
+static bool Idle(void)
+{
+   if(!TimersStarted) {
+      if(NumTimers == 0) {
+         return false;
+      }
+      StartTimerBench();
+   }
+   else if(NumTimers != 0 && SimNow() >= TIMER_BENCH_SECONDS * SIM_TICKS_PER_SEC) {
+      StopTimerBench();
+   }
+   else if(NumTimers != 0 && ScenarioRandom() % TIMER_BENCH_STALL_ODDS == 0) {
+      // timers restarted while the wheel catches up must not expire early
+      SimAdvance((1 + ScenarioRandom() % TIMER_BENCH_STALL_TICKS) * TIMER_WHEEL_TICK_RTCC);
+      StallEnd = SimNow();
+   }
+   return true;
+}
+
+static bool Report(void)
+{
+   const TimerWheelStats_t *pStats = TimerWheelGetStats();
+   const EventHandlerStats_t *pTick = NULL;
+   const EventHandlerStats_t *pHandlers;
+   int Count;
+   int i;
+
+   if(!TimersStarted) {
+      return true;
+   }
+   pHandlers = EventDispatchGetStats(&Count);
+   for(i = 0; i < Count; i++) {
+      if(pHandlers[i].ID == gecko_evt_hardware_soft_timer_id) {
+         pTick = &pHandlers[i];
+      }
+   }
+
+   printf("timers: max armed %lu, ticks %lu, expired %lu, cascaded %lu, late %u\n",
+          (unsigned long) pStats->MaxArmed,(unsigned long) pStats->Ticks,(unsigned long) pStats->Expired,
+          (unsigned long) pStats->Cascaded,TimersLate);
+   printf("timers: %.0f ns per stop and start with %u armed, %.0f ns with %lu",TimerFewNs,TimerFew,TimerOpNs,
+          (unsigned long) pStats->MaxArmed);
+   if(pTick != NULL && pStats->Ticks != 0 && pStats->Expired != 0) {
+      printf(", %.0f ns per tick, %.0f ns per expiry",
+             (double) pTick->TotalCycles * 1e9 / SIM_CORE_CLOCK / pStats->Ticks,
+             (double) pTick->TotalCycles * 1e9 / SIM_CORE_CLOCK / pStats->Expired);
+   }
+   printf("\n");
+
+   if(TimersLate != 0) {
+      printf("timers: %u expiries early or late\n",TimersLate);
+      return false;
+   }
+   if(TimerOpNs > TIMER_BENCH_FLAT * TimerFewNs) {
+      printf("timers: stop and start cost grows with the number of armed timers\n");
+      return false;
+   }
+   return true;
+}
+
+const Scenario_t TimerScenario = {"t:","-t timers [-s seed]",Option,Idle,Report};
@@ -0,0 +1,193 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// -d pushes the given number of numbered on/off statuses while the event
+// trace recorder runs, only built with DARWIN_TRACE (build/gateway_sim_trace
+// records into the simulated flash). Then it dumps the trace as the trace
+// console command does and checks the stream captured from USART0: every
+// record must end before TRACE_END, the statuses must be the newest ones
+// pushed without a gap, and the oldest ones must have been overwritten when
+// more were pushed than flash and RAM hold. -D writes the dump to a file for
+// gateway_sim -r.
+
+#ifdef DARWIN_TRACE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "em_device.h"
+#include "native_gecko.h"
+#include "sim_gecko.h"
+#include "mesh_generic_model_capi_types.h"
+#include "darwin_trace.h"
+#include "gateway_sim.h"
+
+/// Events pushed per call of the idle hook
+#define BATCH   16
+
+/// Size of a pushed status, its record and what the recorder holds in bytes
+#define STATUS_LEN      (sizeof(struct gecko_msg_mesh_generic_client_server_status_evt_t) + 1)
+#define STATUS_WORDS    (2 + (STATUS_LEN + 3) / 4)
+#ifdef TRACE_FLASH_SIZE
+#define TRACE_BYTES     (TRACE_FLASH_SIZE + TRACE_RAM_WORDS * 4)
+#else
+#define TRACE_BYTES     (TRACE_RAM_WORDS * 4)
+#endif
+
+static uint32_t Target;
+static uint32_t Seq;
+static const char *Path;
+static bool DumpStarted;
+/// Dump stream captured from USART0
+static uint8_t *Dump;
+static uint32_t DumpLen;
+static uint32_t DumpSize;
+
+static void Capture(const uint8_t *pData,int Len)
+{
+   if(DumpLen + Len > DumpSize) {
+      DumpSize = 2 * (DumpLen + Len);
+      Dump = realloc(Dump,DumpSize);
+   }
+   memcpy(&Dump[DumpLen],pData,Len);
+   DumpLen += Len;
+}
+
+static void PushStatus(void)
+{
+   uint8_t Buf[STATUS_LEN] = {0};
+   struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus = (void *) Buf;
+
+   // the number goes where the application does not look at it
+   pStatus->model_id = MESH_GENERIC_ON_OFF_CLIENT_MODEL_ID;
+   pStatus->server_address = 1 + Seq % 80;
+   pStatus->remaining = Seq++;
+   pStatus->type = mesh_generic_state_on_off;
+   pStatus->parameters.len = 1;
+   pStatus->parameters.data[0] = Seq & 1;
+   SimPushEvent(gecko_evt_mesh_generic_client_server_status_id,Buf,sizeof(Buf));
+   ScenarioPushed++;
+}
+
+static bool Option(int Opt,const char *Arg)
+{
+   if(Opt == 'D') {
+      Path = Arg;
+   }
+   else {
+      Target = strtoul(Arg,NULL,0);
+   }
+   return true;
+}
+
+static bool Idle(void)
+{
+   TraceStatus_t Status;
+   int i;
+
+   if(Target == 0) {
+      return false;
+   }
+   TraceGetStatus(&Status);
+   if(Seq < Target) {
+      // events come slower than the main loop runs, it gets to move the
+      // RAM ring to flash in between
+      if(Status.RamUsed <= TRACE_RAM_WORDS * 2) {
+         for(i = 0; i < BATCH && Seq < Target; i++) {
+            PushStatus();
+         }
+         SimAdvance(1 + ScenarioRandom() % 100);
+      }
+   }
+   else if(!DumpStarted) {
+      DumpStarted = true;
+      SimUartSetTxHook(Capture);
+      TraceDump();
+   }
+   return true;
+}
+
+static bool Report(void)
+{
+   const uint32_t *pWords = (const uint32_t *) Dump;
+   uint32_t Words = DumpLen / 4;
+   uint32_t Pos = 3;
+   uint32_t Records = 0;
+   uint32_t Statuses = 0;
+   uint32_t Gaps = 0;
+   uint32_t Lost = 0;
+   uint32_t First = 0;
+   uint32_t Last = 0;
+   uint32_t Stamp = 0;
+   bool Ok;
+   FILE *f;
+
+   if(Target == 0) {
+      return true;
+   }
+   if(Words < 4 || pWords[0] != TRACE_MAGIC || pWords[1] != TRACE_VERSION || pWords[2] != SIM_TICKS_PER_SEC) {
+      printf("trace: dump of %u bytes has no valid header\n",DumpLen);
+      return false;
+   }
+   while(Pos < Words && pWords[Pos] != TRACE_END) {
+      uint32_t Header = pWords[Pos];
+
+      if(Pos + TRACE_RECORD_WORDS(Header) > Words) {
+         break;
+      }
+      if(Records++ != 0 && (int32_t) (pWords[Pos + 1] - Stamp) < 0) {
+         printf("trace: time stamp goes back at word %u\n",Pos);
+         return false;
+      }
+      Stamp = pWords[Pos + 1];
+      if(Header == TRACE_LOST) {
+         Lost += pWords[Pos + 2];
+      }
+      else if(BGLIB_MSG_ID(Header) == gecko_evt_mesh_generic_client_server_status_id) {
+         const struct gecko_msg_mesh_generic_client_server_status_evt_t *pStatus = (const void *) &pWords[Pos + 2];
+
+         if(Statuses++ == 0) {
+            First = pStatus->remaining;
+         }
+         else if(pStatus->remaining != Last + 1) {
+            Gaps++;
+         }
+         Last = pStatus->remaining;
+      }
+      Pos += TRACE_RECORD_WORDS(Header);
+   }
+
+   printf("trace: %u statuses pushed, %u records in %u bytes, statuses %u to %u, %u gaps, %u lost\n",Seq,
+          Records,DumpLen,First,Last,Gaps,Lost);
+   Ok = Pos == Words - 1 && Statuses != 0 && Last == Seq - 1 && Gaps == 0 && Lost == 0;
+   if(First == 0 && Seq * STATUS_WORDS * 4 > TRACE_BYTES) {
+      printf("trace: the oldest statuses were not overwritten\n");
+      Ok = false;
+   }
+   if(Pos != Words - 1) {
+      printf("trace: dump does not end after the record at word %u\n",Pos);
+   }
+
+   if(Path != NULL) {
+      f = fopen(Path,"wb");
+      if(f == NULL || fwrite(Dump,1,DumpLen,f) != DumpLen) {
+         perror(Path);
+         Ok = false;
+      }
+      if(f != NULL) {
+         fclose(f);
+      }
+   }
+   return Ok;
+}
+
+const Scenario_t TraceScenario = {"d:D:","-d events [-D trace.bin] [-s seed]",Option,Idle,Report};
+
+#endif   // DARWIN_TRACE
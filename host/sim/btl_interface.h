@@ -0,0 +1,60 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated Gecko bootloader application interface for the Linux host build.
+//
+// Storage slot 0 is SIM_SLOT_SIZE bytes of RAM. Erasing a page and writing
+// a word advance the virtual clock by the typical EFR32 flash timing. A
+// simulated image is valid when it ends with the CRC-32 of the bytes before
+// it, the check is done SIM_VERIFY_CHUNK bytes per continue call as the real
+// bootloader parses a GBL file.
+
+#ifndef _SIM_BTL_INTERFACE_H_
+#define _SIM_BTL_INTERFACE_H_
+
+#include <stdint.h>
+
+#define SIM_SLOT_SIZE                  (256 * 1024)
+#define SIM_FLASH_PAGE_SIZE            2048
+/// Page erase and word write time in us
+#define SIM_FLASH_ERASE_US             20000
+#define SIM_FLASH_WORD_US              10
+#define SIM_VERIFY_CHUNK               4096
+
+#define BOOTLOADER_OK                                 0
+#define BOOTLOADER_ERROR_STORAGE_INVALID_SLOT         0x0401
+#define BOOTLOADER_ERROR_STORAGE_INVALID_ADDRESS      0x0402
+#define BOOTLOADER_ERROR_STORAGE_NEEDS_ERASE          0x0403
+#define BOOTLOADER_ERROR_PARSE_FAILED                 0x1401
+#define BOOTLOADER_ERROR_PARSE_STORAGE                0x1402
+#define BOOTLOADER_ERROR_PARSE_CONTINUE               0x1403
+#define BOOTLOADER_ERROR_PARSE_SUCCESS                0x1404
+
+#define BOOTLOADER_STORAGE_VERIFICATION_CONTEXT_SIZE  384
+
+int32_t bootloader_init(void);
+
+/// Writes Length bytes at Address of the slot, the pages starting in the range are erased first
+int32_t bootloader_eraseWriteStorage(uint32_t SlotId,uint32_t Address,uint8_t *pBuffer,uint32_t Length);
+
+int32_t bootloader_initVerifyImage(uint32_t SlotId,void *pContext,uint32_t ContextSize);
+
+int32_t bootloader_continueVerifyImage(void *pContext,void *pMetadataCallback);
+
+int32_t bootloader_setImageToBootload(int32_t SlotId);
+
+/// Simulation: content of the slot and the bytes written since the start of the image
+const uint8_t *SimSlot(uint32_t *pLength);
+
+/// Simulation: slot set to be installed at the next reset, -1 if none
+int32_t SimSlotToBootload(void);
+
+#endif   // _SIM_BTL_INTERFACE_H_
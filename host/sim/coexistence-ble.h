@@ -0,0 +1,21 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated coexistence interface for the Linux host build
+
+#ifndef _SIM_COEXISTENCE_BLE_H_
+#define _SIM_COEXISTENCE_BLE_H_
+
+static inline void gecko_initCoexHAL(void)
+{
+}
+
+#endif   // _SIM_COEXISTENCE_BLE_H_
@@ -0,0 +1,47 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated device header for the Linux host build: core clock, flash and
+// the CMSIS intrinsics used by the application
+
+#ifndef _SIM_EM_DEVICE_H_
+#define _SIM_EM_DEVICE_H_
+
+#include <stdint.h>
+
+/// Core clock of the simulated EFR32, in Hz
+#define SIM_CORE_CLOCK   38400000UL
+
+/// Flash of the simulated EFR32, only the part written with em_msc.h is
+/// modeled. It is mapped at a fixed address so regions like TRACE_FLASH_BASE
+/// can be given as constants, as on the target.
+#define FLASH_PAGE_SIZE  2048
+#define SIM_FLASH_BASE   0x10000000UL
+#define SIM_FLASH_SIZE   (16 * FLASH_PAGE_SIZE)
+
+static inline uint32_t SystemCoreClockGet(void)
+{
+   return SIM_CORE_CLOCK;
+}
+
+static inline uint32_t __CLZ(uint32_t Value)
+{
+   return Value == 0 ? 32 : __builtin_clz(Value);
+}
+
+static inline uint32_t __REV(uint32_t Value)
+{
+   return __builtin_bswap32(Value);
+}
+
+#define __DMB()    __sync_synchronize()
+
+#endif   // _SIM_EM_DEVICE_H_
@@ -0,0 +1,33 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated flash controller for the Linux host build. Works on the flash
+// mapped at SIM_FLASH_BASE: an erased page reads as all ones and a write can
+// only clear bits, as on the target.
+
+#ifndef _SIM_EM_MSC_H_
+#define _SIM_EM_MSC_H_
+
+#include <stdint.h>
+#include "em_device.h"
+
+typedef enum {
+   mscReturnOk = 0,
+   mscReturnInvalidAddr = -1,
+   mscReturnUnaligned = -4,
+} MSC_Status_TypeDef;
+
+void MSC_Init(void);
+void MSC_Deinit(void);
+MSC_Status_TypeDef MSC_ErasePage(uint32_t *startAddress);
+MSC_Status_TypeDef MSC_WriteWord(uint32_t *address,void const *data,uint32_t numBytes);
+
+#endif   // _SIM_EM_MSC_H_
@@ -0,0 +1,24 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated RTCC for the Linux host build, counts the virtual clock
+
+#ifndef _SIM_EM_RTCC_H_
+#define _SIM_EM_RTCC_H_
+
+#include "sim_gecko.h"
+
+static inline uint32_t RTCC_CounterGet(void)
+{
+   return SimNow();
+}
+
+#endif   // _SIM_EM_RTCC_H_
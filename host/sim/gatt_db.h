@@ -0,0 +1,26 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated GATT database handles for the Linux host build
+
+#ifndef _SIM_GATT_DB_H_
+#define _SIM_GATT_DB_H_
+
+#define gattdb_device_name       3
+#define gattdb_ota_control       16
+#define gattdb_ota_data          18
+#define gattdb_event_latency     20
+#define gattdb_log_levels        22
+
+/// Number of attribute handles of the simulated database
+#define SIM_GATTDB_ATTRIBUTES    32
+
+#endif   // _SIM_GATT_DB_H_
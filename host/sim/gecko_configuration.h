@@ -0,0 +1,48 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated stack configuration for the Linux host build
+
+#ifndef _SIM_GECKO_CONFIGURATION_H_
+#define _SIM_GECKO_CONFIGURATION_H_
+
+#include <stdint.h>
+
+#define PACKSTRUCT(decl) decl __attribute__((__packed__))
+
+typedef struct {
+   uint8_t scan_min;
+   uint8_t scan_max;
+   uint8_t adv_min;
+   uint8_t adv_max;
+   uint8_t conn_min;
+   uint8_t conn_max;
+   uint8_t init_min;
+   uint8_t init_max;
+   uint8_t threshold_coex;
+   uint8_t rail_mapping_offset;
+   uint8_t rail_mapping_range;
+   uint8_t reserved;
+   uint8_t adv_step;
+   uint8_t scan_step;
+} gecko_bluetooth_ll_priorities;
+
+#define GECKO_BLUETOOTH_PRIORITIES_DEFAULT { 191, 143, 175, 127, 135, 0, 55, 15, 255, 16, 16, 0, 4, 4 }
+
+typedef struct {
+   struct {
+      gecko_bluetooth_ll_priorities *linklayer_priorities;
+   } bluetooth;
+   uint8_t max_connections;
+   uint8_t max_timers;
+} gecko_configuration_t;
+
+#endif   // _SIM_GECKO_CONFIGURATION_H_
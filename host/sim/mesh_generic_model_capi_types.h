@@ -0,0 +1,35 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Subset of the mesh generic model types used by the Linux host build
+
+#ifndef _SIM_MESH_GENERIC_MODEL_CAPI_TYPES_H_
+#define _SIM_MESH_GENERIC_MODEL_CAPI_TYPES_H_
+
+#define MESH_GENERIC_ON_OFF_CLIENT_MODEL_ID       0x1001
+#define MESH_LIGHTING_LIGHTNESS_CLIENT_MODEL_ID   0x1302
+#define MESH_LIGHTING_CTL_CLIENT_MODEL_ID         0x1305
+
+typedef enum {
+   mesh_generic_request_on_off = 0x00,
+   mesh_generic_request_level = 0x03,
+   mesh_lighting_request_lightness_actual = 0x80,
+   mesh_lighting_request_ctl = 0x84,
+} mesh_generic_request_t;
+
+typedef enum {
+   mesh_generic_state_on_off = 0x00,
+   mesh_generic_state_level = 0x02,
+   mesh_lighting_state_lightness_actual = 0x80,
+   mesh_lighting_state_ctl = 0x86,
+} mesh_generic_state_t;
+
+#endif   // _SIM_MESH_GENERIC_MODEL_CAPI_TYPES_H_
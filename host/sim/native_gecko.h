@@ -0,0 +1,455 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Simulated subset of the Silicon Labs BGAPI used by the gateway, for the
+// Linux host build. Types, field names and function signatures follow the
+// stack headers so the application compiles unchanged. Message IDs use the
+// BGAPI encoding (method << 24 | class << 16 | type), only what the
+// application needs is declared here.
+
+#ifndef _SIM_NATIVE_GECKO_H_
+#define _SIM_NATIVE_GECKO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gecko_configuration.h"
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t   int8;
+typedef int16_t  int16;
+typedef int32_t  int32;
+
+typedef struct {
+   uint8 addr[6];
+} bd_addr;
+
+typedef struct {
+   uint8 len;
+   uint8 data[];
+} uint8array;
+
+#define gecko_dev_type_gecko     0x20
+#define gecko_msg_type_cmd       0x00
+#define gecko_msg_type_rsp       0x00
+#define gecko_msg_type_evt       0x80
+
+#define BGLIB_MSG_ID(HDR)        ((HDR) & 0xffff00f8)
+#define BGLIB_MSG_LEN(HDR)       ((((HDR) & 0x7) << 8) | (((HDR) & 0xff00) >> 8))
+
+#define SIM_EVT_ID(Class,Method) (((uint32_t) (Method) << 24) | ((uint32_t) (Class) << 16) \
+                                  | gecko_msg_type_evt | gecko_dev_type_gecko)
+#define SIM_CMD_ID(Class,Method) (((uint32_t) (Method) << 24) | ((uint32_t) (Class) << 16) \
+                                  | gecko_msg_type_cmd | gecko_dev_type_gecko)
+
+/*******************************************************************************
+ * Error codes
+ ******************************************************************************/
+enum bg_error_spaces {
+   bg_errspc_hardware = 0x0000,
+   bg_errspc_bg = 0x0100,
+   bg_errspc_att = 0x0400,
+   bg_errspc_mesh = 0x0500,
+};
+
+typedef enum bg_error {
+   bg_err_success = 0,
+   bg_err_invalid_conn_handle = bg_errspc_bg + 0x01,
+   bg_err_out_of_memory = bg_errspc_bg + 0x02,
+   bg_err_not_implemented = bg_errspc_bg + 0x20,
+   bg_err_invalid_param = bg_errspc_bg + 0x21,
+   bg_err_wrong_state = bg_errspc_bg + 0x22,
+   bg_err_timeout = bg_errspc_bg + 0x30,
+   bg_err_not_found = bg_errspc_bg + 0x81,
+   bg_err_att_read_not_permitted = bg_errspc_att + 0x02,
+   bg_err_att_write_not_permitted = bg_errspc_att + 0x03,
+   bg_err_att_invalid_offset = bg_errspc_att + 0x07,
+   bg_err_att_invalid_att_length = bg_errspc_att + 0x0d,
+   bg_err_att_out_of_range = bg_errspc_att + 0xff,
+} bg_error;
+
+/// ATT opcodes of the user write requests
+enum gatt_att_opcode {
+   gatt_write_request = 0x12,
+   gatt_write_command = 0x52,
+};
+
+/*******************************************************************************
+ * Command IDs of the simulated commands
+ ******************************************************************************/
+#define gecko_cmd_system_reset_id                           SIM_CMD_ID(0x01,0x01)
+#define gecko_cmd_system_get_bt_address_id                  SIM_CMD_ID(0x01,0x03)
+#define gecko_cmd_system_linklayer_configure_id             SIM_CMD_ID(0x01,0x0e)
+#define gecko_cmd_le_connection_set_parameters_id           SIM_CMD_ID(0x08,0x00)
+#define gecko_cmd_le_connection_get_rssi_id                 SIM_CMD_ID(0x08,0x01)
+#define gecko_cmd_le_connection_set_phy_id                  SIM_CMD_ID(0x08,0x03)
+#define gecko_cmd_le_connection_close_id                    SIM_CMD_ID(0x08,0x04)
+#define gecko_cmd_gatt_set_max_mtu_id                       SIM_CMD_ID(0x09,0x00)
+#define gecko_cmd_gatt_server_write_attribute_value_id      SIM_CMD_ID(0x0a,0x02)
+#define gecko_cmd_gatt_server_send_user_read_response_id    SIM_CMD_ID(0x0a,0x03)
+#define gecko_cmd_gatt_server_send_user_write_response_id   SIM_CMD_ID(0x0a,0x04)
+#define gecko_cmd_hardware_set_soft_timer_id                SIM_CMD_ID(0x0c,0x00)
+#define gecko_cmd_flash_ps_erase_all_id                     SIM_CMD_ID(0x0d,0x01)
+#define gecko_cmd_flash_ps_save_id                          SIM_CMD_ID(0x0d,0x02)
+#define gecko_cmd_flash_ps_load_id                          SIM_CMD_ID(0x0d,0x03)
+#define gecko_cmd_flash_ps_erase_id                         SIM_CMD_ID(0x0d,0x04)
+#define gecko_cmd_mesh_node_init_id                         SIM_CMD_ID(0x14,0x00)
+#define gecko_cmd_mesh_node_start_unprov_beaconing_id       SIM_CMD_ID(0x14,0x01)
+#define gecko_cmd_mesh_generic_client_get_id                SIM_CMD_ID(0x1e,0x00)
+#define gecko_cmd_mesh_generic_client_set_id                SIM_CMD_ID(0x1e,0x01)
+#define gecko_cmd_mesh_generic_client_init_common_id        SIM_CMD_ID(0x1e,0x05)
+#define gecko_cmd_mesh_generic_client_init_on_off_id        SIM_CMD_ID(0x1e,0x06)
+#define gecko_cmd_mesh_generic_client_init_lightness_id     SIM_CMD_ID(0x1e,0x0e)
+#define gecko_cmd_mesh_generic_client_init_ctl_id           SIM_CMD_ID(0x1e,0x0f)
+#define gecko_cmd_mesh_scene_client_recall_id               SIM_CMD_ID(0x26,0x02)
+#define gecko_cmd_mesh_scene_client_init_id                 SIM_CMD_ID(0x26,0x05)
+
+/*******************************************************************************
+ * Event IDs
+ ******************************************************************************/
+#define gecko_evt_dfu_boot_id                               SIM_EVT_ID(0x00,0x00)
+#define gecko_evt_dfu_boot_failure_id                       SIM_EVT_ID(0x00,0x01)
+#define gecko_evt_system_boot_id                            SIM_EVT_ID(0x01,0x00)
+#define gecko_evt_system_external_signal_id                 SIM_EVT_ID(0x01,0x03)
+#define gecko_evt_system_awake_id                           SIM_EVT_ID(0x01,0x04)
+#define gecko_evt_system_hardware_error_id                  SIM_EVT_ID(0x01,0x05)
+#define gecko_evt_system_error_id                           SIM_EVT_ID(0x01,0x06)
+#define gecko_evt_le_gap_scan_response_id                   SIM_EVT_ID(0x03,0x00)
+#define gecko_evt_le_gap_adv_timeout_id                     SIM_EVT_ID(0x03,0x01)
+#define gecko_evt_le_gap_scan_request_id                    SIM_EVT_ID(0x03,0x02)
+#define gecko_evt_le_connection_opened_id                   SIM_EVT_ID(0x08,0x00)
+#define gecko_evt_le_connection_closed_id                   SIM_EVT_ID(0x08,0x01)
+#define gecko_evt_le_connection_parameters_id               SIM_EVT_ID(0x08,0x02)
+#define gecko_evt_le_connection_rssi_id                     SIM_EVT_ID(0x08,0x03)
+#define gecko_evt_le_connection_phy_status_id               SIM_EVT_ID(0x08,0x04)
+#define gecko_evt_gatt_mtu_exchanged_id                     SIM_EVT_ID(0x09,0x00)
+#define gecko_evt_gatt_service_id                           SIM_EVT_ID(0x09,0x01)
+#define gecko_evt_gatt_characteristic_id                    SIM_EVT_ID(0x09,0x02)
+#define gecko_evt_gatt_descriptor_id                        SIM_EVT_ID(0x09,0x03)
+#define gecko_evt_gatt_characteristic_value_id              SIM_EVT_ID(0x09,0x04)
+#define gecko_evt_gatt_descriptor_value_id                  SIM_EVT_ID(0x09,0x05)
+#define gecko_evt_gatt_procedure_completed_id               SIM_EVT_ID(0x09,0x06)
+#define gecko_evt_gatt_server_attribute_value_id            SIM_EVT_ID(0x0a,0x00)
+#define gecko_evt_gatt_server_user_read_request_id          SIM_EVT_ID(0x0a,0x01)
+#define gecko_evt_gatt_server_user_write_request_id         SIM_EVT_ID(0x0a,0x02)
+#define gecko_evt_gatt_server_characteristic_status_id      SIM_EVT_ID(0x0a,0x03)
+#define gecko_evt_gatt_server_execute_write_completed_id    SIM_EVT_ID(0x0a,0x04)
+#define gecko_evt_hardware_soft_timer_id                    SIM_EVT_ID(0x0c,0x00)
+#define gecko_evt_test_dtm_completed_id                     SIM_EVT_ID(0x0e,0x00)
+#define gecko_evt_sm_passkey_display_id                     SIM_EVT_ID(0x0f,0x00)
+#define gecko_evt_sm_passkey_request_id                     SIM_EVT_ID(0x0f,0x01)
+#define gecko_evt_sm_confirm_passkey_id                     SIM_EVT_ID(0x0f,0x02)
+#define gecko_evt_sm_bonded_id                              SIM_EVT_ID(0x0f,0x03)
+#define gecko_evt_sm_bonding_failed_id                      SIM_EVT_ID(0x0f,0x04)
+#define gecko_evt_sm_list_bonding_entry_id                  SIM_EVT_ID(0x0f,0x05)
+#define gecko_evt_sm_list_all_bondings_complete_id          SIM_EVT_ID(0x0f,0x06)
+#define gecko_evt_sm_confirm_bonding_id                     SIM_EVT_ID(0x0f,0x09)
+#define gecko_evt_mesh_node_initialized_id                  SIM_EVT_ID(0x14,0x00)
+#define gecko_evt_mesh_node_provisioned_id                  SIM_EVT_ID(0x14,0x01)
+#define gecko_evt_mesh_node_config_get_id                   SIM_EVT_ID(0x14,0x02)
+#define gecko_evt_mesh_node_config_set_id                   SIM_EVT_ID(0x14,0x03)
+#define gecko_evt_mesh_node_display_output_oob_id           SIM_EVT_ID(0x14,0x04)
+#define gecko_evt_mesh_node_input_oob_request_id            SIM_EVT_ID(0x14,0x05)
+#define gecko_evt_mesh_node_provisioning_started_id         SIM_EVT_ID(0x14,0x06)
+#define gecko_evt_mesh_node_provisioning_failed_id          SIM_EVT_ID(0x14,0x07)
+#define gecko_evt_mesh_node_key_added_id                    SIM_EVT_ID(0x14,0x08)
+#define gecko_evt_mesh_node_model_config_changed_id         SIM_EVT_ID(0x14,0x09)
+#define gecko_evt_mesh_node_reset_id                        SIM_EVT_ID(0x14,0x0a)
+#define gecko_evt_mesh_node_ivrecovery_needed_id            SIM_EVT_ID(0x14,0x0b)
+#define gecko_evt_mesh_node_changed_ivupdate_state_id       SIM_EVT_ID(0x14,0x0c)
+#define gecko_evt_mesh_node_static_oob_request_id           SIM_EVT_ID(0x14,0x0d)
+#define gecko_evt_mesh_node_key_removed_id                  SIM_EVT_ID(0x14,0x0e)
+#define gecko_evt_mesh_node_key_updated_id                  SIM_EVT_ID(0x14,0x0f)
+#define gecko_evt_mesh_node_heartbeat_id                    SIM_EVT_ID(0x14,0x10)
+#define gecko_evt_mesh_node_heartbeat_start_id              SIM_EVT_ID(0x14,0x11)
+#define gecko_evt_mesh_node_heartbeat_stop_id               SIM_EVT_ID(0x14,0x12)
+#define gecko_evt_mesh_proxy_connected_id                   SIM_EVT_ID(0x18,0x00)
+#define gecko_evt_mesh_proxy_disconnected_id                SIM_EVT_ID(0x18,0x01)
+#define gecko_evt_mesh_proxy_filter_status_id               SIM_EVT_ID(0x18,0x02)
+#define gecko_evt_mesh_generic_client_server_status_id      SIM_EVT_ID(0x1e,0x00)
+#define gecko_evt_mesh_lpn_friendship_established_id        SIM_EVT_ID(0x23,0x00)
+#define gecko_evt_mesh_lpn_friendship_failed_id             SIM_EVT_ID(0x23,0x01)
+#define gecko_evt_mesh_lpn_friendship_terminated_id         SIM_EVT_ID(0x23,0x02)
+#define gecko_evt_mesh_scene_client_status_id               SIM_EVT_ID(0x26,0x00)
+#define gecko_evt_mesh_scene_client_register_status_id      SIM_EVT_ID(0x26,0x01)
+#define gecko_evt_user_message_to_host_id                   SIM_EVT_ID(0xff,0x00)
+
+/*******************************************************************************
+ * Event payloads
+ ******************************************************************************/
+PACKSTRUCT(struct gecko_msg_system_boot_evt_t {
+   uint16 major;
+   uint16 minor;
+   uint16 patch;
+   uint16 build;
+   uint32 bootloader;
+   uint16 hw;
+   uint32 hash;
+});
+
+PACKSTRUCT(struct gecko_msg_system_external_signal_evt_t {
+   uint32 extsignals;
+});
+
+PACKSTRUCT(struct gecko_msg_le_connection_opened_evt_t {
+   bd_addr address;
+   uint8 address_type;
+   uint8 master;
+   uint8 connection;
+   uint8 bonding;
+   uint8 advertiser;
+});
+
+PACKSTRUCT(struct gecko_msg_le_connection_closed_evt_t {
+   uint16 reason;
+   uint8 connection;
+});
+
+PACKSTRUCT(struct gecko_msg_le_connection_parameters_evt_t {
+   uint8 connection;
+   uint16 interval;
+   uint16 latency;
+   uint16 timeout;
+   uint8 security_mode;
+   uint16 txsize;
+});
+
+PACKSTRUCT(struct gecko_msg_le_connection_phy_status_evt_t {
+   uint8 connection;
+   uint8 phy;
+});
+
+PACKSTRUCT(struct gecko_msg_le_connection_rssi_evt_t {
+   uint8 connection;
+   uint8 status;
+   int8 rssi;
+});
+
+PACKSTRUCT(struct gecko_msg_gatt_mtu_exchanged_evt_t {
+   uint8 connection;
+   uint16 mtu;
+});
+
+PACKSTRUCT(struct gecko_msg_gatt_server_attribute_value_evt_t {
+   uint8 connection;
+   uint16 attribute;
+   uint8 att_opcode;
+   uint16 offset;
+   uint8array value;
+});
+
+PACKSTRUCT(struct gecko_msg_gatt_server_user_read_request_evt_t {
+   uint8 connection;
+   uint16 characteristic;
+   uint8 att_opcode;
+   uint16 offset;
+});
+
+PACKSTRUCT(struct gecko_msg_gatt_server_user_write_request_evt_t {
+   uint8 connection;
+   uint16 characteristic;
+   uint8 att_opcode;
+   uint16 offset;
+   uint8array value;
+});
+
+PACKSTRUCT(struct gecko_msg_hardware_soft_timer_evt_t {
+   uint8 handle;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_node_initialized_evt_t {
+   uint8 provisioned;
+   uint16 address;
+   uint32 ivi;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_node_provisioned_evt_t {
+   uint32 iv_index;
+   uint16 address;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_node_provisioning_failed_evt_t {
+   uint16 result;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_node_key_added_evt_t {
+   uint8 type;
+   uint16 index;
+   uint16 netkey_index;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_generic_client_server_status_evt_t {
+   uint16 model_id;
+   uint16 elem_index;
+   uint16 client_address;
+   uint16 server_address;
+   uint32 remaining;
+   uint16 flags;
+   uint8 type;
+   uint8array parameters;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_scene_client_status_evt_t {
+   uint16 elem_index;
+   uint16 client_address;
+   uint16 server_address;
+   uint16 appkey_index;
+   uint8 status;
+   uint16 current_scene;
+   uint16 target_scene;
+   uint32 remaining_time;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_proxy_connected_evt_t {
+   uint32 handle;
+});
+
+PACKSTRUCT(struct gecko_msg_mesh_proxy_disconnected_evt_t {
+   uint32 handle;
+   uint16 reason;
+});
+
+/// Largest event payload of the simulation
+#define SIM_MAX_EVT_PAYLOAD  256
+
+struct gecko_cmd_packet {
+   uint32 header;
+   union {
+      struct gecko_msg_system_boot_evt_t evt_system_boot;
+      struct gecko_msg_system_external_signal_evt_t evt_system_external_signal;
+      struct gecko_msg_le_connection_opened_evt_t evt_le_connection_opened;
+      struct gecko_msg_le_connection_closed_evt_t evt_le_connection_closed;
+      struct gecko_msg_le_connection_parameters_evt_t evt_le_connection_parameters;
+      struct gecko_msg_le_connection_phy_status_evt_t evt_le_connection_phy_status;
+      struct gecko_msg_le_connection_rssi_evt_t evt_le_connection_rssi;
+      struct gecko_msg_gatt_mtu_exchanged_evt_t evt_gatt_mtu_exchanged;
+      struct gecko_msg_gatt_server_attribute_value_evt_t evt_gatt_server_attribute_value;
+      struct gecko_msg_gatt_server_user_read_request_evt_t evt_gatt_server_user_read_request;
+      struct gecko_msg_gatt_server_user_write_request_evt_t evt_gatt_server_user_write_request;
+      struct gecko_msg_hardware_soft_timer_evt_t evt_hardware_soft_timer;
+      struct gecko_msg_mesh_node_initialized_evt_t evt_mesh_node_initialized;
+      struct gecko_msg_mesh_node_provisioned_evt_t evt_mesh_node_provisioned;
+      struct gecko_msg_mesh_node_provisioning_failed_evt_t evt_mesh_node_provisioning_failed;
+      struct gecko_msg_mesh_node_key_added_evt_t evt_mesh_node_key_added;
+      struct gecko_msg_mesh_generic_client_server_status_evt_t evt_mesh_generic_client_server_status;
+      struct gecko_msg_mesh_scene_client_status_evt_t evt_mesh_scene_client_status;
+      struct gecko_msg_mesh_proxy_connected_evt_t evt_mesh_proxy_connected;
+      struct gecko_msg_mesh_proxy_disconnected_evt_t evt_mesh_proxy_disconnected;
+      uint8 payload[SIM_MAX_EVT_PAYLOAD];
+   } data;
+};
+
+/*******************************************************************************
+ * Command responses
+ ******************************************************************************/
+struct gecko_msg_result_rsp_t {
+   uint16 result;
+};
+
+struct gecko_msg_system_get_bt_address_rsp_t {
+   bd_addr address;
+};
+
+struct gecko_msg_system_linklayer_configure_rsp_t {
+   uint16 result;
+};
+
+struct gecko_msg_gatt_set_max_mtu_rsp_t {
+   uint16 result;
+   uint16 max_mtu;
+};
+
+struct gecko_msg_flash_ps_load_rsp_t {
+   uint16 result;
+   uint8array value;
+};
+
+/*******************************************************************************
+ * Stack
+ ******************************************************************************/
+void gecko_stack_init(const gecko_configuration_t *config);
+struct gecko_cmd_packet *gecko_peek_event(void);
+struct gecko_cmd_packet *gecko_wait_event(void);
+void gecko_external_signal(uint32 signals);
+
+void gecko_bgapi_class_dfu_init(void);
+void gecko_bgapi_class_system_init(void);
+void gecko_bgapi_class_le_gap_init(void);
+void gecko_bgapi_class_le_connection_init(void);
+void gecko_bgapi_class_gatt_init(void);
+void gecko_bgapi_class_gatt_server_init(void);
+void gecko_bgapi_class_hardware_init(void);
+void gecko_bgapi_class_flash_init(void);
+void gecko_bgapi_class_test_init(void);
+void gecko_bgapi_class_mesh_node_init(void);
+void gecko_bgapi_class_mesh_proxy_init(void);
+void gecko_bgapi_class_mesh_proxy_server_init(void);
+void gecko_bgapi_class_mesh_lpn_init(void);
+void gecko_bgapi_class_mesh_generic_client_init(void);
+void gecko_bgapi_class_mesh_scene_client_init(void);
+
+/*******************************************************************************
+ * Commands
+ ******************************************************************************/
+void gecko_cmd_system_reset(uint8 dfu);
+struct gecko_msg_system_get_bt_address_rsp_t *gecko_cmd_system_get_bt_address(void);
+struct gecko_msg_system_linklayer_configure_rsp_t *gecko_cmd_system_linklayer_configure(uint8 key,uint8 data_len,
+                                                                                       const uint8 *data_data);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_hardware_set_soft_timer(uint32 time,uint8 handle,uint8 single_shot);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_set_parameters(uint8 connection,uint16 min_interval,
+                                                                      uint16 max_interval,uint16 latency,
+                                                                      uint16 timeout);
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_set_phy(uint8 connection,uint8 phy);
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_get_rssi(uint8 connection);
+struct gecko_msg_gatt_set_max_mtu_rsp_t *gecko_cmd_gatt_set_max_mtu(uint16 max_mtu);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_close(uint8 connection);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_gatt_server_write_attribute_value(uint16 attribute,uint16 offset,
+                                                                           uint8 value_len,const uint8 *value_data);
+struct gecko_msg_result_rsp_t *gecko_cmd_gatt_server_send_user_read_response(uint8 connection,uint16 characteristic,
+                                                                              uint8 att_errorcode,uint8 value_len,
+                                                                              const uint8 *value_data);
+struct gecko_msg_result_rsp_t *gecko_cmd_gatt_server_send_user_write_response(uint8 connection,uint16 characteristic,
+                                                                               uint8 att_errorcode);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_flash_ps_erase_all(void);
+struct gecko_msg_result_rsp_t *gecko_cmd_flash_ps_save(uint16 key,uint8 value_len,const uint8 *value_data);
+struct gecko_msg_flash_ps_load_rsp_t *gecko_cmd_flash_ps_load(uint16 key);
+struct gecko_msg_result_rsp_t *gecko_cmd_flash_ps_erase(uint16 key);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_node_init(void);
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_node_start_unprov_beaconing(uint8 bearer);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_on_off(void);
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_lightness(void);
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_ctl(void);
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_common(void);
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_set(uint16 model_id,uint16 elem_index,uint16 server_address,
+                                                                 uint16 appkey_index,uint8 tid,uint32 transition,
+                                                                 uint16 delay,uint16 flags,uint8 type,
+                                                                 uint8 parameters_len,const uint8 *parameters_data);
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_get(uint16 model_id,uint16 elem_index,uint16 server_address,
+                                                                 uint16 appkey_index,uint8 type);
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_scene_client_init(uint16 elem_index);
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_scene_client_recall(uint16 server_address,uint16 elem_index,
+                                                                  uint16 selected_scene,uint16 appkey_index,
+                                                                  uint8 flags,uint8 tid,uint32 transition,
+                                                                  uint16 delay);
+
+#endif   // _SIM_NATIVE_GECKO_H_
@@ -0,0 +1,1049 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "native_gecko.h"
+#include "gatt_db.h"
+#include "em_device.h"
+#include "em_msc.h"
+#include "sim_gecko.h"
+#include "btl_interface.h"
+#include "uart_dma.h"
+
+/// Maximum number of simulated persistent store keys
+#define SIM_PS_KEYS        64
+/// Maximum size of a persistent store value
+#define SIM_PS_VALUE_SIZE  56
+/// Maximum size of a simulated GATT attribute
+#define SIM_ATTRIBUTE_SIZE 64
+
+/// Starts a command, the profile hook is called when the function returns
+#define SIM_CMD(Name)   SimCommand_t SimCommand __attribute__((cleanup(CommandDone))) = \
+                           {gecko_cmd_##Name##_id,"gecko_cmd_" #Name,SimCycleCount()}; \
+                        if(CommandHook != NULL) CommandHook(#Name)
+
+typedef struct {
+   uint32_t ID;
+   const char *Function;
+   uint32_t Start;
+} SimCommand_t;
+
+static struct gecko_cmd_packet Queue[SIM_QUEUE_SIZE];
+static uint32_t QueueHead;
+static uint32_t QueueTail;
+/// Event returned by the last gecko_peek_event() / gecko_wait_event()
+static struct gecko_cmd_packet Current;
+
+static uint32_t Now;
+static uint64_t EventCount;
+static uint32_t PendingSignals;
+static bool Replay;
+
+static struct {
+   bool Armed;
+   bool SingleShot;
+   uint8_t Handle;
+   uint32_t Period;
+   uint32_t Expiry;
+} Timers[SIM_MAX_TIMERS];
+
+static struct {
+   bool Used;
+   uint16_t Key;
+   uint8_t Len;
+   uint8_t Value[SIM_PS_VALUE_SIZE];
+} PsStore[SIM_PS_KEYS];
+
+static struct {
+   uint8_t Len;
+   uint8_t Value[SIM_ATTRIBUTE_SIZE];
+} Attributes[SIM_GATTDB_ATTRIBUTES];
+
+static void (*IdleHook)(void);
+static void (*DoneHook)(int ResetType);
+static void (*CommandHook)(const char *Name);
+static uint16_t (*MeshHook)(const SimMeshRequest_t *pRequest);
+static void (*WriteResponseHook)(uint16_t Characteristic,uint8_t Error);
+static void (*CommandProfileHook)(uint32_t ID,const char *Function,uint32_t Cycles);
+static int8_t Rssi = -60;
+
+static struct gecko_msg_result_rsp_t ResultRsp;
+static struct gecko_msg_gatt_set_max_mtu_rsp_t MaxMtuRsp;
+static struct gecko_msg_system_get_bt_address_rsp_t BtAddressRsp = {{{0x21,0x43,0x65,0x87,0x09,0x00}}};
+static struct gecko_msg_system_linklayer_configure_rsp_t LinkLayerRsp;
+/// Priority table the link layer arbitrates by, from the configuration or set at runtime
+static gecko_bluetooth_ll_priorities LinkLayerTable;
+static bool LinkLayerConfigured;
+static struct {
+   struct gecko_msg_flash_ps_load_rsp_t Rsp;
+   uint8_t Value[SIM_PS_VALUE_SIZE];
+} PsLoadRsp;
+
+/// Flash, see the end of the file
+static void FlashMap(void);
+
+/// USART0, see the end of the file
+static int UartFd = -1;
+static void UartPump(void);
+static void UartWait(uint32_t Ticks,bool Armed);
+
+/*******************************************************************************
+ * Simulation control
+ ******************************************************************************/
+bool SimPushEvent(uint32_t ID,const void *Data,int Len)
+{
+   struct gecko_cmd_packet *p;
+
+   if(QueueHead - QueueTail == SIM_QUEUE_SIZE || Len > SIM_MAX_EVT_PAYLOAD) {
+      return false;
+   }
+
+   p = &Queue[QueueHead % SIM_QUEUE_SIZE];
+   p->header = ID | ((Len & 0xff) << 8) | ((Len >> 8) & 0x7);
+   memcpy(p->data.payload,Data,Len);
+   QueueHead++;
+   return true;
+}
+
+/// Queues an event generated by the simulation itself, not in replay mode
+static void Generate(uint32_t ID,const void *Data,int Len)
+{
+   if(!Replay) {
+      SimPushEvent(ID,Data,Len);
+   }
+}
+
+int SimQueued(void)
+{
+   return QueueHead - QueueTail;
+}
+
+uint32_t SimNow(void)
+{
+   return Now;
+}
+
+static void ExpireTimers(void)
+{
+   int i;
+
+   for(i = 0; i < SIM_MAX_TIMERS; i++) {
+      if(Timers[i].Armed && (int32_t) (Now - Timers[i].Expiry) >= 0) {
+         struct gecko_msg_hardware_soft_timer_evt_t Evt = {Timers[i].Handle};
+
+         if(Timers[i].SingleShot) {
+            Timers[i].Armed = false;
+         }
+         else {
+            // one event for all the periods that passed, the clock must not
+            // go back to the ones missed
+            do {
+               Timers[i].Expiry += Timers[i].Period;
+            } while((int32_t) (Now - Timers[i].Expiry) >= 0);
+         }
+         Generate(gecko_evt_hardware_soft_timer_id,&Evt,sizeof(Evt));
+      }
+   }
+}
+
+void SimAdvance(uint32_t Ticks)
+{
+   Now += Ticks;
+   ExpireTimers();
+}
+
+uint32_t SimCycleCount(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return (uint32_t) (((uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec) * (SIM_CORE_CLOCK / 1000000) / 1000);
+}
+
+void SimSetIdleHook(void (*Hook)(void))
+{
+   IdleHook = Hook;
+}
+
+void SimSetDoneHook(void (*Hook)(int ResetType))
+{
+   DoneHook = Hook;
+}
+
+void SimSetReplay(bool Value)
+{
+   Replay = Value;
+}
+
+void SimSetCommandHook(void (*Hook)(const char *Name))
+{
+   CommandHook = Hook;
+}
+
+void SimSetCommandProfileHook(void (*Hook)(uint32_t ID,const char *Function,uint32_t Cycles))
+{
+   CommandProfileHook = Hook;
+}
+
+static void CommandDone(SimCommand_t *p)
+{
+   if(CommandProfileHook != NULL) {
+      CommandProfileHook(p->ID,p->Function,SimCycleCount() - p->Start);
+   }
+}
+
+void SimSetMeshHook(uint16_t (*Hook)(const SimMeshRequest_t *pRequest))
+{
+   MeshHook = Hook;
+}
+
+void SimSetWriteResponseHook(void (*Hook)(uint16_t Characteristic,uint8_t Error))
+{
+   WriteResponseHook = Hook;
+}
+
+void SimSetRssi(int8_t Value)
+{
+   Rssi = Value;
+}
+
+uint64_t SimEventCount(void)
+{
+   return EventCount;
+}
+
+int SimGattRead(uint16_t Attribute,uint8_t *Buf,int Size)
+{
+   int Len;
+
+   if(Attribute >= SIM_GATTDB_ATTRIBUTES) {
+      return 0;
+   }
+   Len = Attributes[Attribute].Len < Size ? Attributes[Attribute].Len : Size;
+   memcpy(Buf,Attributes[Attribute].Value,Len);
+   return Len;
+}
+
+static void Done(int ResetType)
+{
+   if(DoneHook != NULL) {
+      DoneHook(ResetType);
+   }
+   exit(0);
+}
+
+/*******************************************************************************
+ * Stack
+ ******************************************************************************/
+void gecko_stack_init(const gecko_configuration_t *config)
+{
+   struct gecko_msg_system_boot_evt_t Boot = {2,13,0,0,0,1,0};
+
+   FlashMap();
+   // the stack copies the table, later changes to it have no effect
+   if(config->bluetooth.linklayer_priorities != NULL) {
+      LinkLayerTable = *config->bluetooth.linklayer_priorities;
+      LinkLayerConfigured = true;
+   }
+   Generate(gecko_evt_system_boot_id,&Boot,sizeof(Boot));
+}
+
+static struct gecko_cmd_packet *NextEvent(void)
+{
+   if(PendingSignals != 0) {
+      struct gecko_msg_system_external_signal_evt_t Evt = {PendingSignals};
+
+      PendingSignals = 0;
+      Generate(gecko_evt_system_external_signal_id,&Evt,sizeof(Evt));
+   }
+
+   if(QueueHead == QueueTail) {
+      return NULL;
+   }
+
+   Current = Queue[QueueTail % SIM_QUEUE_SIZE];
+   QueueTail++;
+   EventCount++;
+   return &Current;
+}
+
+struct gecko_cmd_packet *gecko_peek_event(void)
+{
+   if(UartFd >= 0) {
+      UartPump();
+   }
+   if(QueueHead == QueueTail && PendingSignals == 0 && IdleHook != NULL) {
+      IdleHook();
+   }
+   return NextEvent();
+}
+
+struct gecko_cmd_packet *gecko_wait_event(void)
+{
+   struct gecko_cmd_packet *p;
+
+   while((p = NextEvent()) == NULL) {
+      uint32_t Next = 0;
+      bool Armed = false;
+      int i;
+
+      if(IdleHook != NULL) {
+         IdleHook();
+         if(QueueHead != QueueTail) {
+            continue;
+         }
+      }
+
+      // sleep until the next timer expires
+      for(i = 0; i < SIM_MAX_TIMERS; i++) {
+         if(Timers[i].Armed && (!Armed || (int32_t) (Timers[i].Expiry - Next) < 0)) {
+            Next = Timers[i].Expiry;
+            Armed = true;
+         }
+      }
+      if(UartFd >= 0) {
+         // real time, the timer expires while waiting for input
+         UartWait(Next - Now,Armed);
+         continue;
+      }
+      if(!Armed || Replay) {
+         Done(-1);
+      }
+      SimAdvance(Next - Now);
+   }
+   return p;
+}
+
+void gecko_external_signal(uint32 signals)
+{
+   PendingSignals |= signals;
+}
+
+void gecko_bgapi_class_dfu_init(void) {}
+void gecko_bgapi_class_system_init(void) {}
+void gecko_bgapi_class_le_gap_init(void) {}
+void gecko_bgapi_class_le_connection_init(void) {}
+void gecko_bgapi_class_gatt_init(void) {}
+void gecko_bgapi_class_gatt_server_init(void) {}
+void gecko_bgapi_class_hardware_init(void) {}
+void gecko_bgapi_class_flash_init(void) {}
+void gecko_bgapi_class_test_init(void) {}
+void gecko_bgapi_class_mesh_node_init(void) {}
+void gecko_bgapi_class_mesh_proxy_init(void) {}
+void gecko_bgapi_class_mesh_proxy_server_init(void) {}
+void gecko_bgapi_class_mesh_lpn_init(void) {}
+void gecko_bgapi_class_mesh_generic_client_init(void) {}
+void gecko_bgapi_class_mesh_scene_client_init(void) {}
+
+/// The mesh library passes every event on in the simulation
+bool mesh_bgapi_listener(struct gecko_cmd_packet *evt)
+{
+   return true;
+}
+
+/*******************************************************************************
+ * Commands
+ ******************************************************************************/
+static struct gecko_msg_result_rsp_t *Result(uint16 Result)
+{
+   ResultRsp.result = Result;
+   return &ResultRsp;
+}
+
+void gecko_cmd_system_reset(uint8 dfu)
+{
+   SIM_CMD(system_reset);
+   Done(dfu);
+}
+
+struct gecko_msg_system_get_bt_address_rsp_t *gecko_cmd_system_get_bt_address(void)
+{
+   SIM_CMD(system_get_bt_address);
+   return &BtAddressRsp;
+}
+
+struct gecko_msg_system_linklayer_configure_rsp_t *gecko_cmd_system_linklayer_configure(uint8 key,uint8 data_len,
+                                                                                       const uint8 *data_data)
+{
+   SIM_CMD(system_linklayer_configure);
+   // key 1 sets the priority table
+   if(key != 1 || data_len != sizeof(LinkLayerTable)) {
+      LinkLayerRsp.result = bg_err_invalid_param;
+      return &LinkLayerRsp;
+   }
+   memcpy(&LinkLayerTable,data_data,sizeof(LinkLayerTable));
+   LinkLayerConfigured = true;
+   LinkLayerRsp.result = bg_err_success;
+   return &LinkLayerRsp;
+}
+
+const gecko_bluetooth_ll_priorities *SimLinkLayerPriorities(void)
+{
+   return LinkLayerConfigured ? &LinkLayerTable : NULL;
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_hardware_set_soft_timer(uint32 time,uint8 handle,uint8 single_shot)
+{
+   int Free = -1;
+   int i;
+
+   SIM_CMD(hardware_set_soft_timer);
+   for(i = 0; i < SIM_MAX_TIMERS; i++) {
+      if(Timers[i].Armed && Timers[i].Handle == handle) {
+         break;
+      }
+      if(!Timers[i].Armed && Free < 0) {
+         Free = i;
+      }
+   }
+   if(i == SIM_MAX_TIMERS) {
+      if(time == 0) {
+         return Result(bg_err_success);
+      }
+      if(Free < 0) {
+         return Result(bg_err_out_of_memory);
+      }
+      i = Free;
+   }
+
+   Timers[i].Armed = time != 0;
+   Timers[i].SingleShot = single_shot;
+   Timers[i].Handle = handle;
+   Timers[i].Period = time;
+   Timers[i].Expiry = Now + time;
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_close(uint8 connection)
+{
+   struct gecko_msg_le_connection_closed_evt_t Evt = {0x0216,connection};
+
+   SIM_CMD(le_connection_close);
+   Generate(gecko_evt_le_connection_closed_id,&Evt,sizeof(Evt));
+   return Result(bg_err_success);
+}
+
+/// The peer accepts the parameters at once
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_set_parameters(uint8 connection,uint16 min_interval,
+                                                                      uint16 max_interval,uint16 latency,
+                                                                      uint16 timeout)
+{
+   struct gecko_msg_le_connection_parameters_evt_t Evt = {connection,max_interval,latency,timeout,0,27};
+
+   SIM_CMD(le_connection_set_parameters);
+   Generate(gecko_evt_le_connection_parameters_id,&Evt,sizeof(Evt));
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_set_phy(uint8 connection,uint8 phy)
+{
+   struct gecko_msg_le_connection_phy_status_evt_t Evt = {connection,phy};
+
+   SIM_CMD(le_connection_set_phy);
+   Generate(gecko_evt_le_connection_phy_status_id,&Evt,sizeof(Evt));
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_le_connection_get_rssi(uint8 connection)
+{
+   struct gecko_msg_le_connection_rssi_evt_t Evt = {connection,0,Rssi};
+
+   SIM_CMD(le_connection_get_rssi);
+   Generate(gecko_evt_le_connection_rssi_id,&Evt,sizeof(Evt));
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_gatt_set_max_mtu_rsp_t *gecko_cmd_gatt_set_max_mtu(uint16 max_mtu)
+{
+   SIM_CMD(gatt_set_max_mtu);
+   MaxMtuRsp.result = bg_err_success;
+   MaxMtuRsp.max_mtu = max_mtu;
+   return &MaxMtuRsp;
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_gatt_server_write_attribute_value(uint16 attribute,uint16 offset,
+                                                                           uint8 value_len,const uint8 *value_data)
+{
+   SIM_CMD(gatt_server_write_attribute_value);
+   if(attribute >= SIM_GATTDB_ATTRIBUTES || offset + value_len > SIM_ATTRIBUTE_SIZE) {
+      return Result(bg_err_att_invalid_att_length);
+   }
+   memcpy(&Attributes[attribute].Value[offset],value_data,value_len);
+   Attributes[attribute].Len = offset + value_len;
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_gatt_server_send_user_read_response(uint8 connection,uint16 characteristic,
+                                                                              uint8 att_errorcode,uint8 value_len,
+                                                                              const uint8 *value_data)
+{
+   SIM_CMD(gatt_server_send_user_read_response);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_gatt_server_send_user_write_response(uint8 connection,uint16 characteristic,
+                                                                               uint8 att_errorcode)
+{
+   SIM_CMD(gatt_server_send_user_write_response);
+   if(WriteResponseHook != NULL) {
+      WriteResponseHook(characteristic,att_errorcode);
+   }
+   return Result(bg_err_success);
+}
+
+static int PsFind(uint16 key)
+{
+   int i;
+
+   for(i = 0; i < SIM_PS_KEYS; i++) {
+      if(PsStore[i].Used && PsStore[i].Key == key) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_flash_ps_erase_all(void)
+{
+   SIM_CMD(flash_ps_erase_all);
+   memset(PsStore,0,sizeof(PsStore));
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_flash_ps_save(uint16 key,uint8 value_len,const uint8 *value_data)
+{
+   int i = PsFind(key);
+
+   SIM_CMD(flash_ps_save);
+   if(value_len > SIM_PS_VALUE_SIZE) {
+      return Result(bg_err_invalid_param);
+   }
+   if(i < 0) {
+      for(i = 0; i < SIM_PS_KEYS && PsStore[i].Used; i++);
+      if(i == SIM_PS_KEYS) {
+         return Result(bg_err_out_of_memory);
+      }
+   }
+   PsStore[i].Used = true;
+   PsStore[i].Key = key;
+   PsStore[i].Len = value_len;
+   memcpy(PsStore[i].Value,value_data,value_len);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_flash_ps_load_rsp_t *gecko_cmd_flash_ps_load(uint16 key)
+{
+   int i = PsFind(key);
+
+   SIM_CMD(flash_ps_load);
+   if(i < 0) {
+      PsLoadRsp.Rsp.result = bg_err_not_found;
+      PsLoadRsp.Rsp.value.len = 0;
+   }
+   else {
+      PsLoadRsp.Rsp.result = bg_err_success;
+      PsLoadRsp.Rsp.value.len = PsStore[i].Len;
+      memcpy(PsLoadRsp.Rsp.value.data,PsStore[i].Value,PsStore[i].Len);
+   }
+   return &PsLoadRsp.Rsp;
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_flash_ps_erase(uint16 key)
+{
+   int i = PsFind(key);
+
+   SIM_CMD(flash_ps_erase);
+   if(i < 0) {
+      return Result(bg_err_not_found);
+   }
+   PsStore[i].Used = false;
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_node_init(void)
+{
+   struct gecko_msg_mesh_node_initialized_evt_t Evt = {1,0x0001,0};
+
+   SIM_CMD(mesh_node_init);
+   Generate(gecko_evt_mesh_node_initialized_id,&Evt,sizeof(Evt));
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_node_start_unprov_beaconing(uint8 bearer)
+{
+   SIM_CMD(mesh_node_start_unprov_beaconing);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_on_off(void)
+{
+   SIM_CMD(mesh_generic_client_init_on_off);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_lightness(void)
+{
+   SIM_CMD(mesh_generic_client_init_lightness);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_ctl(void)
+{
+   SIM_CMD(mesh_generic_client_init_ctl);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_init_common(void)
+{
+   SIM_CMD(mesh_generic_client_init_common);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_set(uint16 model_id,uint16 elem_index,uint16 server_address,
+                                                                 uint16 appkey_index,uint8 tid,uint32 transition,
+                                                                 uint16 delay,uint16 flags,uint8 type,
+                                                                 uint8 parameters_len,const uint8 *parameters_data)
+{
+   SimMeshRequest_t Request = {model_id,server_address,tid,flags,type,0,parameters_len,parameters_data};
+
+   SIM_CMD(mesh_generic_client_set);
+   return Result(MeshHook != NULL ? MeshHook(&Request) : bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_generic_client_get(uint16 model_id,uint16 elem_index,uint16 server_address,
+                                                                 uint16 appkey_index,uint8 type)
+{
+   SimMeshRequest_t Request = {model_id,server_address,0,1,type,0,0,NULL,true};
+
+   SIM_CMD(mesh_generic_client_get);
+   return Result(MeshHook != NULL ? MeshHook(&Request) : bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_scene_client_init(uint16 elem_index)
+{
+   SIM_CMD(mesh_scene_client_init);
+   return Result(bg_err_success);
+}
+
+struct gecko_msg_result_rsp_t *gecko_cmd_mesh_scene_client_recall(uint16 server_address,uint16 elem_index,
+                                                                  uint16 selected_scene,uint16 appkey_index,
+                                                                  uint8 flags,uint8 tid,uint32 transition,
+                                                                  uint16 delay)
+{
+   SimMeshRequest_t Request = {0,server_address,tid,flags,0,selected_scene,0,NULL};
+
+   SIM_CMD(mesh_scene_client_recall);
+   return Result(MeshHook != NULL ? MeshHook(&Request) : bg_err_success);
+}
+
+/*******************************************************************************
+ * Bootloader
+ ******************************************************************************/
+static uint8_t Slot[SIM_SLOT_SIZE];
+/// End of the image written to the slot
+static uint32_t SlotLength;
+static int32_t SlotToBootload = -1;
+/// Flash time not yet added to the virtual clock
+static uint32_t FlashUs;
+
+typedef struct {
+   uint32_t Offset;
+   uint32_t Crc;
+} Verify_t;
+
+/// Blocks for the flash operation
+static void FlashBusy(uint32_t Us)
+{
+   uint32_t Ticks;
+
+   FlashUs += Us;
+   Ticks = (uint32_t) ((uint64_t) FlashUs * SIM_TICKS_PER_SEC / 1000000);
+   if(Ticks != 0) {
+      FlashUs -= (uint32_t) ((uint64_t) Ticks * 1000000 / SIM_TICKS_PER_SEC);
+      SimAdvance(Ticks);
+   }
+}
+
+static uint32_t Crc32(uint32_t Crc,const uint8_t *p,uint32_t Len)
+{
+   int i;
+
+   while(Len-- > 0) {
+      Crc ^= *p++;
+      for(i = 0; i < 8; i++) {
+         Crc = (Crc >> 1) ^ (0xedb88320 & -(Crc & 1));
+      }
+   }
+   return Crc;
+}
+
+const uint8_t *SimSlot(uint32_t *pLength)
+{
+   *pLength = SlotLength;
+   return Slot;
+}
+
+int32_t SimSlotToBootload(void)
+{
+   return SlotToBootload;
+}
+
+int32_t bootloader_init(void)
+{
+   return BOOTLOADER_OK;
+}
+
+int32_t bootloader_eraseWriteStorage(uint32_t SlotId,uint32_t Address,uint8_t *pBuffer,uint32_t Length)
+{
+   uint32_t Page;
+   uint32_t i;
+
+   if(SlotId != 0) {
+      return BOOTLOADER_ERROR_STORAGE_INVALID_SLOT;
+   }
+   if(Address > SIM_SLOT_SIZE || Length > SIM_SLOT_SIZE - Address) {
+      return BOOTLOADER_ERROR_STORAGE_INVALID_ADDRESS;
+   }
+
+   for(Page = (Address + SIM_FLASH_PAGE_SIZE - 1) / SIM_FLASH_PAGE_SIZE * SIM_FLASH_PAGE_SIZE;
+       Page < Address + Length; Page += SIM_FLASH_PAGE_SIZE) {
+      memset(&Slot[Page],0xff,SIM_FLASH_PAGE_SIZE);
+      FlashBusy(SIM_FLASH_ERASE_US);
+   }
+   for(i = 0; i < Length; i++) {
+      // flash bits only go from 1 to 0
+      if((Slot[Address + i] & pBuffer[i]) != pBuffer[i]) {
+         return BOOTLOADER_ERROR_STORAGE_NEEDS_ERASE;
+      }
+      Slot[Address + i] = pBuffer[i];
+   }
+   FlashBusy((Length + 3) / 4 * SIM_FLASH_WORD_US);
+
+   if(Address == 0) {
+      SlotLength = 0;
+   }
+   if(Address + Length > SlotLength) {
+      SlotLength = Address + Length;
+   }
+   return BOOTLOADER_OK;
+}
+
+int32_t bootloader_initVerifyImage(uint32_t SlotId,void *pContext,uint32_t ContextSize)
+{
+   Verify_t *p = pContext;
+
+   if(SlotId != 0) {
+      return BOOTLOADER_ERROR_STORAGE_INVALID_SLOT;
+   }
+   if(ContextSize < sizeof(Verify_t)) {
+      return BOOTLOADER_ERROR_PARSE_STORAGE;
+   }
+   p->Offset = 0;
+   p->Crc = 0xffffffff;
+   return BOOTLOADER_OK;
+}
+
+int32_t bootloader_continueVerifyImage(void *pContext,void *pMetadataCallback)
+{
+   Verify_t *p = pContext;
+   uint32_t End;
+   uint32_t Len;
+   uint32_t Crc;
+
+   if(SlotLength <= 4) {
+      return BOOTLOADER_ERROR_PARSE_FAILED;
+   }
+   End = SlotLength - 4;
+   Len = End - p->Offset < SIM_VERIFY_CHUNK ? End - p->Offset : SIM_VERIFY_CHUNK;
+   p->Crc = Crc32(p->Crc,&Slot[p->Offset],Len);
+   p->Offset += Len;
+   if(p->Offset < End) {
+      return BOOTLOADER_ERROR_PARSE_CONTINUE;
+   }
+   Crc = Slot[End] | (Slot[End + 1] << 8) | (Slot[End + 2] << 16) | ((uint32_t) Slot[End + 3] << 24);
+   return (p->Crc ^ 0xffffffff) == Crc ? BOOTLOADER_ERROR_PARSE_SUCCESS : BOOTLOADER_ERROR_PARSE_FAILED;
+}
+
+int32_t bootloader_setImageToBootload(int32_t SlotId)
+{
+   if(SlotId != 0) {
+      return BOOTLOADER_ERROR_STORAGE_INVALID_SLOT;
+   }
+   SlotToBootload = SlotId;
+   return BOOTLOADER_OK;
+}
+
+/*******************************************************************************
+ * Flash
+ ******************************************************************************/
+static uint32_t *const Flash = (uint32_t *) SIM_FLASH_BASE;
+
+/// Maps the erased flash before the application can read it
+static void FlashMap(void)
+{
+   static bool Mapped;
+
+   if(!Mapped) {
+      void *p = mmap(Flash,SIM_FLASH_SIZE,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                     -1,0);
+
+      if(p != Flash) {
+         fprintf(stderr,"cannot map the simulated flash at 0x%lx\n",SIM_FLASH_BASE);
+         exit(1);
+      }
+      memset(Flash,0xff,SIM_FLASH_SIZE);
+      Mapped = true;
+   }
+}
+
+/// Index of the word at Address in the flash, -1 if it is not in it
+static int32_t FlashIndex(const uint32_t *Address,uint32_t Bytes)
+{
+   uintptr_t Offset = (uintptr_t) Address - SIM_FLASH_BASE;
+
+   if((uintptr_t) Address < SIM_FLASH_BASE || Offset + Bytes > SIM_FLASH_SIZE) {
+      return -1;
+   }
+   return Offset / 4;
+}
+
+void MSC_Init(void)
+{
+   FlashMap();
+}
+
+void MSC_Deinit(void) {}
+
+MSC_Status_TypeDef MSC_ErasePage(uint32_t *startAddress)
+{
+   int32_t i = FlashIndex(startAddress,FLASH_PAGE_SIZE);
+
+   if(i < 0) {
+      return mscReturnInvalidAddr;
+   }
+   if(((uintptr_t) startAddress % FLASH_PAGE_SIZE) != 0) {
+      return mscReturnUnaligned;
+   }
+   memset(&Flash[i],0xff,FLASH_PAGE_SIZE);
+   return mscReturnOk;
+}
+
+MSC_Status_TypeDef MSC_WriteWord(uint32_t *address,void const *data,uint32_t numBytes)
+{
+   int32_t i = FlashIndex(address,numBytes);
+   uint32_t j;
+
+   if(i < 0) {
+      return mscReturnInvalidAddr;
+   }
+   if(((uintptr_t) address % 4) != 0 || (numBytes % 4) != 0) {
+      return mscReturnUnaligned;
+   }
+   for(j = 0; j < numBytes / 4; j++) {
+      uint32_t Word;
+
+      // programming only clears bits
+      memcpy(&Word,(const uint8_t *) data + j * 4,4);
+      Flash[i + j] &= Word;
+   }
+   return mscReturnOk;
+}
+
+/*******************************************************************************
+ * USART0
+ ******************************************************************************/
+static uint32_t UartBaudrate;
+static bool UartBaudrateSet;
+static void (*UartRxCallback)(void);
+static uint8_t UartTx[UART_DMA_TX_SIZE];
+static int UartTxLen;
+static uint32_t UartTxDropped;
+static void (*UartTxHook)(const uint8_t *pData,int Len);
+static uint8_t UartRx[UART_DMA_RX_SIZE];
+static int UartRxLen;
+/// Bytes the line can carry now in each direction, refilled as time passes
+static double UartTxBudget;
+static double UartRxBudget;
+/// Wall clock and virtual clock when the UART was attached, wall clock of the last refill
+static uint64_t UartStartNs;
+static uint32_t UartStartTicks;
+static uint64_t UartLastNs;
+
+static uint64_t WallNs(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Moves the virtual clock to the wall clock and refills the line budgets
+static void UartFollowWallClock(void)
+{
+   uint64_t NowNs = WallNs();
+   uint32_t Ticks = UartStartTicks + (uint32_t) ((NowNs - UartStartNs) * SIM_TICKS_PER_SEC / 1000000000ULL);
+
+   if((int32_t) (Ticks - Now) > 0) {
+      SimAdvance(Ticks - Now);
+   }
+   if(UartBaudrate != 0) {
+      // 10 bit times per byte
+      double Bytes = (NowNs - UartLastNs) * 1e-9 * UartBaudrate / 10;
+
+      UartTxBudget = UartTxBudget + Bytes < UART_DMA_TX_SIZE ? UartTxBudget + Bytes : UART_DMA_TX_SIZE;
+      UartRxBudget = UartRxBudget + Bytes < UART_DMA_RX_SIZE ? UartRxBudget + Bytes : UART_DMA_RX_SIZE;
+   }
+   UartLastNs = NowNs;
+}
+
+/// Bytes the line can carry out of Len
+static int UartLimit(double *pBudget,int Len)
+{
+   if(UartBaudrate != 0 && Len > (int) *pBudget) {
+      Len = (int) *pBudget;
+   }
+   return Len;
+}
+
+/// Sends what the line allows and reads what fits into the receive ring
+static void UartPump(void)
+{
+   int Len;
+
+   UartFollowWallClock();
+
+   Len = UartLimit(&UartTxBudget,UartTxLen);
+   if(Len > 0 && (Len = write(UartFd,UartTx,Len)) > 0) {
+      UartTxLen -= Len;
+      UartTxBudget -= Len;
+      memmove(UartTx,&UartTx[Len],UartTxLen);
+   }
+
+   Len = UartLimit(&UartRxBudget,UART_DMA_RX_SIZE - UartRxLen);
+   if(Len > 0 && (Len = read(UartFd,&UartRx[UartRxLen],Len)) > 0) {
+      UartRxLen += Len;
+      UartRxBudget -= Len;
+      if(UartRxCallback != NULL) {
+         UartRxCallback();
+      }
+   }
+}
+
+/// Waits up to Ticks, or without a limit if no timer is armed, for input
+static void UartWait(uint32_t Ticks,bool Armed)
+{
+   struct pollfd Poll = {UartFd,UartRxLen < UART_DMA_RX_SIZE ? POLLIN : 0,0};
+   int TimeoutMs = Armed ? (int) (((uint64_t) Ticks * 1000 + SIM_TICKS_PER_SEC - 1) / SIM_TICKS_PER_SEC) : -1;
+
+   if(UartBaudrate != 0 && (UartTxLen != 0 || UartRxBudget < 1)) {
+      // the line is the limit, come back when it has moved some bytes
+      TimeoutMs = TimeoutMs >= 0 && TimeoutMs < 1 ? TimeoutMs : 1;
+   }
+   poll(&Poll,1,TimeoutMs);
+   UartPump();
+}
+
+void SimUartAttach(int Fd)
+{
+   UartFd = Fd;
+   UartStartNs = UartLastNs = WallNs();
+   UartStartTicks = Now;
+}
+
+void SimUartSetBaudrate(uint32_t Baudrate)
+{
+   UartBaudrate = Baudrate;
+   UartBaudrateSet = true;
+}
+
+void SimUartSetTxHook(void (*Hook)(const uint8_t *pData,int Len))
+{
+   UartTxHook = Hook;
+}
+
+void UartDmaInit(uint32_t Baudrate)
+{
+   if(!UartBaudrateSet) {
+      UartBaudrate = Baudrate;
+   }
+}
+
+int UartDmaWrite(const void *Data,int Len)
+{
+   if(Len > UART_DMA_TX_SIZE - UartTxLen) {
+      UartTxDropped += Len - (UART_DMA_TX_SIZE - UartTxLen);
+      Len = UART_DMA_TX_SIZE - UartTxLen;
+   }
+   memcpy(&UartTx[UartTxLen],Data,Len);
+   UartTxLen += Len;
+   return Len;
+}
+
+int UartDmaTxFree(void)
+{
+   return UART_DMA_TX_SIZE - UartTxLen;
+}
+
+void UartDmaPoll(void)
+{
+   if(UartFd >= 0) {
+      UartPump();
+   }
+   else {
+      // nobody listens, unless the workload captures it
+      if(UartTxHook != NULL && UartTxLen != 0) {
+         UartTxHook(UartTx,UartTxLen);
+      }
+      UartTxLen = 0;
+   }
+}
+
+uint32_t UartDmaTxDropped(void)
+{
+   return UartTxDropped;
+}
+
+void UartDmaSetRxCallback(void (*Callback)(void))
+{
+   UartRxCallback = Callback;
+}
+
+int UartDmaRxAvailable(void)
+{
+   return UartRxLen;
+}
+
+int UartDmaRead(void *Buf,int Len)
+{
+   if(Len > UartRxLen) {
+      Len = UartRxLen;
+   }
+   memcpy(Buf,UartRx,Len);
+   UartDmaRxConsume(Len);
+   return Len;
+}
+
+const uint8_t *UartDmaRxPeek(int Len)
+{
+   // the simulated ring never wraps
+   return Len <= UartRxLen && Len <= UART_DMA_RX_SPILL ? UartRx : NULL;
+}
+
+void UartDmaRxConsume(int Len)
+{
+   UartRxLen -= Len;
+   memmove(UartRx,&UartRx[Len],UartRxLen);
+}
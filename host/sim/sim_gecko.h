@@ -0,0 +1,127 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Control interface of the simulated stack used by the Linux host build.
+//
+// Time is virtual: it only moves when the event queue is empty and the
+// simulation jumps to the next soft timer expiry, so runs are deterministic
+// and as fast as the host allows. The idle hook is called whenever the
+// queue runs empty and lets a workload inject the next events; when it adds
+// nothing and no timer is armed the done hook is called and the program
+// exits.
+//
+// USART0 of uart_dma.h can be attached to a file descriptor, e.g. the master
+// of a pseudo terminal. Then the virtual clock follows the wall clock, the
+// simulation waits for input when it has nothing to do instead of exiting,
+// and the line rate of the UART is modeled in both directions.
+// Without a descriptor a workload can capture what the application sends.
+//
+// The flash written with em_msc.h is mapped at SIM_FLASH_BASE (see
+// em_device.h), erased when the stack is initialized.
+
+#ifndef _SIM_GECKO_H_
+#define _SIM_GECKO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gecko_configuration.h"
+
+/// Ticks of the virtual clock per second, same as the RTCC / soft timers
+#define SIM_TICKS_PER_SEC     32768
+
+/// Maximum number of queued events
+#ifndef SIM_QUEUE_SIZE
+#define SIM_QUEUE_SIZE        256
+#endif
+
+/// Maximum number of armed soft timers
+#ifndef SIM_MAX_TIMERS
+#define SIM_MAX_TIMERS        16
+#endif
+
+/// Queue an event, Len bytes of Data are copied into the payload
+bool SimPushEvent(uint32_t ID,const void *Data,int Len);
+
+/// Number of events waiting in the queue
+int SimQueued(void);
+
+/// Virtual clock in ticks
+uint32_t SimNow(void);
+
+/// Advance the virtual clock, expired soft timers are queued
+void SimAdvance(uint32_t Ticks);
+
+/// Cycle counter of the host build, host time scaled to the simulated core clock
+uint32_t SimCycleCount(void);
+
+/// Called when the application polls or waits and the queue is empty, may
+/// push more events
+void SimSetIdleHook(void (*Hook)(void));
+
+/// Called before the program exits because there is nothing left to do or
+/// the application reset the device
+void SimSetDoneHook(void (*Hook)(int ResetType));
+
+/// Called for every command the application sends, e.g. to count or answer them
+void SimSetCommandHook(void (*Hook)(const char *Name));
+
+/// Called when a command returns with the cycles it took, as the command
+/// handler delegate of the stack does on the target
+void SimSetCommandProfileHook(void (*Hook)(uint32_t ID,const char *Function,uint32_t Cycles));
+
+/// Mesh client request seen by the mesh hook
+typedef struct {
+   uint16_t ModelID;          // client model, 0 for a scene recall
+   uint16_t Address;          // destination
+   uint8_t Tid;
+   uint16_t Flags;            // bit 0: response required
+   uint8_t Type;              // request type of a generic set
+   uint16_t Scene;            // recalled scene
+   uint8_t Len;
+   const uint8_t *pParams;
+   bool Get;                  // a generic get, Type is the state type
+} SimMeshRequest_t;
+
+/// Called for every generic client set, get and scene recall, the hook can
+/// answer with status events and returns the command result
+void SimSetMeshHook(uint16_t (*Hook)(const SimMeshRequest_t *pRequest));
+
+/// Called for every response to a user write request
+void SimSetWriteResponseHook(void (*Hook)(uint16_t Characteristic,uint8_t Error));
+
+/// RSSI reported by le_connection_get_rssi, -60 dBm by default
+void SimSetRssi(int8_t Rssi);
+
+/// Priority table the simulated link layer uses, NULL if none was configured
+const gecko_bluetooth_ll_priorities *SimLinkLayerPriorities(void);
+
+/// In replay mode all events come from the workload: the simulation does not
+/// generate boot, timer, signal or command response events and the program
+/// exits as soon as the workload pushes nothing more
+void SimSetReplay(bool Replay);
+
+/// Number of events returned to the application so far
+uint64_t SimEventCount(void);
+
+/// Content of a simulated GATT attribute, returns its length
+int SimGattRead(uint16_t Attribute,uint8_t *Buf,int Size);
+
+/// Runs USART0 over a non blocking file descriptor in real time
+void SimUartAttach(int Fd);
+
+/// Line rate of USART0 in baud, 0 for as fast as the descriptor goes,
+/// overrides the rate the application starts the UART with
+void SimUartSetBaudrate(uint32_t Baudrate);
+
+/// Called with the bytes USART0 sends while no descriptor is attached
+void SimUartSetTxHook(void (*Hook)(const uint8_t *pData,int Len));
+
+#endif   // _SIM_GECKO_H_
@@ -24,6 +24,7 @@
 
 #include "board_features.h"
 #include "em_cmu.h"
+#include "em_gpio.h"
 
 
 void initBoard(void)
@@ -38,4 +39,8 @@ void initBoard(void)
 
 void initVcomEnable(void)
 {
+#if defined(BSP_VCOM_ENABLE_PORT)
+  // Route USART0 through the board controller to the VCOM port
+  GPIO_PinModeSet(BSP_VCOM_ENABLE_PORT, BSP_VCOM_ENABLE_PIN, gpioModePushPull, 1);
+#endif
 }
\ No newline at end of file
@@ -47,6 +47,7 @@
 #define set_HFXO_CTUNE(val) do {hfxoInit.ctuneSteadyState = (val);} while (0)
 
 static void initMcu_clocks(void);
+static void initMcu_selectHFXO(void);
 static void initHFXO(void);
 
 void initMcu(void)
@@ -105,21 +106,15 @@ static void initMcu_clocks(void)
   // Set system HFXO frequency
   SystemHFXOClockSet(BSP_CLK_HFXO_FREQ);
 
+#if defined(DARWIN_FAST_BOOT)
+  // Start HFXO oscillator without waiting, initMcuWaitHFXO() selects it
+  // once it is stable. Until then the core keeps running from HFRCO.
+  CMU_OscillatorEnable(cmuOsc_HFXO, true, false);
+#else
   // Enable HFXO oscillator, and wait for it to be stable
   CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
-
-  // Enable HFXO Autostart only if EM2 voltage scaling is disabled.
-  // In 1.0 V mode the chip does not support frequencies > 21 MHz,
-  // this is why HFXO autostart is not supported in this case.
-#if!defined(_EMU_CTRL_EM23VSCALE_MASK)
-  // Automatically start and select HFXO
-  CMU_HFXOAutostartEnable(0, true, true);
-#else
-  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
-#endif//_EMU_CTRL_EM23VSCALE_MASK
-
-  // HFRCO not needed when using HFXO
-  CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+  initMcu_selectHFXO();
+#endif
 
   // Enabling HFBUSCLKLE clock for LE peripherals
   CMU_ClockEnable(cmuClock_HFLE, true);
@@ -143,9 +138,41 @@ static void initMcu_clocks(void)
   // Set system LFXO frequency
   SystemLFXOClockSet(BSP_CLK_LFXO_FREQ);
 
+#if defined(DARWIN_FAST_BOOT)
+  // Start LFXO oscillator without waiting too, it takes much longer than
+  // the HFXO. The stack selects it as LF clock in gecko_init() and only
+  // waits for the rest of its start-up then.
+  CMU_OscillatorEnable(cmuOsc_LFXO, true, false);
+#endif
+
 
 }
 
+static void initMcu_selectHFXO(void)
+{
+  // Enable HFXO Autostart only if EM2 voltage scaling is disabled.
+  // In 1.0 V mode the chip does not support frequencies > 21 MHz,
+  // this is why HFXO autostart is not supported in this case.
+#if!defined(_EMU_CTRL_EM23VSCALE_MASK)
+  // Automatically start and select HFXO
+  CMU_HFXOAutostartEnable(0, true, true);
+#else
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+#endif//_EMU_CTRL_EM23VSCALE_MASK
+
+  // HFRCO not needed when using HFXO
+  CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+}
+
+#if defined(DARWIN_FAST_BOOT)
+void initMcuWaitHFXO(void)
+{
+  // Wait for HFXO oscillator to be stable
+  CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
+  initMcu_selectHFXO();
+}
+#endif
+
 static void initHFXO(void)
 {
   // Initialize HFXO
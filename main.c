@@ -30,7 +30,10 @@
 
 /* Application code */
 #include "app.h"
+#include "connections.h"
 #include "darwin_log.h"
+#include "darwin_mem.h"
+#include "darwin_boot.h"
 
 /***************************************************************************//**
  * @addtogroup Application
@@ -42,11 +45,16 @@
  * @{
  ******************************************************************************/
 
-/// Maximum number of simultaneous Bluetooth connections
-#define MAX_CONNECTIONS 1
+// MAX_CONNECTIONS (connections.h) sets the simultaneous Bluetooth connections,
+// the stack heap below grows with it
+#if defined(MESH_CFG_MAX_PROXY_CONNECTIONS) && MESH_CFG_MAX_PROXY_CONNECTIONS > MAX_CONNECTIONS
+#error "MESH_CFG_MAX_PROXY_CONNECTIONS exceeds MAX_CONNECTIONS"
+#endif
 
-/// Heap for Bluetooth stack
-uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS) + BTMESH_HEAP_SIZE + 1760];
+#if defined(DARWIN_FAST_BOOT)
+/// Waits for the HFXO started by initMcu() and selects it (init_mcu.c)
+void initMcuWaitHFXO(void);
+#endif
 
 /// Bluetooth advertisement set configuration
 ///
@@ -60,7 +68,36 @@ uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS) + BTMESH_HE
 ///
 #define MAX_ADVERTISERS (4 + MESH_CFG_MAX_NETKEYS)
 
-/// Priorities for bluetooth link layer operations
+#if defined(MESH_CFG_MAX_PROXY_CONNECTIONS)
+#define MESH_PROXY_CONNECTIONS MESH_CFG_MAX_PROXY_CONNECTIONS
+#else
+#define MESH_PROXY_CONNECTIONS MAX_CONNECTIONS
+#endif
+
+/// Bluetooth heap the mesh stack needs on top of DEFAULT_BLUETOOTH_HEAP() in the
+/// Silicon Labs btmesh examples, which run one connection and the same
+/// 4 + MESH_CFG_MAX_NETKEYS advertisement sets as MAX_ADVERTISERS above
+#define BT_HEAP_MESH_SDK 1760
+
+/// Bluetooth heap for each mesh proxy connection beyond the one of the SDK
+/// figure. Not measured: an estimate of the proxy PDU reassembly and GATT
+/// notification buffers, verify it with the "bt heap" watermark of the "mem"
+/// command (DARWIN_MEM) while all proxy connections are open
+#ifndef BT_HEAP_PER_PROXY
+#define BT_HEAP_PER_PROXY 224
+#endif
+
+/// Bluetooth heap the mesh stack needs on top of DEFAULT_BLUETOOTH_HEAP(),
+/// the mesh heap itself (BTMESH_HEAP_SIZE) follows the MESH_CFG_ netkey,
+/// appkey and model counts in mesh_sizes.h. With MAX_CONNECTIONS 4 and no
+/// MESH_CFG_MAX_PROXY_CONNECTIONS it is 1760 + 3 * 224 = 2432 bytes.
+#define BT_HEAP_MESH_EXTRA (BT_HEAP_MESH_SDK + BT_HEAP_PER_PROXY * (MESH_PROXY_CONNECTIONS - 1))
+
+/// Heap for Bluetooth stack, the mesh heap is the last BTMESH_HEAP_SIZE bytes
+uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS) + BT_HEAP_MESH_EXTRA + BTMESH_HEAP_SIZE];
+
+/// Priorities for bluetooth link layer operations, the profiles of
+/// ll_priority.h are derived from the defaults and applied to it at runtime
 static gecko_bluetooth_ll_priorities linklayer_priorities = GECKO_BLUETOOTH_PRIORITIES_DEFAULT;
 
 /// Bluetooth stack configuration
@@ -106,22 +143,55 @@ static const gecko_configuration_t config =
  ******************************************************************************/
 int main(void)
 {
+  // Time the boot phases from here
+  BOOT_INIT();
+
+  // Paint the RAM for the watermarks before anything uses it
+  MEM_PAINT_STACK();
+
+#if defined(DARWIN_FAST_BOOT)
+  // initMcu() starts the HFXO and the LFXO without waiting for them. The
+  // LFXO, RTCC and energy mode setup of initMcu(), initBoard() and the heap
+  // painting run on HFRCO while the HFXO stabilizes, the LFXO keeps starting
+  // up through initApp() until gecko_init() selects it. The banners are
+  // skipped.
+  initMcu();
+  BOOT_MARK(BOOT_PHASE_MCU);
+  initBoard();
+  MEM_PAINT("bt heap", bluetooth_stack_heap, sizeof(bluetooth_stack_heap) - BTMESH_HEAP_SIZE, false);
+  MEM_PAINT("mesh heap", &bluetooth_stack_heap[sizeof(bluetooth_stack_heap) - BTMESH_HEAP_SIZE],
+            BTMESH_HEAP_SIZE, false);
+  initMcuWaitHFXO();
+  BOOT_MARK(BOOT_PHASE_HFXO);
+  RETARGET_SwoInit();
+#if defined(DARWIN_LOG) && defined(DARWIN_LOG_DEFERRED)
+  DeferredLogInit();
+#endif
+#else
+  MEM_PAINT("bt heap", bluetooth_stack_heap, sizeof(bluetooth_stack_heap) - BTMESH_HEAP_SIZE, false);
+  MEM_PAINT("mesh heap", &bluetooth_stack_heap[sizeof(bluetooth_stack_heap) - BTMESH_HEAP_SIZE],
+            BTMESH_HEAP_SIZE, false);
+
   // Initialize device
   initMcu();
+  BOOT_MARK(BOOT_PHASE_MCU);
+  BOOT_MARK(BOOT_PHASE_HFXO);
   RETARGET_SwoInit();
+#if defined(DARWIN_LOG) && defined(DARWIN_LOG_DEFERRED)
+  DeferredLogInit();
+#endif
   ALOG("(C) Copyright (C) 2020 Darwin Tech, LLC\n");
   ALOG("(C) Copyright (C) 2020 Silicon Labs\n");
   ALOG("EMC Gateway compiled " __DATE__ ", " __TIME__ "\n");
 
   // Initialize board
   initBoard();
+#endif
   // Initialize application
   initApp();
   initVcomEnable();
 
-  // Minimize advertisement latency by allowing the advertiser to always
-  // interrupt the scanner.
-  linklayer_priorities.scan_max = linklayer_priorities.adv_min + 1;
+  BOOT_MARK(BOOT_PHASE_APP);
   // Start application
   appMain(&config);
 }
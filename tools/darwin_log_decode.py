@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+###############################################################################
+# (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+###############################################################################
+# This file is licensed under the Darwin Tech Embedded Software License
+# Agreement. See the file "Darwin Tech - Embedded Software License
+# Agreement.pdf" for details.
+###############################################################################
+"""Decode the binary stream written by the DARWIN_LOG_DEFERRED log mode.
+
+The firmware sends 32 bit little endian words on ITM stimulus port 1:
+
+    word 0: nargs << 24 | format string address
+    word 1: RTCC counter (32768 Hz)
+    word 2..: arguments
+
+Format strings and %s arguments that point into flash are read from the ELF
+file the firmware was built from.
+
+usage: darwin_log_decode.py firmware.axf itm_port1.bin
+"""
+
+import re
+import struct
+import sys
+
+RTCC_HZ = 32768
+PT_LOAD = 1
+
+FORMAT_RE = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+class Elf(object):
+    """Minimal little endian ELF32 reader, maps addresses to file content."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError('%s is not a little endian ELF32 file' % path)
+        phoff, = struct.unpack_from('<I', self.data, 0x1c)
+        phentsize, phnum = struct.unpack_from('<HH', self.data, 0x2a)
+        self.segments = []
+        for i in range(phnum):
+            p_type, p_offset, p_vaddr, p_paddr, p_filesz = struct.unpack_from(
+                '<IIIII', self.data, phoff + i * phentsize)
+            if p_type == PT_LOAD and p_filesz:
+                # initialised data is stored at its load address in flash
+                self.segments.append((p_vaddr, p_offset, p_filesz))
+                if p_paddr != p_vaddr:
+                    self.segments.append((p_paddr, p_offset, p_filesz))
+
+    def string(self, address):
+        for base, offset, size in self.segments:
+            if base <= address < base + size:
+                start = offset + address - base
+                end = self.data.index(b'\0', start)
+                return self.data[start:end].decode('latin-1')
+        return None
+
+
+def format_record(elf, fmt, args):
+    args = list(args)
+
+    def convert(m):
+        flags, width, precision, length, conv = m.groups()
+        if conv == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        spec = '%' + flags + (width or '') + ('.' + precision if precision else '')
+        if conv == 's':
+            text = elf.string(value)
+            return (spec + 's') % (text if text is not None else '<0x%08x>' % value)
+        if conv == 'c':
+            return chr(value & 0xff)
+        if conv in 'di':
+            value = struct.unpack('<i', struct.pack('<I', value))[0]
+            conv = 'd'
+        if conv == 'u':
+            conv = 'd'
+        if conv == 'p':
+            return '0x%08x' % value
+        return (spec + conv) % value
+
+    return FORMAT_RE.sub(convert, fmt)
+
+
+def decode(elf, stream, out):
+    words = struct.unpack('<%dI' % (len(stream) // 4), stream[:len(stream) & ~3])
+    i = 0
+    in_sync = True
+    while i + 2 <= len(words):
+        header, stamp = words[i], words[i + 1]
+        nargs = header >> 24
+        address = header & 0x00ffffff
+        fmt = elf.string(address) if address else None
+        if address and fmt is None:
+            # not a record header, skip a word at a time until one is found
+            if in_sync:
+                out.write('*** stream out of sync at word %d ***\n' % i)
+                in_sync = False
+            i += 1
+            continue
+        in_sync = True
+        args = words[i + 2:i + 2 + nargs]
+        i += 2 + nargs
+        prefix = '[%10.5f] ' % (stamp / float(RTCC_HZ))
+        if address == 0:
+            out.write(prefix + '*** %d log records dropped ***\n' % (args[0] if args else 0))
+        else:
+            out.write(prefix + format_record(elf, fmt, args))
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write(__doc__)
+        return 1
+    elf = Elf(argv[1])
+    with open(argv[2], 'rb') as f:
+        decode(elf, f.read(), sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
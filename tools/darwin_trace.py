@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+###############################################################################
+# (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+###############################################################################
+# This file is licensed under the Darwin Tech Embedded Software License
+# Agreement. See the file "Darwin Tech - Embedded Software License
+# Agreement.pdf" for details.
+###############################################################################
+"""Capture and list the event trace recorded with DARWIN_TRACE.
+
+    darwin_trace.py capture /dev/ttyACM0 trace.bin [baudrate]
+        sends 'trace dump' to the console and saves the binary dump
+
+    darwin_trace.py print trace.bin
+        lists the recorded events
+
+The format is described in common/darwin_trace.h. A saved trace can be
+replayed with the host build: host/build/gateway_sim -r trace.bin [-x speed]
+"""
+
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+TRACE_MAGIC = 0x43525444
+TRACE_VERSION = 1
+TRACE_LOST = 0x00000000
+TRACE_END = 0xffffffff
+MAGIC_BYTES = struct.pack('<I', TRACE_MAGIC)
+TIMEOUT = 5.0
+
+
+def payload_len(header):
+    return ((header & 0x7) << 8) | ((header >> 8) & 0xff)
+
+
+def record_words(header):
+    return 3 if header == TRACE_LOST else 2 + (payload_len(header) + 3) // 4
+
+
+def records(data):
+    """Yields (header, stamp, payload bytes) from a dump stream."""
+    if len(data) < 12:
+        raise ValueError('trace too short')
+    magic, version, ticks = struct.unpack_from('<III', data, 0)
+    if magic != TRACE_MAGIC or version != TRACE_VERSION:
+        raise ValueError('not an event trace')
+    pos = 12
+    while pos + 4 <= len(data):
+        header, = struct.unpack_from('<I', data, pos)
+        if header == TRACE_END:
+            return
+        size = record_words(header) * 4
+        if pos + size > len(data):
+            raise ValueError('trace truncated at byte %d' % pos)
+        stamp, = struct.unpack_from('<I', data, pos + 4)
+        if header == TRACE_LOST:
+            yield header, stamp / float(ticks), data[pos + 8:pos + 12]
+        else:
+            yield header, stamp / float(ticks), data[pos + 8:pos + 8 + payload_len(header)]
+        pos += size
+
+
+def open_port(port, baudrate):
+    fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attr = termios.tcgetattr(fd)
+    speed = getattr(termios, 'B%d' % baudrate)
+    attr[4] = attr[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attr)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def stream_end(stream):
+    """Returns the size of a complete dump stream, None if incomplete."""
+    pos = 12
+    while pos + 4 <= len(stream):
+        header, = struct.unpack_from('<I', stream, pos)
+        if header == TRACE_END:
+            return pos + 4
+        pos += record_words(header) * 4
+    return None
+
+
+def capture(port, path, baudrate):
+    fd = open_port(port, baudrate)
+    os.write(fd, b'trace dump\r')
+    data = b''
+    deadline = time.time() + TIMEOUT
+    while time.time() < deadline:
+        ready, _, _ = select.select([fd], [], [], 0.1)
+        if not ready:
+            continue
+        data += os.read(fd, 4096)
+        deadline = time.time() + TIMEOUT
+        # skip console output in front of the dump
+        start = data.find(MAGIC_BYTES)
+        end = stream_end(data[start:]) if start >= 0 else None
+        if end is not None:
+            stream = data[start:start + end]
+            with open(path, 'wb') as f:
+                f.write(stream)
+            sys.stdout.write('%d records saved to %s\n' % (sum(1 for _ in records(stream)), path))
+            os.close(fd)
+            return 0
+    os.close(fd)
+    sys.stderr.write('no complete trace received\n')
+    return 1
+
+
+def list_records(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    for header, stamp, payload in records(data):
+        if header == TRACE_LOST:
+            sys.stdout.write('[%10.5f] *** %d events lost ***\n' % (stamp, struct.unpack('<I', payload)[0]))
+            continue
+        sys.stdout.write('[%10.5f] class 0x%02x method 0x%02x %s\n' % (
+            stamp, (header >> 16) & 0xff, (header >> 24) & 0xff,
+            ' '.join('%02x' % b for b in bytearray(payload))))
+    return 0
+
+
+def main(argv):
+    if len(argv) >= 4 and argv[1] == 'capture':
+        return capture(argv[2], argv[3], int(argv[4]) if len(argv) > 4 else 115200)
+    if len(argv) == 3 and argv[1] == 'print':
+        return list_records(argv[2])
+    sys.stderr.write(__doc__)
+    return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))